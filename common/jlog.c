@@ -13,20 +13,25 @@
 #include "jfs.h"
 #include "jsocket.h"
 #include "jheap.h"
+#include "jhashmap.h"
 #include "jperf.h"
+#include "joptimize.h"
 
 extern ssize_t jsocket_send_(jsocket_fd_t sfd, const void *buf, ssize_t blen, int print_flag);
+extern ssize_t jsocket_sendv_(jsocket_fd_t sfd, const jfs_iovec_t *iov, int cnt, int print_flag);
 extern jsocket_fd_t jsocket_tcp_client_(const jsocket_jaddr_t *jaddr, int print_flag);
 extern int jfs_mkdir_(const char *dname, int print_flag);
 extern int jfs_listdir_(const char *dname, jfs_dirent_t **dirs, int *num, jfs_filter_cb filter, int print_flag);
 
 #define PATH_MAX_LEN        4096        // 路径最大长度-1
-#define JLOG_SLEEP_MS       1000        // 写线程睡眠时间毫秒
+#define JLOG_SLEEP_MS       1000        // 写线程最长睡眠时间默认毫秒数，即日志的默认最大延迟
 #define JLOG_STACK_SIZE     (64 << 10)  // 默认线程栈大小
 #define JLOG_BUF_SIZE       (1 << 19)   // 缓冲大小
 #define JLOG_BUF_FACTOR     (4)         // 保留缓冲，写入不及时时直接删除旧缓冲大小为(JLOG_BUF_SIZE >> JLOG_BUF_FACTOR)
 #define JLOG_WAKE_SIZE      (128 << 10) // 唤醒写线程的缓冲默认阈值
 #define JLOG_RES_SIZE       1024        // 日志缓冲保留默认大小，即一次写log的最大长度
+#define JLOG_TBUF_SIZE      (64 << 10)  // 每个线程的日志缓冲默认大小
+#define JLOG_CACHELINE      64          // 缓存行大小，用于隔离线程缓冲中生产者和消费者的热数据
 
 #define JLOG_DEF_FSIZE      (1 << 20)   // 写文件时的默认文件大小
 #define JLOG_DEF_FCOUNT     10          // 写文件时的默认文件限制数量
@@ -35,8 +40,9 @@ extern int jfs_listdir_(const char *dname, jfs_dirent_t **dirs, int *num, jfs_fi
 #define JLOG_DEF_IPPORT     9999        // 连接的日志服务器的默认端口
 
 #define JLOG_TS_SIZE        23          // log时间戳的长度
-#define JLOG_WRITE_SIZE     (64 << 10)  // 写文件时单次写大小
-#define JLOG_SEND_SIZE      (64 << 10)  // 发送网络时时单次发送大小
+#define JLOG_SINK_NUM       3           // 输出目标的数量，下标是 jlog_mode_t - 1
+#define JLOG_IOV_MAX        JSOCKET_IOV_MAX // 一次输出最多的内存段个数
+#define JLOG_MSYNC_SIZE     (1 << 20)   // 映射写文件时累计多少字节发起一次异步写回
 #define RESTATDIR_SEC       30          // 重新检查文件系统的时间
 #define HEARTBEAT_SEC       30          // 发送到网络的心跳时间
 #define RECONNECT_SEC       30          // 发送到网络的重连时间
@@ -46,8 +52,10 @@ extern int jfs_listdir_(const char *dname, jfs_dirent_t **dirs, int *num, jfs_fi
 #endif
 #if JLOG_TIMESTAMP
 #define JLOG_HEAD_SIZE      30          // log格式头的长度 JLOG_TS_SIZE + 7，不含module和type
+#define JLOG_LEVEL_POS      (JLOG_TS_SIZE + 2) // log格式头中等级字符的位置
 #else
 #define JLOG_HEAD_SIZE      6
+#define JLOG_LEVEL_POS      1
 #endif
 
 typedef struct {
@@ -59,6 +67,9 @@ typedef struct {
     int tail;               // 快达到buffer结尾时不再写入的位置
     int loses;              // 丢缓冲的次数
     int truncs;             // 可能截断的次数
+    int sinks;              // 正在输出的目标，JLOG_SINK_xxx的组合
+    int pend[JLOG_SINK_NUM];// 每个输出目标还未输出的数据长度，读取位置由最慢的输出目标决定
+    int busy[JLOG_SINK_NUM];// 每个输出目标已取出正在输出的数据长度，丢弃缓冲时不能回收，为0时输出结果作废
     char *buf;              // buffer指针
 #if JLOG_TIMESTAMP
     jtime_t tsec;           // 时间戳
@@ -66,6 +77,123 @@ typedef struct {
 #endif
 } jlog_jbuf_t;
 
+/* 线程缓冲中的一条日志记录，8字节对齐，len为0表示回绕标记 */
+typedef struct {
+    uint32_t len;           // 记录总长度（含记录头，8字节对齐）
+    uint32_t tlen;          // 日志文本长度
+    uint64_t nsec;          // 单调时钟纳秒数，写线程按它合并各线程的日志
+} jlog_trec_t;
+#define JLOG_TREC_SIZE(n)   ((int)((sizeof(jlog_trec_t) + (n) + 7) & ~7u))
+#define JLOG_TREC_BIN       0x80000000u // tlen的标记位，表示记录是延迟格式化的参数数据
+
+/* 延迟格式化记录的头，紧跟在 jlog_trec_t 之后，之后是8字节对齐的参数数据 */
+typedef struct {
+    jlog_bfmt_t *bfmt;      // 格式串描述
+    const jlog_str_t *module; // 产生日志的模块
+    const jlog_str_t *type; // 对日志的分类
+    jtime_mt_t mt;          // 日志时间戳
+    int level;              // 日志输出等级
+    int alen;               // 参数数据长度
+} jlog_brec_t;
+
+/* 延迟格式化的参数类型，低4位是取参数的类型，高位是整数的截断和符号 */
+#define JLOG_BARG_INT       1
+#define JLOG_BARG_LONG      2
+#define JLOG_BARG_LLONG     3
+#define JLOG_BARG_INTMAX    4
+#define JLOG_BARG_SIZE      5
+#define JLOG_BARG_PTRDIFF   6
+#define JLOG_BARG_DOUBLE    7
+#define JLOG_BARG_PTR       8
+#define JLOG_BARG_STR       9
+#define JLOG_BARG_KIND      0x0F
+#define JLOG_BARG_CHAR      0x10        // 截断为char
+#define JLOG_BARG_SHORT     0x20        // 截断为short
+#define JLOG_BARG_UNSIGNED  0x40        // 无符号整数
+#define JLOG_BSPEC_MAX      32          // 单个转换说明的最大长度
+
+/* 解析出的一个转换说明 */
+typedef struct {
+    const char *flags;      // 标志
+    int flen;               // 标志长度
+    const char *width;      // 宽度数字
+    int wlen;               // 宽度数字长度，小于0表示'*'
+    const char *prec;       // 精度数字，NULL表示没有精度
+    int plen;               // 精度数字长度，小于0表示'*'
+    unsigned char arg;      // 参数类型
+    char conv;              // 转换字符
+} jlog_bspec_t;
+
+#define JLOG_BIN_MAGIC      "JLGB"      // 二进制日志文件的魔数
+#define JLOG_BIN_VERSION    1           // 二进制日志文件的格式版本
+#define JLOG_BIN_TEXT       1           // 记录类型：已格式化的一行文本日志
+#define JLOG_BIN_FMT        2           // 记录类型：格式串定义
+#define JLOG_BIN_LOG        3           // 记录类型：延迟格式化日志的参数
+#define JLOG_BIN_SIZE(n)    ((int)((sizeof(jlog_bin_t) + (n) + 7) & ~7u)) // 数据长度为n的记录占用的长度
+#define JLOG_BIN_STEP(len)  ((int)(((len) + 7) & ~7u)) // 记录长度为len的记录占用的长度
+
+/* 二进制日志文件的文件头，之后是已知格式串的定义和日志记录 */
+typedef struct {
+    char magic[4];          // 魔数 JLOG_BIN_MAGIC
+    uint8_t version;        // 格式版本
+    uint8_t endian;         // 字节序，1小端，2大端
+    uint8_t stamp;          // 日志是否带时间戳
+    uint8_t resv;           // 保留
+    int32_t zone;           // 时区偏移秒数
+    int32_t res;            // 单条日志的最大长度，解码时在同样的位置截断
+} jlog_bhead_t;
+
+/* 二进制日志文件中的一条记录，之后是记录数据，下一条记录从8字节对齐的位置开始 */
+typedef struct {
+    uint32_t len;           // 记录长度（含记录头，不含对齐填充）
+    uint8_t kind;           // 记录类型 JLOG_BIN_xxx
+    uint8_t level;          // 日志输出等级
+    uint8_t mlen;           // 模块名长度，只用于JLOG_BIN_LOG
+    uint8_t tlen;           // 类型名长度，只用于JLOG_BIN_LOG
+} jlog_bin_t;
+
+/* 格式串定义的记录数据，之后是带'\0'的源文件名和格式串 */
+typedef struct {
+    uint64_t id;            // 格式串ID
+    int32_t line;           // 调用处所在的行号
+    uint32_t flen;          // 源文件名长度
+} jlog_bdef_t;
+
+/*
+ * 延迟格式化日志的记录数据，之后是模块名和类型名，再之后是紧凑存储的参数：
+ * 浮点数8字节，字符串是变长整数的长度加内容，其它整数是zigzag编码的变长整数
+ */
+typedef struct {
+    uint64_t id;            // 格式串ID
+    uint64_t msec;          // 日志时间戳，单位毫秒
+} jlog_blog_t;
+
+/**
+ * @brief   线程日志缓冲，单生产者单消费者环形缓冲
+ * @note    1. 生产者是所属线程，消费者是写线程，写入位置和读取位置都是单调递增的绝对位置
+ *          2. 链表和关闭状态由缓冲互斥锁保护，日志写入本身不加锁
+ */
+typedef struct jlog_tbuf {
+    struct jlog_tbuf *next; // 链表中的下一个线程缓冲
+    uint32_t size;          // 缓冲大小，2的幂
+    uint32_t closed;        // 所属线程已退出，读完后由写线程释放
+    uint32_t detached;      // 反初始化时已从链表摘除，由所属线程释放
+    uint32_t wsnap;         // 写线程合并时的写入位置快照
+    uint8_t pad0[JLOG_CACHELINE];
+    uint32_t widx;          // 写入位置，只由所属线程修改
+    uint32_t busy;          // 所属线程正在写入
+    uint32_t truncs;        // 可能截断的次数
+    uint32_t pend;          // 还未累加到共享积压计数的提交字节数，只由所属线程访问
+#if JLOG_TIMESTAMP
+    jtime_t tsec;           // 时间戳
+    char tbuf[JLOG_TS_SIZE + 1]; // 时间戳字符串
+#endif
+    uint8_t pad1[JLOG_CACHELINE];
+    uint32_t ridx;          // 读取位置，只由写线程修改
+    uint8_t pad2[JLOG_CACHELINE - sizeof(uint32_t)];
+    char buf[];             // 数据缓冲区
+} jlog_tbuf_t;
+
 typedef struct {
 #define LOGFILE_STRLEN      29
     char name[LOGFILE_STRLEN + 1];
@@ -78,6 +206,13 @@ typedef struct {
     int dlen;               // 文件夹字符串长度
     jtime_t last_check;     // 上次检查文件输出端是否可用的时间戳
     jfs_fd_t fd;            // 文件描述符
+    int mmap;               // 是否映射写入新的log文件
+    int binary;             // 新的log文件是否写二进制格式
+    int bin;                // 正在输出的是二进制文件，由写线程修改
+    char *map;              // 当前log文件的映射地址，为空时直接写文件
+    int mlen;               // 当前log文件的映射大小
+    int synced;             // 已发起写回的长度
+    jtime_t last_sync;      // 上次发起写回的时间戳
     char path[PATH_MAX_LEN];// 文件存储目录
     jlog_fname_t *fnames;   // 记录log文件名列表
     int fnum;               // 记录log文件名的数量
@@ -93,10 +228,12 @@ typedef struct {
 
 typedef struct {
     int level;              // 打印等级
+    int flush_ms;           // 日志最大延迟毫秒数，写线程至少间隔这么久输出一次
     int zone_sec;           // 时区偏移秒数
-    int changed;            // 参数有变化
-    jlog_mode_t mode;       // 输出方式
-    jlog_mode_t wanted;     // 将要设置的输出方式
+    int changed;            // 参数有变化的输出目标，JLOG_SINK_xxx的组合
+    int wanted;             // 将要设置的输出目标，JLOG_SINK_xxx的组合
+    int levels[JLOG_SINK_NUM]; // 每个输出目标的打印等级，0表示不过滤
+    int midline[JLOG_SINK_NUM]; // 输出目标的读取位置在一行日志中间，由输出线程访问，不在输出时可在缓冲互斥锁下清除
     jlog_fcfg_t fcfg;       // 文件输出配置
     jlog_ncfg_t ncfg;       // 网络输出配置
     jlog_perf_t perf;       // 采集系统信息的配置
@@ -105,15 +242,33 @@ typedef struct {
 typedef struct {
     int inited;             // 是否初始化了
     jlog_jbuf_t jbuf;       // 缓冲区
+    jlog_jbuf_t bbuf;       // 二进制缓冲，写二进制文件时文件从这里输出
     jlog_jcfg_t jcfg;       // 输出配置
+    jlog_bfmt_t *bfmts;     // 写入过二进制缓冲的格式串链表，由缓冲互斥锁保护，反初始化后也保留
+    uint32_t bgen;          // 格式串定义的代数，二进制缓冲丢弃数据时增加，之后用到的格式串重新写入定义
 
     jthread_t tid;          // 线程id
+    jthread_t ntid;         // 网络输出线程id
+    int nstate;             // 网络输出线程状态：0未创建，1运行，2退出
+    jthread_cond_t ncond;   // 网络输出线程条件变量
     jthread_mutex_t cmtx;   // 配置互斥锁
     jthread_mutex_t mtx;    // 缓冲互斥锁
     jthread_cond_t cond;    // 缓冲条件变量
+
+    jlog_tbuf_t *tbufs;     // 线程缓冲链表，由缓冲互斥锁保护
+    int tbuf_size;          // 线程缓冲大小，0表示不使用线程缓冲
+    uint32_t gen;           // 初始化代数，初始化和反初始化时增加，用于识别过期的线程缓冲
+    int key_inited;         // 线程局部数据的键是否创建了
+    jthread_key_t key;      // 线程局部数据的键，用于线程退出时关闭线程缓冲
+    uint32_t users;         // 写日志时正在使用缓冲互斥锁的线程数，反初始化等它为0后才销毁锁
+    uint8_t pad0[JLOG_CACHELINE];
+    uint32_t tpend;         // 各线程缓冲累加过来的未合并字节数，各线程积攒到一定量时增加，合并时减少
+    uint8_t pad1[JLOG_CACHELINE - sizeof(uint32_t)];
 } jlog_mgr_t;
 
 static jlog_mgr_t g_jlog_mgr;
+static JATTR_TLS jlog_tbuf_t *t_jlog_tbuf;
+static JATTR_TLS uint32_t t_jlog_gen;
 static const char g_level_str[] = "OFEWIDT";
 static const jlog_str_t g_jlog_none = {"N", 1};
 static const jlog_str_t g_jlog_mod = {"MOD", 3};
@@ -251,6 +406,13 @@ static inline int _jlog_rsize_get(jlog_jbuf_t *jbuf)
 
 static inline void _jlog_widx_update(jlog_jbuf_t *jbuf, int len)
 {
+    int i;
+
+    for (i = 0; i < JLOG_SINK_NUM; ++i) {
+        if (jbuf->sinks & (1 << i))
+            jbuf->pend[i] += len;
+    }
+
     if (jbuf->widx >= jbuf->ridx) {
         jbuf->widx += len;
         if (jbuf->size - jbuf->widx < jbuf->res) {
@@ -262,23 +424,232 @@ static inline void _jlog_widx_update(jlog_jbuf_t *jbuf, int len)
     }
 }
 
-#if JLOG_TIMESTAMP
-static void _jlog_tbuf_update(const jtime_mt_t *mt)
+/* 写入二进制记录的记录头并清零末尾的填充，返回记录数据的位置 */
+static inline char *_jlog_bin_head(char *buf, int kind, int level, int dlen)
+{
+    jlog_bin_t *bin = (jlog_bin_t *)buf;
+    int len = (int)sizeof(jlog_bin_t) + dlen;
+
+    bin->len = (uint32_t)len;
+    bin->kind = (uint8_t)kind;
+    bin->level = (uint8_t)level;
+    bin->mlen = 0;
+    bin->tlen = 0;
+    memset(buf + len, 0, JLOG_BIN_STEP(len) - len);
+    return (char *)(bin + 1);
+}
+
+/*
+ * 返回从buf开始的len字节中完整记录的长度，二进制数据只在记录边界切分
+ * cover非0时到越过want的那条记录结束为止，否则不超过want
+ */
+static int _jlog_bin_span(const char *buf, int len, int want, int cover)
+{
+    int pos = 0, rlen = 0;
+
+    while (pos < len && pos < want) {
+        rlen = JLOG_BIN_STEP(((const jlog_bin_t *)(buf + pos))->len);
+        if (!cover && pos + rlen > want)
+            break;
+        pos += rlen;
+    }
+    return pos;
+}
+
+/* 编码格式串定义，buf为NULL时只返回记录长度 */
+static int _jlog_bin_fmt(const jlog_bfmt_t *bfmt, char *buf)
+{
+    int flen = (int)strlen(bfmt->file), slen = (int)strlen(bfmt->fmt) + 1;
+    int dlen = (int)sizeof(jlog_bdef_t) + flen + 1 + slen;
+    jlog_bdef_t *def = NULL;
+
+    if (buf) {
+        def = (jlog_bdef_t *)_jlog_bin_head(buf, JLOG_BIN_FMT, 0, dlen);
+        def->id = (uint64_t)(uintptr_t)bfmt;
+        def->line = bfmt->line;
+        def->flen = (uint32_t)flen;
+        memcpy(def + 1, bfmt->file, flen + 1);
+        memcpy((char *)(def + 1) + flen + 1, bfmt->fmt, slen);
+    }
+    return JLOG_BIN_SIZE(dlen);
+}
+
+/* 被文件的打印等级过滤掉的日志不写入二进制缓冲，和文本文件按行过滤的规则相同 */
+static inline int _jlog_bin_skip(jlog_mgr_t *mgr, int level)
+{
+    int flevel = mgr->jcfg.levels[JLOG_TO_FILE - 1];
+    return flevel && flevel < mgr->jcfg.level && level > flevel;
+}
+
+/* 一行文本日志编码为二进制记录，等级取自行首日志头中的等级字符; 调用者持有缓冲互斥锁 */
+static void _jlog_bin_text(jlog_mgr_t *mgr, const char *text, int len)
+{
+    jlog_jbuf_t *bbuf = &mgr->bbuf;
+    const char *p = NULL;
+    int level = 0, need = JLOG_BIN_SIZE(len);
+
+    if (len > JLOG_LEVEL_POS && (p = strchr(g_level_str, text[JLOG_LEVEL_POS])) && *p)
+        level = (int)(p - g_level_str);
+    if (_jlog_bin_skip(mgr, level))
+        return;
+    if (need > bbuf->res || _jlog_wsize_get(bbuf) < need) {
+        ++bbuf->loses;
+        return;
+    }
+
+    memcpy(_jlog_bin_head(bbuf->buf + bbuf->widx, JLOG_BIN_TEXT, level, len), text, len);
+    _jlog_widx_update(bbuf, need);
+}
+
+/* 写入变长整数，每字节存7位，最高位表示后面还有字节 */
+static inline char *_jlog_varint_put(char *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (char)v;
+    return p;
+}
+
+/* 读取变长整数，数据不完整时返回NULL */
+static inline const char *_jlog_varint_get(const char *p, const char *end, uint64_t *v)
+{
+    int shift = 0;
+
+    *v = 0;
+    while (p < end && shift < 64) {
+        *v |= (uint64_t)(*p & 0x7F) << shift;
+        if (!(*p++ & 0x80))
+            return p;
+        shift += 7;
+    }
+    return NULL;
+}
+
+/*
+ * 把延迟格式化日志8字节对齐的参数槽紧凑存储到out，返回写入的长度
+ * 最多写入 alen + JLOG_BARG_MAX * 2 字节：每个变长整数最多比8字节多2字节，字符串的长度和结尾的'\0'抵消
+ */
+static int _jlog_bin_pack(const jlog_bfmt_t *bfmt, const char *a, int alen, char *out)
+{
+    const char *aend = a + alen;
+    char *p = out;
+    uint64_t v = 0;
+    int i = 0;
+
+    for (i = 0; i < bfmt->nargs && aend - a >= 8; ++i) {
+        memcpy(&v, a, 8);
+        switch (bfmt->args[i] & JLOG_BARG_KIND) {
+        case JLOG_BARG_DOUBLE:
+            memcpy(p, a, 8);
+            p += 8;
+            a += 8;
+            break;
+        case JLOG_BARG_STR:
+            p = _jlog_varint_put(p, v);
+            memcpy(p, a + 8, (size_t)v);
+            p += v;
+            a += 8 + ((v + 8) & ~(uint64_t)7);
+            break;
+        default:
+            /* zigzag编码，绝对值小的负数也只占很少的字节 */
+            p = _jlog_varint_put(p, (v << 1) ^ (uint64_t)((int64_t)v >> 63));
+            a += 8;
+            break;
+        }
+    }
+    return (int)(p - out);
+}
+
+/*
+ * 延迟格式化的日志在二进制缓冲中紧凑存储参数，不用格式化; 调用者持有缓冲互斥锁
+ * 格式串第一次写入或定义可能被丢弃过时，先写入格式串定义，两条记录一起写入
+ * 成功或被过滤返回0; 记录比二进制缓冲的保留大小还大时返回-1，由调用者格式化为文本写入
+ */
+static int _jlog_bin_brec(jlog_mgr_t *mgr, const jlog_brec_t *brec)
+{
+    jlog_jbuf_t *bbuf = &mgr->bbuf;
+    jlog_bfmt_t *bfmt = brec->bfmt;
+    const jlog_str_t *module = brec->module ? brec->module : &g_jlog_none;
+    const jlog_str_t *type = brec->type ? brec->type : &g_jlog_none;
+    jlog_bin_t *bin = NULL;
+    jlog_blog_t *blog = NULL;
+    char *p = NULL;
+    int mlen = module->len < 255 ? module->len : 255;
+    int tlen = type->len < 255 ? type->len : 255;
+    int dlen = 0, need = 0;
+
+    if (_jlog_bin_skip(mgr, brec->level))
+        return 0;
+    /* 按参数压缩前的上限检查空间，写入后按实际长度更新写入位置 */
+    dlen = bfmt->bgen == mgr->bgen ? 0 : _jlog_bin_fmt(bfmt, NULL);
+    need = JLOG_BIN_SIZE(sizeof(jlog_blog_t) + mlen + tlen + brec->alen + JLOG_BARG_MAX * 2);
+    if (dlen + need > bbuf->res)
+        return -1;
+    if (_jlog_wsize_get(bbuf) < dlen + need) {
+        ++bbuf->loses;
+        return 0;
+    }
+
+    p = bbuf->buf + bbuf->widx;
+    if (dlen) {
+        _jlog_bin_fmt(bfmt, p);
+        p += dlen;
+        if (!bfmt->bgen) {
+            bfmt->next = mgr->bfmts;
+            mgr->bfmts = bfmt;
+        }
+        bfmt->bgen = mgr->bgen;
+    }
+
+    bin = (jlog_bin_t *)p;
+    blog = (jlog_blog_t *)(bin + 1);
+    blog->id = (uint64_t)(uintptr_t)bfmt;
+    blog->msec = (uint64_t)brec->mt.sec * 1000 + brec->mt.msec;
+    p = (char *)(blog + 1);
+    memcpy(p, module->str, mlen);
+    memcpy(p + mlen, type->str, tlen);
+    p += mlen + tlen;
+    p += _jlog_bin_pack(bfmt, (const char *)(brec + 1), brec->alen, p);
+
+    _jlog_bin_head((char *)bin, JLOG_BIN_LOG, brec->level, (int)(p - (char *)blog));
+    bin->mlen = (uint8_t)mlen;
+    bin->tlen = (uint8_t)tlen;
+    _jlog_widx_update(bbuf, dlen + JLOG_BIN_STEP(bin->len));
+    return 0;
+}
+
+/*
+ * 提交刚写入共享缓冲写入位置的一行文本日志; 调用者持有缓冲互斥锁
+ * 写二进制文件时同时编码进二进制缓冲，此时没有文本输出目标就不占用共享缓冲
+ */
+static inline void _jlog_text_commit(jlog_mgr_t *mgr, int len)
 {
-    jlog_mgr_t *mgr = &g_jlog_mgr;
-    jlog_jcfg_t *jcfg = &mgr->jcfg;
     jlog_jbuf_t *jbuf = &mgr->jbuf;
-    char *p = jbuf->tbuf;
+
+    if (mgr->bbuf.sinks) {
+        _jlog_bin_text(mgr, jbuf->buf + jbuf->widx, len);
+        if (!jbuf->sinks)
+            return;
+    }
+    _jlog_widx_update(jbuf, len);
+}
+
+#if JLOG_TIMESTAMP
+static void _jlog_tbuf_update(jtime_t *tsec, char *tbuf, const jtime_mt_t *mt, int zone)
+{
+    char *p = tbuf;
     jtime_tm_t tm = {0};
     int t1, t2;
     jtime_t t = 0;
 
-    t = mt->sec + jcfg->zone_sec - jbuf->tsec;
+    t = mt->sec + zone - *tsec;
     if (t >= 0 && t < 60) {
         p += 17;
     } else {
-        jtime_mtime_to_tm(mt, &tm, jcfg->zone_sec);
-        jbuf->tsec = mt->sec + jcfg->zone_sec - tm.sec;
+        jtime_mtime_to_tm(mt, &tm, zone);
+        *tsec = mt->sec + zone - tm.sec;
         t = tm.sec;
 
         t1 = FAST_DIV100(tm.year);
@@ -317,10 +688,171 @@ static void _jlog_tbuf_update(const jtime_mt_t *mt)
 }
 #endif
 
+/*
+ * 写日志的线程使用缓冲互斥锁前登记，已反初始化时返回-1
+ * 先登记再检查，和反初始化先清除初始化标记再等待登记数为0配对，不会使用已销毁的锁
+ */
+static inline int _jlog_lock_enter(jlog_mgr_t *mgr)
+{
+    jatomic32_fetch_add(&mgr->users, 1);
+    if (JATTR_LIKELY(mgr->inited))
+        return 0;
+    jatomic32_fetch_add(&mgr->users, (uint32_t)-1);
+    return -1;
+}
+
+static inline void _jlog_lock_leave(jlog_mgr_t *mgr)
+{
+    jatomic32_fetch_add(&mgr->users, (uint32_t)-1);
+}
+
+static void jlog_tbuf_release(void *arg)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_tbuf_t *tb = (jlog_tbuf_t *)arg;
+
+    if (!tb || tb != t_jlog_tbuf)
+        return;
+    t_jlog_tbuf = NULL;
+
+    jatomic32_store(&tb->busy, 1);
+    jatomic_fence();
+    if (t_jlog_gen == jatomic32_load(&mgr->gen)) {
+        /* 还在链表中，交给写线程读完后释放 */
+        jatomic32_store_release(&tb->closed, 1);
+        jatomic32_store_release(&tb->busy, 0);
+    } else {
+        /* 反初始化已经开始，等它摘除后自己释放 */
+        jatomic32_store_release(&tb->busy, 0);
+        while (!jatomic32_load_acquire(&tb->detached))
+            jthread_yield();
+        jheap_free(tb);
+    }
+}
+
+static jlog_tbuf_t *jlog_tbuf_get(void)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_tbuf_t *tb = t_jlog_tbuf;
+    uint32_t gen = jatomic32_load_acquire(&mgr->gen);
+
+    if (JATTR_LIKELY(t_jlog_gen == gen))
+        return tb;
+
+    /* 上一次初始化时创建的缓冲已经被摘除，由本线程释放 */
+    if (tb) {
+        while (!jatomic32_load_acquire(&tb->detached))
+            jthread_yield();
+        jheap_free(tb);
+        tb = NULL;
+    }
+
+    if (_jlog_lock_enter(mgr) < 0)
+        return NULL;
+    jthread_mutex_lock(&mgr->mtx);
+    gen = mgr->gen;
+    if (mgr->inited && mgr->tbuf_size > 0) {
+        tb = (jlog_tbuf_t *)jheap_malloc(sizeof(jlog_tbuf_t) + mgr->tbuf_size);
+        if (tb) {
+            memset(tb, 0, sizeof(jlog_tbuf_t));
+            tb->size = (uint32_t)mgr->tbuf_size;
+            tb->next = mgr->tbufs;
+            mgr->tbufs = tb;
+        }
+    }
+    jthread_mutex_unlock(&mgr->mtx);
+    _jlog_lock_leave(mgr);
+
+    t_jlog_gen = gen;
+    t_jlog_tbuf = tb;
+    if (mgr->key_inited)
+        jthread_key_set(mgr->key, tb);
+    return tb;
+}
+
+/* 在线程缓冲中预留一条最长res的记录，成功时置忙碌状态，返回记录; 已反初始化返回NULL */
+static jlog_trec_t *_jlog_trec_reserve(jlog_tbuf_t *tb, int res)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    uint32_t need = (uint32_t)JLOG_TREC_SIZE(res);
+    uint32_t mask = tb->size - 1;
+    uint32_t w = tb->widx, tail = 0;
+
+    jatomic32_store(&tb->busy, 1);
+    jatomic_fence();
+    for (;;) {
+        if (JATTR_UNLIKELY(t_jlog_gen != jatomic32_load(&mgr->gen) || !mgr->inited)) {
+            jatomic32_store_release(&tb->busy, 0);
+            return NULL;
+        }
+        tail = tb->size - (w & mask);
+        if (tb->size - (w - jatomic32_load_acquire(&tb->ridx)) >= (tail < need ? tail + need : need))
+            break;
+        jthread_cond_signal(&mgr->cond);
+        jthread_yield();
+    }
+
+    if (tail < need) {
+        /* 剩余的连续空间不够，放置回绕标记，从缓冲开头写 */
+        ((jlog_trec_t *)(tb->buf + (w & mask)))->len = 0;
+        w += tail;
+    }
+    return (jlog_trec_t *)(tb->buf + (w & mask));
+}
+
+/* 提交预留的记录，发布写入位置并清除忙碌状态 */
+static void _jlog_trec_commit(jlog_tbuf_t *tb, jlog_trec_t *rec, uint32_t tlen, int trunc)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    uint32_t mask = tb->size - 1;
+    uint32_t w = tb->widx;
+    uint32_t pos = (uint32_t)((char *)rec - tb->buf);
+    uint32_t wake = (uint32_t)mgr->jbuf.wake;
+    uint32_t step = wake >> 3;
+    uint32_t old = w, add = 0, fill = 0;
+
+    if ((w & mask) != pos)
+        w += tb->size - (w & mask);
+    rec->len = (uint32_t)JLOG_TREC_SIZE(tlen & ~JLOG_TREC_BIN);
+    rec->tlen = tlen;
+    rec->nsec = jtime_mononsec_get();
+    if (trunc)
+        jatomic32_fetch_add(&tb->truncs, 1);
+    w += rec->len;
+    jatomic32_store_release(&tb->widx, w);
+    jatomic32_store_release(&tb->busy, 0);
+
+    /*
+     * 先在本线程累加，积攒到唤醒阈值的1/8(不超过本线程缓冲的1/4)才累加到共享积压计数，
+     * 避免每条日志都写共享缓存行；累加后总积压达到唤醒阈值就唤醒写线程，
+     * 和共享缓冲一样不只在越过阈值时唤醒，写线程还没开始等待时丢失的唤醒会被后面的补上
+     */
+    tb->pend += w - old;
+    if (step > tb->size >> 2)
+        step = tb->size >> 2;
+    if (tb->pend >= step) {
+        add = tb->pend;
+        tb->pend = 0;
+        fill = jatomic32_fetch_add(&mgr->tpend, add);
+        if (fill + add >= wake) {
+            jthread_cond_signal(&mgr->cond);
+            return;
+        }
+    }
+
+    /* 唤醒阈值大于本线程缓冲时，本线程缓冲过半也唤醒，避免等到满了才写；缓冲满时预留处会再唤醒 */
+    fill = w - jatomic32_load_acquire(&tb->ridx);
+    if (fill >= tb->size >> 1 && fill - (w - old) < tb->size >> 1)
+        jthread_cond_signal(&mgr->cond);
+}
+
 int jlog_vprint(int level, const jlog_str_t *module, const jlog_str_t *type, const char *fmt, va_list ap)
 {
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jbuf_t *jbuf = &mgr->jbuf;
+    jlog_tbuf_t *tb = NULL;
+    jlog_trec_t *rec = NULL;
+    char *p = NULL;
     int len = 0, len1 = 0, len2 = 0, rlen = 0;
 
     if (level > mgr->jcfg.level)
@@ -335,22 +867,47 @@ int jlog_vprint(int level, const jlog_str_t *module, const jlog_str_t *type, con
     jtime_utcmtime_geta(&mt);
 #endif
 
+    /* 优先无锁写入本线程的缓冲，单条日志过长时写入共享缓冲 */
+    len = jbuf->res;
+    tb = jlog_tbuf_get();
+    if (tb && JLOG_TREC_SIZE(len) * 2 <= (int)tb->size && (rec = _jlog_trec_reserve(tb, len))) {
+        p = (char *)(rec + 1);
+#if JLOG_TIMESTAMP
+        _jlog_tbuf_update(&tb->tsec, tb->tbuf, &mt, mgr->jcfg.zone_sec);
+        len1 = jlog_head(tb->tbuf, level, module, type, p, len);
+#else
+        len1 = jlog_head(NULL, level, module, type, p, len);
+#endif
+        len2 = vsnprintf(p + len1, len - len1, fmt, ap);
+        if (len2 < 0)
+            len2 = 0;
+        rlen = len2 > len - len1 - 1;
+        if (rlen)
+            len2 = len - len1 - 1;
+        p[len1 + len2] = '\n';
+        _jlog_trec_commit(tb, rec, len1 + len2 + 1, rlen);
+        return len2;
+    }
+
+    if (_jlog_lock_enter(mgr) < 0)
+        return vprintf(fmt, ap);
 next:
     jthread_mutex_lock(&mgr->mtx);
     if (!mgr->inited) {
         jthread_mutex_unlock(&mgr->mtx);
+        _jlog_lock_leave(mgr);
         len2 = vprintf(fmt, ap);
         return len2;
     }
 
     len = _jlog_wsize_get(jbuf);
-    if (len < jbuf->res) {
+    if (len < jbuf->res || (mgr->bbuf.sinks && _jlog_wsize_get(&mgr->bbuf) < mgr->bbuf.res)) {
         jthread_mutex_unlock(&mgr->mtx);
         jthread_cond_signal(&mgr->cond);
         goto next;
     } else {
 #if JLOG_TIMESTAMP
-        _jlog_tbuf_update(&mt);
+        _jlog_tbuf_update(&jbuf->tsec, jbuf->tbuf, &mt, mgr->jcfg.zone_sec);
         len1 = jlog_head(jbuf->tbuf, level, module, type, jbuf->buf + jbuf->widx, len);
 #else
         len1 = jlog_head(NULL, level, module, type, jbuf->buf + jbuf->widx, len);
@@ -361,14 +918,15 @@ next:
             /* 打印可能用完了空闲的buf，日志可能被截断，设置日志截断状态 */
             ++jbuf->truncs;
         }
-        _jlog_widx_update(jbuf, len1 + len2 + 1);
+        _jlog_text_commit(mgr, len1 + len2 + 1);
     }
 
-    rlen = _jlog_rsize_get(jbuf);
+    rlen = _jlog_rsize_get(jbuf) + _jlog_rsize_get(&mgr->bbuf);
     jthread_mutex_unlock(&mgr->mtx);
 
     if (rlen >= jbuf->wake)
         jthread_cond_signal(&mgr->cond);
+    _jlog_lock_leave(mgr);
 
     return len2;
 }
@@ -388,6 +946,9 @@ int jlog_write(int level, const jlog_str_t *module, const jlog_str_t *type, cons
 {
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jbuf_t *jbuf = &mgr->jbuf;
+    jlog_tbuf_t *tb = NULL;
+    jlog_trec_t *rec = NULL;
+    char *p = NULL;
     int len = 0, len1 = 0, len2 = 0, rlen = 0;
 
     if (level > mgr->jcfg.level)
@@ -402,21 +963,41 @@ int jlog_write(int level, const jlog_str_t *module, const jlog_str_t *type, cons
     jtime_utcmtime_geta(&mt);
 #endif
 
+    len = jbuf->res;
+    tb = jlog_tbuf_get();
+    if (tb && JLOG_TREC_SIZE(len) * 2 <= (int)tb->size && (rec = _jlog_trec_reserve(tb, len))) {
+        p = (char *)(rec + 1);
+#if JLOG_TIMESTAMP
+        _jlog_tbuf_update(&tb->tsec, tb->tbuf, &mt, mgr->jcfg.zone_sec);
+        len1 = jlog_head(tb->tbuf, level, module, type, p, len);
+#else
+        len1 = jlog_head(NULL, level, module, type, p, len);
+#endif
+        len2 = count <= len - len1 - 1 ? count : len - len1 - 1;
+        memcpy(p + len1, buf, len2);
+        p[len1 + len2] = '\n';
+        _jlog_trec_commit(tb, rec, len1 + len2 + 1, len2 < count);
+        return len2;
+    }
+
+    if (_jlog_lock_enter(mgr) < 0)
+        return 0;
 next:
     jthread_mutex_lock(&mgr->mtx);
     if (!mgr->inited) {
         jthread_mutex_unlock(&mgr->mtx);
+        _jlog_lock_leave(mgr);
         return 0;
     }
 
     len = _jlog_wsize_get(jbuf);
-    if (len < jbuf->res) {
+    if (len < jbuf->res || (mgr->bbuf.sinks && _jlog_wsize_get(&mgr->bbuf) < mgr->bbuf.res)) {
         jthread_mutex_unlock(&mgr->mtx);
         jthread_cond_signal(&mgr->cond);
         goto next;
     } else {
 #if JLOG_TIMESTAMP
-        _jlog_tbuf_update(&mt);
+        _jlog_tbuf_update(&jbuf->tsec, jbuf->tbuf, &mt, mgr->jcfg.zone_sec);
         len1 = jlog_head(jbuf->tbuf, level, module, type, jbuf->buf + jbuf->widx, len);
 #else
         len1 = jlog_head(NULL, level, module, type, jbuf->buf + jbuf->widx, len);
@@ -428,87 +1009,730 @@ next:
             /* 打印用完了空闲的buf，日志可能被截断，设置日志截断状态 */
             ++jbuf->truncs;
         }
-        _jlog_widx_update(jbuf, len1 + len2 + 1);
+        _jlog_text_commit(mgr, len1 + len2 + 1);
     }
 
-    rlen = _jlog_rsize_get(jbuf);
+    rlen = _jlog_rsize_get(jbuf) + _jlog_rsize_get(&mgr->bbuf);
     jthread_mutex_unlock(&mgr->mtx);
 
     if (rlen >= jbuf->wake)
         jthread_cond_signal(&mgr->cond);
+    _jlog_lock_leave(mgr);
 
     return len2;
 }
 
-static char *jlog_buf_get(int *len)
+/* 解析'%'之后的转换说明，成功返回转换说明之后的位置; 不支持延迟格式化返回NULL */
+static const char *_jlog_bspec_parse(const char *p, jlog_bspec_t *s)
+{
+    const char *start = p;
+    int lmod = 0;
+    unsigned char sign = 0, trunc = 0;
+
+    s->flags = p;
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'')
+        ++p;
+    s->flen = (int)(p - s->flags);
+
+    s->width = p;
+    if (*p == '*') {
+        ++p;
+        s->wlen = -1;
+    } else {
+        while (*p >= '0' && *p <= '9')
+            ++p;
+        s->wlen = (int)(p - s->width);
+    }
+
+    s->prec = NULL;
+    s->plen = 0;
+    if (*p == '.') {
+        s->prec = ++p;
+        if (*p == '*') {
+            ++p;
+            s->plen = -1;
+        } else {
+            while (*p >= '0' && *p <= '9')
+                ++p;
+            s->plen = (int)(p - s->prec);
+        }
+    }
+
+    switch (*p) {
+    case 'h': lmod = p[1] == 'h' ? 'H' : 'h'; break;
+    case 'l': lmod = p[1] == 'l' ? 'q' : 'l'; break;
+    case 'q': case 'j': case 'z': case 't': case 'L': lmod = *p; break;
+    default: break;
+    }
+    if (lmod)
+        p += (lmod == 'H' || (lmod == 'q' && *p == 'l')) ? 2 : 1;
+
+    s->conv = *p++;
+    switch (s->conv) {
+    case 'o': case 'u': case 'x': case 'X':
+        sign = JLOG_BARG_UNSIGNED;
+        /* fall through */
+    case 'd': case 'i':
+        switch (lmod) {
+        case 'H': trunc = JLOG_BARG_CHAR; s->arg = JLOG_BARG_INT; break;
+        case 'h': trunc = JLOG_BARG_SHORT; s->arg = JLOG_BARG_INT; break;
+        case 0:   s->arg = JLOG_BARG_INT; break;
+        case 'l': s->arg = JLOG_BARG_LONG; break;
+        case 'q': s->arg = JLOG_BARG_LLONG; break;
+        case 'j': s->arg = JLOG_BARG_INTMAX; break;
+        case 'z': s->arg = JLOG_BARG_SIZE; break;
+        case 't': s->arg = JLOG_BARG_PTRDIFF; break;
+        default: return NULL;
+        }
+        s->arg |= sign | trunc;
+        break;
+    case 'c':
+        if (lmod)
+            return NULL;
+        s->arg = JLOG_BARG_INT;
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        if (lmod && lmod != 'l')
+            return NULL;
+        s->arg = JLOG_BARG_DOUBLE;
+        break;
+    case 'p':
+        if (lmod)
+            return NULL;
+        s->arg = JLOG_BARG_PTR;
+        break;
+    case 's':
+        if (lmod)
+            return NULL;
+        s->arg = JLOG_BARG_STR;
+        break;
+    default:
+        return NULL;
+    }
+
+    if (p - start > JLOG_BSPEC_MAX - 8)
+        return NULL;
+    return p;
+}
+
+/* 注册格式串，解析出每个参数的类型 */
+static void _jlog_bfmt_register(jlog_bfmt_t *bfmt)
+{
+    const char *p = bfmt->fmt;
+    jlog_bspec_t s;
+    int n = 0, ok = 1, prec = 0, i = 0;
+    uint32_t state = 0;
+
+    if (!jatomic32_cas(&bfmt->state, &state, 1))
+        return;
+
+    while ((p = strchr(p, '%'))) {
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        if (!(p = _jlog_bspec_parse(p + 1, &s))
+            || n + (s.wlen < 0) + (s.plen < 0) + 1 > JLOG_BARG_MAX) {
+            ok = 0;
+            break;
+        }
+        if (s.wlen < 0)
+            bfmt->args[n++] = JLOG_BARG_INT;
+        if (s.plen < 0)
+            bfmt->args[n++] = JLOG_BARG_INT;
+        if (s.arg == JLOG_BARG_STR) {
+            /* 记录精度，调用时最多只读取精度个字符，参数可以不以'\0'结尾 */
+            prec = -1;
+            if (s.plen < 0) {
+                prec = -2;
+            } else if (s.prec) {
+                for (i = 0, prec = 0; i < s.plen && prec < 0x7FFF; ++i)
+                    prec = prec * 10 + s.prec[i] - '0';
+                if (prec > 0x7FFF)
+                    prec = 0x7FFF;
+            }
+            bfmt->precs[n] = (short)prec;
+        }
+        bfmt->args[n++] = s.arg;
+    }
+
+    if (!ok) {
+        SLOG_WARN("jlog: format at %s:%d can't be deferred, fall back to jlog_vprint\n", bfmt->file, bfmt->line);
+        jatomic32_store_release(&bfmt->state, 3);
+    } else {
+        bfmt->nargs = n;
+        jatomic32_store_release(&bfmt->state, 2);
+    }
+}
+
+int jlog_bprint_(jlog_bfmt_t *bfmt, int level, const jlog_str_t *module, const jlog_str_t *type, ...)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_tbuf_t *tb = NULL;
+    jlog_trec_t *rec = NULL;
+    jlog_brec_t *brec = NULL;
+    char *p = NULL, *end = NULL;
+    const char *str = NULL, *q = NULL;
+    uint64_t v = 0;
+    double d = 0;
+    int len = 0, i = 0, trunc = 0, prec = 0, max = 0;
+    va_list ap;
+
+    if (level > mgr->jcfg.level)
+        return 0;
+
+    if (!mgr->inited) {
+        return 0;
+    }
+
+    if (JATTR_UNLIKELY(jatomic32_load_acquire(&bfmt->state) < 2))
+        _jlog_bfmt_register(bfmt);
+
+    va_start(ap, type);
+    /* 除了记录头和参数槽，字符串内容也能存满单条日志的最大长度，截断的位置和 jlog_vprint 相同 */
+    len = mgr->jbuf.res + (int)sizeof(jlog_brec_t) + JLOG_BARG_MAX * 16;
+    tb = jlog_tbuf_get();
+    if (jatomic32_load_acquire(&bfmt->state) != 2 || !tb || JLOG_TREC_SIZE(len) * 2 > (int)tb->size
+        || !(rec = _jlog_trec_reserve(tb, len))) {
+        jlog_vprint(level, module, type, bfmt->fmt, ap);
+        va_end(ap);
+        return 0;
+    }
+
+    brec = (jlog_brec_t *)(rec + 1);
+    brec->bfmt = bfmt;
+    brec->module = module;
+    brec->type = type;
+    brec->level = level;
+#if JLOG_TIMESTAMP
+    jtime_utcmtime_geta(&brec->mt);
+#endif
+
+    /* 参数按8字节槽存储，整数统一扩展为64位，字符串存储长度和带'\0'的内容 */
+    p = (char *)(brec + 1);
+    end = (char *)brec + (len & ~7);
+    for (i = 0; i < bfmt->nargs; ++i) {
+        if (end - p < 8) {
+            trunc = 1;
+            break;
+        }
+        switch (bfmt->args[i]) {
+        case JLOG_BARG_INT:                                             v = (uint64_t)(int64_t)va_arg(ap, int); break;
+        case JLOG_BARG_INT | JLOG_BARG_CHAR:                            v = (uint64_t)(int64_t)(signed char)va_arg(ap, int); break;
+        case JLOG_BARG_INT | JLOG_BARG_SHORT:                           v = (uint64_t)(int64_t)(short)va_arg(ap, int); break;
+        case JLOG_BARG_INT | JLOG_BARG_UNSIGNED:                        v = (uint64_t)va_arg(ap, unsigned int); break;
+        case JLOG_BARG_INT | JLOG_BARG_CHAR | JLOG_BARG_UNSIGNED:       v = (uint64_t)(unsigned char)va_arg(ap, unsigned int); break;
+        case JLOG_BARG_INT | JLOG_BARG_SHORT | JLOG_BARG_UNSIGNED:      v = (uint64_t)(unsigned short)va_arg(ap, unsigned int); break;
+        case JLOG_BARG_LONG:                                            v = (uint64_t)(int64_t)va_arg(ap, long); break;
+        case JLOG_BARG_LONG | JLOG_BARG_UNSIGNED:                       v = (uint64_t)va_arg(ap, unsigned long); break;
+        case JLOG_BARG_LLONG:
+        case JLOG_BARG_LLONG | JLOG_BARG_UNSIGNED:                      v = (uint64_t)va_arg(ap, unsigned long long); break;
+        case JLOG_BARG_INTMAX:
+        case JLOG_BARG_INTMAX | JLOG_BARG_UNSIGNED:                     v = (uint64_t)va_arg(ap, uintmax_t); break;
+        case JLOG_BARG_SIZE:                                            v = (uint64_t)(int64_t)va_arg(ap, ssize_t); break;
+        case JLOG_BARG_SIZE | JLOG_BARG_UNSIGNED:                       v = (uint64_t)va_arg(ap, size_t); break;
+        case JLOG_BARG_PTRDIFF:                                         v = (uint64_t)(int64_t)va_arg(ap, ptrdiff_t); break;
+        case JLOG_BARG_PTRDIFF | JLOG_BARG_UNSIGNED:                    v = (uint64_t)(size_t)va_arg(ap, ptrdiff_t); break;
+        case JLOG_BARG_PTR:                                             v = (uint64_t)(uintptr_t)va_arg(ap, void *); break;
+        case JLOG_BARG_DOUBLE:
+            d = va_arg(ap, double);
+            memcpy(p, &d, 8);
+            p += 8;
+            continue;
+        case JLOG_BARG_STR:
+            if (end - p < 16) {
+                trunc = 1;
+                goto out;
+            }
+            str = va_arg(ap, const char *);
+            if (!str)
+                str = "(null)";
+            /* 有精度时字符串可以不以'\0'结尾，最多读取精度个字符，'*'精度是刚存储的前一个参数 */
+            max = (int)(end - p - 9);
+            prec = bfmt->precs[i] == -2 ? (int)(int64_t)v : bfmt->precs[i];
+            if (prec >= 0 && prec < max) {
+                q = (const char *)memchr(str, '\0', prec);
+                v = q ? (uint64_t)(q - str) : (uint64_t)prec;
+            } else {
+                q = (const char *)memchr(str, '\0', max);
+                v = q ? (uint64_t)(q - str) : (uint64_t)max;
+                if (!q && prec != max)
+                    trunc = 1;
+            }
+            memcpy(p, &v, 8);
+            memcpy(p + 8, str, (size_t)v);
+            p[8 + v] = '\0';
+            p += 8 + ((v + 8) & ~(uint64_t)7);
+            continue;
+        default:
+            v = 0;
+            break;
+        }
+        memcpy(p, &v, 8);
+        p += 8;
+    }
+out:
+    va_end(ap);
+
+    brec->alen = (int)(p - (char *)(brec + 1));
+    _jlog_trec_commit(tb, rec, JLOG_TREC_BIN | (uint32_t)(p - (char *)brec), trunc);
+    return brec->alen;
+}
+
+/*
+ * 格式化延迟格式化的记录，返回写入长度（含换行符）; 日志可能被截断时设置trunc
+ * tc是时间戳字符串的缓存，写线程用共享缓冲的，解码二进制文件时用自己的
+ */
+static int _jlog_brec_format(const jlog_brec_t *brec, jlog_jbuf_t *tc, int zone, char *buf, int len, int *trunc)
+{
+    const char *p = brec->bfmt->fmt, *q = NULL;
+    const char *a = (const char *)(brec + 1), *aend = a + brec->alen;
+    char spec[JLOG_BSPEC_MAX], *sp = NULL;
+    jlog_bspec_t s;
+    uint64_t v = 0;
+    double d = 0;
+    int n = 0, w = 0, max = len - 1;
+
+#if JLOG_TIMESTAMP
+    _jlog_tbuf_update(&tc->tsec, tc->tbuf, &brec->mt, zone);
+    n = jlog_head(tc->tbuf, brec->level, brec->module, brec->type, buf, len);
+#else
+    (void)tc;
+    (void)zone;
+    n = jlog_head(NULL, brec->level, brec->module, brec->type, buf, len);
+#endif
+
+    while (n < max && *p) {
+        q = strchr(p, '%');
+        w = q ? (int)(q - p) : (int)strlen(p);
+        if (w > max - n) {
+            w = max - n;
+            *trunc = 1;
+        }
+        memcpy(buf + n, p, w);
+        n += w;
+        if (!q || n == max)
+            break;
+        if (q[1] == '%') {
+            buf[n++] = '%';
+            p = q + 2;
+            continue;
+        }
+
+        p = _jlog_bspec_parse(q + 1, &s);
+        sp = spec;
+        *sp++ = '%';
+        memcpy(sp, s.flags, s.flen);
+        sp += s.flen;
+        if (s.wlen < 0) {
+            if (aend - a < 8)
+                break;
+            memcpy(&v, a, 8);
+            a += 8;
+            sp += snprintf(sp, spec + sizeof(spec) - sp, (int64_t)v < 0 ? "-%d" : "%d", (int)((int64_t)v < 0 ? -(int64_t)v : (int64_t)v));
+        } else {
+            memcpy(sp, s.width, s.wlen);
+            sp += s.wlen;
+        }
+        if (s.plen < 0) {
+            if (aend - a < 8)
+                break;
+            memcpy(&v, a, 8);
+            a += 8;
+            if ((int64_t)v >= 0)
+                sp += snprintf(sp, spec + sizeof(spec) - sp, ".%d", (int)v);
+        } else if (s.prec) {
+            *sp++ = '.';
+            memcpy(sp, s.prec, s.plen);
+            sp += s.plen;
+        }
+        if ((s.arg & JLOG_BARG_KIND) <= JLOG_BARG_PTRDIFF && s.conv != 'c') {
+            *sp++ = 'l';
+            *sp++ = 'l';
+        }
+        *sp++ = s.conv;
+        *sp = '\0';
+
+        if (aend - a < 8)
+            break;
+        memcpy(&v, a, 8);
+        a += 8;
+        switch (s.arg & JLOG_BARG_KIND) {
+        case JLOG_BARG_DOUBLE:
+            memcpy(&d, &v, 8);
+            w = snprintf(buf + n, len - n, spec, d);
+            break;
+        case JLOG_BARG_PTR:
+            w = snprintf(buf + n, len - n, spec, (void *)(uintptr_t)v);
+            break;
+        case JLOG_BARG_STR:
+            w = snprintf(buf + n, len - n, spec, a);
+            a += (v + 8) & ~(uint64_t)7;
+            break;
+        default:
+            if (s.conv == 'c')
+                w = snprintf(buf + n, len - n, spec, (int)v);
+            else if (s.arg & JLOG_BARG_UNSIGNED)
+                w = snprintf(buf + n, len - n, spec, (unsigned long long)v);
+            else
+                w = snprintf(buf + n, len - n, spec, (long long)v);
+            break;
+        }
+        if (w < 0)
+            w = 0;
+        if (w > max - n) {
+            w = max - n;
+            *trunc = 1;
+        }
+        n += w;
+    }
+
+    buf[n++] = '\n';
+    return n;
+}
+
+/* 返回线程缓冲中最早的一条记录，跳过回绕标记; 没有记录返回NULL */
+static inline jlog_trec_t *_jlog_tbuf_front(jlog_tbuf_t *tb)
+{
+    jlog_trec_t *rec = NULL;
+
+    while (tb->ridx != tb->wsnap) {
+        rec = (jlog_trec_t *)(tb->buf + (tb->ridx & (tb->size - 1)));
+        if (rec->len)
+            return rec;
+        jatomic32_store_release(&tb->ridx, tb->ridx + tb->size - (tb->ridx & (tb->size - 1)));
+    }
+    return NULL;
+}
+
+/* 把各线程缓冲中的日志按时间顺序合并到共享缓冲，调用者持有缓冲互斥锁 */
+static void _jlog_tbuf_merge(void)
 {
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jbuf_t *jbuf = &mgr->jbuf;
-    char *buf = NULL;
+    jlog_jbuf_t *bbuf = &mgr->bbuf;
+    jlog_tbuf_t *tb = NULL, *min = NULL, **pp = NULL;
+    jlog_trec_t *rec = NULL, *mrec = NULL;
+    const jlog_brec_t *brec = NULL;
+    int len = 0, trunc = 0, text = 0;
+    uint32_t seen = 0;
+
+    if (!mgr->tbufs)
+        return;
+
+    /* 先读积压计数再取快照，计数中的字节在快照之前已发布，合并后减去它不会减多 */
+    seen = jatomic32_load_acquire(&mgr->tpend);
+    for (tb = mgr->tbufs; tb; tb = tb->next)
+        tb->wsnap = jatomic32_load_acquire(&tb->widx);
+
+    for (;;) {
+        min = NULL;
+        mrec = NULL;
+        for (tb = mgr->tbufs; tb; tb = tb->next) {
+            rec = _jlog_tbuf_front(tb);
+            if (rec && (!mrec || rec->nsec < mrec->nsec)) {
+                min = tb;
+                mrec = rec;
+            }
+        }
+        if (!min)
+            break;
+        len = mrec->tlen & JLOG_TREC_BIN ? 0 : (int)mrec->tlen;
+        if (_jlog_wsize_get(jbuf) < (len > jbuf->res ? len : jbuf->res))
+            break;
+        if (bbuf->sinks && _jlog_wsize_get(bbuf) < bbuf->res)
+            break;
+
+        if (len) {
+            memcpy(jbuf->buf + jbuf->widx, mrec + 1, len);
+            text = 1;
+        } else {
+            /* 二进制文件直接存储参数，只有文本输出目标或记录太大时才格式化 */
+            brec = (const jlog_brec_t *)(mrec + 1);
+            text = !bbuf->sinks || _jlog_bin_brec(mgr, brec) < 0;
+            if (text || jbuf->sinks) {
+                trunc = 0;
+                len = _jlog_brec_format(brec, jbuf, mgr->jcfg.zone_sec, jbuf->buf + jbuf->widx, jbuf->res, &trunc);
+                jbuf->truncs += trunc;
+            }
+        }
+        if (text) {
+            _jlog_text_commit(mgr, len);
+        } else if (len) {
+            _jlog_widx_update(jbuf, len);
+        }
+        jatomic32_store_release(&min->ridx, min->ridx + mrec->len);
+    }
+
+    if (seen)
+        jatomic32_fetch_add(&mgr->tpend, 0 - seen);
+
+    /* 释放所属线程已退出且读完的线程缓冲 */
+    pp = &mgr->tbufs;
+    while ((tb = *pp)) {
+        if (jatomic32_load_acquire(&tb->closed) && !jatomic32_load_acquire(&tb->busy)
+            && tb->ridx == jatomic32_load_acquire(&tb->widx)) {
+            *pp = tb->next;
+            jheap_free(tb);
+        } else {
+            pp = &tb->next;
+        }
+    }
+}
+
+/* 合并线程缓冲后返回线程缓冲中还未合并的字节数 */
+static uint32_t jlog_tbuf_pending(void)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_tbuf_t *tb = NULL;
+    uint32_t len = 0;
 
     jthread_mutex_lock(&mgr->mtx);
-    if (jbuf->widx > jbuf->ridx) {
-         buf = jbuf->buf + jbuf->ridx;
-         *len = jbuf->widx - jbuf->ridx;
-    } else if (jbuf->widx < jbuf->ridx) {
-         buf = jbuf->buf + jbuf->ridx;
-         *len = jbuf->tail - jbuf->ridx;
-    } else {
-        if (jbuf->tail) {
-            buf = jbuf->buf + jbuf->ridx;
-            *len = jbuf->tail - jbuf->ridx;
+    _jlog_tbuf_merge();
+    for (tb = mgr->tbufs; tb; tb = tb->next)
+        len += jatomic32_load_acquire(&tb->widx) - tb->ridx;
+    jthread_mutex_unlock(&mgr->mtx);
+
+    return len;
+}
+
+/* 读取位置前移len */
+static void _jlog_ridx_skip(jlog_jbuf_t *jbuf, int len)
+{
+    int tmp = 0;
+
+    if (jbuf->tail) {
+        tmp = jbuf->tail - jbuf->ridx;
+        if (len >= tmp) {
+            len -= tmp;
+            jbuf->ridx = 0;
+            jbuf->tail = 0;
+        }
+    }
+    jbuf->ridx += len;
+}
+
+/* 读取位置前移到最慢的输出目标处 */
+static void _jlog_ridx_update(jlog_jbuf_t *jbuf)
+{
+    int len = 0, max = 0, i = 0;
+
+    for (i = 0; i < JLOG_SINK_NUM; ++i) {
+        if ((jbuf->sinks & (1 << i)) && jbuf->pend[i] > max)
+            max = jbuf->pend[i];
+    }
+    len = _jlog_rsize_get(jbuf) - max;
+    if (len > 0)
+        _jlog_ridx_skip(jbuf, len);
+}
+
+/* 输出目标的待输出数据被截短，正在输出的结果作废，下次从新的读取位置开始 */
+static inline void _jlog_pend_clamp(jlog_mgr_t *mgr, jlog_jbuf_t *jbuf, int sink, int len)
+{
+    jbuf->pend[sink] = len;
+    jbuf->busy[sink] = 0;
+    mgr->jcfg.midline[sink] = 0;
+}
+
+/* 输出目标所在的缓冲，写二进制文件时文件从二进制缓冲输出 */
+static inline jlog_jbuf_t *_jlog_sink_jbuf(jlog_mgr_t *mgr, int sink)
+{
+    return (mgr->bbuf.sinks & (1 << sink)) ? &mgr->bbuf : &mgr->jbuf;
+}
+
+/*
+ * 获取输出目标未输出的数据，回绕时分为两段，返回段数，没有数据时返回0
+ * iov为NULL时只检查有没有数据，否则取出的数据标记为正在输出，直到jlog_buf_set确认
+ */
+static int jlog_buf_get(int sink, jfs_iovec_t iov[2])
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_jbuf_t *jbuf = NULL;
+    int total = 0, off = 0, seg = 0, cnt = 0;
+
+    jthread_mutex_lock(&mgr->mtx);
+    _jlog_tbuf_merge();
+    jbuf = _jlog_sink_jbuf(mgr, sink);
+    total = _jlog_rsize_get(jbuf);
+    if ((jbuf->sinks & (1 << sink)) && jbuf->pend[sink] > 0) {
+        if (jbuf->pend[sink] > total)
+            _jlog_pend_clamp(mgr, jbuf, sink, total);
+        if (!iov) {
+            jthread_mutex_unlock(&mgr->mtx);
+            return 1;
+        }
+        jbuf->busy[sink] = jbuf->pend[sink];
+        off = total - jbuf->pend[sink];
+        seg = jbuf->tail ? jbuf->tail - jbuf->ridx : jbuf->widx - jbuf->ridx;
+        if (off < seg) {
+            iov[cnt].iov_base = jbuf->buf + jbuf->ridx + off;
+            iov[cnt++].iov_len = seg - off;
+            if (jbuf->tail && jbuf->widx) {
+                iov[cnt].iov_base = jbuf->buf;
+                iov[cnt++].iov_len = jbuf->widx;
+            }
         } else {
-            *len = 0;
+            iov[cnt].iov_base = jbuf->buf + off - seg;
+            iov[cnt++].iov_len = jbuf->widx - (off - seg);
         }
     }
     jthread_mutex_unlock(&mgr->mtx);
 
-    return buf;
+    return cnt;
+}
+
+static void jlog_buf_set(int sink, int len)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_jbuf_t *jbuf = NULL;
+
+    jthread_mutex_lock(&mgr->mtx);
+    /* 取出后待输出数据被截短过，已输出的长度不再对应当前的读取位置 */
+    jbuf = _jlog_sink_jbuf(mgr, sink);
+    if (jbuf->busy[sink]) {
+        jbuf->pend[sink] -= len < jbuf->busy[sink] ? len : jbuf->busy[sink];
+        jbuf->busy[sink] = 0;
+        _jlog_ridx_update(jbuf);
+    }
+    jthread_mutex_unlock(&mgr->mtx);
 }
 
-static void jlog_buf_set(int len)
+/* 写线程产生的日志（溢出、性能信息）也写入缓冲，和其它日志一样输出到所有目标 */
+static void jlog_buf_put(const char *buf, int len)
 {
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jbuf_t *jbuf = &mgr->jbuf;
 
     jthread_mutex_lock(&mgr->mtx);
-    jbuf->ridx += len;
-    if (jbuf->ridx == jbuf->tail) {
-        jbuf->ridx = 0;
-        jbuf->tail = 0;
+    if (_jlog_wsize_get(jbuf) >= len) {
+        memcpy(jbuf->buf + jbuf->widx, buf, len);
+        _jlog_text_commit(mgr, len);
+    } else {
+        ++jbuf->loses;
     }
     jthread_mutex_unlock(&mgr->mtx);
 }
 
-static void jlog_buf_abandon(void)
+/* 分配二进制缓冲，保留大小要放下最长的延迟格式化记录加上它的格式串定义 */
+static int _jlog_bbuf_alloc(jlog_mgr_t *mgr)
+{
+    jlog_jbuf_t *bbuf = &mgr->bbuf;
+
+    if (bbuf->buf)
+        return 0;
+
+    bbuf->res = (mgr->jbuf.res << 1) + JLOG_RES_SIZE;
+    bbuf->size = mgr->jbuf.size;
+    if (bbuf->size < bbuf->res << JLOG_BUF_FACTOR)
+        bbuf->size = bbuf->res << JLOG_BUF_FACTOR;
+    bbuf->wake = mgr->jbuf.wake;
+    bbuf->buf = (char *)jheap_malloc(bbuf->size);
+    if (!bbuf->buf) {
+        memset(bbuf, 0, sizeof(jlog_jbuf_t));
+        return -1;
+    }
+    return 0;
+}
+
+/* 开启或关闭缓冲中的输出目标，新开启的目标从缓冲中未读的数据开始输出 */
+static void _jlog_sink_switch(jlog_mgr_t *mgr, jlog_jbuf_t *jbuf, int sink, int on)
+{
+    if (on) {
+        if (!(jbuf->sinks & (1 << sink))) {
+            jbuf->sinks |= 1 << sink;
+            _jlog_pend_clamp(mgr, jbuf, sink, _jlog_rsize_get(jbuf));
+        }
+    } else if (jbuf->sinks & (1 << sink)) {
+        jbuf->sinks &= ~(1 << sink);
+        _jlog_pend_clamp(mgr, jbuf, sink, 0);
+    }
+}
+
+/* 开启或关闭输出目标，文件只从共享缓冲或二进制缓冲中的一个输出 */
+static void jlog_buf_sink(int mask, int wanted)
 {
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jbuf_t *jbuf = &mgr->jbuf;
-    int len = 0, tmp = 0, rev = 0, max = 0;
+    jlog_fcfg_t *fcfg = &mgr->jcfg.fcfg;
+    int binary = 0, i = 0;
+
+    if (mask & JLOG_SINK_FILE) {
+        jthread_mutex_lock(&mgr->cmtx);
+        binary = fcfg->binary;
+        jthread_mutex_unlock(&mgr->cmtx);
+    }
 
     jthread_mutex_lock(&mgr->mtx);
+    for (i = 0; i < JLOG_SINK_NUM; ++i) {
+        if (!(mask & (1 << i)))
+            continue;
+        if (i == JLOG_TO_FILE - 1) {
+            /* 二进制缓冲分配失败时还是写文本文件 */
+            fcfg->bin = (wanted & (1 << i)) && binary && _jlog_bbuf_alloc(mgr) == 0;
+            _jlog_sink_switch(mgr, fcfg->bin ? jbuf : &mgr->bbuf, i, 0);
+            _jlog_sink_switch(mgr, fcfg->bin ? &mgr->bbuf : jbuf, i, wanted & (1 << i));
+        } else {
+            _jlog_sink_switch(mgr, jbuf, i, wanted & (1 << i));
+        }
+    }
+    _jlog_ridx_update(jbuf);
+    _jlog_ridx_update(&mgr->bbuf);
+    jthread_mutex_unlock(&mgr->mtx);
+}
+
+/* 返回二进制缓冲从读取位置开始不超过max的完整记录的长度 */
+static int _jlog_bin_drop(jlog_jbuf_t *bbuf, int max)
+{
+    int seg = bbuf->tail ? bbuf->tail - bbuf->ridx : bbuf->widx - bbuf->ridx;
+    int len = 0;
+
+    len = _jlog_bin_span(bbuf->buf + bbuf->ridx, seg, max, 0);
+    if (len == seg && bbuf->tail)
+        len += _jlog_bin_span(bbuf->buf, bbuf->widx, max - len, 0);
+    return len;
+}
+
+static void _jlog_buf_abandon(jlog_mgr_t *mgr, jlog_jbuf_t *jbuf)
+{
+    int len = 0, rev = 0, max = 0, i = 0;
+
     rev = jbuf->size >> JLOG_BUF_FACTOR;
     max = jbuf->size - (rev >> 1);
 
-    if (jbuf->widx > jbuf->ridx) {
-        len = jbuf->widx - jbuf->ridx;
-        if (len >= max) {
-            jbuf->ridx += rev;
-            ++jbuf->loses;
+    len = _jlog_rsize_get(jbuf);
+    if (len && len >= max) {
+        /* 网络线程在锁外发送取出的数据，丢弃不能越过正在输出的数据的开头 */
+        for (i = 0; i < JLOG_SINK_NUM; ++i) {
+            if (jbuf->busy[i] && len - jbuf->pend[i] < rev)
+                rev = len - jbuf->pend[i];
         }
-    } else {
-        len = jbuf->widx < jbuf->ridx ? jbuf->tail - jbuf->ridx + jbuf->widx : jbuf->tail;
-        if (len >= max) {
-            if (jbuf->ridx + rev < jbuf->tail) {
-                jbuf->ridx += rev;
-            } else {
-                tmp = jbuf->size - jbuf->ridx;
-                jbuf->ridx = tmp >= rev ? 0 : rev - tmp;
-                jbuf->tail = 0;
-            }
+        if (rev > 0 && jbuf == &mgr->bbuf) {
+            /* 二进制缓冲只丢弃完整的记录，丢弃的可能有格式串定义，之后用到的格式串重新写入定义 */
+            rev = _jlog_bin_drop(jbuf, rev);
+            if (!++mgr->bgen)
+                mgr->bgen = 1;
+        }
+        if (rev > 0) {
+            _jlog_ridx_skip(jbuf, rev);
             ++jbuf->loses;
         }
     }
+
+    /* 只有落后的输出目标丢失数据 */
+    len = _jlog_rsize_get(jbuf);
+    for (i = 0; i < JLOG_SINK_NUM; ++i) {
+        if (jbuf->pend[i] > len)
+            _jlog_pend_clamp(mgr, jbuf, i, len);
+    }
+}
+
+static void jlog_buf_abandon(void)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+
+    jthread_mutex_lock(&mgr->mtx);
+    _jlog_buf_abandon(mgr, &mgr->jbuf);
+    _jlog_buf_abandon(mgr, &mgr->bbuf);
     jthread_mutex_unlock(&mgr->mtx);
 }
 
@@ -517,13 +1741,17 @@ static int jlog_check_overflow(char *ebuf, int elen)
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jbuf_t *jbuf = &mgr->jbuf;
     jlog_jcfg_t *jcfg = &mgr->jcfg;
+    jlog_tbuf_t *tb = NULL;
     int loses = 0, truncs = 0, len = 0;
 
     jthread_mutex_lock(&mgr->mtx);
-    loses = jbuf->loses;
+    loses = jbuf->loses + mgr->bbuf.loses;
     truncs = jbuf->truncs;
     jbuf->loses = 0;
+    mgr->bbuf.loses = 0;
     jbuf->truncs = 0;
+    for (tb = mgr->tbufs; tb; tb = tb->next)
+        truncs += (int)jatomic32_exchange(&tb->truncs, 0);
     jthread_mutex_unlock(&mgr->mtx);
 
     if (loses + truncs) {
@@ -531,6 +1759,7 @@ static int jlog_check_overflow(char *ebuf, int elen)
         len = jlog_head(NULL, JLOG_LEVEL_WARN, &g_jlog_none, &g_of_type, ebuf, elen);
         len += snprintf(ebuf + len, elen - len, "{\"lose\":%d,\"truncate\":%d}\n", loses, truncs);
         JFS_WRERR(ebuf, len);
+        jlog_buf_put(ebuf, len);
     }
     return len;
 }
@@ -622,7 +1851,9 @@ static char *jlog_check_performance(int *len)
 static int jlog_filter_file(const char *fname, unsigned int flen, unsigned int ftype)
 {
 #define LOGFILE_SUFFIX      "_j.log"
-    return (flen == LOGFILE_STRLEN && strcmp(fname + JLOG_TS_SIZE, LOGFILE_SUFFIX) == 0);
+#define LOGBIN_SUFFIX       "_j.bin"
+    return (flen == LOGFILE_STRLEN && (strcmp(fname + JLOG_TS_SIZE, LOGFILE_SUFFIX) == 0
+        || strcmp(fname + JLOG_TS_SIZE, LOGBIN_SUFFIX) == 0));
 }
 
 static void jlog_free_file(void)
@@ -630,24 +1861,66 @@ static void jlog_free_file(void)
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_fcfg_t *fcfg = &mgr->jcfg.fcfg;
 
-    if (fcfg->fnames)
-        jheap_free(fcfg->fnames);
-    fcfg->fnames = NULL;
-    fcfg->fnum = 0;
-    fcfg->fcnt = 0;
+    if (fcfg->fnames)
+        jheap_free(fcfg->fnames);
+    fcfg->fnames = NULL;
+    fcfg->fnum = 0;
+    fcfg->fcnt = 0;
+}
+
+/*
+ * 写入二进制文件的文件头和所有已知格式串的定义，文件中的日志记录只引用格式串ID
+ * 链表只在头部插入，取得表头后遍历不用加锁
+ */
+static int jlog_bin_head(jfs_fd_t fd)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_bfmt_t *bfmts = NULL, *bfmt = NULL;
+    jlog_bhead_t *head = NULL;
+    const uint16_t endian = 1;
+    char *buf = NULL;
+    int len = (int)sizeof(jlog_bhead_t), pos = 0;
+
+    jthread_mutex_lock(&mgr->mtx);
+    bfmts = mgr->bfmts;
+    jthread_mutex_unlock(&mgr->mtx);
+
+    for (bfmt = bfmts; bfmt; bfmt = bfmt->next)
+        len += _jlog_bin_fmt(bfmt, NULL);
+    buf = (char *)jheap_malloc(len);
+    if (!buf)
+        return -1;
+
+    head = (jlog_bhead_t *)buf;
+    memset(head, 0, sizeof(jlog_bhead_t));
+    memcpy(head->magic, JLOG_BIN_MAGIC, sizeof(head->magic));
+    head->version = JLOG_BIN_VERSION;
+    head->endian = *(const uint8_t *)&endian ? 1 : 2;
+    head->stamp = JLOG_TIMESTAMP;
+    head->zone = mgr->jcfg.zone_sec;
+    head->res = mgr->jbuf.res;
+    pos = (int)sizeof(jlog_bhead_t);
+    for (bfmt = bfmts; bfmt; bfmt = bfmt->next)
+        pos += _jlog_bin_fmt(bfmt, buf + pos);
+
+    pos = (int)jfs_write(fd, buf, len);
+    jheap_free(buf);
+    return pos == len ? len : -1;
 }
 
 static int jlog_new_file(void)
 {
-#define LOGFILE_FORMAT      "%04hu-%02hhu-%02hhu_%02hhu-%02hhu-%02hhu-%03hu_j.log"
+#define LOGFILE_FORMAT      "%04hu-%02hhu-%02hhu_%02hhu-%02hhu-%02hhu-%03hu%s"
+#define LOGFILE_RETRY       1000        // 文件名已存在时顺延的最多次数
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jcfg_t *jcfg = &mgr->jcfg;
     jlog_fcfg_t *fcfg = &jcfg->fcfg;
     jfs_dirent_t *dirs = NULL;
     int num = 0, fmax = 0, i = 0, cnt = 0;
-    int dlen = 0;
+    int dlen = 0, fsize = 0, use_map = 0;
     char path[PATH_MAX_LEN];// 文件存储目录
     jtime_tm_t tm = {0};
+    jtime_mt_t mt = {0};
     jtime_t cur;
 
     cur = jtime_utcsec_get();
@@ -660,6 +1933,8 @@ static int jlog_new_file(void)
     fmax = fcfg->fcount;
     dlen = fcfg->dlen;
     memcpy(path, fcfg->path, dlen + 1);
+    fsize = fcfg->fsize;
+    use_map = fcfg->mmap;
     jthread_mutex_unlock(&mgr->cmtx);
 
     if (jfs_mkdir_(path, 0) < 0) {
@@ -710,15 +1985,48 @@ static int jlog_new_file(void)
         }
     }
 
+    if (fcfg->bin)
+        use_map = 0;
     jcfg->zone_sec = jtime_localutc_diff();
-    jtime_utctime_get(&tm, jcfg->zone_sec);
-    snprintf(path + dlen, PATH_MAX_LEN - dlen, LOGFILE_FORMAT,
-        tm.year, tm.month, tm.day, tm.hour, tm.min, tm.sec, tm.msec);
-    fcfg->fd = jfs_open(path, "a+");
+    jtime_utcmtime_get(&mt);
+    /* 文件名只精确到毫秒，同一毫秒内多次轮转时文件名顺延1毫秒，不打开(截断)已存在的文件 */
+    for (i = 0; i < LOGFILE_RETRY; ++i) {
+        jtime_mtime_to_tm(&mt, &tm, jcfg->zone_sec);
+        snprintf(path + dlen, PATH_MAX_LEN - dlen, LOGFILE_FORMAT,
+            tm.year, tm.month, tm.day, tm.hour, tm.min, tm.sec, tm.msec, fcfg->bin ? LOGBIN_SUFFIX : LOGFILE_SUFFIX);
+        fcfg->fd = jfs_open(path, use_map || fcfg->bin ? "w+x" : "a+x");
+        if (jfs_fd_valid(fcfg->fd) || !jfs_existed(path))
+            break;
+        if (++mt.msec == 1000) {
+            mt.msec = 0;
+            ++mt.sec;
+        }
+    }
     if (!jfs_fd_valid(fcfg->fd)) {
         path[dlen] = '\0';
         goto err;
     }
+    if (fcfg->bin) {
+        /* 二进制文件必须从文件头开始，写入失败时删除文件 */
+        fcfg->size = jlog_bin_head(fcfg->fd);
+        if (fcfg->size < 0) {
+            jfs_close(fcfg->fd);
+            fcfg->size = 0;
+            jfs_rmfile(path);
+            path[dlen] = '\0';
+            goto err;
+        }
+    }
+    if (use_map) {
+        /* 预分配整个文件并映射，写文件只是内存拷贝，由系统批量写回；映射失败时直接写文件 */
+        if (jfs_fallocate(fcfg->fd, fsize) == 0 && (fcfg->map = (char *)jfs_fdmap(fcfg->fd, fsize))) {
+            fcfg->mlen = fsize;
+            fcfg->synced = 0;
+            fcfg->last_sync = cur;
+        } else {
+            jfs_ftruncate(fcfg->fd, 0);
+        }
+    }
     if (fmax) {
         memcpy(fcfg->fnames[fcfg->fcnt].name, path + dlen, LOGFILE_STRLEN + 1);
         if (++fcfg->fcnt == fcfg->fnum)
@@ -731,6 +2039,21 @@ err:
     return -1;
 }
 
+/* 关闭当前log文件，映射写入的文件截断到实际写入的长度 */
+static void jlog_close_file(void)
+{
+    jlog_fcfg_t *fcfg = &g_jlog_mgr.jcfg.fcfg;
+
+    if (fcfg->map) {
+        jfs_shm_unmap(fcfg->map, fcfg->mlen);
+        fcfg->map = NULL;
+        fcfg->mlen = 0;
+        jfs_ftruncate(fcfg->fd, fcfg->size);
+    }
+    jfs_close(fcfg->fd);
+    fcfg->size = 0;
+}
+
 static inline int jlog_check_file(void)
 {
     if (jfs_fd_valid(g_jlog_mgr.jcfg.fcfg.fd))
@@ -738,44 +2061,147 @@ static inline int jlog_check_file(void)
     return jlog_new_file();
 }
 
-static inline int jlog_write_file(char *buf, int rlen)
+/* 映射写入，剩余空间放不下时只写入完整的行，返回写入的长度，为0时表示需要切换文件 */
+static int jlog_map_file(char *buf, int rlen)
 {
-    jlog_mgr_t *mgr = &g_jlog_mgr;
-    jlog_jcfg_t *jcfg = &mgr->jcfg;
-    int wlen = 0;
+    jlog_fcfg_t *fcfg = &g_jlog_mgr.jcfg.fcfg;
+    int wlen = fcfg->mlen - fcfg->size;
+    jtime_t cur;
 
-    wlen = jfs_write(jcfg->fcfg.fd, buf, rlen);
-    if (wlen < 0) {
-        jfs_close(jcfg->fcfg.fd);
-        jcfg->fcfg.size = 0;
-        return -1;
+    if (rlen > wlen) {
+        while (wlen > 0 && buf[wlen - 1] != '\n')
+            --wlen;
+        if (!wlen && !fcfg->size)
+            wlen = fcfg->mlen; /* 一行日志比整个文件还大 */
+    } else {
+        wlen = rlen;
     }
+    if (!wlen)
+        return 0;
 
-    jcfg->fcfg.size += wlen;
-    if (jcfg->fcfg.size < jcfg->fcfg.fsize)
-        return wlen;
+    memcpy(fcfg->map + fcfg->size, buf, wlen);
+    fcfg->size += wlen;
+
+    /* 写回从页对齐的位置开始，已发起写回的最后一页会重复包含 */
+    cur = jtime_utcsec_get();
+    if (fcfg->size - fcfg->synced >= JLOG_MSYNC_SIZE || cur != fcfg->last_sync) {
+        int start = fcfg->synced - fcfg->synced % (int)jfs_mirror_granularity();
+        jfs_file_flush(fcfg->map + start, fcfg->size - start);
+        fcfg->synced = fcfg->size;
+        fcfg->last_sync = cur;
+    }
+    return wlen;
+}
+
+/* 二进制记录写入文件，只在记录边界切换文件，返回写入的长度; 失败返回-1 */
+static int jlog_bin_file(const jfs_iovec_t *iov, int cnt)
+{
+    jlog_fcfg_t *fcfg = &g_jlog_mgr.jcfg.fcfg;
+    jfs_iovec_t vec[2];
+    int left = fcfg->fsize - fcfg->size, total = 0, wlen = 0, i = 0;
+
+    /* 只写到超过文件大小的那条记录结束，至少写一条记录 */
+    if (left <= 0)
+        left = 1;
+    for (i = 0; i < cnt && i < 2 && left > 0; ++i) {
+        vec[i].iov_base = iov[i].iov_base;
+        vec[i].iov_len = _jlog_bin_span((const char *)iov[i].iov_base, (int)iov[i].iov_len, left, 1);
+        total += (int)vec[i].iov_len;
+        left -= (int)vec[i].iov_len;
+    }
 
-    jfs_close(jcfg->fcfg.fd);
-    jcfg->fcfg.size = 0;
-    jcfg->fcfg.last_check = 0;
-    if (jlog_new_file() < 0)
+    wlen = (int)jfs_writev(fcfg->fd, vec, i);
+    if (wlen != total) {
+        /* 只写入一部分时截断到原来的长度，文件中只保留完整的记录 */
+        if (wlen > 0)
+            jfs_ftruncate(fcfg->fd, fcfg->size);
+        jlog_close_file();
         return -1;
+    }
 
+    fcfg->size += wlen;
+    if (fcfg->size >= fcfg->fsize) {
+        jlog_close_file();
+        fcfg->last_check = 0;
+        jlog_new_file();
+    }
     return wlen;
 }
 
+/* 内存段一次写入文件，返回写入的长度; 失败返回-1 */
+static int jlog_write_file(const jfs_iovec_t *iov, int cnt)
+{
+    jlog_fcfg_t *fcfg = &g_jlog_mgr.jcfg.fcfg;
+    int wlen = 0, total = 0, off = 0, i = 0;
+
+    if (fcfg->bin)
+        return jlog_bin_file(iov, cnt);
+
+    if (!fcfg->map) {
+        /* 只写到超过文件大小的那一行结束，其余的写入下一个文件 */
+        jfs_iovec_t vec[JLOG_IOV_MAX];
+        int left = fcfg->fsize - fcfg->size;
+        const char *p = NULL;
+
+        for (i = 0; i < cnt && left > 0; ++i) {
+            vec[i] = iov[i];
+            if ((int)vec[i].iov_len < left) {
+                left -= (int)vec[i].iov_len;
+            } else {
+                p = (const char *)memchr((char *)vec[i].iov_base + left - 1, '\n', vec[i].iov_len - left + 1);
+                if (p)
+                    vec[i].iov_len = p - (char *)vec[i].iov_base + 1;
+                left = 0;
+            }
+        }
+
+        wlen = (int)jfs_writev(fcfg->fd, vec, i);
+        if (wlen < 0) {
+            jlog_close_file();
+            return -1;
+        }
+
+        fcfg->size += wlen;
+        if (fcfg->size >= fcfg->fsize) {
+            jlog_close_file();
+            fcfg->last_check = 0;
+            jlog_new_file();
+        }
+        return wlen;
+    }
+
+    for (i = 0; i < cnt; ++i) {
+        for (off = 0; off < (int)iov[i].iov_len; ) {
+            wlen = jlog_map_file((char *)iov[i].iov_base + off, (int)iov[i].iov_len - off);
+            off += wlen;
+            total += wlen;
+            if (wlen && fcfg->size < fcfg->mlen)
+                continue;
+
+            /* 文件写满或剩余空间放不下下一行时切换文件，新文件映射失败时下次直接写 */
+            jlog_close_file();
+            fcfg->last_check = 0;
+            if (jlog_new_file() < 0)
+                return total ? total : -1;
+            if (!fcfg->map)
+                return total;
+        }
+    }
+
+    return total;
+}
+
 static int jlog_check_network(void)
 {
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jcfg_t *jcfg = &mgr->jcfg;
     jlog_ncfg_t *ncfg = &jcfg->ncfg;
-    char *buf = NULL;
     jtime_t cur;
 
     cur = jtime_utcsec_get();
     if (jsocket_fd_valid(ncfg->fd)) {
         int rlen = 0, wlen = 0;
-        if (cur - ncfg->last_send >= HEARTBEAT_SEC && !(buf = jlog_buf_get(&rlen))) {
+        if (cur - ncfg->last_send >= HEARTBEAT_SEC && !jlog_buf_get(JLOG_TO_NET - 1, NULL)) {
             char ebuf[128];
             jcfg->zone_sec = jtime_localutc_diff();
             rlen = jlog_head(NULL, JLOG_LEVEL_WARN, &g_jlog_none, &g_hb_type, ebuf, sizeof(ebuf));
@@ -797,6 +2223,8 @@ static int jlog_check_network(void)
         if (!jsocket_fd_valid(ncfg->fd)) {
             goto err;
         }
+        /* 对端接收慢时不阻塞，只有网络输出落后，缓冲满时丢弃它未发送的数据 */
+        jsocket_fd_nonblock_set(ncfg->fd);
         jcfg->zone_sec = jtime_localutc_diff();
     }
 
@@ -805,140 +2233,286 @@ err:
     return -1;
 }
 
-static void jlog_flush(void)
+/* 所有内存段一次输出到目标，返回输出的长度; 失败返回-1 */
+static int jlog_sink_output(int sink, const jfs_iovec_t *iov, int cnt)
 {
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jcfg_t *jcfg = &mgr->jcfg;
-    int rlen = 0, wlen = 0;
-    int send_flag = 0, change_flag = 0;
-    char *buf = NULL;
-    char ebuf[128];
-
-    jthread_mutex_lock(&mgr->cmtx);
-    if (jcfg->changed) {
-        jcfg->changed = 0;
-        change_flag = 1;
-    }
-    jthread_mutex_unlock(&mgr->cmtx);
-
-    if (change_flag) {
-        jfs_close(jcfg->fcfg.fd);
-        jcfg->fcfg.size = 0;
-        jcfg->fcfg.last_check = 0;
-        jlog_free_file();
-        jsocket_close(jcfg->ncfg.fd);
-        jcfg->ncfg.last_check = 0;
-        jcfg->mode = jcfg->wanted;
-    }
+    int wlen = 0, i = 0;
 
-    switch (jcfg->mode) {
+    switch (sink + 1) {
     case JLOG_TO_FILE:
-        if (jlog_check_file() < 0) {
-            break;
+        wlen = jlog_write_file(iov, cnt);
+        break;
+    case JLOG_TO_NET:
+        wlen = (int)jsocket_sendv_(jcfg->ncfg.fd, iov, cnt, 0);
+        if (wlen < 0)
+            jsocket_close(jcfg->ncfg.fd);
+        else if (wlen > 0)
+            jcfg->ncfg.last_send = jtime_utcsec_get();
+        break;
+    default:
+        wlen = (int)JFS_WROUTV(iov, cnt);
+        if (wlen < 0) {
+            /* 终端输出失败时丢弃 */
+            for (i = 0, wlen = 0; i < cnt; ++i)
+                wlen += (int)iov[i].iov_len;
         }
+        break;
+    }
+    return wlen;
+}
 
-        rlen = jlog_check_overflow(ebuf, sizeof(ebuf));
-        if (rlen) {
-            wlen = jlog_write_file(ebuf, rlen);
-            if (wlen < 0) {
-                break;
+/*
+ * 按输出目标的等级过滤后收集要输出的内存段，返回收集到的源数据长度（包括过滤掉的日志）
+ * 缓冲中的日志都是完整的行，按行首日志头中的等级字符过滤，连续的多行合并为一段
+ * ends记录每个内存段结束处对应的源数据长度
+ */
+static int jlog_sink_gather(int sink, const jfs_iovec_t *src, int cnt, jfs_iovec_t *out, int *ends, int *num)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_jcfg_t *jcfg = &mgr->jcfg;
+    int level = jcfg->levels[sink];
+    int base = 0, len = 0, pos = 0, start = 0, end = 0, i = 0, n = 0;
+    char *buf = NULL;
+    const char *p = NULL;
+
+    for (i = 0; i < cnt; ++i) {
+        buf = (char *)src[i].iov_base;
+        len = (int)src[i].iov_len;
+        pos = 0;
+        start = 0;
+
+        if (level && level < jcfg->level) {
+            while (pos < len) {
+                p = (const char *)memchr(buf + pos, '\n', len - pos);
+                end = p ? (int)(p - buf) + 1 : len;
+                if (i == 0 && pos == 0 && jcfg->midline[sink]) {
+                    /* 上次只输出了这一行的前一部分 */
+                } else if (end - pos > JLOG_LEVEL_POS && (p = strchr(g_level_str, buf[pos + JLOG_LEVEL_POS]))
+                    && *p && (int)(p - g_level_str) > level) {
+                    if (pos > start) {
+                        out[n].iov_base = buf + start;
+                        out[n].iov_len = pos - start;
+                        ends[n++] = base + pos;
+                        if (n == JLOG_IOV_MAX)
+                            goto out;
+                    }
+                    start = end;
+                }
+                pos = end;
             }
         }
 
-        buf = jlog_check_performance(&rlen);
-        if (buf) {
-            wlen = jlog_write_file(buf, rlen);
-            if (wlen < 0) {
-                break;
+        if (len > start) {
+            out[n].iov_base = buf + start;
+            out[n].iov_len = len - start;
+            ends[n++] = base + len;
+            if (n == JLOG_IOV_MAX && i + 1 < cnt) {
+                pos = len;
+                goto out;
             }
         }
+        base += len;
+    }
+    *num = n;
+    return base;
 
-        while ((buf = jlog_buf_get(&rlen))) {
-            wlen = jlog_write_file(buf, rlen < JLOG_WRITE_SIZE ? rlen : JLOG_WRITE_SIZE);
-            if (wlen < 0) {
-                break;
-            }
-            jlog_buf_set(wlen);
-        }
-        break;
+out:
+    *num = n;
+    return base + pos;
+}
 
-    case JLOG_TO_NET:
-        if (jlog_check_network() < 0) {
+/*
+ * 收集输出目标所有可读的数据，一次系统调用输出，返回处理的长度（包括过滤掉的日志）; 失败返回-1
+ * glen返回收集到的源数据长度，内存段超过JLOG_IOV_MAX时小于所有可读数据的长度
+ */
+static int jlog_sink_write(int sink, const jfs_iovec_t *src, int cnt, int *glen)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_jcfg_t *jcfg = &mgr->jcfg;
+    jfs_iovec_t out[JLOG_IOV_MAX];
+    int ends[JLOG_IOV_MAX];
+    int num = 0, wlen = 0, done = 0, i = 0, seg = 0;
+    const char *last = NULL;
+
+    if (sink + 1 == JLOG_TO_FILE && jcfg->fcfg.bin) {
+        /* 二进制记录在编码时已按等级过滤，直接输出 */
+        for (i = 0, *glen = 0; i < cnt; ++i)
+            *glen += (int)src[i].iov_len;
+        return jlog_sink_output(sink, src, cnt);
+    }
+
+    *glen = jlog_sink_gather(sink, src, cnt, out, ends, &num);
+    if (!num) {
+        jcfg->midline[sink] = 0;
+        return *glen;
+    }
+
+    wlen = jlog_sink_output(sink, out, num);
+    if (wlen < 0)
+        return -1;
+
+    /* 输出长度换算为源数据长度，只输出了一部分时下次从输出结束的位置继续 */
+    for (i = 0; i < num; ++i) {
+        seg = (int)out[i].iov_len;
+        if (wlen < seg)
             break;
-        }
+        wlen -= seg;
+        last = (const char *)out[i].iov_base + seg - 1;
+    }
+    if (i == num) {
+        done = *glen;
+    } else {
+        done = ends[i] - seg + wlen;
+        if (wlen)
+            last = (const char *)out[i].iov_base + wlen - 1;
+        else if (done)
+            last = "\n"; /* 停在一段的开头，前面是完整的行 */
+    }
+    if (last)
+        jcfg->midline[sink] = *last != '\n';
+    return done;
+}
 
-        send_flag = 0;
-        rlen = jlog_check_overflow(ebuf, sizeof(ebuf));
-        if (rlen) {
-            wlen = (int)jsocket_send_(jcfg->ncfg.fd, ebuf, rlen, 0);
-            if (wlen < 0) {
-                jsocket_close(jcfg->ncfg.fd);
-                break;
-            }
-            send_flag = 1;
-        }
+static void jlog_sink_flush(int sink)
+{
+    jfs_iovec_t iov[2];
+    int cnt = 0, wlen = 0, glen = 0;
+
+    while ((cnt = jlog_buf_get(sink, iov))) {
+        wlen = jlog_sink_write(sink, iov, cnt, &glen);
+        /* 输出失败也要清除正在输出的标记，否则缓冲满时无法丢弃 */
+        jlog_buf_set(sink, wlen > 0 ? wlen : 0);
+        if (wlen <= 0)
+            break;
+        /* 可读的数据都已输出时本轮结束，新数据等下一轮；网络只发送了一部分说明发送缓冲已满 */
+        if (wlen == (int)(iov[0].iov_len + (cnt > 1 ? iov[1].iov_len : 0)))
+            break;
+        if (wlen < glen && sink + 1 == JLOG_TO_NET)
+            break;
+    }
+}
 
-        buf = jlog_check_performance(&rlen);
-        if (buf) {
-            wlen = (int)jsocket_send_(jcfg->ncfg.fd, buf, rlen, 0);
-            if (wlen < 0) {
-                jsocket_close(jcfg->ncfg.fd);
-                break;
-            }
-            send_flag = 1;
-        }
+/* 获取由本线程处理的输出目标的配置变化，返回有变化的输出目标，wanted返回要开启的输出目标 */
+static int jlog_sink_changed(int mask, int *wanted)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_jcfg_t *jcfg = &mgr->jcfg;
+    int changed = 0;
 
-        while ((buf = jlog_buf_get(&rlen))) {
-            wlen = (int)jsocket_send_(jcfg->ncfg.fd, buf, rlen < JLOG_SEND_SIZE ? rlen : JLOG_SEND_SIZE, 0);
-            if (wlen < 0) {
-                jsocket_close(jcfg->ncfg.fd);
-                break;
-            } else if (wlen > 0) {
-                jlog_buf_set(wlen);
-            }
-            send_flag = 1;
-        }
-        if (send_flag)
-            jcfg->ncfg.last_send = jtime_utcsec_get();
-        break;
+    jthread_mutex_lock(&mgr->cmtx);
+    changed = jcfg->changed & mask;
+    jcfg->changed &= ~mask;
+    *wanted = jcfg->wanted;
+    jthread_mutex_unlock(&mgr->cmtx);
 
-    default:
-        rlen = jlog_check_overflow(ebuf, sizeof(ebuf));
-        if (rlen) {
-            JFS_WRERR(ebuf, rlen);
-        }
+    return changed;
+}
 
-        buf = jlog_check_performance(&rlen);
-        if (buf) {
-            JFS_WROUT(buf, rlen);
-        }
+static void jlog_flush_net(void)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_jcfg_t *jcfg = &mgr->jcfg;
+    int changed = 0, wanted = 0;
+
+    changed = jlog_sink_changed(JLOG_SINK_NET, &wanted);
+    if (changed) {
+        jsocket_close(jcfg->ncfg.fd);
+        jcfg->ncfg.last_check = 0;
+        jlog_buf_sink(changed, wanted);
+    }
+
+    if (!(wanted & JLOG_SINK_NET) || jlog_check_network() < 0)
+        return;
+    jlog_sink_flush(JLOG_TO_NET - 1);
+}
+
+static jthread_ret_t jlog_net_run(void *args)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_jcfg_t *jcfg = &mgr->jcfg;
+
+    jthread_setname("jlog_net");
+    while (mgr->nstate == 1) {
+        jthread_mutex_lock(&mgr->cmtx);
+        jthread_cond_mtimewait(&mgr->ncond, &mgr->cmtx, jcfg->flush_ms);
+        jthread_mutex_unlock(&mgr->cmtx);
+        jlog_flush_net();
+    }
+    jlog_flush_net();
+
+    jsocket_close(jcfg->ncfg.fd);
+    return (jthread_ret_t)0;
+}
+
+static void jlog_flush(void)
+{
+    jlog_mgr_t *mgr = &g_jlog_mgr;
+    jlog_jcfg_t *jcfg = &mgr->jcfg;
+    int rlen = 0, changed = 0, wanted = 0;
+    char *buf = NULL;
+    char ebuf[128];
+    jthread_attr_t attr = {0};
 
-        while ((buf = jlog_buf_get(&rlen))) {
-            JFS_WROUT(buf, rlen);
-            wlen = rlen;
-            jlog_buf_set(wlen);
+    changed = jlog_sink_changed(JLOG_SINK_TTY | JLOG_SINK_FILE, &wanted);
+    if (changed) {
+        if (changed & JLOG_SINK_FILE) {
+            /* 已有的日志先写入原来的文件，切换文件格式时不丢失 */
+            if (jfs_fd_valid(jcfg->fcfg.fd))
+                jlog_sink_flush(JLOG_TO_FILE - 1);
+            jlog_close_file();
+            jcfg->fcfg.last_check = 0;
+            jlog_free_file();
         }
-        break;
+        jlog_buf_sink(changed, wanted);
     }
+
+    /* 网络输出在单独的线程中，对端阻塞时不影响其它输出 */
+    if ((wanted & JLOG_SINK_NET) && !mgr->nstate && mgr->inited) {
+        attr.stack_size = JLOG_STACK_SIZE;
+        mgr->nstate = 1;
+        if (jthread_create(&mgr->ntid, &attr, jlog_net_run, NULL) != 0)
+            mgr->nstate = 0;
+    }
+
+    jlog_check_overflow(ebuf, sizeof(ebuf));
+    buf = jlog_check_performance(&rlen);
+    if (buf)
+        jlog_buf_put(buf, rlen);
+
+    if (wanted & JLOG_SINK_TTY)
+        jlog_sink_flush(JLOG_TO_TTY - 1);
+    if ((wanted & JLOG_SINK_FILE) && jlog_check_file() == 0)
+        jlog_sink_flush(JLOG_TO_FILE - 1);
+    if (mgr->nstate == 1)
+        jthread_cond_signal(&mgr->ncond);
+
     jlog_buf_abandon();
 }
 
 static jthread_ret_t jlog_run(void *args)
 {
     jlog_mgr_t *mgr = &g_jlog_mgr;
-    jlog_jcfg_t *jcfg = &mgr->jcfg;
+    uint32_t pend = 0, last = 0;
 
     jthread_setname("jlog_flush");
     while (mgr->inited) {
         jthread_mutex_lock(&mgr->cmtx);
-        jthread_cond_mtimewait(&mgr->cond, &mgr->cmtx, JLOG_SLEEP_MS);
+        jthread_cond_mtimewait(&mgr->cond, &mgr->cmtx, mgr->jcfg.flush_ms);
         jthread_mutex_unlock(&mgr->cmtx);
         jlog_flush();
     }
-    jlog_flush();
 
-    jfs_close(jcfg->fcfg.fd);
-    jsocket_close(jcfg->ncfg.fd);
+    /* 反初始化已等待所有线程离开线程缓冲，一次合并可能放不下，输出到读完或不再有进展为止 */
+    pend = jlog_tbuf_pending();
+    do {
+        last = pend;
+        jlog_flush();
+        pend = jlog_tbuf_pending();
+    } while (pend && pend < last);
+
+    jlog_close_file();
     jlog_free_file();
 
     return (jthread_ret_t)0;
@@ -964,14 +2538,24 @@ int jlog_init(const jlog_cfg_t *cfg)
     jcfg->level = cfg->level;
     if (!jcfg->level)
         jcfg->level = JLOG_LEVEL_DEF;
-
-    jcfg->mode = cfg->mode;
-    if (jcfg->mode == JLOG_TO_AUTO)
-        jcfg->mode = JLOG_TO_TTY;
-    jcfg->wanted = jcfg->mode;
+    jcfg->flush_ms = cfg->flush_ms > 0 ? cfg->flush_ms : JLOG_SLEEP_MS;
+
+    jcfg->wanted = cfg->sinks & (JLOG_SINK_TTY | JLOG_SINK_FILE | JLOG_SINK_NET);
+    if (!jcfg->wanted)
+        jcfg->wanted = JLOG_SINK_MODE(cfg->mode == JLOG_TO_AUTO ? JLOG_TO_TTY : cfg->mode);
+    jcfg->changed = 0;
+    jcfg->levels[JLOG_TO_TTY - 1] = cfg->tty_level > 0 ? cfg->tty_level : 0;
+    jcfg->levels[JLOG_TO_FILE - 1] = cfg->file_level > 0 ? cfg->file_level : 0;
+    jcfg->levels[JLOG_TO_NET - 1] = cfg->net_level > 0 ? cfg->net_level : 0;
+    memset(jcfg->midline, 0, sizeof(jcfg->midline));
     jcfg->zone_sec = jtime_localutc_diff();
 
     fcfg->fd = JFS_INVALID_FD;
+    fcfg->mmap = cfg->file.file_mmap > 0;
+    fcfg->binary = cfg->file.file_binary > 0;
+    fcfg->bin = 0;
+    fcfg->map = NULL;
+    fcfg->mlen = 0;
     fcfg->fsize = cfg->file.file_size;
     if (!fcfg->fsize)
         fcfg->fsize = JLOG_DEF_FSIZE;
@@ -1034,11 +2618,38 @@ int jlog_init(const jlog_cfg_t *cfg)
         jbuf->size = 0;
         return -1;
     }
+    jbuf->sinks = jcfg->wanted;
+    memset(jbuf->pend, 0, sizeof(jbuf->pend));
+    memset(jbuf->busy, 0, sizeof(jbuf->busy));
+    if (!mgr->bgen)
+        mgr->bgen = 1;
+    if ((jcfg->wanted & JLOG_SINK_FILE) && fcfg->binary && _jlog_bbuf_alloc(mgr) == 0) {
+        jbuf->sinks &= ~JLOG_SINK_FILE;
+        mgr->bbuf.sinks = JLOG_SINK_FILE;
+        fcfg->bin = 1;
+    }
+
+    if (!mgr->key_inited && jthread_key_create(&mgr->key, jlog_tbuf_release) == 0)
+        mgr->key_inited = 1;
+    mgr->tbuf_size = 0;
+    if (cfg->tbuf_size >= 0 && mgr->key_inited) {
+        len = cfg->tbuf_size ? cfg->tbuf_size : JLOG_TBUF_SIZE;
+        if (len < JLOG_TREC_SIZE(jbuf->res) * 4)
+            len = JLOG_TREC_SIZE(jbuf->res) * 4;
+        mgr->tbuf_size = 1;
+        while (mgr->tbuf_size < len)
+            mgr->tbuf_size <<= 1;
+    }
+    mgr->tbufs = NULL;
+    mgr->tpend = 0;
 
     jthread_mutex_init(&mgr->cmtx);
     jthread_mutex_init(&mgr->mtx);
     jthread_cond_init(&mgr->cond, 1);
+    jthread_cond_init(&mgr->ncond, 1);
+    mgr->nstate = 0;
     mgr->inited = 1;
+    jatomic32_fetch_add(&mgr->gen, 1);
 
     attr.stack_size = JLOG_STACK_SIZE;
     jthread_create(&mgr->tid, &attr, jlog_run, NULL);
@@ -1067,6 +2678,8 @@ int jlog_init_ini(const char *ini)
     cfg.file.file_size = jini_get_int(hd, "jlog", "file_size", 1024) << 10;
     cfg.file.file_count = jini_get_int(hd, "jlog", "file_count", 10);
     cfg.file.file_path = jini_get(hd, "jlog", "file_path", "jlog");
+    cfg.file.file_mmap = jini_get_int(hd, "jlog", "file_mmap", 0);
+    cfg.file.file_binary = jini_get_int(hd, "jlog", "file_binary", 0);
 
     cfg.net.is_ipv6 = jini_get_int(hd, "jlog", "is_ipv6", 0);
     cfg.net.ip_port = jini_get_int(hd, "jlog", "ip_port", 9999);
@@ -1075,6 +2688,13 @@ int jlog_init_ini(const char *ini)
     cfg.perf.cpu_cycle = jini_get_int(hd, "jlog", "cpu_cycle", 0);
     cfg.perf.mem_cycle = jini_get_int(hd, "jlog", "mem_cycle", 0);
     cfg.perf.net_cycle = jini_get_int(hd, "jlog", "net_cycle", 0);
+    cfg.tbuf_size = jini_get_int(hd, "jlog", "tbuf_size", 64);
+    cfg.tbuf_size = cfg.tbuf_size < 0 ? -1 : cfg.tbuf_size << 10;
+    cfg.sinks = jini_get_int(hd, "jlog", "sinks", 0);
+    cfg.tty_level = jini_get_int(hd, "jlog", "tty_level", 0);
+    cfg.file_level = jini_get_int(hd, "jlog", "file_level", 0);
+    cfg.net_level = jini_get_int(hd, "jlog", "net_level", 0);
+    cfg.flush_ms = jini_get_int(hd, "jlog", "flush_ms", JLOG_SLEEP_MS);
 
     int ret = jlog_init(&cfg);
     jini_uninit(hd);
@@ -1086,21 +2706,61 @@ void jlog_uninit(void)
 {
     jlog_mgr_t *mgr = &g_jlog_mgr;
     jlog_jbuf_t *jbuf = &mgr->jbuf;
+    jlog_tbuf_t *tb = NULL, *next = NULL;
 
     if (!mgr->inited)
         return;
+
+    /*
+     * 先禁止写入并等待正在写入线程缓冲的线程提交离开，之后线程缓冲不会再有新记录，
+     * 写线程退出前读完它们，不会丢失刚通过检查的线程提交的日志
+     */
     jthread_mutex_lock(&mgr->mtx);
     mgr->inited = 0;
+    jatomic32_fetch_add(&mgr->gen, 1);
+    jatomic_fence();
+    for (tb = mgr->tbufs; tb; tb = tb->next) {
+        while (jatomic32_load_acquire(&tb->busy))
+            jthread_yield();
+    }
     jthread_mutex_unlock(&mgr->mtx);
     jthread_cond_signal(&mgr->cond);
 
     jthread_join(mgr->tid);
+    if (mgr->nstate) {
+        mgr->nstate = 2;
+        jthread_cond_signal(&mgr->ncond);
+        jthread_join(mgr->ntid);
+        mgr->nstate = 0;
+    }
+
+    /* 摘除线程缓冲，所属线程已退出的直接释放 */
+    jthread_mutex_lock(&mgr->mtx);
+    for (tb = mgr->tbufs; tb; tb = next) {
+        next = tb->next;
+        while (jatomic32_load_acquire(&tb->busy))
+            jthread_yield();
+        if (jatomic32_load_acquire(&tb->closed))
+            jheap_free(tb);
+        else
+            jatomic32_store_release(&tb->detached, 1);
+    }
+    mgr->tbufs = NULL;
+    jthread_mutex_unlock(&mgr->mtx);
+
+    /* 等待已通过初始化检查的写日志线程离开，销毁正在等待的锁会使它们永远阻塞 */
+    while (jatomic32_load_acquire(&mgr->users))
+        jthread_yield();
     jthread_mutex_destroy(&mgr->cmtx);
     jthread_mutex_destroy(&mgr->mtx);
     jthread_cond_destroy(&mgr->cond);
+    jthread_cond_destroy(&mgr->ncond);
 
     jheap_free(jbuf->buf);
     memset(jbuf, 0, sizeof(jlog_jbuf_t));
+    if (mgr->bbuf.buf)
+        jheap_free(mgr->bbuf.buf);
+    memset(&mgr->bbuf, 0, sizeof(jlog_jbuf_t));
 }
 
 int jlog_cfg_get(jlog_cfg_t *cfg)
@@ -1118,19 +2778,34 @@ int jlog_cfg_get(jlog_cfg_t *cfg)
     cfg->wake_size = jbuf->wake;
     cfg->res_size = jbuf->res;
     cfg->level = jcfg->level;
-    cfg->mode = jcfg->mode;
+    jthread_mutex_lock(&mgr->cmtx);
+    cfg->flush_ms = jcfg->flush_ms;
+    cfg->sinks = jcfg->wanted;
+    jthread_mutex_unlock(&mgr->cmtx);
+    switch (cfg->sinks) {
+    case JLOG_SINK_TTY: cfg->mode = JLOG_TO_TTY; break;
+    case JLOG_SINK_FILE: cfg->mode = JLOG_TO_FILE; break;
+    case JLOG_SINK_NET: cfg->mode = JLOG_TO_NET; break;
+    default: cfg->mode = JLOG_TO_AUTO; break;
+    }
+    cfg->tty_level = jcfg->levels[JLOG_TO_TTY - 1];
+    cfg->file_level = jcfg->levels[JLOG_TO_FILE - 1];
+    cfg->net_level = jcfg->levels[JLOG_TO_NET - 1];
 
     cfg->file.file_size = fcfg->fsize;
     cfg->file.file_count = fcfg->fcount;
     if (cfg->file.file_count == 0)
         cfg->file.file_count = -1;
     cfg->file.file_path = fcfg->path;
+    cfg->file.file_mmap = fcfg->mmap ? 1 : -1;
+    cfg->file.file_binary = fcfg->binary ? 1 : -1;
 
     cfg->net.is_ipv6 = ncfg->jaddr.domain == AF_INET6 ? 1 : 0;
     cfg->net.ip_port = ncfg->jaddr.port;
     cfg->net.ip_addr = ncfg->jaddr.addr;
 
     cfg->perf = jcfg->perf;
+    cfg->tbuf_size = mgr->tbuf_size ? mgr->tbuf_size : -1;
 
     return 0;
 }
@@ -1152,12 +2827,22 @@ int jlog_cfg_set(const jlog_cfg_t *cfg)
 
     if (cfg->level)
         jcfg->level = cfg->level;
-
-    if (cfg->mode != JLOG_TO_AUTO) {
-        if (jcfg->mode != cfg->mode || jcfg->wanted != cfg->mode)
-            jcfg->changed = 1;
-        jcfg->wanted = cfg->mode;
+    if (cfg->flush_ms > 0)
+        jcfg->flush_ms = cfg->flush_ms;
+
+    len = cfg->sinks & (JLOG_SINK_TTY | JLOG_SINK_FILE | JLOG_SINK_NET);
+    if (!len && cfg->mode != JLOG_TO_AUTO)
+        len = JLOG_SINK_MODE(cfg->mode);
+    if (len) {
+        jcfg->changed |= jcfg->wanted ^ len;
+        jcfg->wanted = len;
     }
+    if (cfg->tty_level)
+        jcfg->levels[JLOG_TO_TTY - 1] = cfg->tty_level > 0 ? cfg->tty_level : 0;
+    if (cfg->file_level)
+        jcfg->levels[JLOG_TO_FILE - 1] = cfg->file_level > 0 ? cfg->file_level : 0;
+    if (cfg->net_level)
+        jcfg->levels[JLOG_TO_NET - 1] = cfg->net_level > 0 ? cfg->net_level : 0;
 
     if (cfg->file.file_size)
         fcfg->fsize = cfg->file.file_size;
@@ -1166,6 +2851,16 @@ int jlog_cfg_set(const jlog_cfg_t *cfg)
         if (fcfg->fcount < 0)
             fcfg->fcount = 0;
     }
+    if (cfg->file.file_mmap && fcfg->mmap != (cfg->file.file_mmap > 0)) {
+        if (jcfg->wanted & JLOG_SINK_FILE)
+            jcfg->changed |= JLOG_SINK_FILE;
+        fcfg->mmap = cfg->file.file_mmap > 0;
+    }
+    if (cfg->file.file_binary && fcfg->binary != (cfg->file.file_binary > 0)) {
+        if (jcfg->wanted & JLOG_SINK_FILE)
+            jcfg->changed |= JLOG_SINK_FILE;
+        fcfg->binary = cfg->file.file_binary > 0;
+    }
     if (cfg->file.file_path && cfg->file.file_path[0]) {
         len = (int)strlen(cfg->file.file_path);
         tmp = (char *)jheap_malloc(len + 2);
@@ -1178,8 +2873,8 @@ int jlog_cfg_set(const jlog_cfg_t *cfg)
                 tmp[len] = '\0';
             }
             if (len != fcfg->dlen || strncmp(tmp, fcfg->path, len) != 0) {
-                if (jcfg->wanted == JLOG_TO_FILE)
-                    jcfg->changed = 1;
+                if (jcfg->wanted & JLOG_SINK_FILE)
+                    jcfg->changed |= JLOG_SINK_FILE;
                 fcfg->dlen = len;
                 memcpy(fcfg->path, tmp, fcfg->dlen);
             }
@@ -1189,13 +2884,13 @@ int jlog_cfg_set(const jlog_cfg_t *cfg)
     }
 
     if (cfg->net.ip_port && ncfg->jaddr.port != cfg->net.ip_port) {
-        if (jcfg->wanted == JLOG_TO_NET)
-            jcfg->changed = 1;
+        if (jcfg->wanted & JLOG_SINK_NET)
+            jcfg->changed |= JLOG_SINK_NET;
         ncfg->jaddr.port = cfg->net.ip_port;
     }
     if (cfg->net.ip_addr && cfg->net.ip_addr[0] && strcmp(ncfg->jaddr.addr, cfg->net.ip_addr) != 0) {
-        if (jcfg->wanted == JLOG_TO_NET)
-            jcfg->changed = 1;
+        if (jcfg->wanted & JLOG_SINK_NET)
+            jcfg->changed |= JLOG_SINK_NET;
         ncfg->jaddr.domain = cfg->net.is_ipv6 ? AF_INET6 : AF_INET;
         len = (int)strlen(cfg->net.ip_addr);
         memcpy(ncfg->jaddr.addr, cfg->net.ip_addr, len);
@@ -1236,3 +2931,242 @@ void jlog_perf_set(jlog_perf_t *perf)
     jlog_mgr_t *mgr = &g_jlog_mgr;
     mgr->jcfg.perf = *perf;
 }
+
+/* 解码时还原的格式串，以格式串ID为键 */
+typedef struct {
+    struct jhashmap node;   // 哈希表节点
+    uint64_t id;            // 格式串ID
+    jlog_bfmt_t bfmt;       // 格式串描述，字符串指向读入的文件数据
+} jlog_dfmt_t;
+
+static unsigned int jlog_dfmt_key_hash(const void *key)
+{
+    uint64_t id = *(const uint64_t *)key;
+    return (unsigned int)((id >> 3) ^ (id >> 32));
+}
+
+static unsigned int jlog_dfmt_node_hash(struct jhashmap *node)
+{
+    return jlog_dfmt_key_hash(&jhashmap_entry(node, jlog_dfmt_t, node)->id);
+}
+
+static int jlog_dfmt_key_cmp(struct jhashmap *node, const void *key)
+{
+    return jhashmap_entry(node, jlog_dfmt_t, node)->id != *(const uint64_t *)key;
+}
+
+static int jlog_dfmt_node_cmp(struct jhashmap *a, struct jhashmap *b)
+{
+    return jhashmap_entry(a, jlog_dfmt_t, node)->id != jhashmap_entry(b, jlog_dfmt_t, node)->id;
+}
+
+static uintptr_t jlog_dfmt_free_cb(struct jhashmap *node)
+{
+    jheap_free(jhashmap_entry(node, jlog_dfmt_t, node));
+    return JHASHMAP_DEL;
+}
+
+/* 解码格式串定义，格式串解析失败时也保留，它的日志只输出日志头 */
+static void jlog_decode_fmt(struct jhashmap_hd *hd, const char *data, int dlen)
+{
+    const jlog_bdef_t *def = (const jlog_bdef_t *)data;
+    jlog_dfmt_t *dfmt = NULL;
+    struct jhashmap *node = NULL;
+
+    if (dlen < (int)sizeof(jlog_bdef_t) + 2 || def->flen > (uint32_t)dlen - sizeof(jlog_bdef_t) - 2
+        || data[sizeof(jlog_bdef_t) + def->flen] != '\0' || data[dlen - 1] != '\0')
+        return;
+
+    dfmt = (jlog_dfmt_t *)jheap_malloc(sizeof(jlog_dfmt_t));
+    if (!dfmt)
+        return;
+    memset(dfmt, 0, sizeof(jlog_dfmt_t));
+    dfmt->id = def->id;
+    dfmt->bfmt.file = (const char *)(def + 1);
+    dfmt->bfmt.fmt = dfmt->bfmt.file + def->flen + 1;
+    dfmt->bfmt.line = def->line;
+    _jlog_bfmt_register(&dfmt->bfmt);
+
+    node = jhashmap_add(hd, &dfmt->node);
+    if (node)
+        jheap_free(jhashmap_entry(node, jlog_dfmt_t, node));
+}
+
+/*
+ * 把紧凑存储的参数还原为8字节对齐的参数槽，返回参数槽的长度，数据损坏时返回-1
+ * args至少要有 plen * 8 + JLOG_BARG_MAX * 16 字节
+ */
+static int _jlog_bin_unpack(const jlog_bfmt_t *bfmt, const char *p, int plen, char *args)
+{
+    const char *end = p + plen;
+    char *a = args;
+    uint64_t v = 0;
+    int i = 0;
+
+    for (i = 0; i < bfmt->nargs && p < end; ++i) {
+        switch (bfmt->args[i] & JLOG_BARG_KIND) {
+        case JLOG_BARG_DOUBLE:
+            if (end - p < 8)
+                return -1;
+            memcpy(a, p, 8);
+            p += 8;
+            a += 8;
+            break;
+        case JLOG_BARG_STR:
+            if (!(p = _jlog_varint_get(p, end, &v)) || v > (uint64_t)(end - p))
+                return -1;
+            memcpy(a, &v, 8);
+            memcpy(a + 8, p, (size_t)v);
+            memset(a + 8 + v, 0, ((v + 8) & ~(uint64_t)7) - v);
+            p += v;
+            a += 8 + ((v + 8) & ~(uint64_t)7);
+            break;
+        default:
+            if (!(p = _jlog_varint_get(p, end, &v)))
+                return -1;
+            v = (v >> 1) ^ (uint64_t)-(int64_t)(v & 1);
+            memcpy(a, &v, 8);
+            a += 8;
+            break;
+        }
+    }
+    return p == end ? (int)(a - args) : -1;
+}
+
+int jlog_decode(const char *src, const char *dst)
+{
+    struct jhashmap_hd hd;
+    jlog_jbuf_t tc;
+    jlog_bfmt_t none;
+    jlog_str_t module, type;
+    const jlog_bhead_t *head = NULL;
+    const jlog_bin_t *bin = NULL;
+    const jlog_blog_t *blog = NULL;
+    jlog_brec_t *brec = NULL;
+    jlog_dfmt_t *dfmt = NULL;
+    struct jhashmap *node = NULL;
+    const uint16_t endian = 1;
+    const char *data = NULL;
+    char *buf = NULL, *out = NULL, *args = NULL;
+    size_t size = 0, pos = 0;
+    FILE *fp = NULL;
+    int ret = -1, dlen = 0, slen = 0, alen = 0, amax = 0, len = 0, trunc = 0;
+    uint64_t msec = 0;
+
+    if (!src)
+        return -1;
+    if (jfs_readall(src, &buf, &size) < 0)
+        return -1;
+
+    head = (const jlog_bhead_t *)buf;
+    if (size < sizeof(jlog_bhead_t) || memcmp(head->magic, JLOG_BIN_MAGIC, sizeof(head->magic)) != 0
+        || head->version != JLOG_BIN_VERSION || head->endian != (*(const uint8_t *)&endian ? 1 : 2)
+        || head->stamp != JLOG_TIMESTAMP || head->res < JLOG_RES_SIZE) {
+        SLOG_ERROR("jlog: %s isn't a binary log file of this platform\n", src);
+        jfs_readfree(&buf, &size);
+        return -1;
+    }
+
+    memset(&hd, 0, sizeof(hd));
+    hd.key_hash = jlog_dfmt_key_hash;
+    hd.node_hash = jlog_dfmt_node_hash;
+    hd.key_cmp = jlog_dfmt_key_cmp;
+    hd.node_cmp = jlog_dfmt_node_cmp;
+    if (jhashmap_init(&hd, 8) < 0) {
+        jfs_readfree(&buf, &size);
+        return -1;
+    }
+
+    out = (char *)jheap_malloc(head->res);
+    fp = dst ? fopen(dst, "w") : stdout;
+    if (!out || !fp) {
+        SLOG_ERROR("jlog: can't decode %s to %s\n", src, dst ? dst : "stdout");
+        goto end;
+    }
+
+    /* 找不到定义的日志用没有转换说明的格式串只输出日志头 */
+    memset(&none, 0, sizeof(none));
+    none.fmt = "";
+    none.file = "";
+    memset(&tc, 0, sizeof(tc));
+
+    for (pos = sizeof(jlog_bhead_t); pos + sizeof(jlog_bin_t) <= size; pos += JLOG_BIN_STEP(bin->len)) {
+        bin = (const jlog_bin_t *)(buf + pos);
+        if (bin->len < sizeof(jlog_bin_t) || (size_t)JLOG_BIN_STEP(bin->len) > size - pos)
+            break;
+        data = (const char *)(bin + 1);
+        dlen = (int)(bin->len - sizeof(jlog_bin_t));
+
+        switch (bin->kind) {
+        case JLOG_BIN_TEXT:
+            fwrite(data, 1, dlen, fp);
+            break;
+        case JLOG_BIN_FMT:
+            jlog_decode_fmt(&hd, data, dlen);
+            break;
+        case JLOG_BIN_LOG:
+            blog = (const jlog_blog_t *)data;
+            slen = bin->mlen + bin->tlen;
+            if (dlen < (int)sizeof(jlog_blog_t) + slen)
+                break;
+            dlen -= (int)sizeof(jlog_blog_t) + slen;
+
+            /* 重建延迟格式化的记录，参数后面补'\0'，损坏的字符串参数也不会越界 */
+            alen = dlen * 8 + JLOG_BARG_MAX * 16 + 8;
+            if (alen > amax) {
+                amax = alen > JLOG_RES_SIZE ? alen : JLOG_RES_SIZE;
+                if (args)
+                    jheap_free(args);
+                args = (char *)jheap_malloc(sizeof(jlog_brec_t) + amax);
+                if (!args) {
+                    amax = 0;
+                    goto end;
+                }
+            }
+            brec = (jlog_brec_t *)args;
+            module.str = (const char *)(blog + 1);
+            module.len = bin->mlen;
+            type.str = module.str + bin->mlen;
+            type.len = bin->tlen;
+            node = jhashmap_find(&hd, &blog->id, NULL);
+            dfmt = node ? jhashmap_entry(node, jlog_dfmt_t, node) : NULL;
+            brec->bfmt = dfmt && dfmt->bfmt.state == 2 ? &dfmt->bfmt : &none;
+            brec->module = &module;
+            brec->type = &type;
+            memset(&brec->mt, 0, sizeof(brec->mt));
+            msec = blog->msec;
+            brec->mt.sec = (jtime_t)(msec / 1000);
+            brec->mt.msec = (uint16_t)(msec % 1000);
+            brec->level = bin->level < sizeof(g_level_str) - 1 ? bin->level : 0;
+            alen = _jlog_bin_unpack(brec->bfmt, type.str + type.len, dlen, (char *)(brec + 1));
+            if (alen < 0) {
+                brec->bfmt = &none;
+                alen = 0;
+            }
+            brec->alen = alen;
+            memset((char *)(brec + 1) + alen, 0, 8);
+
+            len = _jlog_brec_format(brec, &tc, head->zone, out, head->res, &trunc);
+            fwrite(out, 1, len, fp);
+            break;
+        default:
+            break;
+        }
+    }
+    if (pos != size)
+        SLOG_WARN("jlog: %s has an incomplete record at offset %llu\n", src, (unsigned long long)pos);
+
+    fflush(fp);
+    ret = ferror(fp) ? -1 : 0;
+end:
+    if (fp && fp != stdout)
+        fclose(fp);
+    if (out)
+        jheap_free(out);
+    if (args)
+        jheap_free(args);
+    jhashmap_loop(&hd, jlog_dfmt_free_cb);
+    jhashmap_uninit(&hd);
+    jfs_readfree(&buf, &size);
+    return ret;
+}
@@ -23,10 +23,20 @@ typedef enum {
     JLOG_TO_NET = 3         // 输出到网络
 } jlog_mode_t;
 
+/**
+ * @brief   同时输出的目标，可以组合
+ */
+#define JLOG_SINK_TTY       (1 << 0)    // 输出到终端
+#define JLOG_SINK_FILE      (1 << 1)    // 输出到文件
+#define JLOG_SINK_NET       (1 << 2)    // 输出到网络
+#define JLOG_SINK_MODE(mode) (1 << ((mode) - 1)) // jlog_mode_t转换为输出目标
+
 typedef struct {
     int file_size;          // 每个log文件的最大大小
     int file_count;         // 最多多少个log文件，小于0时不限制文件数量
     const char *file_path;  // 日志存储的文件夹
+    int file_mmap;          // 大于0时预分配file_size大小的文件并映射写入，小于0时直接写文件，0时保持原设置(默认直接写)
+    int file_binary;        // 大于0时写紧凑的二进制文件(用 jlog_decode 还原为文本)，小于0时写文本文件，0时保持原设置(默认文本)
 } jlog_file_t;
 
 typedef struct {
@@ -43,13 +53,19 @@ typedef struct {
 
 typedef struct {
     int buf_size;           // 日志缓冲区大小，只有初始化时缓冲区大小设置才有效
-    int wake_size;          // 日志缓冲区有多长日志时唤醒写入线程
+    int wake_size;          // 日志缓冲区或所有线程缓冲中共有多长日志时唤醒写入线程，即按字节数输出的阈值
     int res_size;           // 日志缓冲保留默认大小，决定一次写log的最大长度
     int level;              // 日志输出等级
     jlog_mode_t mode;       // 日志输出模式
     jlog_file_t file;       // 输出到文件的配置
     jlog_net_t net;         // 输出到网络的配置
     jlog_perf_t perf;       // 采集系统信息的配置
+    int tbuf_size;          // 每个线程的日志缓冲区大小，只有初始化时设置才有效，最小为4条最长日志的长度，小于0时所有线程直接写入共享缓冲区
+    int sinks;              // 同时输出的目标，JLOG_SINK_xxx的组合，0时只输出到mode指定的目标
+    int tty_level;          // 输出到终端的日志等级，0时和level相同，只有比level低时才有过滤作用
+    int file_level;         // 输出到文件的日志等级，同上
+    int net_level;          // 输出到网络的日志等级，同上
+    int flush_ms;           // 日志最大延迟毫秒数，写线程至少每隔这么久输出一次，0时取默认值1000
 } jlog_cfg_t;
 
 /**
@@ -88,7 +104,7 @@ int jlog_cfg_get(jlog_cfg_t *cfg);
  * @brief   更新日志配置
  * @param   cfg [IN] 日志配置参数，不可以为NULL
  * @return  成功返回0; 失败返回-1
- * @note    cfg中某参数为0时此项参数不会更新
+ * @note    cfg中某参数为0时此项参数不会更新，tty_level/file_level/net_level小于0时恢复和level相同
  */
 int jlog_cfg_set(const jlog_cfg_t *cfg);
 
@@ -124,6 +140,16 @@ void jlog_perf_get(jlog_perf_t *perf);
  */
 void jlog_perf_set(jlog_perf_t *perf);
 
+/**
+ * @brief   把二进制日志文件还原为文本日志
+ * @param   src [IN] file_binary 写入的二进制日志文件(后缀为_j.bin)
+ * @param   dst [IN] 输出的文本文件，为NULL时输出到标准输出
+ * @return  成功返回0; 失败返回-1
+ * @note    1. 格式串定义也写在二进制文件中(每个文件开头都有)，解码不需要写日志的程序
+ *          2. 文件结尾不完整的记录(例如进程崩溃时)被忽略，找不到定义的日志只输出日志头
+ */
+int jlog_decode(const char *src, const char *dst);
+
 /**
  * @brief   写入日志到内存缓冲
  * @param   level [IN] 本条日志输出等级
@@ -160,6 +186,55 @@ int jlog_vprint(int level, const jlog_str_t *module, const jlog_str_t *type, con
  */
 int jlog_print(int level, const jlog_str_t *module, const jlog_str_t *type, const char *fmt, ...);
 
+#define JLOG_BARG_MAX       16      // 延迟格式化日志最多的参数个数，包括'*'指定的宽度和精度
+
+/**
+ * @brief   延迟格式化日志的格式串描述
+ * @note    由 jlog_bprint 等宏在调用处定义为静态变量，它的地址就是格式串的ID，不要直接使用
+ */
+typedef struct jlog_bfmt {
+    const char *fmt;        // 日志格式化字符串，必须是字符串常量
+    const char *file;       // 调用处所在的源文件
+    int line;               // 调用处所在的行号
+    unsigned int state;     // 注册状态：0未注册，1注册中，2延迟格式化，3不支持延迟格式化
+    int nargs;              // 参数个数
+    unsigned char args[JLOG_BARG_MAX]; // 每个参数的类型
+    short precs[JLOG_BARG_MAX]; // 字符串参数的精度，-1表示没有精度，-2表示由前一个'*'参数指定
+    struct jlog_bfmt *next; // 写入过二进制文件的格式串链表，新的二进制文件开头重写这些格式串的定义
+    unsigned int bgen;      // 定义写入二进制缓冲时的代数，0表示还未写入过
+} jlog_bfmt_t;
+
+/**
+ * @brief   写入延迟格式化的日志到内存缓冲
+ * @param   bfmt [IN] 格式串描述，由 jlog_bprint 宏定义
+ * @param   level [IN] 本条日志输出等级
+ * @param   module [IN] 产生日志的模块，可以为NULL，此时表示无模块{"N", 1}
+ * @param   type [IN] 对日志的分类，可以为NULL，此时表示无类别{"N", 1}
+ * @param   ... [IN] 日志格式化数据
+ * @return  返回写入的参数数据长度，一般不用关心返回值
+ * @note    1. 调用线程只记录格式串ID、时间戳和参数的原始数据，写线程合并线程缓冲时再格式化，
+ *             写二进制文件(file_binary)时不格式化，直接存储参数
+ *          2. module和type只记录指针，它们必须一直有效（一般是全局常量）；字符串参数会拷贝内容
+ *          3. 支持 d i o u x X c s p e E f F g G a A 转换和 hh h l ll j z t 长度修饰，
+ *             其它格式串、参数过多或没有线程缓冲时退化为 jlog_vprint
+ *          4. 外部应使用 jlog_bprint 宏，不要直接调用此接口
+ */
+int jlog_bprint_(jlog_bfmt_t *bfmt, int level, const jlog_str_t *module, const jlog_str_t *type, ...);
+
+/**
+ * @brief   写入延迟格式化的日志到内存缓冲
+ * @param   level [IN] 本条日志输出等级
+ * @param   mod [IN] 产生日志的模块，可以为NULL
+ * @param   type [IN] 对日志的分类，可以为NULL
+ * @param   fmt [IN] 日志格式化字符串常量，无需加入'\n'
+ * @param   ... [IN] 日志格式化数据
+ * @note    每个调用处定义一个静态的格式串描述，首次调用时注册
+ */
+#define jlog_bprint(level, mod, type, fmt, ...) do {                                     \
+    static jlog_bfmt_t _jlog_bfmt_ = {fmt, __FILE__, __LINE__, 0, 0, {0}, {0}, NULL, 0}; \
+    jlog_bprint_(&_jlog_bfmt_, level, mod, type, ##__VA_ARGS__);                         \
+} while (0)
+
 /**
  * @brief   派生接口，大多数情况下都是使用派生接口
  */
@@ -177,6 +252,13 @@ int jlog_print(int level, const jlog_str_t *module, const jlog_str_t *type, cons
 #define jlog_debug( mod, type, fmt, ...) jlog_print(JLOG_LEVEL_DEBUG, mod, type, fmt, ##__VA_ARGS__)
 #define jlog_trace( mod, type, fmt, ...) jlog_print(JLOG_LEVEL_TRACE, mod, type, fmt, ##__VA_ARGS__)
 
+#define jlog_bfatal(mod, type, fmt, ...) jlog_bprint(JLOG_LEVEL_FATAL, mod, type, fmt, ##__VA_ARGS__)
+#define jlog_berror(mod, type, fmt, ...) jlog_bprint(JLOG_LEVEL_ERROR, mod, type, fmt, ##__VA_ARGS__)
+#define jlog_bwarn( mod, type, fmt, ...) jlog_bprint(JLOG_LEVEL_WARN,  mod, type, fmt, ##__VA_ARGS__)
+#define jlog_binfo( mod, type, fmt, ...) jlog_bprint(JLOG_LEVEL_INFO,  mod, type, fmt, ##__VA_ARGS__)
+#define jlog_bdebug(mod, type, fmt, ...) jlog_bprint(JLOG_LEVEL_DEBUG, mod, type, fmt, ##__VA_ARGS__)
+#define jlog_btrace(mod, type, fmt, ...) jlog_bprint(JLOG_LEVEL_TRACE, mod, type, fmt, ##__VA_ARGS__)
+
 #define JLOG_FATAL( mod, type, fmt, ...) jlog_print(JLOG_LEVEL_FATAL, mod, type, "%s:%d " fmt, __func__, __LINE__, ##__VA_ARGS__)
 #define JLOG_ERROR( mod, type, fmt, ...) jlog_print(JLOG_LEVEL_ERROR, mod, type, "%s:%d " fmt, __func__, __LINE__, ##__VA_ARGS__)
 #define JLOG_WARN(  mod, type, fmt, ...) jlog_print(JLOG_LEVEL_WARN,  mod, type, "%s:%d " fmt, __func__, __LINE__, ##__VA_ARGS__)
@@ -204,6 +286,13 @@ int jlog_print(int level, const jlog_str_t *module, const jlog_str_t *type, cons
 #define jdebug( fmt, ...) jlog_print(JLOG_LEVEL_DEBUG, NULL, NULL, fmt, ##__VA_ARGS__)
 #define jtrace( fmt, ...) jlog_print(JLOG_LEVEL_TRACE, NULL, NULL, fmt, ##__VA_ARGS__)
 
+#define jbfatal(fmt, ...) jlog_bprint(JLOG_LEVEL_FATAL, NULL, NULL, fmt, ##__VA_ARGS__)
+#define jberror(fmt, ...) jlog_bprint(JLOG_LEVEL_ERROR, NULL, NULL, fmt, ##__VA_ARGS__)
+#define jbwarn( fmt, ...) jlog_bprint(JLOG_LEVEL_WARN,  NULL, NULL, fmt, ##__VA_ARGS__)
+#define jbinfo( fmt, ...) jlog_bprint(JLOG_LEVEL_INFO,  NULL, NULL, fmt, ##__VA_ARGS__)
+#define jbdebug(fmt, ...) jlog_bprint(JLOG_LEVEL_DEBUG, NULL, NULL, fmt, ##__VA_ARGS__)
+#define jbtrace(fmt, ...) jlog_bprint(JLOG_LEVEL_TRACE, NULL, NULL, fmt, ##__VA_ARGS__)
+
 #define JFATAL( fmt, ...) jlog_print(JLOG_LEVEL_FATAL, NULL, NULL, "%s:%d " fmt, __func__, __LINE__, ##__VA_ARGS__)
 #define JERROR( fmt, ...) jlog_print(JLOG_LEVEL_ERROR, NULL, NULL, "%s:%d " fmt, __func__, __LINE__, ##__VA_ARGS__)
 #define JWARN(  fmt, ...) jlog_print(JLOG_LEVEL_WARN,  NULL, NULL, "%s:%d " fmt, __func__, __LINE__, ##__VA_ARGS__)
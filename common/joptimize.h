@@ -43,6 +43,7 @@ extern "C" {
  */
 #define JATTR_CONSTRUCTOR       __attribute__((constructor))    // 标记main函数运行前运行此函数
 #define JATTR_DESTRUCTOR        __attribute__((destructor))     // 标记main函数退出后运行此函数
+#define JATTR_TLS               __thread                        // 标记变量为线程局部存储，每个线程一份
 
 /**
  * @brief   翻转字节顺序
@@ -102,6 +103,40 @@ static inline int jbit8_count(uint8_t n)    { return __builtin_popcount(n); }
 static inline int jbit32_count(uint32_t n)  { return __builtin_popcount(n); }
 static inline int jbit64_count(uint64_t n)  { return __builtin_popcountll(n); }
 
+/**
+ * @brief   原子操作和内存屏障
+ * @param   p [INOUT] 要操作的变量地址
+ * @param   v [IN] 要写入或累加的值
+ * @param   e [INOUT] CAS的期望值，失败时回写变量当前值
+ * @return  load返回变量值；fetch_add/exchange返回操作前的值；cas成功返回1，失败返回0
+ * @note    1. 无后缀为relaxed语义，acquire/release用于无锁结构发布和获取数据，其它读改写操作为顺序一致语义
+ *          2. jatomic_fence为全屏障，jcpu_relax用于自旋等待时降低CPU功耗和流水线冲刷
+ */
+static inline uint32_t jatomic32_load(const uint32_t *p)            { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+static inline uint32_t jatomic32_load_acquire(const uint32_t *p)    { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void jatomic32_store(uint32_t *p, uint32_t v)         { __atomic_store_n(p, v, __ATOMIC_RELAXED); }
+static inline void jatomic32_store_release(uint32_t *p, uint32_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline uint32_t jatomic32_fetch_add(uint32_t *p, uint32_t v) { return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST); }
+static inline uint32_t jatomic32_exchange(uint32_t *p, uint32_t v)  { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+static inline int jatomic32_cas(uint32_t *p, uint32_t *e, uint32_t v)
+{
+    return __atomic_compare_exchange_n(p, e, v, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline uint64_t jatomic64_load(const uint64_t *p)            { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+static inline void jatomic64_store(uint64_t *p, uint64_t v)         { __atomic_store_n(p, v, __ATOMIC_RELAXED); }
+static inline uint64_t jatomic64_fetch_add(uint64_t *p, uint64_t v) { return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST); }
+
+static inline void jatomic_fence(void)      { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+#if defined(__i386__) || defined(__x86_64__)
+static inline void jcpu_relax(void)         { __builtin_ia32_pause(); }
+#elif defined(__aarch64__) || defined(__arm__)
+static inline void jcpu_relax(void)         { __asm__ __volatile__("yield" ::: "memory"); }
+#else
+static inline void jcpu_relax(void)         { __asm__ __volatile__("" ::: "memory"); }
+#endif
+
 #elif defined(_MSC_VER)
 #include <intrin.h>
 #include <stdlib.h>
@@ -124,6 +159,7 @@ static inline int jbit64_count(uint64_t n)  { return __builtin_popcountll(n); }
 
 #define JATTR_CONSTRUCTOR                   "attribute 'constructor' is not supported!" /* 不支持 */
 #define JATTR_DESTRUCTOR                    "attribute 'destructor' is not supported!" /* 不支持 */
+#define JATTR_TLS                           __declspec(thread)
 
 static inline void jbyte2_reverse(void *p)  { uint16_t *val = (uint16_t *)p; *val = _byteswap_ushort(*val); }
 static inline void jbyte4_reverse(void *p)  { uint32_t *val = (uint32_t *)p; *val = _byteswap_ulong(*val); }
@@ -145,6 +181,33 @@ static inline int jbit8_count(uint8_t n)    { return __popcnt(n); }
 static inline int jbit32_count(uint32_t n)  { return __popcnt(n); }
 static inline int jbit64_count(uint64_t n)  { return (int)__popcnt64(n); }
 
+static inline uint32_t jatomic32_load(const uint32_t *p)            { return *(const volatile uint32_t *)p; }
+static inline uint32_t jatomic32_load_acquire(const uint32_t *p)    { uint32_t v = *(const volatile uint32_t *)p; _ReadWriteBarrier(); return v; }
+static inline void jatomic32_store(uint32_t *p, uint32_t v)         { *(volatile uint32_t *)p = v; }
+static inline void jatomic32_store_release(uint32_t *p, uint32_t v) { _ReadWriteBarrier(); *(volatile uint32_t *)p = v; }
+static inline uint32_t jatomic32_fetch_add(uint32_t *p, uint32_t v) { return (uint32_t)_InterlockedExchangeAdd((volatile long *)p, (long)v); }
+static inline uint32_t jatomic32_exchange(uint32_t *p, uint32_t v)  { return (uint32_t)_InterlockedExchange((volatile long *)p, (long)v); }
+static inline int jatomic32_cas(uint32_t *p, uint32_t *e, uint32_t v)
+{
+    uint32_t old = (uint32_t)_InterlockedCompareExchange((volatile long *)p, (long)v, (long)*e);
+    if (old == *e)
+        return 1;
+    *e = old;
+    return 0;
+}
+
+static inline uint64_t jatomic64_load(const uint64_t *p)            { return *(const volatile uint64_t *)p; }
+static inline void jatomic64_store(uint64_t *p, uint64_t v)         { *(volatile uint64_t *)p = v; }
+static inline uint64_t jatomic64_fetch_add(uint64_t *p, uint64_t v) { return (uint64_t)_InterlockedExchangeAdd64((volatile __int64 *)p, (__int64)v); }
+
+#if defined(_M_IX86) || defined(_M_AMD64)
+static inline void jatomic_fence(void)      { _mm_mfence(); }
+static inline void jcpu_relax(void)         { _mm_pause(); }
+#else
+static inline void jatomic_fence(void)      { __dmb(_ARM64_BARRIER_ISH); }
+static inline void jcpu_relax(void)         { __yield(); }
+#endif
+
 #else
 
 #define JATTR_UNUSED                        /* 无效果 */
@@ -165,6 +228,7 @@ static inline int jbit64_count(uint64_t n)  { return (int)__popcnt64(n); }
 
 #define JATTR_CONSTRUCTOR                   "attribute 'constructor' is not supported!" /* 不支持 */
 #define JATTR_DESTRUCTOR                    "attribute 'destructor' is not supported!" /* 不支持 */
+#define JATTR_TLS                           "attribute 'thread' is not supported!" /* 不支持 */
 
 static inline void jbyte2_reverse(void *p)
 {
@@ -262,6 +326,31 @@ static inline int jbit64_count(uint64_t n)
 {
     return jbit32_count((uint32_t)(n & 0xFFFFFFFF)) + jbit32_count((uint32_t)(n >> 32));
 }
+
+/* 未知编译器：仅保证volatile访问，不保证读改写操作的原子性 */
+static inline uint32_t jatomic32_load(const uint32_t *p)            { return *(const volatile uint32_t *)p; }
+static inline uint32_t jatomic32_load_acquire(const uint32_t *p)    { return *(const volatile uint32_t *)p; }
+static inline void jatomic32_store(uint32_t *p, uint32_t v)         { *(volatile uint32_t *)p = v; }
+static inline void jatomic32_store_release(uint32_t *p, uint32_t v) { *(volatile uint32_t *)p = v; }
+static inline uint32_t jatomic32_fetch_add(uint32_t *p, uint32_t v) { uint32_t old = *(volatile uint32_t *)p; *(volatile uint32_t *)p = old + v; return old; }
+static inline uint32_t jatomic32_exchange(uint32_t *p, uint32_t v)  { uint32_t old = *(volatile uint32_t *)p; *(volatile uint32_t *)p = v; return old; }
+static inline int jatomic32_cas(uint32_t *p, uint32_t *e, uint32_t v)
+{
+    uint32_t old = *(volatile uint32_t *)p;
+    if (old == *e) {
+        *(volatile uint32_t *)p = v;
+        return 1;
+    }
+    *e = old;
+    return 0;
+}
+
+static inline uint64_t jatomic64_load(const uint64_t *p)            { return *(const volatile uint64_t *)p; }
+static inline void jatomic64_store(uint64_t *p, uint64_t v)         { *(volatile uint64_t *)p = v; }
+static inline uint64_t jatomic64_fetch_add(uint64_t *p, uint64_t v) { uint64_t old = *(volatile uint64_t *)p; *(volatile uint64_t *)p = old + v; return old; }
+
+static inline void jatomic_fence(void)      { }
+static inline void jcpu_relax(void)         { }
 #endif
 
 #if (__WORDSIZE == 64) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6) || __clang_major__ >= 9)
@@ -12,21 +12,75 @@
 #include "jringbuf.h"
 #include "jthread.h"
 #include "jheap.h"
+#include "jfs.h"
+#include "joptimize.h"
 
 /*----------------------------------------------------------------------------
   环形缓冲区主结构（柔性数组布局）
 ----------------------------------------------------------------------------*/
 
+#define JRB_CACHELINE   64  // 缓存行大小（字节），用于隔离生产者和消费者的热数据
+#define JRB_SHM_MAGIC   0x4A524231u // 共享内存中管理器的魔数（"JRB1"），布局改变时需要修改
+#define JRB_SHM_NAME_MAX 64 // 共享内存名称最大长度（含'\0'）
+#define JRB_MAP_SHM     1   // 位于命名共享内存中
+#define JRB_MAP_FILE    2   // 位于映射文件中
+
+/**
+ * @brief 独占读模式下的消费者状态，每个消费者独占一个缓存行，避免不同核上的消费者伪共享
+ */
+typedef struct {
+    uint32_t        read_index;         // 读位置（元素个数）
+    uint32_t        peek_num;           // 窥视未释放的元素个数
+    uint8_t         pad[JRB_CACHELINE - 2 * sizeof(uint32_t)];
+} jrb_consumer_t;
+
+/**
+ * @brief 等待事件（JRINGBUF_BLOCK）：等待者先自旋、再让出CPU、最后以 seq 为键在 futex 上睡眠
+ * @note  唤醒方只在有等待者时递增 seq，只在有睡眠者时才进行 futex 系统调用
+ */
+typedef struct {
+    uint32_t        seq;                // 事件序号
+    uint32_t        waiters;            // 等待（自旋、让出或睡眠）中的线程个数
+    uint32_t        sleepers;           // 在 futex 上睡眠的线程个数
+    uint32_t        pshared;            // 1 表示位于进程间共享内存中，唤醒和等待可以跨进程
+} jrb_event_t;
+
+/**
+ * @brief 就绪描述符（jringbuf_get_event_fd/jringbuf_get_space_fd），可读表示可以读取或写入
+ */
+typedef struct {
+    int             fd;                 // 事件描述符，未创建时为 -1
+    uint32_t        ready;              // 描述符当前是否已置位，只在状态改变时进行系统调用
+} jrb_evfd_t;
+
 /**
  * @brief 环形缓冲区管理器（按元素管理）
  *
  * 尾部连续内存布局（由偏移量索引）：
- *   - buffer[byte_capacity]              数据缓冲区
- *   - read_index[max_consumers]          消费者读位置数组 (uint32_t)，仅 max_consumers>1且JRINGBUF_READ_EXCLUSIVE
+ *   - seq[capacity]                      槽位序号数组 (uint32_t)，仅无锁多生产者多消费者模式(lockfree)
+ *   - buffer[byte_capacity]              数据缓冲区，JRINGBUF_MIRROR 时不在此处而是单独的镜像映射
+ *   - consumer_state[max_consumers]      消费者状态数组 (jrb_consumer_t，每个占一个缓存行)，仅 max_consumers>1且JRINGBUF_READ_EXCLUSIVE
+ *   - tree[tree_leaves]                  最慢消费者锦标赛树 (uint32_t)，条件同 consumer_state
  *   - producer[max_producers]            生产者有效性数组 (uint8_t)，仅 max_producers>1
  *   - consumer[max_consumers]            消费者有效性数组 (uint8_t)，仅 max_consumers>1
+ *   - stats[max_producers+max_consumers] 统计信息数组（每个占整数个缓存行），仅 JRINGBUF_STATS，先生产者后消费者
+ *
+ * 单生产者单消费者时为无锁模式(spsc)：write_index 只由生产者修改，min_read_index 由消费者前移
+ * （生产者丢弃数据时用CAS前移），两者通过 acquire/release 发布；生产者侧和消费者侧的成员
+ * 分别由填充隔离在不同的缓存行，互斥锁只在有线程需要睡眠时才使用。
+ *
+ * 无锁多生产者多消费者模式(lockfree)：write_index 为生产者认领位置，min_read_index 为消费者认领位置，
+ * 都用CAS推进；槽位序号 seq[i] 为 pos 表示位置 pos 可写，为 pos+1 表示可读，读完后置为 pos+capacity。
+ * 认领前先检查序号，只认领对端已完成拷贝的槽位，所以认领后不用等待对端。
+ *
+ * 管理器中只保存偏移不保存指针，因此可以整体放在命名共享内存中由多个进程映射（jringbuf_init_shm），
+ * 此时互斥锁为进程间共享的健壮锁，等待事件使用进程间共享的 futex。
  */
 struct jringbuf {
+    uint32_t        magic;              // 共享内存模式下的魔数，用于 jringbuf_attach_shm 校验
+    uint32_t        shm;                // JRB_MAP_SHM 表示位于命名共享内存中，JRB_MAP_FILE 表示位于映射文件中
+    uint64_t        map_size;           // 共享内存映射大小（字节）
+    char            shm_name[JRB_SHM_NAME_MAX]; // 共享内存名称
     uint32_t        max_producers;      // 最大生产者数量
     uint32_t        cur_producers;      // 当前生产者数量
     uint32_t        max_consumers;      // 最大消费者数量
@@ -34,25 +88,60 @@ struct jringbuf {
     uint32_t        hold_num;           // 历史窗口大小（元素个数）
     uint32_t        wake_num;           // 唤醒窗口大小（元素个数）
     enum jringbuf_read_mode read_mode;  // 读指针管理模式
-    uint8_t         disable_rw;         // 是否禁止读写
+    uint32_t        disable_rw;         // 是否禁止读写
+    uint8_t         spsc;               // 1 表示单生产者单消费者无锁模式
+    uint8_t         lockfree;           // 1 表示多生产者多消费者无锁模式
     uint8_t         min_read_stale;     // 1 表示 min_read_index 需要重新计算（惰性）
-    uint8_t         min_read_lock;      // 1 表示正在读取数据，不能改变 min_read_index (单消费者)
+    uint8_t         mirror;             // 1 表示数据缓冲区为镜像映射（mirror_buf）
+    uint32_t        min_read_lock;      // 正在锁外读取或窥视数据的消费者个数，不为0时不能丢弃旧数据
     uint32_t        rw_count;           // 正在读写的生产者或消费者数目
+    uint32_t        rd_reserved;        // 共享读模式下已窥视未释放的元素个数（jringbuf_read_peek）
+    int             rd_consumer;        // 共享读模式下窥视数据的消费者 ID
     uint32_t        total_size;         // 数据区总大小（字节）
     uint32_t        producer_offset;    // 生产者有效性数组偏移（字节）
     uint32_t        consumer_offset;    // 消费者有效性数组偏移（字节）
 
     uint32_t        capacity;           // 缓冲区元素总个数（2的幂）
     uint32_t        unit_size;          // 单个元素大小（字节）
-    uint32_t        data_len;           // 有效数据元素个数 = write_index - min_read_index
-    uint32_t        write_index;        // 绝对写位置（元素个数），单调递增，利用自然溢出
-    uint32_t        min_read_index;     // 活跃消费者中最小的读位置（元素个数）
+    uint32_t        data_len;           // 有效数据元素个数 = write_index - min_read_index（无锁模式不维护）
     uint32_t        buf_offset;         // 数据缓冲区起始偏移（字节）
-    uint32_t        read_index_offset;  // 消费者读索引数组偏移（字节）
+    uint8_t        *mirror_buf;         // 镜像映射的数据缓冲区，后面紧跟同一块内存的第二次映射
+    uint32_t        read_index_offset;  // 消费者状态数组偏移（字节）
+    uint32_t        tree_offset;        // 最慢消费者锦标赛树偏移（字节）
+    uint32_t        tree_leaves;        // 锦标赛树叶子个数（max_consumers 向上对齐到2的幂）
+    uint32_t        seq_offset;         // 槽位序号数组偏移（字节）
+    uint32_t        spin_num;           // 阻塞等待时睡眠前的自旋次数
+    uint32_t        yield_num;          // 阻塞等待时睡眠前让出CPU的次数
+    jrb_evfd_t     *evfds;              // 就绪描述符数组，[0]为生产者（空间），[1+i]为消费者i（数据）
+    uint32_t        evfd_num;           // 就绪描述符数组元素个数
+    uint32_t        evfd_used;          // 1 表示已创建就绪描述符，读写后需要同步描述符状态
+    uint32_t        stats_offset;       // 统计信息数组偏移（字节）
+    uint32_t        stats_num;          // 统计信息数组元素个数，0 表示未开启统计
 
     jthread_mutex_t mutex;              // 全局互斥锁
-    jthread_cond_t  not_empty;          // 数据可用条件变量（单调时钟）
-    jthread_cond_t  not_full;           // 空间可用条件变量（单调时钟）
+    jthread_mutex_t evfd_mutex;         // 就绪描述符互斥锁，加锁顺序在全局互斥锁之前
+
+    /* 生产者侧（独占缓存行） */
+    uint8_t         pad0[JRB_CACHELINE];
+    uint32_t        write_index;        // 绝对写位置（元素个数），单调递增，利用自然溢出
+    uint32_t        cached_read_index;  // 生产者缓存的 min_read_index（无锁模式）
+    uint32_t        prod_busy;          // 生产者正在写（无锁模式）
+    uint32_t        wr_reserved;        // 已预留未提交的元素个数（jringbuf_write_reserve）
+    int             wr_producer;        // 预留空间的生产者 ID
+
+    /* 消费者侧（独占缓存行） */
+    uint8_t         pad1[JRB_CACHELINE - 5 * sizeof(uint32_t)];
+    uint32_t        min_read_index;     // 活跃消费者中最小的读位置（元素个数）
+    uint32_t        cached_write_index; // 消费者缓存的 write_index（无锁模式）
+    uint32_t        cons_busy;          // 消费者正在读（无锁模式）
+    uint32_t        rd_peek_num;        // 已窥视未释放的元素个数（无锁模式）
+    uint32_t        rd_peek_index;      // 窥视时的读位置（无锁模式）
+
+    /* 等待事件（只在有线程等待时修改） */
+    uint8_t         pad2[JRB_CACHELINE - 5 * sizeof(uint32_t)];
+    jrb_event_t     not_empty;          // 数据可用事件
+    jrb_event_t     not_full;           // 空间可用事件
+    uint8_t         pad3[JRB_CACHELINE - 2 * sizeof(jrb_event_t)];
 
     uint8_t         data[];             // 柔性数组起始
 };
@@ -61,10 +150,20 @@ struct jringbuf {
   内部宏：通过偏移访问各数组
 ----------------------------------------------------------------------------*/
 
-#define JRB_BUF(rb)       ((uint8_t*)((rb)->data + (rb)->buf_offset))            // 数据缓冲区
-#define JRB_CONS_IDX(rb)  ((uint32_t*)((rb)->data + (rb)->read_index_offset))    // 消费者读索引数组（元素位置）
+#define JRB_BUF(rb)       ((rb)->mirror ? (rb)->mirror_buf : (uint8_t*)((rb)->data + (rb)->buf_offset)) // 数据缓冲区
+#define JRB_CONS(rb)      ((jrb_consumer_t*)((rb)->data + (rb)->read_index_offset)) // 消费者状态数组
+#define JRB_CONS_IDX(rb, i)  (JRB_CONS(rb)[i].read_index)                         // 消费者读位置（元素位置）
+#define JRB_CONS_PEEK(rb, i) (JRB_CONS(rb)[i].peek_num)                           // 消费者窥视个数
+#define JRB_TREE(rb)      ((uint32_t*)((rb)->data + (rb)->tree_offset))          // 最慢消费者锦标赛树
+#define JRB_SEQ(rb)       ((uint32_t*)((rb)->data + (rb)->seq_offset))           // 槽位序号数组
+
+#define JRB_SPIN_NUM      64  // 等待槽位时先自旋的次数，之后让出CPU
+#define JRB_NONE          0xFFFFFFFFu // 锦标赛树中表示没有活跃消费者
 #define JRB_PROD_ACT(rb)  ((uint8_t*)((rb)->data + (rb)->producer_offset))       // 生产者活跃数组
 #define JRB_CONS_ACT(rb)  ((uint8_t*)((rb)->data + (rb)->consumer_offset))       // 消费者活跃数组
+#define JRB_STATS_STRIDE  ((sizeof(jringbuf_stats_t) + JRB_CACHELINE - 1) & ~(size_t)(JRB_CACHELINE - 1)) // 统计信息数组元素间隔
+#define JRB_STATS(rb, i)  ((jringbuf_stats_t*)((rb)->data + (rb)->stats_offset + (i) * JRB_STATS_STRIDE)) // 第i个统计信息
+#define JRB_STAT_ADD(st, member, v) do { if (st) jatomic64_fetch_add(&(st)->member, (uint64_t)(v)); } while (0) // 累加统计计数
 
 /*----------------------------------------------------------------------------
   内部辅助函数
@@ -87,26 +186,70 @@ static inline uint32_t next_pow2(uint32_t n)
 }
 
 /**
- * @brief   遍历活跃消费者并重新计算 min_read_index 及 data_len（均以元素为单位）
+ * @brief   返回两个消费者中更慢（读位置离写位置更远）的一个
+ * @note    所有活跃读位置都在 [write_index - capacity, write_index] 内，写位置前进不改变比较结果
+ */
+static inline uint32_t jringbuf_slower(jringbuf_t *rb, uint32_t a, uint32_t b)
+{
+    if (a == JRB_NONE)
+        return b;
+    if (b == JRB_NONE)
+        return a;
+    return (rb->write_index - JRB_CONS_IDX(rb, a)) >= (rb->write_index - JRB_CONS_IDX(rb, b)) ? a : b;
+}
+
+/**
+ * @brief   获取锦标赛树节点的胜者，叶子节点为消费者自身（不活跃时为 JRB_NONE）
+ */
+static inline uint32_t jringbuf_tree_winner(jringbuf_t *rb, uint32_t node)
+{
+    if (node >= rb->tree_leaves) {
+        uint32_t i = node - rb->tree_leaves;
+        return (i < rb->max_consumers && JRB_CONS_ACT(rb)[i]) ? i : JRB_NONE;
+    }
+    return JRB_TREE(rb)[node];
+}
+
+/**
+ * @brief   消费者 i 的读位置或有效性改变后，从叶子到根重新比较，O(log n)
+ * @param   advance [IN] 1 表示只是读位置前进，i 在某节点不是胜者时上层都不会改变，提前结束
+ */
+static void jringbuf_tree_update(jringbuf_t *rb, uint32_t i, int advance)
+{
+    uint32_t *tree = JRB_TREE(rb);
+
+    for (uint32_t node = (rb->tree_leaves + i) >> 1; node >= 1; node >>= 1) {
+        if (advance && tree[node] != i)
+            break;
+        tree[node] = jringbuf_slower(rb, jringbuf_tree_winner(rb, node << 1), jringbuf_tree_winner(rb, (node << 1) + 1));
+    }
+}
+
+/**
+ * @brief   多个消费者的读位置同时改变后重建锦标赛树，O(n)
+ */
+static void jringbuf_tree_build(jringbuf_t *rb)
+{
+    uint32_t *tree = JRB_TREE(rb);
+
+    for (uint32_t node = rb->tree_leaves - 1; node >= 1; --node) {
+        tree[node] = jringbuf_slower(rb, jringbuf_tree_winner(rb, node << 1), jringbuf_tree_winner(rb, (node << 1) + 1));
+    }
+}
+
+/**
+ * @brief   根据锦标赛树的根（最慢的消费者）重新计算 min_read_index 及 data_len（均以元素为单位）
  */
 static void update_min_read_index(jringbuf_t *rb)
 {
     uint32_t old_min = rb->min_read_index;
     uint32_t min_idx = rb->write_index;   /* 初始设为最远位置 */
 
-    /* 1. 基于活跃消费者计算“最慢读指针” */
+    /* 1. 最慢读指针 */
     if (rb->read_mode == JRINGBUF_READ_EXCLUSIVE) {
-        uint32_t *idx = JRB_CONS_IDX(rb);
-        uint8_t  *act = JRB_CONS_ACT(rb);
-
-        for (uint32_t i = 0, j = 0; i < rb->max_consumers && j < rb->cur_consumers; ++i) {
-            if (act[i]) {
-                ++j;
-                /* 距离大的更旧（利用无符号减法自然溢出） */
-                if ((rb->write_index - idx[i]) > (rb->write_index - min_idx)) {
-                    min_idx = idx[i];
-                }
-            }
+        uint32_t slowest = JRB_TREE(rb)[1];
+        if (slowest != JRB_NONE) {
+            min_idx = JRB_CONS_IDX(rb, slowest);
         }
     }
 
@@ -133,64 +276,978 @@ static void update_min_read_index(jringbuf_t *rb)
     rb->min_read_stale = 0;
 }
 
-/*----------------------------------------------------------------------------
-  核心接口实现
-----------------------------------------------------------------------------*/
+/**
+ * @brief   将从绝对位置 index 开始的 num 个元素转换为最多两段连续内存
+ */
+static inline void jringbuf_fill_span(jringbuf_t *rb, uint32_t index, uint32_t num,
+                                      jringbuf_span_t *span1, jringbuf_span_t *span2)
+{
+    uint32_t pos   = index & (rb->capacity - 1);
+    uint32_t tail  = rb->mirror ? rb->capacity : rb->capacity - pos;
+    uint32_t first = (num <= tail) ? num : tail;
+
+    span1->data = JRB_BUF(rb) + pos * rb->unit_size;
+    span1->len  = first;
+    span2->data = (num > tail) ? JRB_BUF(rb) : NULL;
+    span2->len  = num - first;
+}
+
+/**
+ * @brief   将 num 个元素拷贝到绝对位置 index 处
+ * @note    跨越缓冲区尾部时分两段拷贝，镜像映射时总是一次拷贝
+ */
+static inline void jringbuf_copy_in(jringbuf_t *rb, uint32_t index, const void *data, uint32_t num)
+{
+    uint32_t pos  = index & (rb->capacity - 1);
+    uint32_t tail = rb->capacity - pos;
+    uint8_t *ring = JRB_BUF(rb);
+
+    if (num <= tail || rb->mirror) {
+        memcpy(ring + pos * rb->unit_size, data, num * rb->unit_size);
+    } else {
+        memcpy(ring + pos * rb->unit_size, data, tail * rb->unit_size);
+        memcpy(ring, (const uint8_t*)data + tail * rb->unit_size, (num - tail) * rb->unit_size);
+    }
+}
+
+/**
+ * @brief   从绝对位置 index 处拷贝出 num 个元素
+ */
+static inline void jringbuf_copy_out(jringbuf_t *rb, uint32_t index, void *buf, uint32_t num)
+{
+    uint32_t pos  = index & (rb->capacity - 1);
+    uint32_t tail = rb->capacity - pos;
+    uint8_t *ring = JRB_BUF(rb);
+
+    if (num <= tail || rb->mirror) {
+        memcpy(buf, ring + pos * rb->unit_size, num * rb->unit_size);
+    } else {
+        memcpy(buf, ring + pos * rb->unit_size, tail * rb->unit_size);
+        memcpy((uint8_t*)buf + tail * rb->unit_size, ring, (num - tail) * rb->unit_size);
+    }
+}
+
+/**
+ * @brief   无锁模式下获取可读元素个数(is_reader=1)或可写元素个数(is_reader=0)
+ * @note    两次读取之间对端可能前移索引，结果只作为是否需要等待的判断依据
+ */
+static inline uint32_t jringbuf_spsc_avail(jringbuf_t *rb, int is_reader)
+{
+    uint32_t r = jatomic32_load_acquire(&rb->min_read_index);
+    uint32_t w = jatomic32_load_acquire(&rb->write_index);
+    return is_reader ? w - r : rb->capacity - (w - r);
+}
+
+/**
+ * @brief   获取生产者(is_reader=0)或消费者(is_reader=1)的统计信息
+ * @return  未开启统计或 ID 无效时返回 NULL
+ */
+static inline jringbuf_stats_t* jringbuf_stats_slot(jringbuf_t *rb, int is_reader, int id)
+{
+    uint32_t max = is_reader ? rb->max_consumers : rb->max_producers;
+
+    if (!rb->stats_num)
+        return NULL;
+    if (max == 1)
+        id = 0;
+    else if (id < 0 || (uint32_t)id >= max)
+        return NULL;
+    return JRB_STATS(rb, (is_reader ? rb->max_producers : 0) + (uint32_t)id);
+}
+
+/**
+ * @brief   写入后采样缓冲区中的元素个数到 log2 直方图
+ */
+static inline void jringbuf_stats_sample(jringbuf_t *rb, jringbuf_stats_t *st)
+{
+    uint32_t n = (rb->spsc || rb->lockfree) ? jringbuf_spsc_avail(rb, 1) : jatomic32_load(&rb->data_len);
+    jatomic64_fetch_add(&st->occupancy[32 - jbit32_clz(n)], 1);
+}
+
+/**
+ * @brief   零拷贝写入提交或读取释放后累加统计，写入时同时采样占用直方图
+ */
+static inline void jringbuf_stats_span(jringbuf_t *rb, int is_reader, int id, uint32_t n)
+{
+    jringbuf_stats_t *st = jringbuf_stats_slot(rb, is_reader, id);
+
+    if (!st)
+        return;
+    if (is_reader) {
+        JRB_STAT_ADD(st, read_num, n);
+        JRB_STAT_ADD(st, read_bytes, (uint64_t)n * rb->unit_size);
+    } else {
+        JRB_STAT_ADD(st, write_num, n);
+        JRB_STAT_ADD(st, write_bytes, (uint64_t)n * rb->unit_size);
+        jringbuf_stats_sample(rb, st);
+    }
+}
+
+/**
+ * @brief   唤醒等待事件的线程
+ * @param   force       [IN]    为1时无论是否有等待者都唤醒（停止读写时使用）
+ * @note    没有等待者时只有一次内存屏障和读取，没有睡眠者时不进行系统调用
+ */
+static inline void jrb_event_wake(jrb_event_t *ev, int force)
+{
+    jatomic_fence();
+    if (force || jatomic32_load(&ev->waiters)) {
+        jatomic32_fetch_add(&ev->seq, 1);
+        jatomic_fence();
+        if (force || jatomic32_load(&ev->sleepers))
+            jthread_futex_wake(&ev->seq, 1, ev->pshared);
+    }
+}
+
+/**
+ * @brief   登记等待者并返回当前事件序号
+ * @note    调用后必须重新检查等待条件，条件已满足时调用 jrb_event_cancel，否则调用 jrb_event_wait；
+ *          "先登记等待者再检查条件"和唤醒方的"先发布数据再检查等待者"配对，不会丢失唤醒
+ */
+static inline uint32_t jrb_event_prepare(jrb_event_t *ev)
+{
+    uint32_t seq;
+    jatomic32_fetch_add(&ev->waiters, 1);
+    jatomic_fence();
+    seq = jatomic32_load(&ev->seq);
+    jatomic_fence();
+    return seq;
+}
+
+static inline void jrb_event_cancel(jrb_event_t *ev)
+{
+    jatomic32_fetch_add(&ev->waiters, (uint32_t)-1);
+}
+
+/**
+ * @brief   加锁
+ * @note    共享内存模式下持锁进程异常退出时，恢复互斥锁的一致性后继续使用
+ */
+static inline void jringbuf_lock(jringbuf_t *rb)
+{
+    if (jthread_mutex_lock(&rb->mutex) == EOWNERDEAD)
+        jthread_mutex_consistent(&rb->mutex);
+}
+
+/**
+ * @brief   等待事件序号改变：先自旋 spin_num 次，再让出CPU yield_num 次，最后在 futex 上睡眠
+ * @param   seq         [IN]    jrb_event_prepare 返回的事件序号
+ * @param   locked      [IN]    加锁模式下为1，表示已持有互斥锁，等待期间释放；无锁模式为0
+ * @param   arg         [INOUT] 剩余超时毫秒数，-1 表示无限等待，返回时更新为剩余时间
+ * @param   st          [INOUT] 统计信息，可以为NULL
+ * @note    可能虚假返回，调用者需要重新检查条件
+ */
+static void jrb_event_wait(jringbuf_t *rb, jrb_event_t *ev, uint32_t seq,
+    int locked, int *arg, jringbuf_stats_t *st)
+{
+    uint32_t i;
+    uint64_t t1 = 0, t2, ns = 0;
+
+    if (st)
+        ns = jtime_mononsec_get();
+    if (*arg != -1)
+        t1 = jtime_monomsec_get();
+    if (locked)
+        jthread_mutex_unlock(&rb->mutex);
+
+    for (i = 0; i < rb->spin_num; ++i) {
+        if (jatomic32_load(&ev->seq) != seq)
+            goto end;
+        jcpu_relax();
+    }
+    for (i = 0; i < rb->yield_num; ++i) {
+        if (jatomic32_load(&ev->seq) != seq)
+            goto end;
+        jthread_yield();
+    }
+
+    jatomic32_fetch_add(&ev->sleepers, 1);
+    jatomic_fence();
+    if (jatomic32_load(&ev->seq) == seq) {
+        int msec = *arg;
+        if (msec != -1) {
+            t2 = jtime_monomsec_get();
+            msec = ((int)(t2 - t1) < msec) ? (msec - (int)(t2 - t1)) : 0;
+        }
+        jthread_futex_wait(&ev->seq, seq, msec, ev->pshared);
+    }
+    jatomic32_fetch_add(&ev->sleepers, (uint32_t)-1);
+
+end:
+    jrb_event_cancel(ev);
+    if (locked)
+        jringbuf_lock(rb);
+    if (*arg != -1) {
+        t2 = jtime_monomsec_get();
+        *arg = ((int)(t2 - t1) < *arg) ? (*arg - (int)(t2 - t1)) : 0;
+    }
+    if (st) {
+        JRB_STAT_ADD(st, block_waits, 1);
+        JRB_STAT_ADD(st, block_nsec, jtime_mononsec_get() - ns);
+    }
+}
+
+/**
+ * @brief   无锁模式下等待可读数据或可写空间
+ */
+static void jringbuf_spsc_wait(jringbuf_t *rb, int is_reader, uint32_t need, int *arg,
+                               jringbuf_stats_t *st)
+{
+    jrb_event_t *ev = is_reader ? &rb->not_empty : &rb->not_full;
+    uint32_t seq = jrb_event_prepare(ev);
+
+    if (!jatomic32_load(&rb->disable_rw) && jringbuf_spsc_avail(rb, is_reader) < need)
+        jrb_event_wait(rb, ev, seq, 0, arg, st);
+    else
+        jrb_event_cancel(ev);
+}
+
+/**
+ * @brief   根据当前可读元素个数和空闲空间同步就绪描述符的状态
+ * @note    1. 没有创建就绪描述符时只有一次读取；状态没有改变时不进行系统调用
+ *          2. 在就绪描述符锁内重新获取个数，所以最后一次同步总是反映最新的状态，不会丢失就绪
+ *          3. 不能在持有全局互斥锁时调用；停止读写后所有描述符都置位，让等待者读写时得到错误返回
+ */
+static void jringbuf_evfd_sync(jringbuf_t *rb)
+{
+    uint32_t thresh, num, ready;
+
+    if (!jatomic32_load_acquire(&rb->evfd_used))
+        return;
+
+    thresh = rb->wake_num ? rb->wake_num : 1;
+    if (thresh > rb->capacity)
+        thresh = rb->capacity;
+
+    jthread_mutex_lock(&rb->evfd_mutex);
+    for (uint32_t i = 0; i < rb->evfd_num; ++i) {
+        jrb_evfd_t *ev = &rb->evfds[i];
+        if (ev->fd < 0)
+            continue;
+
+        if (i == 0)
+            num = rb->capacity - jringbuf_size(rb, -1);
+        else
+            num = jringbuf_size(rb, rb->read_mode == JRINGBUF_READ_EXCLUSIVE ? (int)i - 1 : 0);
+        ready = jatomic32_load(&rb->disable_rw) || num >= thresh;
+        if (ready != ev->ready) {
+            if (ready)
+                jthread_evfd_set(ev->fd);
+            else
+                jthread_evfd_clear(ev->fd);
+            ev->ready = ready;
+        }
+    }
+    jthread_mutex_unlock(&rb->evfd_mutex);
+}
+
+/**
+ * @brief   获取（首次调用时创建）第 index 个就绪描述符
+ */
+static int jringbuf_evfd_get(jringbuf_t *rb, uint32_t index)
+{
+    int fd;
+
+    if (rb->shm)
+        return -1;
+
+    jthread_mutex_lock(&rb->evfd_mutex);
+    if (!rb->evfds) {
+        uint32_t num = 1 + (rb->read_mode == JRINGBUF_READ_EXCLUSIVE ? rb->max_consumers : 1);
+        rb->evfds = (jrb_evfd_t*)jheap_malloc(num * sizeof(jrb_evfd_t));
+        if (!rb->evfds) {
+            jthread_mutex_unlock(&rb->evfd_mutex);
+            return -1;
+        }
+        for (uint32_t i = 0; i < num; ++i) {
+            rb->evfds[i].fd = -1;
+            rb->evfds[i].ready = 0;
+        }
+        rb->evfd_num = num;
+    }
+
+    fd = rb->evfds[index].fd;
+    if (fd < 0) {
+        fd = jthread_evfd_create();
+        rb->evfds[index].fd = fd;
+        rb->evfds[index].ready = 0;
+    }
+    jthread_mutex_unlock(&rb->evfd_mutex);
+
+    if (fd >= 0) {
+        jatomic32_store_release(&rb->evfd_used, 1);
+        jringbuf_evfd_sync(rb);
+    }
+    return fd;
+}
+
+/**
+ * @brief   无锁模式写入（单生产者单消费者）
+ */
+static int jringbuf_write_spsc(jringbuf_t *rb, const void *data, uint32_t len,
+                              uint32_t strategy, int arg, uint32_t *pdropped)
+{
+    int complete = (strategy & JRINGBUF_COMPLETE) ? 1 : 0;
+    int drop     = (strategy & JRINGBUF_DROP)     ? 1 : 0;
+    int block    = (strategy & JRINGBUF_BLOCK)    ? 1 : 0;
+    int retry    = (strategy & JRINGBUF_RETRY)    ? 1 : 0;
+    uint32_t dropped = pdropped ? *pdropped : 0;
+    uint32_t need = complete ? len : 1;
+    uint32_t w, r, space, data_len, drop_need, drop_amount, to_write;
+    jringbuf_stats_t *st = jringbuf_stats_slot(rb, 0, 0);
+    int ret = -1;
+
+    if (need > rb->capacity)
+        return -1;
+    /* 预留未提交时写入会覆盖预留的空间，也不能清除预留设置的 prod_busy */
+    if (rb->wr_reserved)
+        return -1;
+
+    /* 和 jringbuf_stop 配对：先标记忙再检查是否禁止读写 */
+    jatomic32_store(&rb->prod_busy, 1);
+    jatomic_fence();
+
+    w = rb->write_index;
+    do {
+        if (jatomic32_load(&rb->disable_rw)) {
+            goto end;
+        }
+
+        /* 优先使用缓存的读位置，空间不足时才访问消费者的缓存行 */
+        r = rb->cached_read_index;
+        space = rb->capacity - (w - r);
+        if (space >= len) {
+            break;
+        }
+        r = jatomic32_load_acquire(&rb->min_read_index);
+        rb->cached_read_index = r;
+        space = rb->capacity - (w - r);
+        if (space >= len) {
+            break;
+        }
+
+        if ((!block && !retry) || !arg) {
+            break;
+        }
+
+        if (block) {
+            jringbuf_spsc_wait(rb, 0, len, &arg, st);
+        } else {
+            if (arg > 0) {
+                --arg;
+            }
+            JRB_STAT_ADD(st, retries, 1);
+            jthread_yield();
+        }
+    } while (1);
+
+    /* 丢弃旧数据：和消费者竞争前移 min_read_index，失败时重新计算 */
+    if (space < len && drop) {
+        while (space < len) {
+            data_len = w - r;
+            drop_need = len - space;
+            drop_amount = (dropped < drop_need || data_len < drop_need) ? drop_need :
+                                   (dropped < data_len ? dropped : data_len);
+            if (drop_amount > data_len && !complete) {
+                drop_amount = data_len;
+            }
+            if (drop_amount > data_len) {
+                goto end;
+            }
+
+            if (jatomic32_cas(&rb->min_read_index, &r, r + drop_amount)) {
+                if (pdropped)
+                    *pdropped = drop_amount;
+                JRB_STAT_ADD(st, drop_full, drop_amount);
+                r += drop_amount;
+                space = rb->capacity - (w - r);
+                break;
+            }
+            space = rb->capacity - (w - r);
+        }
+        rb->cached_read_index = r;
+    }
+
+    if (space < need) {
+        goto end;
+    }
+
+    to_write = (len <= space) ? len : space;
+
+    jringbuf_copy_in(rb, w, data, to_write);
+
+    w += to_write;
+    jatomic32_store_release(&rb->write_index, w);
+    if (w - r >= rb->wake_num)
+        jrb_event_wake(&rb->not_empty, 0);
+    ret = (int)to_write;
+
+end:
+    jatomic32_store_release(&rb->prod_busy, 0);
+    return ret;
+}
+
+/**
+ * @brief   无锁模式读取（单生产者单消费者）
+ */
+static int jringbuf_read_spsc(jringbuf_t *rb, void *buf, uint32_t len,
+                             uint32_t *size, uint32_t strategy, int arg)
+{
+    int complete = (strategy & JRINGBUF_COMPLETE) ? 1 : 0;
+    int block    = (strategy & JRINGBUF_BLOCK)    ? 1 : 0;
+    int retry    = (strategy & JRINGBUF_RETRY)    ? 1 : 0;
+    uint32_t need = complete ? len : 1;
+    uint32_t w, r, avail, to_read;
+    jringbuf_stats_t *st = jringbuf_stats_slot(rb, 1, 0);
+    int ret = -1;
+
+    /* 窥视未释放时读取会越过窥视的数据，也不能清除窥视设置的 cons_busy */
+    if (rb->rd_peek_num)
+        return -1;
+
+    jatomic32_store(&rb->cons_busy, 1);
+    jatomic_fence();
+
+redo:
+    do {
+        if (jatomic32_load(&rb->disable_rw)) {
+            goto end;
+        }
+
+        /* 优先使用缓存的写位置，数据不足时才访问生产者的缓存行 */
+        r = jatomic32_load_acquire(&rb->min_read_index);
+        w = rb->cached_write_index;
+        avail = w - r;
+        if (avail < len || avail > rb->capacity) {
+            w = jatomic32_load_acquire(&rb->write_index);
+            rb->cached_write_index = w;
+            avail = w - r;
+            if (avail > rb->capacity) {
+                /* 生产者刚刚丢弃了旧数据，重新获取读位置 */
+                continue;
+            }
+        }
+
+        if (avail >= need) {
+            break;
+        }
+
+        if ((!block && !retry) || !arg) {
+            goto end;
+        }
+
+        if (block) {
+            jringbuf_spsc_wait(rb, 1, need, &arg, st);
+        } else {
+            if (arg > 0) {
+                --arg;
+            }
+            JRB_STAT_ADD(st, retries, 1);
+            jthread_yield();
+        }
+    } while (1);
+
+    to_read = (len < avail) ? len : avail;
+
+    jringbuf_copy_out(rb, r, buf, to_read);
+
+    /* 拷贝期间生产者丢弃了这段数据时CAS失败，数据可能已被覆盖，需要重读 */
+    if (!jatomic32_cas(&rb->min_read_index, &r, r + to_read)) {
+        goto redo;
+    }
+
+    if (size)
+        *size = avail;
+    jrb_event_wake(&rb->not_full, 0);
+    ret = (int)to_read;
+
+end:
+    if (ret < 0 && size)
+        *size = 0;
+    jatomic32_store_release(&rb->cons_busy, 0);
+    return ret;
+}
+
+/**
+ * @brief   无锁多生产者多消费者模式下从 pos 开始连续 n 个槽位中，序号依次为 pos+off 的槽位个数
+ * @note    off 为0时是可写的槽位，为1时是可读的槽位
+ */
+static inline uint32_t jringbuf_slot_ready(jringbuf_t *rb, uint32_t pos, uint32_t n, uint32_t off)
+{
+    uint32_t *seq = JRB_SEQ(rb);
+    uint32_t i;
+
+    for (i = 0; i < n; ++i) {
+        if (jatomic32_load_acquire(&seq[(pos + i) & (rb->capacity - 1)]) != pos + i + off)
+            break;
+    }
+    return i;
+}
+
+/**
+ * @brief   无锁多生产者多消费者模式写入
+ */
+static int jringbuf_write_lockfree(jringbuf_t *rb, int producer_id, const void *data, uint32_t len,
+                                  uint32_t strategy, int arg)
+{
+    int complete = (strategy & JRINGBUF_COMPLETE) ? 1 : 0;
+    int block    = (strategy & JRINGBUF_BLOCK)    ? 1 : 0;
+    int retry    = (strategy & JRINGBUF_RETRY)    ? 1 : 0;
+    uint32_t need = complete ? len : 1;
+    uint32_t *seq = JRB_SEQ(rb);
+    uint32_t pos, r, space, ready, to_write = 0;
+    jringbuf_stats_t *st = jringbuf_stats_slot(rb, 0, producer_id);
+    int ret = -1;
+
+    if (need > rb->capacity)
+        return -1;
+
+    jatomic32_fetch_add(&rb->rw_count, 1);
+    jatomic_fence();
+
+    /* 1. CAS 认领 [pos, pos + to_write) */
+    pos = jatomic32_load(&rb->write_index);
+    do {
+        if (jatomic32_load(&rb->disable_rw)) {
+            goto end;
+        }
+        if (rb->max_producers > 1
+            && (producer_id < 0 || (uint32_t)producer_id >= rb->max_producers
+                || !JRB_PROD_ACT(rb)[producer_id])) {
+            goto end;
+        }
+
+        r = jatomic32_load_acquire(&rb->min_read_index);
+        space = rb->capacity - (pos - r);
+        if (space > rb->capacity) {
+            /* pos 已过时 */
+            pos = jatomic32_load(&rb->write_index);
+            continue;
+        }
+
+        /* 只认领上一圈消费者已读完的槽位 */
+        ready = (space >= need) ? jringbuf_slot_ready(rb, pos, (len <= space) ? len : space, 0) : 0;
+        if (ready >= len || (ready >= need && ((!block && !retry) || !arg))) {
+            to_write = (len <= ready) ? len : ready;
+            if (jatomic32_cas(&rb->write_index, &pos, pos + to_write)) {
+                break;
+            }
+            continue;
+        }
+
+        if ((!block && !retry) || !arg) {
+            goto end;
+        }
+
+        if (block && space < len) {
+            jringbuf_spsc_wait(rb, 0, len, &arg, st);
+        } else {
+            /* 空间足够但消费者还在拷贝时和重试一样让出CPU，阻塞时不计次数 */
+            if (!block && arg > 0) {
+                --arg;
+            }
+            JRB_STAT_ADD(st, retries, 1);
+            jthread_yield();
+        }
+        pos = jatomic32_load(&rb->write_index);
+    } while (1);
+
+    /* 2. 拷贝后发布序号 */
+    jringbuf_copy_in(rb, pos, data, to_write);
+
+    for (uint32_t i = 0; i < to_write; ++i) {
+        jatomic32_store_release(&seq[(pos + i) & (rb->capacity - 1)], pos + i + 1);
+    }
+
+    if (pos + to_write - r >= rb->wake_num)
+        jrb_event_wake(&rb->not_empty, 0);
+    ret = (int)to_write;
+
+end:
+    jatomic32_fetch_add(&rb->rw_count, (uint32_t)-1);
+    return ret;
+}
+
+/**
+ * @brief   无锁多生产者多消费者模式读取，buf为NULL时只丢弃数据
+ * @note    consumer_id 由调用者校验，为 -1 时不检查消费者有效性（内部丢弃数据使用）
+ */
+static int jringbuf_read_lockfree(jringbuf_t *rb, int consumer_id, void *buf, uint32_t len,
+                                 uint32_t *size, uint32_t strategy, int arg)
+{
+    int complete = (strategy & JRINGBUF_COMPLETE) ? 1 : 0;
+    int block    = (strategy & JRINGBUF_BLOCK)    ? 1 : 0;
+    int retry    = (strategy & JRINGBUF_RETRY)    ? 1 : 0;
+    uint32_t need = complete ? len : 1;
+    uint32_t *seq = JRB_SEQ(rb);
+    uint32_t pos, avail, ready, to_read = 0;
+    jringbuf_stats_t *st = jringbuf_stats_slot(rb, 1, consumer_id);
+    int ret = -1;
+
+    jatomic32_fetch_add(&rb->rw_count, 1);
+    jatomic_fence();
+
+    /* 1. CAS 认领 [pos, pos + to_read) */
+    pos = jatomic32_load(&rb->min_read_index);
+    do {
+        if (jatomic32_load(&rb->disable_rw)) {
+            goto end;
+        }
+        if (consumer_id >= 0 && rb->max_consumers > 1 && !JRB_CONS_ACT(rb)[consumer_id]) {
+            goto end;
+        }
+
+        avail = jatomic32_load_acquire(&rb->write_index) - pos;
+        if (avail > rb->capacity) {
+            /* pos 已过时 */
+            pos = jatomic32_load(&rb->min_read_index);
+            continue;
+        }
+
+        /* 只认领生产者已发布的槽位，不等待认领后还没写完的生产者 */
+        ready = (avail >= need) ? jringbuf_slot_ready(rb, pos, (len < avail) ? len : avail, 1) : 0;
+        if (ready >= need) {
+            to_read = ready;
+            if (jatomic32_cas(&rb->min_read_index, &pos, pos + to_read)) {
+                break;
+            }
+            continue;
+        }
+
+        if ((!block && !retry) || !arg) {
+            goto end;
+        }
+
+        if (block && avail < need) {
+            jringbuf_spsc_wait(rb, 1, need, &arg, st);
+        } else {
+            /* 数据足够但生产者还在拷贝时和重试一样让出CPU，阻塞时不计次数 */
+            if (!block && arg > 0) {
+                --arg;
+            }
+            JRB_STAT_ADD(st, retries, 1);
+            jthread_yield();
+        }
+        pos = jatomic32_load(&rb->min_read_index);
+    } while (1);
+
+    /* 2. 拷贝后把序号推进到下一圈 */
+    if (buf)
+        jringbuf_copy_out(rb, pos, buf, to_read);
+
+    for (uint32_t i = 0; i < to_read; ++i) {
+        jatomic32_store_release(&seq[(pos + i) & (rb->capacity - 1)], pos + i + rb->capacity);
+    }
+
+    if (size)
+        *size = avail;
+    jrb_event_wake(&rb->not_full, 0);
+    ret = (int)to_read;
+
+end:
+    if (ret < 0 && size)
+        *size = 0;
+    jatomic32_fetch_add(&rb->rw_count, (uint32_t)-1);
+    return ret;
+}
+
+/*----------------------------------------------------------------------------
+  核心接口实现
+----------------------------------------------------------------------------*/
+
+/**
+ * @brief   计算管理器需要的内存大小，rb 不为 NULL 时同时在 rb 指向的内存中初始化管理器（不含互斥锁）
+ * @return  成功返回内存大小（字节）；参数错误返回 0
+ */
+static size_t jringbuf_layout(const jringbuf_cfg_t *cfg, jringbuf_t *rb)
+{
+    if (!cfg || cfg->capacity == 0 || cfg->unit_size == 0 || cfg->max_producers < 1 || cfg->max_consumers < 1)
+        return 0;
+
+    int spsc = (cfg->max_producers == 1 && cfg->max_consumers == 1);
+    int lockfree = !spsc && (cfg->flags & JRINGBUF_LOCKFREE);
+    if (lockfree && cfg->max_consumers > 1 && cfg->read_mode == JRINGBUF_READ_EXCLUSIVE)
+        return 0;
+
+    int mirror = (cfg->flags & JRINGBUF_MIRROR) != 0;
+    /* 无锁模式容量为1时序号无法区分满和空 */
+    uint32_t elem_capacity = next_pow2((lockfree && cfg->capacity < 2) ? 2 : cfg->capacity);
+    if (mirror) {
+        /* 镜像映射的大小必须是映射粒度的整数倍 */
+        size_t gran = jfs_mirror_granularity();
+        while ((size_t)elem_capacity * cfg->unit_size < gran)
+            elem_capacity <<= 1;
+        if ((size_t)elem_capacity * cfg->unit_size % gran)
+            return 0;
+    }
+    uint32_t byte_capacity = elem_capacity * cfg->unit_size;
+    uint32_t buf_size      = mirror ? 0 : byte_capacity;
+    uint32_t exclusive     = (cfg->max_consumers > 1 && cfg->read_mode == JRINGBUF_READ_EXCLUSIVE);
+    uint32_t tree_leaves   = exclusive ? next_pow2(cfg->max_consumers) : 0;
+    uint32_t cons_idx_size = exclusive ? cfg->max_consumers * sizeof(jrb_consumer_t) : 0;
+    uint32_t tree_size     = tree_leaves * sizeof(uint32_t);
+    uint32_t prod_act_size = (cfg->max_producers > 1) ? cfg->max_producers * sizeof(uint8_t)  : 0;
+    uint32_t cons_act_size = (cfg->max_consumers > 1) ? cfg->max_consumers * sizeof(uint8_t)  : 0;
+    uint32_t seq_size      = lockfree ? elem_capacity * sizeof(uint32_t) : 0;
+    uint32_t stats_num     = (cfg->flags & JRINGBUF_STATS) ? cfg->max_producers + cfg->max_consumers : 0;
+    uint32_t stats_size    = stats_num * JRB_STATS_STRIDE;
+
+    size_t total = sizeof(jringbuf_t) + seq_size + buf_size + JRB_CACHELINE + cons_idx_size + tree_size
+                   + prod_act_size + cons_act_size + (stats_size ? JRB_CACHELINE + stats_size : 0);
+    if (!rb)
+        return total;
+
+    memset(rb, 0, sizeof(jringbuf_t));
+    rb->max_producers  = cfg->max_producers;
+    rb->cur_producers  = 0;
+    rb->max_consumers  = cfg->max_consumers;
+    rb->cur_consumers  = 0;
+    rb->hold_num       = lockfree ? 0 : cfg->hold_num;
+    rb->wake_num       = cfg->wake_num;
+    rb->read_mode      = (cfg->max_consumers == 1) ? JRINGBUF_READ_SHARED : cfg->read_mode;
+    rb->spsc           = spsc;
+    rb->lockfree       = lockfree;
+    rb->mirror         = mirror;
+    rb->disable_rw     = 0;
+    rb->rw_count       = 0;
+
+    rb->capacity       = elem_capacity;          // 元素个数
+    rb->unit_size      = cfg->unit_size;
+    rb->data_len       = 0;
+    rb->write_index    = 0;
+    rb->min_read_index = 0;
+    rb->min_read_stale = 0;
+    rb->min_read_lock  = 0;
+
+    uint32_t off = 0;
+    rb->seq_offset        = seq_size ? off : 0; off += seq_size;
+    rb->buf_offset        = off; off += buf_size;
+    if (cons_idx_size)
+        off = (off + JRB_CACHELINE - 1) & ~(JRB_CACHELINE - 1);
+    rb->read_index_offset = cons_idx_size ? off : 0; off += cons_idx_size;
+    rb->tree_offset       = tree_size ? off : 0; off += tree_size;
+    rb->tree_leaves       = tree_leaves;
+    rb->producer_offset   = prod_act_size ? off : 0; off += prod_act_size;
+    rb->consumer_offset   = cons_act_size ? off : 0; off += cons_act_size;
+    if (stats_size)
+        off = (off + JRB_CACHELINE - 1) & ~(JRB_CACHELINE - 1);
+    rb->stats_offset      = stats_size ? off : 0; off += stats_size;
+    rb->stats_num         = stats_num;
+    rb->total_size        = off;
+    if (off > rb->buf_offset + buf_size) {
+        memset(rb->data + rb->buf_offset + buf_size, 0, off - rb->buf_offset - buf_size);
+    }
+    if (tree_size) {
+        memset(JRB_TREE(rb), 0xFF, tree_size);  /* JRB_NONE */
+    }
+    if (seq_size) {
+        uint32_t *seq = JRB_SEQ(rb);
+        for (uint32_t i = 0; i < elem_capacity; ++i)
+            seq[i] = i;
+    }
+
+    rb->spin_num       = cfg->spin_num;
+    rb->yield_num      = cfg->yield_num;
+
+    return total;
+}
+
+
+/**
+ * @brief   创建环形缓冲区
+ */
+jringbuf_t* jringbuf_init(const jringbuf_cfg_t *cfg)
+{
+    size_t total = jringbuf_layout(cfg, NULL);
+    if (!total)
+        return NULL;
+
+    jringbuf_t *rb = (jringbuf_t*)jheap_malloc(total);
+    if (!rb)
+        return NULL;
+
+    jringbuf_layout(cfg, rb);
+    if (rb->mirror) {
+        rb->mirror_buf = (uint8_t*)jfs_mirror_map((size_t)rb->capacity * rb->unit_size);
+        if (!rb->mirror_buf) {
+            jheap_free(rb);
+            return NULL;
+        }
+    }
+    jthread_mutex_init(&rb->mutex);
+    jthread_mutex_init(&rb->evfd_mutex);
+    return rb;
+}
+
+/**
+ * @brief   在进程间共享的映射内存中初始化管理器，最后发布魔数
+ * @return  成功返回0；失败返回-1
+ */
+static int jringbuf_map_init(jringbuf_t *rb, size_t map_size, const jringbuf_cfg_t *cfg, uint32_t kind)
+{
+    jringbuf_layout(cfg, rb);
+    if (jthread_mutex_init_pshared(&rb->mutex) != 0)
+        return -1;
+    rb->not_empty.pshared = 1;
+    rb->not_full.pshared = 1;
+    rb->shm = kind;
+    rb->map_size = map_size;
+
+    /* 最后发布魔数，attach 看到魔数时管理器已初始化完成 */
+    jatomic_fence();
+    jatomic32_store(&rb->magic, JRB_SHM_MAGIC);
+    return 0;
+}
+
+/**
+ * @brief   校验映射内存中的管理器，失败时解除映射
+ */
+static jringbuf_t* jringbuf_map_check(jringbuf_t *rb, size_t map_size)
+{
+    if (map_size < sizeof(jringbuf_t) || jatomic32_load(&rb->magic) != JRB_SHM_MAGIC
+            || rb->map_size > map_size || rb->total_size + sizeof(jringbuf_t) > map_size) {
+        jfs_shm_unmap(rb, map_size);
+        return NULL;
+    }
+    jatomic_fence();
+    return rb;
+}
+
+/**
+ * @brief   在命名共享内存中创建环形缓冲区
+ */
+jringbuf_t* jringbuf_init_shm(const char *name, const jringbuf_cfg_t *cfg)
+{
+    if (!name || strlen(name) >= JRB_SHM_NAME_MAX || !cfg || (cfg->flags & JRINGBUF_MIRROR))
+        return NULL;
+
+    size_t total = jringbuf_layout(cfg, NULL);
+    if (!total)
+        return NULL;
+
+    size_t map_size = total;
+    jringbuf_t *rb = (jringbuf_t*)jfs_shm_map(name, &map_size, 1);
+    if (!rb)
+        return NULL;
+
+    if (jringbuf_map_init(rb, map_size, cfg, JRB_MAP_SHM) != 0) {
+        jfs_shm_unmap(rb, map_size);
+        jfs_shm_unlink(name);
+        return NULL;
+    }
+    strcpy(rb->shm_name, name);
+    return rb;
+}
+
+/**
+ * @brief   映射其它进程创建的共享内存环形缓冲区
+ */
+jringbuf_t* jringbuf_attach_shm(const char *name)
+{
+    if (!name)
+        return NULL;
+
+    size_t map_size = 0;
+    jringbuf_t *rb = (jringbuf_t*)jfs_shm_map(name, &map_size, 0);
+    if (!rb)
+        return NULL;
+
+    return jringbuf_map_check(rb, map_size);
+}
+
+/**
+ * @brief   在映射文件中创建环形缓冲区
+ */
+jringbuf_t* jringbuf_init_file(const char *fname, const jringbuf_cfg_t *cfg)
+{
+    if (!fname || !cfg || (cfg->flags & (JRINGBUF_LOCKFREE | JRINGBUF_MIRROR)))
+        return NULL;
+
+    size_t total = jringbuf_layout(cfg, NULL);
+    if (!total)
+        return NULL;
+
+    size_t map_size = total;
+    jringbuf_t *rb = (jringbuf_t*)jfs_file_map(fname, &map_size, 1);
+    if (!rb)
+        return NULL;
+
+    if (jringbuf_map_init(rb, map_size, cfg, JRB_MAP_FILE) != 0) {
+        jfs_shm_unmap(rb, map_size);
+        return NULL;
+    }
+    return rb;
+}
 
 /**
- * @brief   创建环形缓冲区
+ * @brief   打开文件环形缓冲区
  */
-jringbuf_t* jringbuf_init(const jringbuf_cfg_t *cfg)
+jringbuf_t* jringbuf_attach_file(const char *fname)
 {
-    if (cfg->capacity == 0 || cfg->unit_size == 0 || cfg->max_producers < 1 || cfg->max_consumers < 1)
+    if (!fname)
         return NULL;
 
-    uint32_t elem_capacity = next_pow2(cfg->capacity);
-    uint32_t byte_capacity = elem_capacity * cfg->unit_size;
-    uint32_t cons_idx_size = (cfg->max_consumers > 1 && cfg->read_mode == JRINGBUF_READ_EXCLUSIVE) ?  cfg->max_consumers * sizeof(uint32_t) : 0;
-    uint32_t prod_act_size = (cfg->max_producers > 1) ? cfg->max_producers * sizeof(uint8_t)  : 0;
-    uint32_t cons_act_size = (cfg->max_consumers > 1) ? cfg->max_consumers * sizeof(uint8_t)  : 0;
+    size_t map_size = 0;
+    jringbuf_t *rb = (jringbuf_t*)jfs_file_map(fname, &map_size, 0);
+    if (!rb)
+        return NULL;
 
-    size_t total = sizeof(jringbuf_t) + byte_capacity + cons_idx_size + prod_act_size + cons_act_size;
+    return jringbuf_map_check(rb, map_size);
+}
 
-    jringbuf_t *rb = (jringbuf_t*)jheap_malloc(total);
+/**
+ * @brief   打开创建者已崩溃的文件环形缓冲区，清除遗留的预留、窥视和读写中状态
+ */
+jringbuf_t* jringbuf_recover_file(const char *fname)
+{
+    jringbuf_t *rb = jringbuf_attach_file(fname);
     if (!rb)
         return NULL;
 
-    memset(rb, 0, sizeof(jringbuf_t));
-    rb->max_producers  = cfg->max_producers;
-    rb->cur_producers  = 0;
-    rb->max_consumers  = cfg->max_consumers;
-    rb->cur_consumers  = 0;
-    rb->hold_num       = cfg->hold_num;
-    rb->wake_num       = cfg->wake_num;
-    rb->read_mode      = (cfg->max_consumers == 1) ? JRINGBUF_READ_SHARED : cfg->read_mode;
-    rb->disable_rw     = 0;
-    rb->rw_count       = 0;
+    /* 崩溃时可能持有互斥锁，重新初始化；预留和窥视的数据没有提交或释放，直接丢弃这些状态 */
+    if (jthread_mutex_init_pshared(&rb->mutex) != 0) {
+        jringbuf_detach_shm(rb);
+        return NULL;
+    }
+    rb->wr_reserved   = 0;
+    rb->wr_producer   = 0;
+    rb->prod_busy     = 0;
+    rb->rd_reserved   = 0;
+    rb->rd_consumer   = 0;
+    rb->rd_peek_num   = 0;
+    rb->rd_peek_index = 0;
+    rb->cons_busy     = 0;
+    rb->min_read_lock = 0;
+    rb->rw_count      = 0;
+    rb->disable_rw    = 0;
+    rb->not_empty.waiters  = 0;
+    rb->not_empty.sleepers = 0;
+    rb->not_full.waiters   = 0;
+    rb->not_full.sleepers  = 0;
+    jatomic_fence();
+    return rb;
+}
 
-    rb->capacity       = elem_capacity;          // 元素个数
-    rb->unit_size      = cfg->unit_size;
-    rb->data_len       = 0;
-    rb->write_index    = 0;
-    rb->min_read_index = 0;
-    rb->min_read_stale = 0;
-    rb->min_read_lock  = 0;
+/**
+ * @brief   将文件环形缓冲区同步写入磁盘
+ */
+int jringbuf_sync_file(jringbuf_t *rb)
+{
+    if (!rb || rb->shm != JRB_MAP_FILE)
+        return -1;
 
-    uint32_t off = 0;
-    rb->buf_offset        = off; off += byte_capacity;
-    rb->read_index_offset = cons_idx_size ? off : 0; off += cons_idx_size;
-    rb->producer_offset   = prod_act_size ? off : 0; off += prod_act_size;
-    rb->consumer_offset   = cons_act_size ? off : 0; off += cons_act_size;
-    rb->total_size        = off;
-    if (off > byte_capacity) {
-        memset(rb->data + byte_capacity, 0, off - byte_capacity);
-    }
+    return jfs_file_sync(rb, (size_t)rb->map_size);
+}
 
-    jthread_mutex_init(&rb->mutex);
-    jthread_cond_init(&rb->not_empty, 1);     /* 单调时钟 */
-    jthread_cond_init(&rb->not_full,  1);
+/**
+ * @brief   解除映射 jringbuf_attach_shm 得到的共享内存环形缓冲区
+ */
+void jringbuf_detach_shm(jringbuf_t *rb)
+{
+    if (!rb || !rb->shm)
+        return;
 
-    return rb;
+    jfs_shm_unmap(rb, (size_t)rb->map_size);
 }
 
 /**
@@ -203,9 +1260,28 @@ void jringbuf_uninit(jringbuf_t *rb)
 
     jringbuf_stop(rb);
     jthread_mutex_destroy(&rb->mutex);
-    jthread_cond_destroy(&rb->not_empty);
-    jthread_cond_destroy(&rb->not_full);
-    jheap_free(rb);
+    if (rb->shm == JRB_MAP_SHM) {
+        char name[JRB_SHM_NAME_MAX];
+        strcpy(name, rb->shm_name);
+        rb->magic = 0;
+        jfs_shm_unmap(rb, (size_t)rb->map_size);
+        jfs_shm_unlink(name);
+    } else if (rb->shm == JRB_MAP_FILE) {
+        /* 文件是持久的记录，保留魔数以便之后打开回放 */
+        jfs_shm_unmap(rb, (size_t)rb->map_size);
+    } else {
+        if (rb->evfds) {
+            for (uint32_t i = 0; i < rb->evfd_num; ++i) {
+                if (rb->evfds[i].fd >= 0)
+                    jthread_evfd_close(rb->evfds[i].fd);
+            }
+            jheap_free(rb->evfds);
+        }
+        jthread_mutex_destroy(&rb->evfd_mutex);
+        if (rb->mirror)
+            jfs_mirror_unmap(rb->mirror_buf, (size_t)rb->capacity * rb->unit_size);
+        jheap_free(rb);
+    }
 }
 
 /**
@@ -216,9 +1292,10 @@ int jringbuf_start(jringbuf_t *rb)
     if (!rb)
         return -1;
 
-    jthread_mutex_lock(&rb->mutex);
-    rb->disable_rw = 0;
+    jringbuf_lock(rb);
+    jatomic32_store(&rb->disable_rw, 0);
     jthread_mutex_unlock(&rb->mutex);
+    jringbuf_evfd_sync(rb);
     return 0;
 }
 
@@ -231,16 +1308,20 @@ void jringbuf_stop(jringbuf_t *rb)
         return;
 
     /* 唤醒所有等待线程，让它们自己退出 */
-    jthread_mutex_lock(&rb->mutex);
-    rb->disable_rw = 1;
-    while (rb->rw_count) {
-        jthread_cond_broadcast(&rb->not_empty);
-        jthread_cond_broadcast(&rb->not_full);
+    jringbuf_lock(rb);
+    jatomic32_store(&rb->disable_rw, 1);
+    jatomic_fence();
+    /* acquire 和读写者退出时的 release 配对，返回后读写者对缓冲区的访问都已完成，可以释放 */
+    while (jatomic32_load_acquire(&rb->rw_count) || jatomic32_load_acquire(&rb->prod_busy)
+        || jatomic32_load_acquire(&rb->cons_busy)) {
+        jrb_event_wake(&rb->not_empty, 1);
+        jrb_event_wake(&rb->not_full, 1);
         jthread_mutex_unlock(&rb->mutex);
         jthread_yield();
-        jthread_mutex_lock(&rb->mutex);
+        jringbuf_lock(rb);
     }
     jthread_mutex_unlock(&rb->mutex);
+    jringbuf_evfd_sync(rb);
 }
 
 /**
@@ -251,7 +1332,10 @@ uint32_t jringbuf_size(jringbuf_t *rb, int consumer_id)
     if (!rb)
         return 0;
 
-    jthread_mutex_lock(&rb->mutex);
+    if (rb->spsc || rb->lockfree)
+        return jringbuf_spsc_avail(rb, 1);
+
+    jringbuf_lock(rb);
 
     if (rb->min_read_stale && rb->read_mode == JRINGBUF_READ_EXCLUSIVE && consumer_id == -1) {
         update_min_read_index(rb);
@@ -267,7 +1351,7 @@ uint32_t jringbuf_size(jringbuf_t *rb, int consumer_id)
     } else {
         if (consumer_id >= 0 && (uint32_t)consumer_id < rb->max_consumers) {
             if (JRB_CONS_ACT(rb)[consumer_id]) {
-                sz = rb->write_index - JRB_CONS_IDX(rb)[consumer_id];
+                sz = rb->write_index - JRB_CONS_IDX(rb, consumer_id);
             }
         }
     }
@@ -294,7 +1378,7 @@ int jringbuf_members(jringbuf_t *rb, uint32_t *producers, uint32_t *consumers)
     if (!producers && !consumers)
         return -1;
 
-    jthread_mutex_lock(&rb->mutex);
+    jringbuf_lock(rb);
     if (producers)
         *producers = rb->max_producers > 1 ? rb->cur_producers : 1;
     if (consumers)
@@ -304,10 +1388,10 @@ int jringbuf_members(jringbuf_t *rb, uint32_t *producers, uint32_t *consumers)
 }
 
 /**
- * @brief   向缓冲区写入数据
+ * @brief   向缓冲区写入数据（不同步就绪描述符）
  */
-int jringbuf_write(jringbuf_t *rb, int producer_id, const void *data, uint32_t len,
-                   uint32_t strategy, int arg, uint32_t *pdropped)
+static int jringbuf_write_data(jringbuf_t *rb, int producer_id, const void *data, uint32_t len,
+                               uint32_t strategy, int arg, uint32_t *pdropped)
 {
     if (!rb || !data || !len)
         return -1;
@@ -321,9 +1405,15 @@ int jringbuf_write(jringbuf_t *rb, int producer_id, const void *data, uint32_t l
     uint32_t need = complete ? len : 1; /* 最少需要元素个数 */
     uint32_t drop_need, drop_amount;
     uint32_t to_write;
+    jringbuf_stats_t *st = jringbuf_stats_slot(rb, 0, producer_id);
+
+    if (rb->spsc)
+        return jringbuf_write_spsc(rb, data, len, strategy, arg, pdropped);
+    if (rb->lockfree)
+        return jringbuf_write_lockfree(rb, producer_id, data, len, strategy, arg);
 
 redo:
-    jthread_mutex_lock(&rb->mutex);
+    jringbuf_lock(rb);
     ++rb->rw_count;
 
     if (need > rb->capacity) {
@@ -343,12 +1433,21 @@ redo:
             goto err;
         }
 
-        /* 惰性更新 */
-        if (rb->min_read_stale)
-            update_min_read_index(rb);
+        if (rb->wr_reserved) {
+            /* 自己的预留没有提交前不能写入，等待也等不到 */
+            if (rb->max_producers == 1 || rb->wr_producer == producer_id) {
+                goto err;
+            }
+            /* 其它生产者预留了写空间，和空间不足一样处理，只在阻塞/重试策略下等待其提交 */
+            space = 0;
+        } else {
+            /* 惰性更新 */
+            if (rb->min_read_stale)
+                update_min_read_index(rb);
 
-        /* 获取可写剩余元素空间 */
-        space = rb->capacity - rb->data_len;
+            /* 获取可写剩余元素空间 */
+            space = rb->capacity - rb->data_len;
+        }
 
         /* 满足 len，直接跳出 */
         if (space >= len) {
@@ -362,34 +1461,29 @@ redo:
 
         /* 未满足条件，尝试等待或重试 */
         if (block) {
-            if (arg == -1) {
-                /* 无限等待 */
-                jthread_cond_wait(&rb->not_full, &rb->mutex);
-            } else {
-                /* 超时等待 */
-                uint64_t t1, t2;
-                t1 = jtime_monomsec_get();
-                jthread_cond_mtimewait(&rb->not_full, &rb->mutex, arg);
-                t2 = jtime_monomsec_get();
-                arg = ((int)(t2 - t1) < arg) ? (arg - (int)(t2 - t1)) : 0;
-            }
+            /* 自旋、让出CPU或睡眠等待（期间释放互斥锁），arg 为 -1 时无限等待 */
+            uint32_t seq = jrb_event_prepare(&rb->not_full);
+            jrb_event_wait(rb, &rb->not_full, seq, 1, &arg, st);
         } else { /* retry */
             if (arg > 0) {
                 --arg;
             }
+            JRB_STAT_ADD(st, retries, 1);
             jthread_mutex_unlock(&rb->mutex);
             jthread_yield();
-            jthread_mutex_lock(&rb->mutex);
+            jringbuf_lock(rb);
         }
     } while (1);
 
+    /* 预留期间不能丢弃旧数据腾出空间 */
+    if (rb->wr_reserved) {
+        goto err;
+    }
+
     /* 如果空间仍不够，且允许丢弃旧数据，则执行丢弃 */
     if (space < len && drop) {
         if (rb->min_read_lock) {
-            --rb->rw_count;
-            jthread_mutex_unlock(&rb->mutex);
-            jthread_yield();
-            goto redo;
+            goto yield_redo;
         }
 
         drop_need = len - space;               // 至少需要丢弃的元素个数
@@ -405,19 +1499,20 @@ redo:
             uint32_t new_min = rb->min_read_index + drop_amount;
             if (pdropped)
                 *pdropped = drop_amount;
+            JRB_STAT_ADD(st, drop_full, drop_amount);
 
             /* 移动消费者读位置，避免非法读 */
             if (rb->read_mode == JRINGBUF_READ_EXCLUSIVE && rb->max_consumers > 1) {
-                uint32_t *idx = JRB_CONS_IDX(rb);
                 uint8_t  *act = JRB_CONS_ACT(rb);
                 for (uint32_t i = 0, j = 0; i < rb->max_consumers && j < rb->cur_consumers; ++i) {
                     if (act[i]) {
                         ++j;
-                        if ((rb->write_index - idx[i]) > (rb->write_index - drop_amount)) {
-                            idx[i] = new_min;
+                        if ((rb->write_index - JRB_CONS_IDX(rb, i)) > (rb->write_index - new_min)) {
+                            JRB_CONS_IDX(rb, i) = new_min;
                         }
                     }
                 }
+                jringbuf_tree_build(rb);
             }
 
             rb->min_read_index = new_min;
@@ -439,36 +1534,33 @@ redo:
     to_write = (len <= space) ? len : space;
 
     {
-        /* 计算起始元素序号和字节偏移 */
-        uint32_t wpos  = rb->write_index & (rb->capacity - 1);
-        uint32_t tail  = rb->capacity - wpos;
-        uint32_t first = (to_write <= tail) ? to_write : tail;
-
         /* 单生产者优化：数据拷贝期间临时解锁 */
         if (rb->max_producers == 1)
             jthread_mutex_unlock(&rb->mutex);
 
-        /* 分段拷贝，避免跨越尾部 */
-        uint8_t *ring = JRB_BUF(rb);
-        memcpy(ring + wpos * rb->unit_size, data, first * rb->unit_size);
-        if (to_write > tail) {
-            memcpy(ring, (const uint8_t*)data + first * rb->unit_size, (to_write - tail) * rb->unit_size);
-        }
+        /* 跨越尾部时分段拷贝 */
+        jringbuf_copy_in(rb, rb->write_index, data, to_write);
 
         if (rb->max_producers == 1)
-            jthread_mutex_lock(&rb->mutex);
+            jringbuf_lock(rb);
 
         rb->write_index += to_write;
         rb->data_len    += to_write;
     }
 
     if (rb->data_len >= rb->wake_num)
-        jthread_cond_broadcast(&rb->not_empty);
+        jrb_event_wake(&rb->not_empty, 0);
     --rb->rw_count;
     jthread_mutex_unlock(&rb->mutex);
 
     return (int)to_write;
 
+yield_redo:
+    --rb->rw_count;
+    jthread_mutex_unlock(&rb->mutex);
+    jthread_yield();
+    goto redo;
+
 err:
     --rb->rw_count;
     jthread_mutex_unlock(&rb->mutex);
@@ -476,10 +1568,163 @@ err:
 }
 
 /**
- * @brief   从缓冲区读取数据
+ * @brief   向缓冲区写入数据
  */
-int jringbuf_read(jringbuf_t *rb, int consumer_id, void *buf, uint32_t len,
-                  uint32_t *size, uint32_t strategy, int arg)
+int jringbuf_write(jringbuf_t *rb, int producer_id, const void *data, uint32_t len,
+                   uint32_t strategy, int arg, uint32_t *pdropped)
+{
+    int ret = jringbuf_write_data(rb, producer_id, data, len, strategy, arg, pdropped);
+    jringbuf_stats_t *st;
+
+    if (rb && data && len && (st = jringbuf_stats_slot(rb, 0, producer_id)) != NULL) {
+        JRB_STAT_ADD(st, write_num, ret > 0 ? ret : 0);
+        JRB_STAT_ADD(st, write_bytes, (uint64_t)(ret > 0 ? ret : 0) * rb->unit_size);
+        JRB_STAT_ADD(st, write_short, len - (ret > 0 ? (uint32_t)ret : 0));
+        jringbuf_stats_sample(rb, st);
+    }
+    if (ret > 0)
+        jringbuf_evfd_sync(rb);
+    return ret;
+}
+
+/**
+ * @brief   预留写空间（零拷贝写入）
+ */
+int jringbuf_write_reserve(jringbuf_t *rb, int producer_id, uint32_t n,
+                           jringbuf_span_t *span1, jringbuf_span_t *span2)
+{
+    if (!rb || !n || !span1 || !span2 || rb->lockfree)
+        return -1;
+
+    uint32_t space, to_write;
+
+    if (rb->spsc) {
+        uint32_t w, r;
+
+        /* 只有一个生产者，已有预留未提交时是误用，不能修改 prod_busy */
+        if (rb->wr_reserved)
+            return -1;
+
+        jatomic32_store(&rb->prod_busy, 1);
+        jatomic_fence();
+        if (jatomic32_load(&rb->disable_rw)) {
+            goto err_spsc;
+        }
+
+        w = rb->write_index;
+        r = jatomic32_load_acquire(&rb->min_read_index);
+        rb->cached_read_index = r;
+        space = rb->capacity - (w - r);
+        if (!space) {
+            goto err_spsc;
+        }
+
+        /* 提交前保持 prod_busy，jringbuf_stop 会等待提交 */
+        to_write = (n <= space) ? n : space;
+        jringbuf_fill_span(rb, w, to_write, span1, span2);
+        rb->wr_reserved = to_write;
+        rb->wr_producer = 0;
+        return (int)to_write;
+
+err_spsc:
+        jatomic32_store_release(&rb->prod_busy, 0);
+        return -1;
+    }
+
+    jringbuf_lock(rb);
+    ++rb->rw_count;
+
+    if (rb->disable_rw) {
+        goto err;
+    }
+
+    if (rb->max_producers > 1
+        && (producer_id < 0 || (uint32_t)producer_id >= rb->max_producers
+            || !JRB_PROD_ACT(rb)[producer_id])) {
+        goto err;
+    }
+
+    /* 同一时刻只能有一个预留，已有预留（包括本生产者自己的）时和空间不足一样直接失败 */
+    if (rb->wr_reserved) {
+        goto err;
+    }
+
+    if (rb->min_read_stale)
+        update_min_read_index(rb);
+
+    space = rb->capacity - rb->data_len;
+    if (!space) {
+        goto err;
+    }
+
+    /* 提交前保持 rw_count 计数，其它生产者看到 wr_reserved 后失败或按策略等待 */
+    to_write = (n <= space) ? n : space;
+    jringbuf_fill_span(rb, rb->write_index, to_write, span1, span2);
+    rb->wr_reserved = to_write;
+    rb->wr_producer = rb->max_producers > 1 ? producer_id : 0;
+    jthread_mutex_unlock(&rb->mutex);
+    return (int)to_write;
+
+err:
+    --rb->rw_count;
+    jthread_mutex_unlock(&rb->mutex);
+    return -1;
+}
+
+/**
+ * @brief   提交预留的写空间
+ */
+int jringbuf_write_commit(jringbuf_t *rb, int producer_id, uint32_t n_used)
+{
+    if (!rb || rb->lockfree)
+        return -1;
+
+    if (rb->max_producers == 1)
+        producer_id = 0;
+
+    if (rb->spsc) {
+        if (!rb->wr_reserved || n_used > rb->wr_reserved)
+            return -1;
+
+        uint32_t w = rb->write_index + n_used;
+        rb->wr_reserved = 0;
+        if (n_used) {
+            jatomic32_store_release(&rb->write_index, w);
+            if (w - rb->cached_read_index >= rb->wake_num)
+                jrb_event_wake(&rb->not_empty, 0);
+        }
+        jatomic32_store_release(&rb->prod_busy, 0);
+        jringbuf_stats_span(rb, 0, producer_id, n_used);
+        jringbuf_evfd_sync(rb);
+        return 0;
+    }
+
+    jringbuf_lock(rb);
+    if (!rb->wr_reserved || rb->wr_producer != producer_id || n_used > rb->wr_reserved) {
+        jthread_mutex_unlock(&rb->mutex);
+        return -1;
+    }
+
+    rb->write_index += n_used;
+    rb->data_len    += n_used;
+    rb->wr_reserved  = 0;
+
+    if (n_used && rb->data_len >= rb->wake_num)
+        jrb_event_wake(&rb->not_empty, 0);
+    /* 唤醒因预留而阻塞等待的其它生产者 */
+    jrb_event_wake(&rb->not_full, 0);
+    --rb->rw_count;
+    jthread_mutex_unlock(&rb->mutex);
+    jringbuf_stats_span(rb, 0, producer_id, n_used);
+    jringbuf_evfd_sync(rb);
+    return 0;
+}
+
+/**
+ * @brief   从缓冲区读取数据（不同步就绪描述符）
+ */
+static int jringbuf_read_data(jringbuf_t *rb, int consumer_id, void *buf, uint32_t len,
+                              uint32_t *size, uint32_t strategy, int arg)
 {
     if (!rb || !buf || !len)
         return -1;
@@ -492,8 +1737,19 @@ int jringbuf_read(jringbuf_t *rb, int consumer_id, void *buf, uint32_t len,
     uint32_t need = complete ? len : 1;       /* 最少需要的数据量（元素个数） */
     uint32_t c_read = 0, to_read = 0;
     int shared_mode = 0;
+    jringbuf_stats_t *st = jringbuf_stats_slot(rb, 1, consumer_id);
+
+    if (rb->spsc)
+        return jringbuf_read_spsc(rb, buf, len, size, strategy, arg);
+    if (rb->lockfree) {
+        if (rb->max_consumers == 1)
+            consumer_id = 0;
+        else if (consumer_id < 0 || (uint32_t)consumer_id >= rb->max_consumers)
+            return -1;
+        return jringbuf_read_lockfree(rb, consumer_id, buf, len, size, strategy, arg);
+    }
 
-    jthread_mutex_lock(&rb->mutex);
+    jringbuf_lock(rb);
     ++rb->rw_count;
 
     /* 单消费者固定 ID 为 0，无需校验 active 数组 */
@@ -517,10 +1773,16 @@ int jringbuf_read(jringbuf_t *rb, int consumer_id, void *buf, uint32_t len,
         }
 
         /* 获取该消费者或全局可用元素个数 */
-        if (shared_mode) {
+        if (shared_mode && rb->rd_reserved) {
+            /* 自己窥视未释放时不能读取；共享读指针被其它消费者窥视中和没有数据一样处理，只在阻塞/重试策略下等待其释放 */
+            if (rb->max_consumers == 1 || rb->rd_consumer == consumer_id) {
+                goto err;
+            }
+            avail = 0;
+        } else if (shared_mode) {
             avail = rb->data_len;
         } else {
-            avail = rb->write_index - JRB_CONS_IDX(rb)[consumer_id];
+            avail = rb->write_index - JRB_CONS_IDX(rb, consumer_id);
         }
 
         /* 满足 need，直接跳出 */
@@ -534,89 +1796,339 @@ int jringbuf_read(jringbuf_t *rb, int consumer_id, void *buf, uint32_t len,
         }
 
         if (block) {
-            if (arg == -1) {
-                /* 无限等待 */
-                jthread_cond_wait(&rb->not_empty, &rb->mutex);
-            } else {
-                /* 超时等待 */
-                uint64_t t1, t2;
-                t1 = jtime_monomsec_get();
-                jthread_cond_mtimewait(&rb->not_empty, &rb->mutex, arg);
-                t2 = jtime_monomsec_get();
-                arg = ((int)(t2 - t1) < arg) ? (arg - (int)(t2 - t1)) : 0;
-            }
+            /* 自旋、让出CPU或睡眠等待（期间释放互斥锁），arg 为 -1 时无限等待 */
+            uint32_t seq = jrb_event_prepare(&rb->not_empty);
+            jrb_event_wait(rb, &rb->not_empty, seq, 1, &arg, st);
         } else { /* retry */
             if (arg > 0) {
                 --arg;
             }
+            JRB_STAT_ADD(st, retries, 1);
             jthread_mutex_unlock(&rb->mutex);
             jthread_yield();
-            jthread_mutex_lock(&rb->mutex);
+            jringbuf_lock(rb);
         }
     } while (1);
 
-    /* 最终校验：至少满足最小需求 */
-    if (avail < need) {
+    /* 最终校验：至少满足最小需求 */
+    if (avail < need) {
+        goto err;
+    }
+
+    /* 实际读取部分 */
+    if (size)
+        *size = avail;
+
+    c_read  = (rb->max_consumers == 1) ? rb->min_read_index :
+                       (rb->read_mode == JRINGBUF_READ_SHARED) ? rb->min_read_index :
+                       JRB_CONS_IDX(rb, consumer_id);
+    to_read = (len < avail) ? len : avail;
+
+    {
+        if (rb->max_consumers == 1) {
+            ++rb->min_read_lock;
+            jthread_mutex_unlock(&rb->mutex);
+        }
+
+        jringbuf_copy_out(rb, c_read, buf, to_read);
+
+        if (rb->max_consumers == 1) {
+            jringbuf_lock(rb);
+            --rb->min_read_lock;
+        }
+
+        /* 更新读位置 */
+        if (shared_mode) {
+            rb->min_read_index += to_read;
+            rb->data_len       -= to_read;
+        } else {
+            JRB_CONS_IDX(rb, consumer_id) += to_read;
+            jringbuf_tree_update(rb, consumer_id, 1);
+            if (!rb->min_read_stale && c_read == rb->min_read_index) {
+                rb->min_read_stale = 1;
+            }
+            rb->data_len = rb->write_index - rb->min_read_index;
+        }
+    }
+
+    jrb_event_wake(&rb->not_full, 0);
+    --rb->rw_count;
+    jthread_mutex_unlock(&rb->mutex);
+
+    return (int)to_read;
+err:
+    if (size)
+        *size = 0;
+    --rb->rw_count;
+    jthread_mutex_unlock(&rb->mutex);
+    return -1;
+}
+
+/**
+ * @brief   从缓冲区读取数据
+ */
+int jringbuf_read(jringbuf_t *rb, int consumer_id, void *buf, uint32_t len,
+                  uint32_t *size, uint32_t strategy, int arg)
+{
+    int ret = jringbuf_read_data(rb, consumer_id, buf, len, size, strategy, arg);
+    jringbuf_stats_t *st;
+
+    if (ret > 0) {
+        if ((st = jringbuf_stats_slot(rb, 1, consumer_id)) != NULL) {
+            JRB_STAT_ADD(st, read_num, ret);
+            JRB_STAT_ADD(st, read_bytes, (uint64_t)ret * rb->unit_size);
+        }
+        jringbuf_evfd_sync(rb);
+    }
+    return ret;
+}
+
+/**
+ * @brief   窥视可读数据（零拷贝读取）
+ */
+int jringbuf_read_peek(jringbuf_t *rb, int consumer_id, uint32_t max,
+                       jringbuf_span_t *span1, jringbuf_span_t *span2)
+{
+    if (!rb || !max || !span1 || !span2 || rb->lockfree)
+        return -1;
+
+    uint32_t c_read, avail, num;
+    int shared_mode;
+
+    if (rb->spsc) {
+        uint32_t w, r;
+
+        /* 只有一个消费者，已有窥视未释放时是误用，不能修改 cons_busy */
+        if (rb->rd_peek_num)
+            return -1;
+
+        jatomic32_store(&rb->cons_busy, 1);
+        jatomic_fence();
+        if (jatomic32_load(&rb->disable_rw)) {
+            goto err_spsc;
+        }
+
+        do {
+            r = jatomic32_load_acquire(&rb->min_read_index);
+            w = jatomic32_load_acquire(&rb->write_index);
+            avail = w - r;
+        } while (avail > rb->capacity);
+        rb->cached_write_index = w;
+        if (!avail) {
+            goto err_spsc;
+        }
+
+        /* 释放前保持 cons_busy，jringbuf_stop 会等待释放 */
+        num = (max < avail) ? max : avail;
+        jringbuf_fill_span(rb, r, num, span1, span2);
+        rb->rd_peek_num   = num;
+        rb->rd_peek_index = r;
+        return (int)num;
+
+err_spsc:
+        jatomic32_store_release(&rb->cons_busy, 0);
+        return -1;
+    }
+
+    jringbuf_lock(rb);
+    ++rb->rw_count;
+
+    if (rb->max_consumers == 1) {
+        consumer_id = 0;
+    } else if (consumer_id < 0 || (uint32_t)consumer_id >= rb->max_consumers) {
+        goto err;
+    }
+
+    if (rb->disable_rw) {
+        goto err;
+    }
+    if (rb->max_consumers > 1 && !JRB_CONS_ACT(rb)[consumer_id]) {
+        goto err;
+    }
+
+    shared_mode = (rb->max_consumers == 1 || rb->read_mode == JRINGBUF_READ_SHARED);
+    if (shared_mode) {
+        if (rb->rd_reserved) {
+            /* 共享读指针已被窥视（包括本消费者自己的），和没有数据一样直接失败 */
+            goto err;
+        }
+        c_read = rb->min_read_index;
+        avail  = rb->data_len;
+    } else {
+        if (JRB_CONS_PEEK(rb, consumer_id)) {
+            goto err;
+        }
+        c_read = JRB_CONS_IDX(rb, consumer_id);
+        avail  = rb->write_index - c_read;
+    }
+
+    if (!avail) {
         goto err;
     }
 
-    /* 实际读取部分 */
-    if (size)
-        *size = avail;
+    /* 释放前保持 rw_count，并增加 min_read_lock 阻止丢弃旧数据覆盖窥视的区域 */
+    num = (max < avail) ? max : avail;
+    jringbuf_fill_span(rb, c_read, num, span1, span2);
+    if (shared_mode) {
+        rb->rd_reserved = num;
+        rb->rd_consumer = consumer_id;
+    } else {
+        JRB_CONS_PEEK(rb, consumer_id) = num;
+    }
+    ++rb->min_read_lock;
+    jthread_mutex_unlock(&rb->mutex);
+    return (int)num;
 
-    c_read  = (rb->max_consumers == 1) ? rb->min_read_index :
-                       (rb->read_mode == JRINGBUF_READ_SHARED) ? rb->min_read_index :
-                       JRB_CONS_IDX(rb)[consumer_id];
-    to_read = (len < avail) ? len : avail;
+err:
+    --rb->rw_count;
+    jthread_mutex_unlock(&rb->mutex);
+    return -1;
+}
 
-    {
-        uint32_t rpos  = c_read & (rb->capacity - 1);
-        uint32_t tail  = rb->capacity - rpos;
-        uint32_t first = (to_read <= tail) ? to_read : tail;
+/**
+ * @brief   释放窥视的数据
+ */
+int jringbuf_read_release(jringbuf_t *rb, int consumer_id, uint32_t n)
+{
+    if (!rb || rb->lockfree)
+        return -1;
 
-        if (rb->max_consumers == 1) {
-            rb->min_read_lock = 1;
-            jthread_mutex_unlock(&rb->mutex);
-        }
+    uint32_t peeked;
+    int shared_mode, ret = 0;
 
-        uint8_t *ring = JRB_BUF(rb);
-        memcpy(buf, ring + rpos * rb->unit_size, first * rb->unit_size);
-        if (to_read > tail) {
-            memcpy((uint8_t*)buf + first * rb->unit_size, ring, (to_read - tail) * rb->unit_size);
-        }
+    if (rb->spsc) {
+        uint32_t r = rb->rd_peek_index;
 
-        if (rb->max_consumers == 1) {
-            jthread_mutex_lock(&rb->mutex);
-            rb->min_read_lock = 0;
+        if (!rb->rd_peek_num || n > rb->rd_peek_num)
+            return -1;
+
+        rb->rd_peek_num = 0;
+        if (n) {
+            /* 窥视期间生产者丢弃了这段数据时CAS失败，数据可能已被覆盖 */
+            if (jatomic32_cas(&rb->min_read_index, &r, r + n))
+                jrb_event_wake(&rb->not_full, 0);
+            else
+                ret = -1;
         }
+        jatomic32_store_release(&rb->cons_busy, 0);
+        if (ret == 0)
+            jringbuf_stats_span(rb, 1, consumer_id, n);
+        jringbuf_evfd_sync(rb);
+        return ret;
+    }
 
-        /* 更新读位置 */
-        if (shared_mode) {
-            rb->min_read_index += to_read;
-            rb->data_len       -= to_read;
-        } else {
-            uint32_t *idx = JRB_CONS_IDX(rb);
-            idx[consumer_id] += to_read;
+    jringbuf_lock(rb);
+    if (rb->max_consumers == 1) {
+        consumer_id = 0;
+    } else if (consumer_id < 0 || (uint32_t)consumer_id >= rb->max_consumers) {
+        goto err;
+    }
+
+    shared_mode = (rb->max_consumers == 1 || rb->read_mode == JRINGBUF_READ_SHARED);
+    if (shared_mode) {
+        peeked = (rb->rd_consumer == consumer_id) ? rb->rd_reserved : 0;
+    } else {
+        peeked = JRB_CONS_PEEK(rb, consumer_id);
+    }
+    if (!peeked || n > peeked) {
+        goto err;
+    }
+
+    if (shared_mode) {
+        rb->rd_reserved     = 0;
+        rb->min_read_index += n;
+        rb->data_len       -= n;
+        /* 唤醒因窥视而阻塞等待的其它消费者 */
+        if (rb->data_len)
+            jrb_event_wake(&rb->not_empty, 0);
+    } else {
+        JRB_CONS_PEEK(rb, consumer_id) = 0;
+        if (JRB_CONS_ACT(rb)[consumer_id]) {
+            /* 和读取一样，最慢的消费者前进时惰性更新 min_read_index */
+            uint32_t c_read = JRB_CONS_IDX(rb, consumer_id);
+            JRB_CONS_IDX(rb, consumer_id) += n;
+            jringbuf_tree_update(rb, consumer_id, 1);
             if (!rb->min_read_stale && c_read == rb->min_read_index) {
                 rb->min_read_stale = 1;
             }
-            rb->data_len = rb->write_index - rb->min_read_index;
         }
     }
 
-    jthread_cond_broadcast(&rb->not_full);
+    --rb->min_read_lock;
+    if (n)
+        jrb_event_wake(&rb->not_full, 0);
     --rb->rw_count;
     jthread_mutex_unlock(&rb->mutex);
+    jringbuf_stats_span(rb, 1, consumer_id, n);
+    jringbuf_evfd_sync(rb);
+    return 0;
 
-    return (int)to_read;
 err:
-    if (size)
-        *size = 0;
-    --rb->rw_count;
     jthread_mutex_unlock(&rb->mutex);
     return -1;
 }
 
+/*----------------------------------------------------------------------------
+  对外接口：直接写出到文件描述符
+----------------------------------------------------------------------------*/
+
+int jringbuf_read_to_fd(jringbuf_t *rb, int consumer_id, int fd, uint32_t max, uint32_t flags)
+{
+    if (!rb || fd < 0)
+        return -1;
+
+    jringbuf_span_t span1, span2;
+    jfs_iovec_t iov[2];
+    uint32_t num, done, rem;
+    ssize_t n;
+    int cnt, ret;
+
+    ret = jringbuf_read_peek(rb, consumer_id, max ? max : rb->capacity, &span1, &span2);
+    if (ret < 0)
+        return -1;
+    num = (uint32_t)ret;
+
+    /* iovec 直接指向缓冲区中的一段或两段数据 */
+    iov[0].iov_base = span1.data;
+    iov[0].iov_len  = (size_t)span1.len * rb->unit_size;
+    iov[1].iov_base = span2.data;
+    iov[1].iov_len  = (size_t)span2.len * rb->unit_size;
+    cnt = span2.len ? 2 : 1;
+
+    do {
+        n = jfs_writev(fd, iov, cnt);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        ret = errno;
+        jringbuf_read_release(rb, consumer_id, 0);
+        errno = ret;
+        return -1;
+    }
+
+    done = (uint32_t)((size_t)n / rb->unit_size);
+    rem  = (uint32_t)((size_t)n % rb->unit_size);
+    if (done < num && (rem || (flags & JRINGBUF_FD_ALL))) {
+        /* 补写只写出一部分的元素（JRINGBUF_FD_ALL时为全部剩余元素），接收端不会看到半个元素 */
+        uint32_t target = (flags & JRINGBUF_FD_ALL) ? num : done + 1;
+        size_t end = (size_t)target * rb->unit_size;
+
+        if (end <= iov[0].iov_len) {
+            iov[0].iov_len = end;
+            cnt = 1;
+        } else {
+            iov[1].iov_len = end - iov[0].iov_len;
+        }
+        if (jfs_writev_full(fd, iov, cnt, (size_t)n, JRINGBUF_FD_WAIT_MS) == 0)
+            done = target;
+        else if (rem)
+            ++done; /* 已写出一部分的元素不能重发，也算作消费 */
+    }
+
+    if (jringbuf_read_release(rb, consumer_id, done) < 0)
+        return -1;
+    return (int)done;
+}
+
 /*----------------------------------------------------------------------------
   生产者管理
 ----------------------------------------------------------------------------*/
@@ -631,7 +2143,7 @@ int jringbuf_add_producer(jringbuf_t *rb)
     if (rb->max_producers == 1)
         return 0;
 
-    jthread_mutex_lock(&rb->mutex);
+    jringbuf_lock(rb);
     uint8_t *prod = JRB_PROD_ACT(rb);
     uint32_t i = rb->cur_producers;
     if (rb->cur_producers < rb->max_producers) {
@@ -664,7 +2176,7 @@ int jringbuf_del_producer(jringbuf_t *rb, int producer_id)
         return (producer_id == 0 || producer_id == -1) ? 0 : -1;
     }
 
-    jthread_mutex_lock(&rb->mutex);
+    jringbuf_lock(rb);
     uint8_t *prod = JRB_PROD_ACT(rb);
     if (producer_id == -1) {
         for (uint32_t i = 0; i < rb->max_producers; ++i)
@@ -681,8 +2193,9 @@ int jringbuf_del_producer(jringbuf_t *rb, int producer_id)
     --rb->cur_producers;
 
 end:
-    jthread_cond_broadcast(&rb->not_full);
+    jrb_event_wake(&rb->not_full, 0);
     jthread_mutex_unlock(&rb->mutex);
+    jringbuf_evfd_sync(rb);
     return 0;
 }
 
@@ -700,7 +2213,7 @@ int jringbuf_add_consumer(jringbuf_t *rb, int use_ridx)
     if (rb->max_consumers == 1)
         return 0;
 
-    jthread_mutex_lock(&rb->mutex);
+    jringbuf_lock(rb);
     uint8_t  *act = JRB_CONS_ACT(rb);
     uint32_t i = rb->cur_consumers;
     if (rb->cur_consumers < rb->max_consumers) {
@@ -719,10 +2232,12 @@ end:
     act[i] = 1;
     ++rb->cur_consumers;
     if (rb->read_mode == JRINGBUF_READ_EXCLUSIVE) {
-        uint32_t *idx = JRB_CONS_IDX(rb);
-        idx[i] = use_ridx ? rb->min_read_index : rb->write_index; // 初始读位置（元素）
+        JRB_CONS_IDX(rb, i) = use_ridx ? rb->min_read_index : rb->write_index; // 初始读位置（元素）
+        JRB_CONS_PEEK(rb, i) = 0;
+        jringbuf_tree_update(rb, i, 0);
     }
     jthread_mutex_unlock(&rb->mutex);
+    jringbuf_evfd_sync(rb);
     return (int)i;
 }
 
@@ -735,22 +2250,34 @@ int jringbuf_del_consumer(jringbuf_t *rb, int consumer_id)
         return -1;
     if (rb->max_consumers == 1) {
         if (consumer_id == 0 || consumer_id == -1) {
-            jthread_mutex_lock(&rb->mutex);
-            rb->min_read_index = rb->write_index;
-            rb->data_len       = 0;
-            jthread_cond_broadcast(&rb->not_full);
+            jringbuf_lock(rb);
+            if (rb->spsc) {
+                uint32_t r = jatomic32_load_acquire(&rb->min_read_index);
+                while (!jatomic32_cas(&rb->min_read_index, &r, jatomic32_load_acquire(&rb->write_index)));
+            } else if (rb->lockfree) {
+                jthread_mutex_unlock(&rb->mutex);
+                jringbuf_read_lockfree(rb, -1, NULL, rb->capacity, NULL, 0, 0);
+                jringbuf_lock(rb);
+            } else {
+                rb->min_read_index = rb->write_index;
+                rb->data_len       = 0;
+            }
+            jrb_event_wake(&rb->not_full, 0);
             jthread_mutex_unlock(&rb->mutex);
+            jringbuf_evfd_sync(rb);
             return 0;
         }
         return -1;
     }
 
-    jthread_mutex_lock(&rb->mutex);
+    jringbuf_lock(rb);
     uint8_t *act = JRB_CONS_ACT(rb);
     if (consumer_id == -1) {
         for (uint32_t i = 0; i < rb->max_consumers; ++i)
             act[i] = 0;
         rb->cur_consumers = 0;
+        if (rb->read_mode == JRINGBUF_READ_EXCLUSIVE)
+            jringbuf_tree_build(rb);
         goto end;
     }
 
@@ -760,12 +2287,15 @@ int jringbuf_del_consumer(jringbuf_t *rb, int consumer_id)
     }
     act[consumer_id] = 0;
     --rb->cur_consumers;
+    if (rb->read_mode == JRINGBUF_READ_EXCLUSIVE)
+        jringbuf_tree_update(rb, consumer_id, 0);
 
 end:
     update_min_read_index(rb);
-    jthread_cond_broadcast(&rb->not_full);
-    jthread_cond_broadcast(&rb->not_empty);
+    jrb_event_wake(&rb->not_full, 0);
+    jrb_event_wake(&rb->not_empty, 0);
     jthread_mutex_unlock(&rb->mutex);
+    jringbuf_evfd_sync(rb);
     return 0;
 }
 
@@ -777,11 +2307,42 @@ int jringbuf_drop_data(jringbuf_t *rb, int consumer_id, uint32_t dropped)
     if (!rb)
         return -1;
 
-    jthread_mutex_lock(&rb->mutex);
+    jringbuf_stats_t *st = jringbuf_stats_slot(rb, 1, consumer_id < 0 ? 0 : consumer_id);
+
+    if (rb->spsc) {
+        /* 无锁模式：和读写者竞争前移 min_read_index */
+        if (consumer_id != 0 && consumer_id != -1)
+            return -1;
+
+        uint32_t r = jatomic32_load_acquire(&rb->min_read_index);
+        uint32_t avail, drop;
+        do {
+            avail = jatomic32_load_acquire(&rb->write_index) - r;
+            drop = (dropped == 0 || dropped > avail) ? avail : dropped;
+        } while (!jatomic32_cas(&rb->min_read_index, &r, r + drop));
+
+        JRB_STAT_ADD(st, drop_user, drop);
+        jrb_event_wake(&rb->not_full, 0);
+        jringbuf_evfd_sync(rb);
+        return 0;
+    }
+
+    if (rb->lockfree) {
+        /* 无锁模式只有共享读，和读取一样认领后丢弃 */
+        if (consumer_id != -1 && (rb->max_consumers == 1 ? consumer_id != 0 :
+            (consumer_id < 0 || (uint32_t)consumer_id >= rb->max_consumers || !JRB_CONS_ACT(rb)[consumer_id])))
+            return -1;
+        int ret = jringbuf_read_lockfree(rb, -1, NULL, dropped ? dropped : rb->capacity, NULL, 0, 0);
+        JRB_STAT_ADD(st, drop_user, ret > 0 ? ret : 0);
+        jringbuf_evfd_sync(rb);
+        return 0;
+    }
+
+    jringbuf_lock(rb);
     while (rb->min_read_lock) {
         jthread_mutex_unlock(&rb->mutex);
         jthread_yield();
-        jthread_mutex_lock(&rb->mutex);
+        jringbuf_lock(rb);
     }
 
     uint32_t avail, drop;
@@ -798,15 +2359,16 @@ int jringbuf_drop_data(jringbuf_t *rb, int consumer_id, uint32_t dropped)
     act = JRB_CONS_ACT(rb);
     if (consumer_id == -1) {
         if (rb->read_mode == JRINGBUF_READ_EXCLUSIVE) {
-            uint32_t *idx = JRB_CONS_IDX(rb);
             for (uint32_t i = 0, j = 0; i < rb->max_consumers && j < rb->cur_consumers; ++i) {
                 if (act[i]) {
-                    avail = rb->write_index - idx[i];
+                    avail = rb->write_index - JRB_CONS_IDX(rb, i);
                     drop = (dropped == 0 || dropped > avail) ? avail : dropped;
-                    idx[i] += drop;
+                    JRB_CONS_IDX(rb, i) += drop;
+                    JRB_STAT_ADD(jringbuf_stats_slot(rb, 1, (int)i), drop_user, drop);
                     ++j;
                 }
             }
+            jringbuf_tree_build(rb);
             update_min_read_index(rb);
             goto end1;
         } else {
@@ -820,10 +2382,11 @@ int jringbuf_drop_data(jringbuf_t *rb, int consumer_id, uint32_t dropped)
     }
 
     if (rb->read_mode == JRINGBUF_READ_EXCLUSIVE) {
-        uint32_t *idx = JRB_CONS_IDX(rb);
-        avail = rb->write_index - idx[consumer_id];
+        avail = rb->write_index - JRB_CONS_IDX(rb, consumer_id);
         drop = (dropped == 0 || dropped > avail) ? avail : dropped;
-        idx[consumer_id] += drop;
+        JRB_CONS_IDX(rb, consumer_id) += drop;
+        JRB_STAT_ADD(st, drop_user, drop);
+        jringbuf_tree_update(rb, consumer_id, 1);
         update_min_read_index(rb);
         goto end1;
     } else {
@@ -836,9 +2399,365 @@ end2:
     drop = (dropped == 0 || dropped > avail) ? avail : dropped;
     rb->min_read_index += drop;
     rb->data_len       -= drop;
+    JRB_STAT_ADD(st, drop_user, drop);
 end1:
-    jthread_cond_broadcast(&rb->not_full);
+    jrb_event_wake(&rb->not_full, 0);
     jthread_mutex_unlock(&rb->mutex);
+    jringbuf_evfd_sync(rb);
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+  就绪描述符
+----------------------------------------------------------------------------*/
+
+/**
+ * @brief   获取消费者的数据就绪描述符
+ */
+int jringbuf_get_event_fd(jringbuf_t *rb, int consumer_id)
+{
+    if (!rb)
+        return -1;
+    if (rb->max_consumers == 1)
+        consumer_id = 0;
+    else if (consumer_id < 0 || (uint32_t)consumer_id >= rb->max_consumers)
+        return -1;
+
+    return jringbuf_evfd_get(rb, rb->read_mode == JRINGBUF_READ_EXCLUSIVE ? 1 + (uint32_t)consumer_id : 1);
+}
+
+/**
+ * @brief   获取生产者的空间就绪描述符
+ */
+int jringbuf_get_space_fd(jringbuf_t *rb)
+{
+    if (!rb)
+        return -1;
+
+    return jringbuf_evfd_get(rb, 0);
+}
+
+/**
+ * @brief   获取统计信息
+ */
+int jringbuf_stats_get(jringbuf_t *rb, jringbuf_stats_t *stats)
+{
+    if (!rb || !stats || !rb->stats_num)
+        return -1;
+
+    uint64_t *dst = (uint64_t *)stats;
+    uint32_t num = sizeof(jringbuf_stats_t) / sizeof(uint64_t);
+
+    memset(stats, 0, sizeof(jringbuf_stats_t));
+    for (uint32_t i = 0; i < rb->stats_num; ++i) {
+        uint64_t *src = (uint64_t *)JRB_STATS(rb, i);
+        for (uint32_t j = 0; j < num; ++j)
+            dst[j] += jatomic64_load(&src[j]);
+    }
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+  分片环形缓冲区
+----------------------------------------------------------------------------*/
+
+/**
+ * @brief 分片状态，每个分片独占一个缓存行，避免生产者读取自己的分片时和消费者更新排序键伪共享
+ */
+typedef struct {
+    jringbuf_t     *rb;                 // 子环形缓冲区（单生产者单消费者）
+    uint32_t        active;             // 1 表示已分配给生产者
+    uint32_t        key_valid;          // 1 表示 key 为分片头部元素的排序键（合并读取）
+    uint64_t        key;                // 分片头部元素的排序键
+    uint8_t         pad[JRB_CACHELINE - sizeof(jringbuf_t*) - 2 * sizeof(uint32_t) - sizeof(uint64_t)];
+} jrb_shard_slot_t;
+
+/**
+ * @brief 分片环形缓冲区管理器
+ *
+ * 生产者只访问自己分片的子环形缓冲区，写位置不在生产者之间共享；合并消费者读取所有分片。
+ * 子环形缓冲区的 not_empty 事件只对各自的消费者有效，因此消费者阻塞时在管理器的 not_empty 事件上等待，
+ * 生产者写入后检查此事件的等待者（没有等待者时只有一次内存屏障和读取）。
+ */
+struct jringbuf_shard {
+    uint32_t        shard_num;          // 分片个数
+    uint32_t        cur_producers;      // 当前生产者数量
+    uint32_t        unit_size;          // 单个元素大小（字节）
+    uint32_t        wake_num;           // 唤醒窗口大小（元素个数）
+    uint32_t        next;               // 轮询读取的起始分片
+    uint32_t        disable_rw;         // 是否禁止读写
+    uint32_t        cons_busy;          // 消费者正在读
+    jringbuf_shard_key_t get_key;       // 排序键回调，为NULL时轮询
+    jthread_mutex_t mutex;              // 生产者管理互斥锁
+
+    uint8_t         pad0[JRB_CACHELINE];
+    jrb_event_t     not_empty;          // 任一分片数据可用事件
+    uint8_t         pad1[JRB_CACHELINE - sizeof(jrb_event_t)];
+
+    jrb_shard_slot_t slot[];            // 分片状态数组
+};
+
+/**
+ * @brief   所有分片中的有效元素个数
+ */
+static uint32_t jringbuf_shard_avail(jringbuf_shard_t *sh)
+{
+    uint32_t avail = 0;
+
+    for (uint32_t i = 0; i < sh->shard_num; ++i)
+        avail += jringbuf_spsc_avail(sh->slot[i].rb, 1);
+    return avail;
+}
+
+/**
+ * @brief   窥视分片头部元素并获取其排序键
+ * @return  分片有数据返回1；没有数据返回0
+ */
+static int jringbuf_shard_peek_key(jringbuf_shard_t *sh, jrb_shard_slot_t *slot)
+{
+    jringbuf_span_t span1, span2;
+
+    if (!slot->key_valid) {
+        if (jringbuf_read_peek(slot->rb, 0, 1, &span1, &span2) != 1)
+            return 0;
+        slot->key = sh->get_key(span1.data);
+        slot->key_valid = 1;
+        jringbuf_read_release(slot->rb, 0, 0);
+    }
+    return 1;
+}
+
+/**
+ * @brief   创建分片环形缓冲区
+ */
+jringbuf_shard_t* jringbuf_shard_init(const jringbuf_cfg_t *cfg, jringbuf_shard_key_t get_key)
+{
+    if (!cfg || cfg->max_producers < 1)
+        return NULL;
+
+    jringbuf_shard_t *sh = (jringbuf_shard_t*)jheap_malloc(sizeof(jringbuf_shard_t)
+        + cfg->max_producers * sizeof(jrb_shard_slot_t));
+    if (!sh)
+        return NULL;
+    memset(sh, 0, sizeof(jringbuf_shard_t) + cfg->max_producers * sizeof(jrb_shard_slot_t));
+
+    jringbuf_cfg_t sub = *cfg;
+    sub.max_producers = 1;
+    sub.max_consumers = 1;
+    sub.hold_num = 0;
+    sub.read_mode = JRINGBUF_READ_SHARED;
+    sub.flags &= ~JRINGBUF_LOCKFREE;
+
+    sh->shard_num = cfg->max_producers;
+    sh->unit_size = cfg->unit_size;
+    sh->wake_num = cfg->wake_num;
+    sh->get_key = get_key;
+    for (uint32_t i = 0; i < sh->shard_num; ++i) {
+        sh->slot[i].rb = jringbuf_init(&sub);
+        if (!sh->slot[i].rb) {
+            while (i--)
+                jringbuf_uninit(sh->slot[i].rb);
+            jheap_free(sh);
+            return NULL;
+        }
+    }
+    jthread_mutex_init(&sh->mutex);
+    return sh;
+}
+
+/**
+ * @brief   销毁分片环形缓冲区
+ */
+void jringbuf_shard_uninit(jringbuf_shard_t *sh)
+{
+    if (!sh)
+        return;
+
+    jringbuf_shard_stop(sh);
+    for (uint32_t i = 0; i < sh->shard_num; ++i)
+        jringbuf_uninit(sh->slot[i].rb);
+    jthread_mutex_destroy(&sh->mutex);
+    jheap_free(sh);
+}
+
+/**
+ * @brief   允许读写
+ */
+int jringbuf_shard_start(jringbuf_shard_t *sh)
+{
+    if (!sh)
+        return -1;
+
+    for (uint32_t i = 0; i < sh->shard_num; ++i)
+        jringbuf_start(sh->slot[i].rb);
+    jatomic32_store(&sh->disable_rw, 0);
+    return 0;
+}
+
+/**
+ * @brief   停止并禁止读写
+ */
+void jringbuf_shard_stop(jringbuf_shard_t *sh)
+{
+    if (!sh)
+        return;
+
+    jatomic32_store(&sh->disable_rw, 1);
+    jatomic_fence();
+    for (uint32_t i = 0; i < sh->shard_num; ++i)
+        jringbuf_stop(sh->slot[i].rb);
+    while (jatomic32_load(&sh->cons_busy)) {
+        jrb_event_wake(&sh->not_empty, 1);
+        jthread_yield();
+    }
+}
+
+/**
+ * @brief   添加一个生产者，返回生产者 ID
+ */
+int jringbuf_shard_add_producer(jringbuf_shard_t *sh)
+{
+    if (!sh)
+        return -1;
+
+    jthread_mutex_lock(&sh->mutex);
+    for (uint32_t i = 0; i < sh->shard_num; ++i) {
+        if (!sh->slot[i].active) {
+            sh->slot[i].active = 1;
+            ++sh->cur_producers;
+            jthread_mutex_unlock(&sh->mutex);
+            return (int)i;
+        }
+    }
+    jthread_mutex_unlock(&sh->mutex);
+    return -1;
+}
+
+/**
+ * @brief   移除一个生产者
+ */
+int jringbuf_shard_del_producer(jringbuf_shard_t *sh, int producer_id)
+{
+    if (!sh || producer_id < 0 || (uint32_t)producer_id >= sh->shard_num)
+        return -1;
+
+    jthread_mutex_lock(&sh->mutex);
+    if (!sh->slot[producer_id].active) {
+        jthread_mutex_unlock(&sh->mutex);
+        return -1;
+    }
+    sh->slot[producer_id].active = 0;
+    --sh->cur_producers;
+    jthread_mutex_unlock(&sh->mutex);
     return 0;
 }
 
+/**
+ * @brief   获取所有分片中的有效元素个数
+ */
+uint32_t jringbuf_shard_size(jringbuf_shard_t *sh)
+{
+    return sh ? jringbuf_shard_avail(sh) : 0;
+}
+
+/**
+ * @brief   向生产者自己的分片写入数据
+ */
+int jringbuf_shard_write(jringbuf_shard_t *sh, int producer_id, const void *data, uint32_t len,
+                         uint32_t strategy, int arg, uint32_t *pdropped)
+{
+    if (!sh || producer_id < 0 || (uint32_t)producer_id >= sh->shard_num)
+        return -1;
+
+    jrb_shard_slot_t *slot = &sh->slot[producer_id];
+    if (!jatomic32_load(&slot->active))
+        return -1;
+
+    int ret = jringbuf_write(slot->rb, 0, data, len, strategy, arg, pdropped);
+    if (ret > 0 && jringbuf_spsc_avail(slot->rb, 1) >= sh->wake_num)
+        jrb_event_wake(&sh->not_empty, 0);
+    return ret;
+}
+
+/**
+ * @brief   从所有分片中读取数据
+ */
+int jringbuf_shard_read(jringbuf_shard_t *sh, void *buf, uint32_t len, uint32_t *size,
+                        uint32_t strategy, int arg)
+{
+    if (!sh || !buf || !len)
+        return -1;
+
+    int complete = (strategy & JRINGBUF_COMPLETE) ? 1 : 0;
+    int block    = (strategy & JRINGBUF_BLOCK)    ? 1 : 0;
+    int retry    = (strategy & JRINGBUF_RETRY)    ? 1 : 0;
+    uint32_t need = complete ? len : 1;
+    uint32_t avail, seq, num = 0;
+    uint8_t *out = (uint8_t*)buf;
+    int ret = -1;
+
+    jatomic32_store(&sh->cons_busy, 1);
+    jatomic_fence();
+
+    do {
+        if (jatomic32_load(&sh->disable_rw))
+            goto end;
+
+        avail = jringbuf_shard_avail(sh);
+        if (avail >= need)
+            break;
+
+        if ((!block && !retry) || !arg)
+            goto end;
+
+        if (block) {
+            /* 和 jringbuf_spsc_wait 一样先登记再检查，自旋参数和子环形缓冲区相同 */
+            seq = jrb_event_prepare(&sh->not_empty);
+            if (!jatomic32_load(&sh->disable_rw) && jringbuf_shard_avail(sh) < need)
+                jrb_event_wait(sh->slot[0].rb, &sh->not_empty, seq, 0, &arg, NULL);
+            else
+                jrb_event_cancel(&sh->not_empty);
+        } else {
+            if (arg > 0)
+                --arg;
+            jthread_yield();
+        }
+    } while (1);
+
+    if (!sh->get_key) {
+        /* 轮询：从上次结束的下一个分片开始，依次读完每个分片 */
+        for (uint32_t i = 0; i < sh->shard_num && num < len; ++i) {
+            uint32_t index = sh->next;
+            int n = jringbuf_read(sh->slot[index].rb, 0, out + num * sh->unit_size, len - num, NULL, 0, 0);
+            if (n > 0)
+                num += n;
+            sh->next = (index + 1 == sh->shard_num) ? 0 : index + 1;
+        }
+    } else {
+        /* 合并：每次取头部排序键最小的分片中的一个元素 */
+        while (num < len) {
+            jrb_shard_slot_t *best = NULL;
+            for (uint32_t i = 0; i < sh->shard_num; ++i) {
+                jrb_shard_slot_t *slot = &sh->slot[i];
+                if (jringbuf_shard_peek_key(sh, slot) && (!best || slot->key < best->key))
+                    best = slot;
+            }
+            if (!best)
+                break;
+            best->key_valid = 0;
+            if (jringbuf_read(best->rb, 0, out + num * sh->unit_size, 1, NULL, 0, 0) == 1)
+                ++num;
+        }
+    }
+
+    if (size)
+        *size = avail;
+    ret = (int)num;
+
+end:
+    if (ret < 0 && size)
+        *size = 0;
+    jatomic32_store_release(&sh->cons_busy, 0);
+    return ret;
+}
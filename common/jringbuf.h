@@ -40,10 +40,74 @@ enum jringbuf_read_mode {
     JRINGBUF_READ_EXCLUSIVE     // 独立读指针：所有消费者都读过某数据后空间才释放
 };
 
+/**
+ * @brief   缓冲区特性标志（jringbuf_cfg_t.flags，可按位或）
+ * @note    JRINGBUF_LOCKFREE：多生产者/多消费者无锁模式，生产者和消费者先检查每个槽位的
+ *          序号确认槽位可写/可读，再用CAS认领，不经过互斥锁。限制如下：
+ *          1. 只支持共享读模式（JRINGBUF_READ_EXCLUSIVE且多消费者时创建失败），hold_num无效
+ *          2. 不支持 JRINGBUF_DROP 策略（忽略），不支持零拷贝预留和窥视接口
+ *          3. 单生产者单消费者时总是使用更快的SPSC无锁模式，此标志无效
+ *          4. 容量至少为2（序号无法区分容量为1时的满和空），小于2时取2
+ *          JRINGBUF_MIRROR：数据缓冲区使用镜像映射（同一块内存连续映射两次），任意不超过容量的区域
+ *          在虚拟地址上都连续，读写不再分段拷贝，零拷贝预留和窥视总是只返回一段。限制如下：
+ *          1. 缓冲区字节数需要是映射粒度（posix为页大小，windows为64KB）的整数倍，
+ *             容量不足时自动增大，unit_size不是2的幂导致无法对齐时创建失败
+ *          2. 不支持共享内存模式（jringbuf_init_shm）
+ *          JRINGBUF_STATS：记录统计信息，每个生产者和消费者各有一组计数（各占独立的缓存行），
+ *          由读写者自己原子累加，jringbuf_stats_get 时才汇总；未开启时读写路径只多一次判断
+ */
+enum jringbuf_flag {
+    JRINGBUF_LOCKFREE = 1,      // 多生产者/多消费者无锁模式
+    JRINGBUF_MIRROR   = 1 << 1, // 数据缓冲区镜像映射
+    JRINGBUF_STATS    = 1 << 2  // 记录统计信息
+};
+
+/**
+ * @brief   jringbuf_read_to_fd 的标志（可按位或）
+ */
+enum jringbuf_fd_flag {
+    JRINGBUF_FD_ALL   = 1       // 写出窥视到的全部数据才返回，否则只调用一次writev（补写不完整的元素除外）
+};
+
+#define JRINGBUF_FD_WAIT_MS 1000 // jringbuf_read_to_fd 补写时非阻塞描述符最多等待可写的毫秒数
+
+#define JRINGBUF_HIST_NUM   33  // 占用直方图的桶数
+
+/**
+ * @brief   统计信息（JRINGBUF_STATS）
+ * @note    occupancy 是每次写入后缓冲区中元素个数的 log2 直方图：
+ *          [0] 为 0 个，[k] 为 [2^(k-1), 2^k) 个，用于根据实际数据选择 capacity 和 wake_num
+ */
+typedef struct jringbuf_stats {
+    uint64_t write_num;         // 写入的元素个数（包括零拷贝提交的）
+    uint64_t write_bytes;       // 写入的字节数
+    uint64_t write_short;       // 请求写入但没有写入的元素个数（空间不足、停止读写等）
+    uint64_t read_num;          // 读取的元素个数（包括零拷贝释放的）
+    uint64_t read_bytes;        // 读取的字节数
+    uint64_t drop_full;         // 写入时 JRINGBUF_DROP 丢弃的旧元素个数
+    uint64_t drop_user;         // jringbuf_drop_data 丢弃的元素个数
+    uint64_t block_waits;       // JRINGBUF_BLOCK 等待的次数
+    uint64_t block_nsec;        // JRINGBUF_BLOCK 等待的总时间（纳秒）
+    uint64_t retries;           // JRINGBUF_RETRY 重试的次数
+    uint64_t occupancy[JRINGBUF_HIST_NUM]; // 写入后元素个数的 log2 直方图
+} jringbuf_stats_t;
+
+/**
+ * @brief   零拷贝读写时环形缓冲区中的一段连续内存
+ * @note    预留或窥视的区域跨越缓冲区尾部时分为两段（JRINGBUF_MIRROR时不分段），否则第二段的len为0
+ */
+typedef struct jringbuf_span {
+    void *data;                 // 连续内存起始地址
+    uint32_t len;               // 连续内存的元素个数
+} jringbuf_span_t;
+
 /**
  * @brief   缓冲区初始化参数
  * @note    1. hold_num用于更新min_read_index保留一定数量的元素，以便新消费者可以消费历史数据
  *          2. 多生产者需要显式 jringbuf_add_producer，多消费者需要显式 jringbuf_add_consumer，单的无需
+ *          3. spin_num/yield_num是JRINGBUF_BLOCK的等待策略：先自旋spin_num次(每次执行CPU暂停指令)，
+ *             再让出CPU yield_num次，条件仍不满足时才在futex上睡眠；都为0时立即睡眠。
+ *             对端通常在几微秒内发布数据的流水线(线程绑核)适合设置较大的spin_num
  */
 typedef struct jringbuf_cfg {
     uint32_t capacity;          // 缓冲区元素个数，内部会向上对齐到2的幂，实际字节容量 = capacity * unit_size
@@ -53,6 +117,9 @@ typedef struct jringbuf_cfg {
     uint32_t hold_num;          // 是否保留一定的历史数据以便新消费者可以消费历史数据（为 0 时不保留），单位：元素个数
     uint32_t wake_num;          // 生产者写入后缓冲区中的元素个数大于等于此项设置时才唤醒消费者，单位：元素个数
     enum jringbuf_read_mode read_mode; // 多消费者时的读模式（max_consumers==1 时忽略，内部强制为 SHARED）
+    uint32_t flags;             // 特性标志，见 enum jringbuf_flag，为 0 时使用默认的加锁模式
+    uint32_t spin_num;          // 阻塞等待时睡眠前的自旋次数（为 0 时不自旋）
+    uint32_t yield_num;         // 阻塞等待时自旋后睡眠前让出CPU的次数（为 0 时不让出）
 } jringbuf_cfg_t;
 
 /**
@@ -60,7 +127,7 @@ typedef struct jringbuf_cfg {
  * @param   cfg          [IN]   创建缓冲区的配置参数
  * @return  成功返回管理器指针；失败返回 NULL
  * @note    1. 结构体、缓冲区、消费者数组、生产者数组分配在连续的一块内存中
- *          2. 条件变量总使用单调时钟
+ *          2. 超时等待总使用单调时钟
  */
 jringbuf_t* jringbuf_init(const jringbuf_cfg_t *cfg);
 
@@ -75,14 +142,104 @@ static inline jringbuf_t* jringbuf_init1(uint32_t capacity,
     cfg.hold_num = hold_num;
     cfg.wake_num = wake_num;
     cfg.read_mode = read_mode;
+    cfg.flags = 0;
+    cfg.spin_num = 0;
+    cfg.yield_num = 0;
     return jringbuf_init(&cfg);
 }
 
+/**
+ * @brief   在命名共享内存中创建环形缓冲区，供多个进程读写
+ * @param   name         [IN]   共享内存名称，posix要求以'/'开头，长度小于64，已存在时创建失败
+ * @param   cfg          [IN]   创建缓冲区的配置参数
+ * @return  成功返回管理器指针（共享内存的映射地址）；失败返回 NULL
+ * @note    1. 布局和 jringbuf_init 相同，管理器中只保存偏移，各进程映射地址可以不同
+ *          2. 互斥锁为进程间共享的健壮锁，阻塞等待使用进程间共享的 futex；
+ *             持锁进程异常退出后锁可以恢复，但它正在进行的读写状态不保证一致
+ *          3. 其它进程使用 jringbuf_attach_shm 映射，生产者/消费者 ID 在所有进程中通用
+ *          4. 创建者使用 jringbuf_uninit 停止读写、解除映射并删除共享内存
+ *          5. windows 不支持进程间共享的互斥锁，总是返回 NULL；不支持 JRINGBUF_MIRROR
+ */
+jringbuf_t* jringbuf_init_shm(const char *name, const jringbuf_cfg_t *cfg);
+
+/**
+ * @brief   映射其它进程通过 jringbuf_init_shm 创建的环形缓冲区
+ * @param   name         [IN]   共享内存名称
+ * @return  成功返回管理器指针；共享内存不存在或不是环形缓冲区时返回 NULL
+ * @note    使用完后调用 jringbuf_detach_shm 解除映射，不能调用 jringbuf_uninit
+ */
+jringbuf_t* jringbuf_attach_shm(const char *name);
+
+/**
+ * @brief   解除 jringbuf_attach_shm 的映射
+ * @param   rb          [IN]    管理器指针
+ * @return  无返回值
+ * @note    只解除本进程的映射，不影响其它进程；本进程添加的生产者/消费者需要先删除
+ */
+void jringbuf_detach_shm(jringbuf_t *rb);
+
+/**
+ * @brief   在映射文件中创建环形缓冲区（飞行记录器）
+ * @param   fname        [IN]   文件名，已存在时清空后重新创建
+ * @param   cfg          [IN]   创建缓冲区的配置参数
+ * @return  成功返回管理器指针（文件的映射地址）；失败返回 NULL
+ * @note    1. 管理器和数据缓冲区都在文件的共享映射(MAP_SHARED)中，写入即写入文件的页缓存，
+ *             没有 write 系统调用；进程崩溃后文件中保留最后 capacity 个元素
+ *          2. 写位置总在数据拷贝完成后才前进，丢弃旧数据时先前移读位置再覆盖，
+ *             所以文件中 [min_read_index, write_index) 之间的数据总是完整的
+ *          3. 其它进程使用 jringbuf_attach_file 打开，崩溃后的分析工具使用 jringbuf_recover_file 打开，
+ *             再从 min_read_index 读取回放
+ *          4. 互斥锁和阻塞等待同 jringbuf_init_shm；jringbuf_uninit 只解除映射，不删除文件
+ *          5. 需要在系统崩溃（而不只是进程崩溃）后保留数据时调用 jringbuf_sync_file 落盘
+ *          6. 不支持 JRINGBUF_LOCKFREE（认领后未完成拷贝的槽位无法恢复）和 JRINGBUF_MIRROR
+ */
+jringbuf_t* jringbuf_init_file(const char *fname, const jringbuf_cfg_t *cfg);
+
+/**
+ * @brief   打开 jringbuf_init_file 创建的文件环形缓冲区
+ * @param   fname        [IN]   文件名
+ * @return  成功返回管理器指针；文件不存在或不是环形缓冲区时返回 NULL
+ * @note    1. 使用完后调用 jringbuf_detach_file 解除映射，不能调用 jringbuf_uninit
+ *          2. 不修改管理器，创建者仍在运行时其它进程也可以打开；
+ *             创建者崩溃后回放使用 jringbuf_recover_file
+ */
+jringbuf_t* jringbuf_attach_file(const char *fname);
+
+/**
+ * @brief   打开创建者已崩溃的文件环形缓冲区
+ * @param   fname        [IN]   文件名
+ * @return  成功返回管理器指针；文件不存在或不是环形缓冲区时返回 NULL
+ * @note    1. 重新初始化互斥锁，清除未提交的预留、未释放的窥视、读写中计数和等待者计数，
+ *             预留或窥视的元素按未写入或未读取处理，[min_read_index, write_index) 的数据不变
+ *          2. 遗留的生产者/消费者不清除，分析工具只以消费者 0 读取即可
+ *          3. 只能在没有其它进程使用该文件时调用，使用完后调用 jringbuf_detach_file 解除映射
+ */
+jringbuf_t* jringbuf_recover_file(const char *fname);
+
+/**
+ * @brief   解除 jringbuf_attach_file 的映射
+ * @param   rb          [IN]    管理器指针
+ * @return  无返回值
+ */
+static inline void jringbuf_detach_file(jringbuf_t *rb)
+{
+    jringbuf_detach_shm(rb);
+}
+
+/**
+ * @brief   将文件环形缓冲区的修改同步写入磁盘
+ * @param   rb          [IN]    管理器指针
+ * @return  成功返回 0；失败或不是文件环形缓冲区返回 -1
+ * @note    会阻塞到写盘完成，不要在热路径调用
+ */
+int jringbuf_sync_file(jringbuf_t *rb);
+
 /**
  * @brief   销毁环形缓冲区并释放所有资源
  * @param   rb          [IN]    管理器指针
  * @return  无返回值
- * @note    jringbuf_uninit时已自动调用jringbuf_stop停止并禁止读写
+ * @note    1. jringbuf_uninit时已自动调用jringbuf_stop停止并禁止读写
+ *          2. 共享内存环形缓冲区只能由创建者调用，同时删除共享内存
  */
 void jringbuf_uninit(jringbuf_t *rb);
 
@@ -145,6 +302,33 @@ int jringbuf_members(jringbuf_t *rb, uint32_t *producers, uint32_t *consumers);
  */
 int jringbuf_write(jringbuf_t *rb, int producer_id, const void *data, uint32_t len, uint32_t strategy, int arg, uint32_t *pdropped);
 
+/**
+ * @brief   预留写空间，调用者直接在缓冲区中构造数据（零拷贝写入）
+ * @param   rb          [INOUT] 管理器指针
+ * @param   producer_id [IN]    写数据的生产者 ID
+ * @param   n           [IN]    期望预留的元素个数
+ * @param   span1       [OUT]   第一段连续内存
+ * @param   span2       [OUT]   第二段连续内存（未跨越缓冲区尾部时len为0）
+ * @return  成功返回实际预留的元素个数（1 ~ n）；没有空间、已有预留或失败返回 -1
+ * @note    1. 必须调用 jringbuf_write_commit 提交，两者之间的数据对消费者不可见
+ *          2. 同一时刻只能有一个预留，已有预留（包括本生产者自己的）时再预留直接失败；其它生产者的写入
+ *             和空间不足一样处理，只有 JRINGBUF_BLOCK/JRINGBUF_RETRY 策略时等待提交，所以预留期间
+ *             不要执行耗时操作；预留者自己的写入直接失败
+ *          3. 此接口不阻塞也不丢弃旧数据，需要时可先调用 jringbuf_write 或 jringbuf_drop_data
+ */
+int jringbuf_write_reserve(jringbuf_t *rb, int producer_id, uint32_t n,
+                           jringbuf_span_t *span1, jringbuf_span_t *span2);
+
+/**
+ * @brief   提交预留的写空间
+ * @param   rb          [INOUT] 管理器指针
+ * @param   producer_id [IN]    预留空间的生产者 ID
+ * @param   n_used      [IN]    实际写入的元素个数（≤ 预留个数，为 0 时放弃预留）
+ * @return  成功返回 0；没有预留或n_used超过预留个数返回 -1
+ * @note    从两段连续内存的开头依次计算 n_used 个元素
+ */
+int jringbuf_write_commit(jringbuf_t *rb, int producer_id, uint32_t n_used);
+
 /**
  * @brief   从缓冲区读取数据
  * @param   rb          [INOUT] 管理器指针
@@ -159,6 +343,50 @@ int jringbuf_write(jringbuf_t *rb, int producer_id, const void *data, uint32_t l
  */
 int jringbuf_read(jringbuf_t *rb, int consumer_id, void *buf, uint32_t len, uint32_t* size, uint32_t strategy, int arg);
 
+/**
+ * @brief   窥视可读数据，调用者直接在缓冲区中解析数据（零拷贝读取）
+ * @param   rb          [INOUT] 管理器指针
+ * @param   consumer_id [IN]    消费者 ID（由 add_consumer 返回；单消费者时固定传 0）
+ * @param   max         [IN]    最多窥视的元素个数
+ * @param   span1       [OUT]   第一段连续内存
+ * @param   span2       [OUT]   第二段连续内存（未跨越缓冲区尾部时len为0）
+ * @return  成功返回窥视的元素个数（1 ~ max）；没有数据或失败返回 -1
+ * @note    1. 必须调用 jringbuf_read_release 释放，同一消费者释放前不能再窥视或读取
+ *          2. 共享读模式下其它消费者的窥视直接失败，读取和没有数据一样处理，只有 JRINGBUF_BLOCK/JRINGBUF_RETRY
+ *             策略时等待释放；窥视期间带 JRINGBUF_DROP 的写入和
+ *             jringbuf_drop_data 也会等待释放，所以窥视期间不要执行耗时操作
+ *          3. 单生产者单消费者的无锁模式下写入不等待窥视，丢弃旧数据时释放会返回 -1
+ */
+int jringbuf_read_peek(jringbuf_t *rb, int consumer_id, uint32_t max,
+                       jringbuf_span_t *span1, jringbuf_span_t *span2);
+
+/**
+ * @brief   释放窥视的数据
+ * @param   rb          [INOUT] 管理器指针
+ * @param   consumer_id [IN]    消费者 ID
+ * @param   n           [IN]    消费的元素个数（≤ 窥视个数，为 0 时不消费任何数据）
+ * @return  成功返回 0；没有窥视或n超过窥视个数返回 -1；无锁模式下窥视的数据已被丢弃也返回 -1
+ * @note    独占读模式下释放的元素和读取一样参与最小读位置的更新
+ */
+int jringbuf_read_release(jringbuf_t *rb, int consumer_id, uint32_t n);
+
+/**
+ * @brief   把可读数据直接写出到文件描述符（零拷贝转发）
+ * @param   rb          [INOUT] 管理器指针
+ * @param   consumer_id [IN]    消费者 ID（由 add_consumer 返回；单消费者时固定传 0）
+ * @param   fd          [IN]    文件、管道或套接字描述符
+ * @param   max         [IN]    最多写出的元素个数，为 0 时不限制
+ * @param   flags       [IN]    jringbuf_fd_flag 标志
+ * @return  成功返回消费的元素个数；没有数据、写出失败（errno为写出的错误码）或其它失败返回 -1
+ * @note    1. 内部窥视数据并以跨越尾部的两段内存构造 iovec，一次 writev 写出，只消费内核接受的元素，
+ *             内核只接受了某个元素的一部分时会补写该元素的剩余部分
+ *          2. 和 jringbuf_read_peek 有相同的限制（不支持 JRINGBUF_LOCKFREE），写出期间持有窥视，
+ *             阻塞的描述符会使其它消费者和丢弃等待
+ *          3. 非阻塞描述符补写时最多等待可写 JRINGBUF_FD_WAIT_MS 毫秒，超时后已写出一部分的元素也算作消费
+ *             （接收端只收到半个元素），JRINGBUF_FD_ALL 时未写出的完整元素留待下次
+ */
+int jringbuf_read_to_fd(jringbuf_t *rb, int consumer_id, int fd, uint32_t max, uint32_t flags);
+
 /**
  * @brief   添加一个生产者（多生产者有效）
  * @param   rb          [INOUT] 管理器指针
@@ -205,6 +433,133 @@ int jringbuf_del_consumer(jringbuf_t *rb, int consumer_id);
  */
 int jringbuf_drop_data(jringbuf_t *rb, int consumer_id, uint32_t dropped);
 
+/**
+ * @brief   获取消费者的数据就绪描述符，可以和套接字、定时器一起用 poll/epoll 等待
+ * @param   rb          [IN]    管理器指针
+ * @param   consumer_id [IN]    消费者 ID（单消费者时固定传 0）
+ * @return  成功返回描述符；失败返回 -1
+ * @note    1. 首次调用时创建描述符，jringbuf_uninit时关闭，调用者不要读写或关闭描述符
+ *          2. 消费者未读元素个数大于等于 wake_num(为0时按1处理)时描述符可读，读取后不足时自动变为不可读，
+ *             等待者收到可读事件后使用非阻塞方式(JRINGBUF_BLOCK之外的策略)读取
+ *          3. 共享读模式下所有消费者返回同一个描述符；停止读写后描述符一直可读
+ *          4. 创建描述符后每次读写都会同步描述符状态，状态改变时有一次系统调用
+ *          5. 只支持linux，不支持共享内存环形缓冲区
+ */
+int jringbuf_get_event_fd(jringbuf_t *rb, int consumer_id);
+
+/**
+ * @brief   获取生产者的空间就绪描述符，可以和套接字、定时器一起用 poll/epoll 等待
+ * @param   rb          [IN]    管理器指针
+ * @return  成功返回描述符；失败返回 -1
+ * @note    空闲空间大于等于 wake_num(为0时按1处理)时描述符可读，其它同 jringbuf_get_event_fd
+ */
+int jringbuf_get_space_fd(jringbuf_t *rb);
+
+/**
+ * @brief   获取统计信息（JRINGBUF_STATS）
+ * @param   rb          [IN]    管理器指针
+ * @param   stats       [OUT]   所有生产者和消费者的计数之和
+ * @return  成功返回 0；未开启统计返回 -1
+ * @note    和读写并发时各计数不是同一时刻的快照
+ */
+int jringbuf_stats_get(jringbuf_t *rb, jringbuf_stats_t *stats);
+
+/**
+ * @brief   分片环形缓冲区管理器
+ * @note    每个生产者独占一个单生产者单消费者的子环形缓冲区(无锁SPSC模式)，生产者之间不共享写位置，
+ *          由一个合并消费者轮询或按排序键合并读取所有子环形缓冲区
+ */
+typedef struct jringbuf_shard jringbuf_shard_t;
+
+/**
+ * @brief   获取元素的排序键（如序号或时间戳），合并消费者每次取出排序键最小的元素
+ * @param   elem        [IN]    元素地址
+ * @return  排序键
+ */
+typedef uint64_t (*jringbuf_shard_key_t)(const void *elem);
+
+/**
+ * @brief   创建分片环形缓冲区
+ * @param   cfg         [IN]    配置参数，max_producers为分片(子环形缓冲区)个数，capacity为每个分片的容量
+ * @param   get_key     [IN]    排序键回调，为NULL时轮询读取各分片
+ * @return  成功返回管理器指针；失败返回 NULL
+ * @note    1. max_consumers、read_mode、hold_num和JRINGBUF_LOCKFREE被忽略，只有一个合并消费者
+ *          2. wake_num对每个分片生效：分片中的元素个数大于等于wake_num时才唤醒阻塞的消费者
+ *          3. 按排序键合并时，每个分片内的排序键需要单调递增，消费者只在当前可见的元素中取最小的，
+ *             读取后其它生产者才写入的更小排序键的元素不会被重新排序
+ */
+jringbuf_shard_t* jringbuf_shard_init(const jringbuf_cfg_t *cfg, jringbuf_shard_key_t get_key);
+
+/**
+ * @brief   销毁分片环形缓冲区
+ * @param   sh          [IN]    管理器指针
+ * @return  无返回值
+ * @note    已自动调用jringbuf_shard_stop停止并禁止读写
+ */
+void jringbuf_shard_uninit(jringbuf_shard_t *sh);
+
+/**
+ * @brief   允许读写
+ * @param   sh          [IN]    管理器指针
+ * @return  成功返回 0；失败返回 -1
+ */
+int jringbuf_shard_start(jringbuf_shard_t *sh);
+
+/**
+ * @brief   停止并禁止读写
+ * @param   sh          [IN]    管理器指针
+ * @return  无返回值
+ * @note    需要等待所有读写退出
+ */
+void jringbuf_shard_stop(jringbuf_shard_t *sh);
+
+/**
+ * @brief   添加一个生产者，分配一个空闲的分片
+ * @param   sh          [IN]    管理器指针
+ * @return  成功返回生产者 ID（即分片序号 0 ~ max_producers-1）；无空闲分片返回 -1
+ */
+int jringbuf_shard_add_producer(jringbuf_shard_t *sh);
+
+/**
+ * @brief   移除一个生产者
+ * @param   sh          [IN]    管理器指针
+ * @param   producer_id [IN]    生产者 ID
+ * @return  成功返回 0；ID 无效返回 -1
+ * @note    分片中未读的数据仍然可以被消费者读取
+ */
+int jringbuf_shard_del_producer(jringbuf_shard_t *sh, int producer_id);
+
+/**
+ * @brief   获取所有分片中的有效元素个数
+ * @param   sh          [IN]    管理器指针
+ * @return  有效元素个数
+ */
+uint32_t jringbuf_shard_size(jringbuf_shard_t *sh);
+
+/**
+ * @brief   向生产者自己的分片写入数据
+ * @param   sh          [IN]    管理器指针
+ * @note    其它参数和返回值同 jringbuf_write，同一个生产者 ID 同时只能由一个线程写入
+ */
+int jringbuf_shard_write(jringbuf_shard_t *sh, int producer_id, const void *data, uint32_t len,
+                         uint32_t strategy, int arg, uint32_t *pdropped);
+
+/**
+ * @brief   从所有分片中读取数据
+ * @param   sh          [IN]    管理器指针
+ * @param   buf         [OUT]   读取数据存放缓冲区（至少 len * unit_size 字节）
+ * @param   len         [IN]    期望读取的元素个数
+ * @param   size        [OUT]   所有分片当前总有效元素个数(含本次读取的)，可以为NULL
+ * @param   strategy    [IN]    缓冲区不足策略（JRINGBUF_COMPLETE/JRINGBUF_BLOCK/JRINGBUF_RETRY）
+ * @param   arg         [IN]    策略的参数，含义依赖策略（超时时间或尝试次数）
+ * @return  成功返回实际读取的元素个数；失败返回 -1
+ * @note    1. 只能有一个消费者线程调用
+ *          2. 轮询时从上次结束的下一个分片开始，依次读完每个分片的可读数据；合并时每次取排序键最小的一个元素
+ *          3. 生产者使用JRINGBUF_DROP丢弃旧数据时，JRINGBUF_COMPLETE读取的个数可能少于len
+ */
+int jringbuf_shard_read(jringbuf_shard_t *sh, void *buf, uint32_t len, uint32_t *size,
+                        uint32_t strategy, int arg);
+
 #ifdef __cplusplus
 }
 #endif
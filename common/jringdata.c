@@ -12,6 +12,8 @@
 #include "jringdata.h"
 #include "jthread.h"
 #include "jheap.h"
+#include "jfs.h"
+#include "joptimize.h"
 
 /*----------------------------------------------------------------------------
   带索引的数据环形缓冲区主结构（柔性数组布局）
@@ -30,14 +32,42 @@ struct jringdata_ctx {
     uint32_t        read_index_offset;  // 消费者读索引数组偏移（仅独立读有效）
 };
 
+/**
+ * @brief   等待事件（JRINGDATA_BLOCK）：等待者先自旋、再让出CPU、最后以 seq 为键在 futex 上睡眠
+ * @note    唤醒方只在有等待者时递增 seq，只在有睡眠者时才进行 futex 系统调用
+ */
+struct jringdata_event {
+    uint32_t        seq;                // 事件序号
+    uint32_t        waiters;            // 等待（自旋、让出或睡眠）中的线程个数
+    uint32_t        sleepers;           // 在 futex 上睡眠的线程个数
+};
+
+/**
+ * @brief   就绪描述符（jringdata_get_event_fd/jringdata_get_space_fd），可读表示可以读取或写入
+ */
+struct jringdata_evfd {
+    int             fd;                 // 事件描述符，未创建时为 -1
+    uint32_t        ready;              // 描述符当前是否已置位，只在状态改变时进行系统调用
+};
+
+/**
+ * @brief   消费者的记录过滤回调（jringdata_add_consumer_filter）
+ */
+struct jringdata_filter {
+    jringdata_filter_cb cb;             // 过滤回调，为NULL时不过滤
+    void           *arg;                // 过滤回调的用户参数
+};
+
 /**
  * @brief   带索引的数据环形缓冲区管理器
  *
  * 尾部连续内存布局（由偏移量索引）：
  *   - index[idx_num * idx_size]        索引缓冲区
- *   - data[capacity]                   数据缓冲区
+ *   - data[capacity]                   数据缓冲区，JRINGDATA_MIRROR 时不在此处而是单独的镜像映射
  *   - read_idx[max_consumers]          消费者索引读位置数组 (uint32_t)，仅 max_consumers>1且JRINGDATA_READ_EXCLUSIVE
  *   - read_data[max_consumers]         消费者数据读位置数组 (uint32_t)，仅 max_consumers>1且JRINGDATA_READ_EXCLUSIVE
+ *   - data_pos[idx_num]                每个索引槽位记录的数据起始绝对位置 (uint32_t)，仅 JRINGDATA_SEQ 或 max_age_ns
+ *   - time[idx_num]                    每个索引槽位记录的写入时间 (uint64_t，8字节对齐)，仅 JRINGDATA_TIME 或 max_age_ns
  *   - producer[max_producers]          生产者有效性数组 (uint8_t)，仅 max_producers>1
  *   - consumer[max_consumers]          消费者有效性数组 (uint8_t)，仅 max_consumers>1
  */
@@ -51,19 +81,36 @@ struct jringdata {
     enum jringdata_read_mode read_mode; // 读指针管理模式
     uint8_t         disable_rw;         // 是否禁止读写
     uint8_t         min_read_stale;     // 1 表示 min_read_index 需要重新计算（惰性）
-    uint8_t         min_read_lock;      // 1 表示正在读取数据，不能改变 min_read_index (单消费者)
+    uint8_t         mirror;             // 1 表示数据缓冲区为镜像映射（mirror_buf）
     uint32_t        rw_count;           // 正在读写的生产者或消费者数目
+    uint32_t        min_read_lock;      // 正在不持锁访问数据的读者数目（单消费者读取或迭代器），非0时不能丢弃数据
+    uint32_t        wr_reserved;        // 1 表示有生产者预留了写空间（jringdata_write_reserve）
+    uint32_t        wr_data;            // 预留的裸数据字节数
+    int             wr_producer;        // 预留空间的生产者 ID
+    uint32_t        rd_reserved;        // 1 表示有消费者正在迭代共享读位置的数据（jringdata_iter_begin）
+    int             rd_consumer;        // 正在迭代共享读位置的消费者 ID
     uint32_t        total_size;         // 数据区总大小
+    uint32_t        dpos_offset;        // 索引槽位数据位置数组偏移，为0表示未开启
+    uint32_t        ts_offset;          // 索引槽位写入时间数组偏移，为0表示未开启
     uint32_t        producer_offset;    // 生产者有效性数组偏移
     uint32_t        consumer_offset;    // 消费者有效性数组偏移
     uint32_t (*get_size)(const void *idx); // 通过idx获取裸数据大小，不填时直接将idx的前4字节当作uint32_t获取值
+    uint8_t        *mirror_buf;         // 镜像映射的数据缓冲区，后面紧跟同一块内存的第二次映射
+    uint32_t        spin_num;           // 阻塞等待时睡眠前的自旋次数
+    uint32_t        yield_num;          // 阻塞等待时睡眠前让出CPU的次数
+    struct jringdata_evfd *evfds;       // 就绪描述符数组，[0]为生产者（空间），[1+i]为消费者i（数据）
+    uint32_t        evfd_num;           // 就绪描述符数组元素个数
+    jringdata_stats_t *stats;           // 统计信息数组，[i]为生产者i，[max_producers+i]为消费者i，仅 JRINGDATA_STATS
+    struct jringdata_filter *filters;   // 消费者过滤回调数组，第一次添加带过滤的消费者时分配
+    uint64_t        write_seq;          // 下一条写入记录的序号（已写入的记录总数），不会回绕
+    uint64_t        max_age_ns;         // 记录的最长存活时间（纳秒），为0时不过期
 
     struct jringdata_ctx idx_ctx;       // 索引环形缓冲区上下文
     struct jringdata_ctx data_ctx;      // 数据环形缓冲区上下文
 
     jthread_mutex_t mutex;              // 全局互斥锁
-    jthread_cond_t  not_empty;          // 数据可用条件变量（单调时钟）
-    jthread_cond_t  not_full;           // 空间可用条件变量（单调时钟）
+    struct jringdata_event not_empty;   // 数据可用事件
+    struct jringdata_event not_full;    // 空间可用事件
 
     uint8_t         data[];             // 柔性数组起始
 };
@@ -73,11 +120,14 @@ struct jringdata {
 ----------------------------------------------------------------------------*/
 
 #define JRD_IDX_BUF(rd)     ((uint8_t*)((rd)->data))                                    // 索引缓冲区起始
-#define JRD_DATA_BUF(rd)    ((uint8_t*)((rd)->data + (rd)->data_ctx.buf_offset))        // 数据缓冲区起始
+#define JRD_DATA_BUF(rd)    ((rd)->mirror ? (rd)->mirror_buf : (uint8_t*)((rd)->data + (rd)->data_ctx.buf_offset)) // 数据缓冲区起始
 #define JRD_RIDX_ARR(rd)    ((uint32_t*)((rd)->data + (rd)->idx_ctx.read_index_offset)) // 消费者索引读位置数组
 #define JRD_RDATA_ARR(rd)   ((uint32_t*)((rd)->data + (rd)->data_ctx.read_index_offset))// 消费者数据读位置数组
+#define JRD_DPOS_ARR(rd)    ((uint32_t*)((rd)->data + (rd)->dpos_offset))               // 索引槽位数据位置数组
+#define JRD_TS_ARR(rd)      ((uint64_t*)((rd)->data + (rd)->ts_offset))                 // 索引槽位写入时间数组
 #define JRD_PROD_ACT(rd)    ((uint8_t*)((rd)->data + (rd)->producer_offset))            // 生产者活跃数组
 #define JRD_CONS_ACT(rd)    ((uint8_t*)((rd)->data + (rd)->consumer_offset))            // 消费者活跃数组
+#define JRD_STAT_ADD(st, member, v) do { if (st) (st)->member += (v); } while (0)       // 累加统计计数（持锁）
 
 /*----------------------------------------------------------------------------
   内部辅助函数
@@ -322,6 +372,266 @@ static int drop_old_data(jringdata_t *rd, uint32_t *pdropped, uint32_t need_idx,
   核心接口实现
 ----------------------------------------------------------------------------*/
 
+/**
+ * @brief   将 len 字节数据拷贝到数据缓冲区环内位置 pos 处
+ * @note    跨越缓冲区尾部时分两段拷贝，镜像映射时总是一次拷贝
+ */
+static inline void jringdata_data_in(jringdata_t *rd, uint32_t pos, const void *src, uint32_t len)
+{
+    uint8_t *data_buf = JRD_DATA_BUF(rd);
+    uint32_t tail = rd->data_ctx.total_len - pos;
+
+    if (len <= tail || rd->mirror) {
+        memcpy(data_buf + pos, src, len);
+    } else {
+        memcpy(data_buf + pos, src, tail);
+        memcpy(data_buf, (const uint8_t*)src + tail, len - tail);
+    }
+}
+
+/**
+ * @brief   从数据缓冲区环内位置 pos 处拷贝出 len 字节数据
+ */
+static inline void jringdata_data_out(jringdata_t *rd, uint32_t pos, void *dst, uint32_t len)
+{
+    uint8_t *data_buf = JRD_DATA_BUF(rd);
+    uint32_t tail = rd->data_ctx.total_len - pos;
+
+    if (len <= tail || rd->mirror) {
+        memcpy(dst, data_buf + pos, len);
+    } else {
+        memcpy(dst, data_buf + pos, tail);
+        memcpy((uint8_t*)dst + tail, data_buf, len - tail);
+    }
+}
+
+/**
+ * @brief   唤醒等待事件的线程（持有互斥锁时调用）
+ * @param   force       [IN]    为1时无论是否有等待者都唤醒（停止读写时使用）
+ * @note    没有等待者时不修改事件，没有睡眠者时不进行系统调用
+ */
+static inline void jringdata_event_wake(struct jringdata_event *ev, int force)
+{
+    if (force || jatomic32_load(&ev->waiters)) {
+        jatomic32_fetch_add(&ev->seq, 1);
+        jatomic_fence();
+        if (force || jatomic32_load(&ev->sleepers))
+            jthread_futex_wake(&ev->seq, 1, 0);
+    }
+}
+
+/**
+ * @brief   获取生产者(is_reader=0)或消费者(is_reader=1)的统计信息
+ * @return  未开启统计或 ID 无效时返回 NULL
+ */
+static inline jringdata_stats_t* jringdata_stats_slot(jringdata_t *rd, int is_reader, int id)
+{
+    uint32_t max = is_reader ? rd->max_consumers : rd->max_producers;
+
+    if (!rd->stats)
+        return NULL;
+    if (max == 1)
+        id = 0;
+    else if (id < 0 || (uint32_t)id >= max)
+        return NULL;
+    return &rd->stats[(is_reader ? rd->max_producers : 0) + (uint32_t)id];
+}
+
+/**
+ * @brief   整批过期写入时间早于 max_age_ns 的记录（持有互斥锁时调用）
+ * @param   consumer_id [IN]    -1 表示从最小读位置过期（独立读模式下同时移动落在过期区间的所有消费者），
+ *                              否则只移动独立读模式下该消费者的读位置
+ * @return  返回过期的索引个数
+ * @note    写入时间随索引位置单调不减，二分查找第一条未过期的记录，数据位置由槽位记录直接得到
+ */
+static uint32_t expire_old_data(jringdata_t *rd, int consumer_id)
+{
+    uint64_t *ts = JRD_TS_ARR(rd);
+    uint32_t mask = rd->idx_ctx.total_len - 1;
+    uint32_t start, lo, hi, mid, cut, cut_data;
+    uint64_t now = jtime_mononsec_get();
+    uint64_t deadline;
+
+    if (now <= rd->max_age_ns)
+        return 0;
+    deadline = now - rd->max_age_ns;
+
+    start = consumer_id < 0 ? rd->idx_ctx.min_read_index : JRD_RIDX_ARR(rd)[consumer_id];
+    lo = 0;
+    hi = rd->idx_ctx.write_index - start;
+    while (lo < hi) {
+        mid = lo + ((hi - lo) >> 1);
+        if (ts[(start + mid) & mask] < deadline)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (!lo)
+        return 0;
+
+    cut = start + lo;
+    cut_data = (cut == rd->idx_ctx.write_index) ? rd->data_ctx.write_index : JRD_DPOS_ARR(rd)[cut & mask];
+
+    if (consumer_id >= 0) {
+        if (!rd->min_read_stale && (start == rd->idx_ctx.min_read_index || rd->hold_num))
+            rd->min_read_stale = 1;
+        JRD_RIDX_ARR(rd)[consumer_id] = cut;
+        JRD_RDATA_ARR(rd)[consumer_id] = cut_data;
+    } else {
+        if (rd->read_mode == JRINGDATA_READ_EXCLUSIVE) {
+            uint32_t *ridx = JRD_RIDX_ARR(rd);
+            uint32_t *rdata = JRD_RDATA_ARR(rd);
+            uint8_t *act = JRD_CONS_ACT(rd);
+            for (uint32_t i = 0, j = 0; i < rd->max_consumers && j < rd->cur_consumers; ++i) {
+                if (act[i]) {
+                    ++j;
+                    if (ridx[i] - start < lo) {
+                        ridx[i] = cut;
+                        rdata[i] = cut_data;
+                    }
+                }
+            }
+        }
+        rd->idx_ctx.min_read_index = cut;
+        rd->idx_ctx.data_len = rd->idx_ctx.write_index - cut;
+        rd->data_ctx.min_read_index = cut_data;
+        rd->data_ctx.data_len = rd->data_ctx.write_index - cut_data;
+    }
+    jringdata_event_wake(&rd->not_full, 0);
+    return lo;
+}
+
+/**
+ * @brief   持有互斥锁时等待事件：释放锁后先自旋 spin_num 次，再让出CPU yield_num 次，最后在 futex 上睡眠
+ * @param   arg         [INOUT] 剩余超时毫秒数，-1 表示无限等待，返回时更新为剩余时间
+ * @param   st          [INOUT] 统计信息，可以为NULL
+ * @note    等待者在持锁时登记并记录事件序号，唤醒方也在持锁时修改序号，因此不会丢失唤醒；
+ *          可能虚假返回，调用者需要重新检查条件
+ */
+static void jringdata_event_wait(jringdata_t *rd, struct jringdata_event *ev, int *arg,
+                                 jringdata_stats_t *st)
+{
+    uint32_t i, seq;
+    uint64_t t1 = 0, t2, ns = 0;
+
+    if (st)
+        ns = jtime_mononsec_get();
+    if (*arg != -1)
+        t1 = jtime_monomsec_get();
+    jatomic32_fetch_add(&ev->waiters, 1);
+    seq = ev->seq;
+    jthread_mutex_unlock(&rd->mutex);
+
+    for (i = 0; i < rd->spin_num; ++i) {
+        if (jatomic32_load(&ev->seq) != seq)
+            goto end;
+        jcpu_relax();
+    }
+    for (i = 0; i < rd->yield_num; ++i) {
+        if (jatomic32_load(&ev->seq) != seq)
+            goto end;
+        jthread_yield();
+    }
+
+    jatomic32_fetch_add(&ev->sleepers, 1);
+    jatomic_fence();
+    if (jatomic32_load(&ev->seq) == seq) {
+        int msec = *arg;
+        if (msec != -1) {
+            t2 = jtime_monomsec_get();
+            msec = ((int)(t2 - t1) < msec) ? (msec - (int)(t2 - t1)) : 0;
+        }
+        jthread_futex_wait(&ev->seq, seq, msec, 0);
+    }
+    jatomic32_fetch_add(&ev->sleepers, (uint32_t)-1);
+
+end:
+    jatomic32_fetch_add(&ev->waiters, (uint32_t)-1);
+    jthread_mutex_lock(&rd->mutex);
+    if (*arg != -1) {
+        t2 = jtime_monomsec_get();
+        *arg = ((int)(t2 - t1) < *arg) ? (*arg - (int)(t2 - t1)) : 0;
+    }
+    if (st) {
+        ++st->block_waits;
+        st->block_nsec += jtime_mononsec_get() - ns;
+    }
+}
+
+/**
+ * @brief   根据当前可读索引个数和空闲空间同步就绪描述符的状态（持有互斥锁时调用）
+ * @note    没有创建就绪描述符时直接返回；状态没有改变时不进行系统调用；
+ *          停止读写后所有描述符都置位，让等待者读写时得到错误返回
+ */
+static void jringdata_evfd_sync(jringdata_t *rd)
+{
+    uint32_t thresh, num, ready;
+
+    if (!rd->evfds)
+        return;
+
+    thresh = rd->wake_num ? rd->wake_num : 1;
+    if (thresh > rd->idx_ctx.total_len)
+        thresh = rd->idx_ctx.total_len;
+
+    for (uint32_t i = 0; i < rd->evfd_num; ++i) {
+        struct jringdata_evfd *ev = &rd->evfds[i];
+        if (ev->fd < 0)
+            continue;
+
+        if (i == 0) {
+            if (rd->min_read_stale && rd->read_mode == JRINGDATA_READ_EXCLUSIVE)
+                update_min_read_index(rd);
+            num = rd->data_ctx.data_len < rd->data_ctx.total_len ? rd->idx_ctx.total_len - rd->idx_ctx.data_len : 0;
+        } else if (rd->read_mode == JRINGDATA_READ_EXCLUSIVE) {
+            num = JRD_CONS_ACT(rd)[i - 1] ? rd->idx_ctx.write_index - JRD_RIDX_ARR(rd)[i - 1] : 0;
+        } else {
+            num = rd->idx_ctx.data_len;
+        }
+        ready = rd->disable_rw || num >= thresh;
+        if (ready != ev->ready) {
+            if (ready)
+                jthread_evfd_set(ev->fd);
+            else
+                jthread_evfd_clear(ev->fd);
+            ev->ready = ready;
+        }
+    }
+}
+
+/**
+ * @brief   获取（首次调用时创建）第 index 个就绪描述符
+ */
+static int jringdata_evfd_get(jringdata_t *rd, uint32_t index)
+{
+    int fd;
+
+    jthread_mutex_lock(&rd->mutex);
+    if (!rd->evfds) {
+        uint32_t num = 1 + (rd->read_mode == JRINGDATA_READ_EXCLUSIVE ? rd->max_consumers : 1);
+        rd->evfds = (struct jringdata_evfd*)jheap_malloc(num * sizeof(struct jringdata_evfd));
+        if (!rd->evfds) {
+            jthread_mutex_unlock(&rd->mutex);
+            return -1;
+        }
+        for (uint32_t i = 0; i < num; ++i) {
+            rd->evfds[i].fd = -1;
+            rd->evfds[i].ready = 0;
+        }
+        rd->evfd_num = num;
+    }
+
+    fd = rd->evfds[index].fd;
+    if (fd < 0) {
+        fd = jthread_evfd_create();
+        rd->evfds[index].fd = fd;
+        rd->evfds[index].ready = 0;
+        jringdata_evfd_sync(rd);
+    }
+    jthread_mutex_unlock(&rd->mutex);
+    return fd;
+}
+
 /**
  * @brief   创建带索引的数据环形缓冲区
  */
@@ -332,17 +642,28 @@ jringdata_t* jringdata_init(const jringdata_cfg_t *cfg)
         return NULL;
     }
 
+    int mirror = (cfg->flags & JRINGDATA_MIRROR) != 0;
     uint32_t idx_num = next_pow2(cfg->idx_num);
     uint32_t capacity = next_pow2(cfg->capacity);
+    if (mirror) {
+        /* 镜像映射的大小必须是映射粒度的整数倍 */
+        uint32_t gran = (uint32_t)jfs_mirror_granularity();
+        if (capacity < gran)
+            capacity = gran;
+        if (capacity % gran)
+            return NULL;
+    }
     uint32_t idx_buf_size = idx_num * cfg->idx_size;
-    uint32_t data_buf_size = capacity;
+    uint32_t data_buf_size = mirror ? 0 : capacity;
     uint32_t ridx_size = (cfg->max_consumers > 1 && cfg->read_mode == JRINGDATA_READ_EXCLUSIVE) ?  cfg->max_consumers * sizeof(uint32_t) : 0;
     uint32_t rdata_size = (cfg->max_consumers > 1 && cfg->read_mode == JRINGDATA_READ_EXCLUSIVE) ?  cfg->max_consumers * sizeof(uint32_t) : 0;
+    uint32_t dpos_size = ((cfg->flags & JRINGDATA_SEQ) || cfg->max_age_ns) ? idx_num * sizeof(uint32_t) : 0;
+    uint32_t ts_size = ((cfg->flags & JRINGDATA_TIME) || cfg->max_age_ns) ? idx_num * sizeof(uint64_t) : 0;
     uint32_t prod_act_size = (cfg->max_producers > 1) ? cfg->max_producers * sizeof(uint8_t) : 0;
     uint32_t cons_act_size = (cfg->max_consumers > 1) ? cfg->max_consumers * sizeof(uint8_t) : 0;
 
     uint32_t total = (uint32_t)sizeof(jringdata_t) + idx_buf_size + data_buf_size +
-                   ridx_size + rdata_size + prod_act_size + cons_act_size;
+                   ridx_size + rdata_size + dpos_size + (ts_size ? ts_size + 7 : 0) + prod_act_size + cons_act_size;
 
     jringdata_t *rd = (jringdata_t*)jheap_malloc(total);
     if (!rd) {
@@ -362,6 +683,7 @@ jringdata_t* jringdata_init(const jringdata_cfg_t *cfg)
     rd->min_read_lock = 0;
     rd->rw_count = 0;
     rd->get_size = cfg->get_size ? cfg->get_size : get_size_def;
+    rd->max_age_ns = cfg->max_age_ns;
 
     rd->idx_ctx.total_len = idx_num;
     rd->idx_ctx.unit_size = cfg->idx_size;
@@ -378,6 +700,12 @@ jringdata_t* jringdata_init(const jringdata_cfg_t *cfg)
     off += ridx_size;
     rd->data_ctx.read_index_offset = rdata_size ? off : 0;
     off += rdata_size;
+    rd->dpos_offset = dpos_size ? off : 0;
+    off += dpos_size;
+    if (ts_size)
+        off = (off + 7) & ~7u;
+    rd->ts_offset = ts_size ? off : 0;
+    off += ts_size;
     rd->producer_offset = prod_act_size ? off : 0;
     off += prod_act_size;
     rd->consumer_offset = cons_act_size ? off : 0;
@@ -389,9 +717,28 @@ jringdata_t* jringdata_init(const jringdata_cfg_t *cfg)
         memset(rd->data + idx_buf_size + data_buf_size, 0, off - idx_buf_size - data_buf_size);
     }
 
+    if (mirror) {
+        rd->mirror_buf = (uint8_t*)jfs_mirror_map(capacity);
+        if (!rd->mirror_buf) {
+            jheap_free(rd);
+            return NULL;
+        }
+        rd->mirror = 1;
+    }
+
+    if (cfg->flags & JRINGDATA_STATS) {
+        rd->stats = (jringdata_stats_t*)jheap_calloc(cfg->max_producers + cfg->max_consumers, sizeof(jringdata_stats_t));
+        if (!rd->stats) {
+            if (rd->mirror)
+                jfs_mirror_unmap(rd->mirror_buf, capacity);
+            jheap_free(rd);
+            return NULL;
+        }
+    }
+
+    rd->spin_num = cfg->spin_num;
+    rd->yield_num = cfg->yield_num;
     jthread_mutex_init(&rd->mutex);
-    jthread_cond_init(&rd->not_empty, 1);     /* 单调时钟 */
-    jthread_cond_init(&rd->not_full,  1);
 
     return rd;
 }
@@ -406,8 +753,19 @@ void jringdata_uninit(jringdata_t *rd)
 
     jringdata_stop(rd);
     jthread_mutex_destroy(&rd->mutex);
-    jthread_cond_destroy(&rd->not_empty);
-    jthread_cond_destroy(&rd->not_full);
+    if (rd->evfds) {
+        for (uint32_t i = 0; i < rd->evfd_num; ++i) {
+            if (rd->evfds[i].fd >= 0)
+                jthread_evfd_close(rd->evfds[i].fd);
+        }
+        jheap_free(rd->evfds);
+    }
+    if (rd->stats)
+        jheap_free(rd->stats);
+    if (rd->filters)
+        jheap_free(rd->filters);
+    if (rd->mirror)
+        jfs_mirror_unmap(rd->mirror_buf, rd->data_ctx.total_len);
     jheap_free(rd);
 }
 
@@ -421,6 +779,7 @@ int jringdata_start(jringdata_t *rd)
 
     jthread_mutex_lock(&rd->mutex);
     rd->disable_rw = 0;
+    jringdata_evfd_sync(rd);
     jthread_mutex_unlock(&rd->mutex);
     return 0;
 }
@@ -436,12 +795,13 @@ void jringdata_stop(jringdata_t *rd)
     jthread_mutex_lock(&rd->mutex);
     rd->disable_rw = 1;
     while (rd->rw_count) {
-        jthread_cond_broadcast(&rd->not_empty);
-        jthread_cond_broadcast(&rd->not_full);
+        jringdata_event_wake(&rd->not_empty, 1);
+        jringdata_event_wake(&rd->not_full, 1);
         jthread_mutex_unlock(&rd->mutex);
         jthread_yield();
         jthread_mutex_lock(&rd->mutex);
     }
+    jringdata_evfd_sync(rd);
     jthread_mutex_unlock(&rd->mutex);
 }
 
@@ -697,6 +1057,8 @@ static int jringdata_write_common(jringdata_t *rd, int producer_id,
     uint32_t write_data = 0;
     uint32_t idx_space;
     uint32_t data_space;
+    uint32_t old_min;
+    jringdata_stats_t *st = jringdata_stats_slot(rd, 0, producer_id);
 
 redo:
     jthread_mutex_lock(&rd->mutex);
@@ -716,53 +1078,57 @@ redo:
             goto err;
         }
 
-        /* 惰性更新 */
-        if (rd->min_read_stale)
-            update_min_read_index(rd);
-
-        /* 获取可写剩余空间 */
-        idx_space = rd->idx_ctx.total_len - rd->idx_ctx.data_len;
-        data_space = rd->data_ctx.total_len - rd->data_ctx.data_len;
-
-        if (idx_space >= num && data_space >= len) {
-            /* 空间满足，直接进入后续步骤 */
-            write_num = num;
-            write_data = len;
-            break;
-        } else if (idx_space < need_idx || data_space < need_data) {
-            /* 快速检查：连最小需求都满足不了，直接进入等待/丢弃 */
+        if (rd->wr_reserved) {
+            /* 自己的预留没有提交前不能写入，等待也等不到 */
+            if (rd->max_producers == 1 || rd->wr_producer == producer_id) {
+                goto err;
+            }
+            /* 其它生产者预留了写空间，和空间不足一样处理，只在阻塞/重试策略下等待其提交 */
             write_num = 0;
             write_data = 0;
         } else {
-            /* 计算当前最大可写索引数及所需数据空间，判断是否满足写入条件 */
-            write_num = calc_write_size(rd, arg, &write_data);
-            if (write_num == num) {
+            /* 惰性更新 */
+            if (rd->min_read_stale)
+                update_min_read_index(rd);
+
+            /* 获取可写剩余空间 */
+            idx_space = rd->idx_ctx.total_len - rd->idx_ctx.data_len;
+            data_space = rd->data_ctx.total_len - rd->data_ctx.data_len;
+
+            if (idx_space >= num && data_space >= len) {
+                /* 空间满足，直接进入后续步骤 */
+                write_num = num;
+                write_data = len;
                 break;
+            } else if (idx_space < need_idx || data_space < need_data) {
+                /* 快速检查：连最小需求都满足不了，直接进入等待/丢弃 */
+                write_num = 0;
+                write_data = 0;
+            } else {
+                /* 计算当前最大可写索引数及所需数据空间，判断是否满足写入条件 */
+                write_num = calc_write_size(rd, arg, &write_data);
+                if (write_num == num) {
+                    break;
+                }
             }
         }
 
-        /* 没有重试或阻塞策略且没有丢数据机制 */
+        /* 没有重试或阻塞策略且没有丢数据机制；预留期间也不能丢弃旧数据腾出空间 */
         if ((!block && !retry) || !timeout_or_tries) {
+            if (rd->wr_reserved) {
+                goto err;
+            }
             break;
         }
 
         /* 未满足条件，尝试等待或重试 */
         if (block) {
-            if (timeout_or_tries == -1) {
-                /* 无限等待 */
-                jthread_cond_wait(&rd->not_full, &rd->mutex);
-            } else {
-                /* 超时等待 */
-                uint64_t t1, t2;
-                t1 = jtime_monomsec_get();
-                jthread_cond_mtimewait(&rd->not_full, &rd->mutex, timeout_or_tries);
-                t2 = jtime_monomsec_get();
-                timeout_or_tries = ((int)(t2 - t1) < timeout_or_tries) ?
-                    (timeout_or_tries - (int)(t2 - t1)) : 0;
-            }
+            /* 自旋、让出CPU或睡眠等待（期间释放互斥锁），-1 时无限等待 */
+            jringdata_event_wait(rd, &rd->not_full, &timeout_or_tries, st);
         } else { /* retry */
             if (timeout_or_tries > 0)
                 --timeout_or_tries;
+            JRD_STAT_ADD(st, retries, 1);
             jthread_mutex_unlock(&rd->mutex);
             jthread_yield();
             jthread_mutex_lock(&rd->mutex);
@@ -779,7 +1145,21 @@ redo:
             goto redo;
         }
 
-        if (!complete && (num > rd->idx_ctx.total_len ||
+        /* 先整批过期超过 max_age_ns 的记录，空间仍不足时再逐条丢弃最旧的记录 */
+        if (rd->max_age_ns) {
+            uint32_t expired = expire_old_data(rd, -1);
+            if (expired) {
+                JRD_STAT_ADD(st, drop_expired, expired);
+                write_num = calc_write_size(rd, arg, &write_data);
+            }
+        }
+
+        old_min = rd->idx_ctx.min_read_index;
+        if (write_num == num) {
+            /* 过期后空间已经足够，不再丢弃未过期的记录 */
+            if (pdropped)
+                *pdropped = 0;
+        } else if (!complete && (num > rd->idx_ctx.total_len ||
             /* 非完整写且全部空间不足以写，直接丢弃全部缓冲数据 */
             len > rd->data_ctx.total_len)) {
             uint32_t dropped = rd->idx_ctx.data_len;
@@ -791,11 +1171,13 @@ redo:
         } else {
             /* 丢弃到可以完整写 */
             if (drop_old_data(rd, pdropped, num, len) < 0) {
+                JRD_STAT_ADD(st, drop_full, rd->idx_ctx.min_read_index - old_min);
                 goto err;
             }
             write_num = num;
             write_data = len;
         }
+        JRD_STAT_ADD(st, drop_full, rd->idx_ctx.min_read_index - old_min);
     }
 
     /* 检查写入条件 */
@@ -808,13 +1190,14 @@ redo:
     {
         /* 计算起始元素序号和字节偏移 */
         uint8_t *idx_buf = JRD_IDX_BUF(rd);
-        uint8_t *data_buf = JRD_DATA_BUF(rd);
 
         uint32_t idx_size = rd->idx_ctx.unit_size;
         uint32_t idx_mask = rd->idx_ctx.total_len - 1;
         uint32_t idx_wpos = rd->idx_ctx.write_index & idx_mask;
         uint32_t data_mask = rd->data_ctx.total_len - 1;
         uint32_t data_wpos = rd->data_ctx.write_index & data_mask;
+        uint32_t data_widx = rd->data_ctx.write_index;
+        uint64_t now = rd->ts_offset ? jtime_mononsec_get() : 0;
 
         /* 单生产者优化：数据拷贝期间临时解锁 */
         if (rd->max_producers == 1)
@@ -831,33 +1214,38 @@ redo:
             }
 
             /* 写入数据 */
-            if (write_data) {
-                const uint8_t *data_src = (const uint8_t*)data_ptr;
-                uint32_t data_tail = rd->data_ctx.total_len - data_wpos;
-                uint32_t data_first = (write_data <= data_tail) ? write_data : data_tail;
-                memcpy(data_buf + data_wpos, data_src, data_first);
-                if (write_data > data_tail) {
-                    memcpy(data_buf, data_src + data_first, write_data - data_first);
+            if (write_data)
+                jringdata_data_in(rd, data_wpos, data_ptr, write_data);
+
+            /* 记录每个索引的数据起始位置和写入时间 */
+            if (rd->dpos_offset) {
+                uint32_t *dpos = JRD_DPOS_ARR(rd);
+                for (uint32_t i = 0; i < write_num; ++i) {
+                    dpos[(idx_wpos + i) & idx_mask] = data_widx;
+                    data_widx += rd->get_size(idx_src + i * idx_size);
                 }
             }
+            if (rd->ts_offset) {
+                uint64_t *ts = JRD_TS_ARR(rd);
+                for (uint32_t i = 0; i < write_num; ++i)
+                    ts[(idx_wpos + i) & idx_mask] = now;
+            }
         } else {
             for (uint32_t i = 0; i < write_num; ++i) {
                 /* 写入索引 */
                 uint32_t idx_pos = idx_wpos & idx_mask;
                 memcpy(idx_buf + idx_pos * idx_size, idx_arr[i], idx_size);
+                if (rd->dpos_offset)
+                    JRD_DPOS_ARR(rd)[idx_pos] = data_widx;
+                if (rd->ts_offset)
+                    JRD_TS_ARR(rd)[idx_pos] = now;
                 ++idx_wpos;
                 /* 写入数据 */
                 uint32_t dlen = rd->get_size(idx_arr[i]);
                 if (dlen) {
-                    const uint8_t *data_src = (const uint8_t*)data_arr[i];
-                    uint32_t data_pos = data_wpos & data_mask;
-                    uint32_t data_tail = rd->data_ctx.total_len - data_pos;
-                    uint32_t data_first = (dlen <= data_tail) ? dlen : data_tail;
-                    memcpy(data_buf + data_pos, data_src, data_first);
-                    if (dlen > data_tail) {
-                        memcpy(data_buf, data_src + data_first, dlen - data_first);
-                    }
+                    jringdata_data_in(rd, data_wpos & data_mask, data_arr[i], dlen);
                     data_wpos += dlen;
+                    data_widx += dlen;
                 }
             }
         }
@@ -868,18 +1256,30 @@ redo:
         /* 更新写指针 */
         rd->idx_ctx.write_index += write_num;
         rd->idx_ctx.data_len += write_num;
+        rd->write_seq += write_num;
         rd->data_ctx.write_index += write_data;
         rd->data_ctx.data_len += write_data;
     }
 
+    if (st) {
+        st->write_num += write_num;
+        st->write_bytes += write_data;
+        st->write_short += num - write_num;
+        ++st->occupancy[32 - jbit32_clz(rd->idx_ctx.data_len)];
+    }
     if (rd->idx_ctx.data_len >= rd->wake_num)
-        jthread_cond_broadcast(&rd->not_empty);
+        jringdata_event_wake(&rd->not_empty, 0);
+    jringdata_evfd_sync(rd);
 
     --rd->rw_count;
     jthread_mutex_unlock(&rd->mutex);
     return (int)write_num;
 
 err:
+    if (st) {
+        st->write_short += num;
+        ++st->occupancy[32 - jbit32_clz(rd->idx_ctx.data_len)];
+    }
     --rd->rw_count;
     jthread_mutex_unlock(&rd->mutex);
     return -1;
@@ -932,6 +1332,76 @@ static uint32_t calc_read_size(jringdata_t *rd, uint32_t c_idx, uint32_t avail_i
     return max_can;
 }
 
+/**
+ * @brief   计算带过滤回调的消费者最大可读的匹配索引数及所需数据空间
+ * @param   scan        [OUT]   scan[0]/scan[1]为本次读取需要越过的索引数/字节数（含跳过的记录），
+ *                              scan[2]/scan[3]为第一条匹配记录之前的索引数/字节数
+ * @param   blocked     [OUT]   为1表示调用者的缓冲区无法容纳下一条匹配的记录
+ * @note    只访问索引环，不匹配的记录由 get_size 越过裸数据
+ */
+static uint32_t calc_read_size_filter(jringdata_t *rd, uint32_t c_idx, uint32_t avail_idx,
+    struct jringdata_read_arg *arg, const struct jringdata_filter *filter,
+    uint32_t *data_len, uint32_t scan[4], int *blocked)
+{
+    uint32_t max_can = 0;
+    uint32_t data_need = 0;
+    uint32_t scan_num = 0, scan_data = 0;
+    uint32_t num = arg->num;
+
+    uint8_t *idx_buf = JRD_IDX_BUF(rd);
+    uint32_t idx_size = rd->idx_ctx.unit_size;
+    uint32_t idx_mask = rd->idx_ctx.total_len - 1;
+    uint32_t rpos = c_idx & idx_mask;
+
+    *blocked = 0;
+    for (; scan_num < avail_idx && max_can < num; ++scan_num) {
+        void *entry = idx_buf + rpos * idx_size;
+        uint32_t dlen = rd->get_size(entry);
+        if (filter->cb(entry, filter->arg)) {
+            if (!max_can) {
+                scan[2] = scan_num;
+                scan[3] = scan_data;
+            }
+            if (arg->is_discrete ? dlen > arg->v.d.len[max_can] : data_need + dlen > arg->v.c.len) {
+                *blocked = 1;
+                break;
+            }
+            data_need += dlen;
+            ++max_can;
+        }
+        scan_data += dlen;
+        rpos = (rpos + 1) & idx_mask;
+    }
+    if (!max_can) {
+        scan[2] = scan_num;
+        scan[3] = scan_data;
+    }
+
+    scan[0] = scan_num;
+    scan[1] = scan_data;
+    *data_len = data_need;
+    return max_can;
+}
+
+/**
+ * @brief   独立读的消费者越过 num 个索引和 data 字节（持有互斥锁时调用）
+ */
+static void consumer_advance(jringdata_t *rd, int consumer_id, uint32_t num, uint32_t data)
+{
+    uint32_t *ridx = JRD_RIDX_ARR(rd);
+    uint32_t *rdata = JRD_RDATA_ARR(rd);
+    uint32_t c_idx = ridx[consumer_id];
+
+    ridx[consumer_id] += num;
+    rdata[consumer_id] += data;
+    /* 最慢的消费者前进或者 hold_num 窗口使最小读位置落后于所有消费者时需要重新计算 */
+    if (!rd->min_read_stale && (c_idx == rd->idx_ctx.min_read_index || rd->hold_num)) {
+        rd->min_read_stale = 1;
+    }
+    rd->idx_ctx.data_len = rd->idx_ctx.write_index - rd->idx_ctx.min_read_index;
+    rd->data_ctx.data_len = rd->data_ctx.write_index - rd->data_ctx.min_read_index;
+}
+
 /**
  * @brief   read 和 readv 的公共读取流程
  * @param   rd              管理器指针
@@ -943,7 +1413,7 @@ static uint32_t calc_read_size(jringdata_t *rd, uint32_t c_idx, uint32_t avail_i
  * @param   timeout_or_tries策略参数（阻塞超时ms或重试次数，-1无限）
  * @return  成功返回实际读取的索引数，失败返回 -1
  * @note    处理 COMPLETE、BLOCK、RETRY 策略。
- *          共享读模式下拷贝数据期间会设置 min_read_lock 以防止数据被覆盖。
+ *          单消费者模式下拷贝数据期间会增加 min_read_lock 以防止数据被覆盖。
  */
 static int jringdata_read_common(jringdata_t *rd, int consumer_id,
                                  struct jringdata_read_arg *arg,
@@ -962,7 +1432,10 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
     uint32_t read_data = 0;
     uint32_t c_idx = 0, c_data = 0;
     uint32_t avail_idx = 0, avail_data = 0;
-    int shared_mode = 0;
+    uint32_t scan[4] = {0};
+    int shared_mode = 0, blocked = 0;
+    const struct jringdata_filter *filter = NULL;
+    jringdata_stats_t *st = jringdata_stats_slot(rd, 1, consumer_id);
 
     jthread_mutex_lock(&rd->mutex);
     ++rd->rw_count;
@@ -975,6 +1448,8 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
     }
 
     shared_mode = (rd->max_consumers == 1 || rd->read_mode == JRINGDATA_READ_SHARED);
+    if (!shared_mode && rd->filters && rd->filters[consumer_id].cb)
+        filter = &rd->filters[consumer_id];
 
     /* 主循环：等待数据可用 */
     do {
@@ -986,6 +1461,22 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
         if (rd->max_consumers > 1 && !JRD_CONS_ACT(rd)[consumer_id])
             goto err;
 
+        /* 共享读位置正在被其它消费者迭代时等待其结束，同一消费者迭代期间不能读取 */
+        if (shared_mode && rd->rd_reserved) {
+            if (rd->rd_consumer == consumer_id)
+                goto err;
+            jthread_mutex_unlock(&rd->mutex);
+            jthread_yield();
+            jthread_mutex_lock(&rd->mutex);
+            continue;
+        }
+
+        /* 跳过超过 max_age_ns 的记录，共享读位置正在被锁外读取时不能移动 */
+        if (rd->max_age_ns && !(shared_mode && rd->min_read_lock)) {
+            uint32_t expired = expire_old_data(rd, shared_mode ? -1 : consumer_id);
+            JRD_STAT_ADD(st, drop_expired, expired);
+        }
+
         /* 获取当前消费者的读位置及可用数据量 */
         if (shared_mode) {
             c_idx = rd->idx_ctx.min_read_index;
@@ -1001,8 +1492,19 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
             avail_data = rd->data_ctx.write_index - c_data;
         }
 
-        /* 检查数据缓冲区是否足够 */
-        if (avail_idx > 0) {
+        /* 带过滤的消费者只统计匹配的记录，第一条匹配记录之前的记录直接越过 */
+        if (filter && avail_idx > 0) {
+            read_num = calc_read_size_filter(rd, c_idx, avail_idx, arg, filter, &read_data, scan, &blocked);
+            if ((read_num == num) || (!complete && read_num > 0))
+                break;
+            if (blocked)
+                goto err;
+            if (scan[2]) {
+                consumer_advance(rd, consumer_id, scan[2], scan[3]);
+                jringdata_event_wake(&rd->not_full, 0);
+                jringdata_evfd_sync(rd);
+            }
+        } else if (avail_idx > 0) {
             read_num = calc_read_size(rd, c_idx, avail_idx, arg, &read_data);
             if ((read_num == num) || (!complete && read_num > 0)) {
                 break;
@@ -1022,19 +1524,11 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
 
         /* 等待或重试 */
         if (block) {
-            if (timeout_or_tries == -1) {
-                jthread_cond_wait(&rd->not_empty, &rd->mutex);
-            } else {
-                uint64_t t1, t2;
-                t1 = jtime_monomsec_get();
-                jthread_cond_mtimewait(&rd->not_empty, &rd->mutex, timeout_or_tries);
-                t2 = jtime_monomsec_get();
-                timeout_or_tries = ((int)(t2 - t1) < timeout_or_tries) ?
-                                   (timeout_or_tries - (int)(t2 - t1)) : 0;
-            }
+            jringdata_event_wait(rd, &rd->not_empty, &timeout_or_tries, st);
         } else { /* retry */
             if (timeout_or_tries > 0)
                 --timeout_or_tries;
+            JRD_STAT_ADD(st, retries, 1);
             jthread_mutex_unlock(&rd->mutex);
             jthread_yield();
             jthread_mutex_lock(&rd->mutex);
@@ -1057,7 +1551,6 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
     {
         /* 计算起始元素序号和字节偏移 */
         uint8_t *idx_buf = JRD_IDX_BUF(rd);
-        uint8_t *data_buf = JRD_DATA_BUF(rd);
 
         uint32_t idx_size = rd->idx_ctx.unit_size;
         uint32_t idx_mask = rd->idx_ctx.total_len - 1;
@@ -1065,11 +1558,31 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
 
         /* 单用户模式下，数据拷贝前临时解锁（防止长时间持锁） */
         if (rd->max_consumers == 1) {
-            rd->min_read_lock = 1;
+            ++rd->min_read_lock;
             jthread_mutex_unlock(&rd->mutex);
         }
 
-        if (!arg->is_discrete) {
+        if (filter) {
+            /* 只拷贝匹配的记录，跳过的记录不访问裸数据 */
+            uint32_t idx_pos = c_idx & idx_mask;
+            uint32_t data_pos = c_data & data_mask;
+            uint32_t k = 0, doff = 0;
+            for (uint32_t i = 0; i < scan[0]; ++i) {
+                void *entry = idx_buf + idx_pos * idx_size;
+                uint32_t dlen = rd->get_size(entry);
+                if (filter->cb(entry, filter->arg)) {
+                    void *idx_dst = arg->is_discrete ? arg->v.d.idx[k] : (uint8_t*)arg->v.c.idx + k * idx_size;
+                    void *data_dst = arg->is_discrete ? arg->v.d.data[k] : (uint8_t*)arg->v.c.data + doff;
+                    memcpy(idx_dst, entry, idx_size);
+                    if (dlen)
+                        jringdata_data_out(rd, data_pos, data_dst, dlen);
+                    doff += dlen;
+                    ++k;
+                }
+                idx_pos = (idx_pos + 1) & idx_mask;
+                data_pos = (data_pos + dlen) & data_mask;
+            }
+        } else if (!arg->is_discrete) {
             /* 读取索引 */
             void *idx_dst = arg->v.c.idx;
             void *data_dst = arg->v.c.data;
@@ -1082,15 +1595,8 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
                     idx_buf, (read_num - idx_first) * idx_size);
             }
             /* 读取数据 */
-            if (read_data) {
-                uint32_t rpos_data = c_data & data_mask;
-                uint32_t data_tail = rd->data_ctx.total_len - rpos_data;
-                uint32_t data_first = (read_data <= data_tail) ? read_data : data_tail;
-                memcpy(data_dst, data_buf + rpos_data, data_first);
-                if (read_data > data_tail) {
-                    memcpy((uint8_t*)data_dst + data_first, data_buf, read_data - data_first);
-                }
-            }
+            if (read_data)
+                jringdata_data_out(rd, c_data & data_mask, data_dst, read_data);
         } else {
             void **idx_dst_arr = arg->v.d.idx;
             void **data_dst_arr = arg->v.d.data;
@@ -1105,12 +1611,7 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
                 /* 读取数据 */
                 uint32_t dlen = rd->get_size(idx_dst_arr[i]);
                 if (dlen) {
-                    uint32_t data_tail = rd->data_ctx.total_len - data_pos;
-                    uint32_t data_first = (dlen <= data_tail) ? dlen : data_tail;
-                    memcpy(data_dst_arr[i], data_buf + data_pos, data_first);
-                    if (dlen > data_tail) {
-                        memcpy((uint8_t*)data_dst_arr[i] + data_first, data_buf, dlen - data_first);
-                    }
+                    jringdata_data_out(rd, data_pos, data_dst_arr[i], dlen);
                     data_pos = (data_pos + dlen) & data_mask;
                 }
             }
@@ -1118,7 +1619,7 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
 
         if (rd->max_consumers == 1) {
             jthread_mutex_lock(&rd->mutex);
-            rd->min_read_lock = 0;
+            --rd->min_read_lock;
         }
 
         /* 更新读位置 */
@@ -1127,20 +1628,19 @@ static int jringdata_read_common(jringdata_t *rd, int consumer_id,
             rd->idx_ctx.data_len -= read_num;
             rd->data_ctx.min_read_index += read_data;
             rd->data_ctx.data_len -= read_data;
+        } else if (filter) {
+            consumer_advance(rd, consumer_id, scan[0], scan[1]);
         } else {
-            uint32_t *ridx = JRD_RIDX_ARR(rd);
-            uint32_t *rdata = JRD_RDATA_ARR(rd);
-            ridx[consumer_id] += read_num;
-            rdata[consumer_id] += read_data;
-            if (!rd->min_read_stale && c_idx == rd->idx_ctx.min_read_index) {
-                rd->min_read_stale = 1;
-            }
-            rd->idx_ctx.data_len = rd->idx_ctx.write_index - rd->idx_ctx.min_read_index;
-            rd->data_ctx.data_len = rd->data_ctx.write_index - rd->data_ctx.min_read_index;
+            consumer_advance(rd, consumer_id, read_num, read_data);
         }
     }
 
-    jthread_cond_broadcast(&rd->not_full);
+    if (st) {
+        st->read_num += read_num;
+        st->read_bytes += read_data;
+    }
+    jringdata_event_wake(&rd->not_full, 0);
+    jringdata_evfd_sync(rd);
     --rd->rw_count;
     jthread_mutex_unlock(&rd->mutex);
     return (int)read_num;
@@ -1190,56 +1690,550 @@ int jringdata_writev(jringdata_t *rd, int producer_id, const void **idx, uint32_
 }
 
 /*----------------------------------------------------------------------------
-  对外接口：Read / Readv
+  对外接口：零拷贝写入
 ----------------------------------------------------------------------------*/
 
-int jringdata_read(jringdata_t *rd, int consumer_id, void *idx, uint32_t num,
-                   void *data, uint32_t len, uint32_t* total_num, uint32_t* total_size,
-                   uint32_t strategy, int arg)
+int jringdata_write_reserve(jringdata_t *rd, int producer_id, uint32_t data_len,
+                            void **idx, jringdata_span_t *span1, jringdata_span_t *span2)
 {
-    if (!rd || !idx || !num)
+    if (!rd || !idx || !span1 || !span2 || data_len > rd->data_ctx.total_len)
         return -1;
 
-    struct jringdata_read_arg rarg;
-    rarg.is_discrete = 0;
-    rarg.num = num;
-    rarg.v.c.idx = idx;
-    rarg.v.c.data = data;
-    rarg.v.c.len = len;
+    uint32_t idx_pos, data_pos, tail;
 
-    return jringdata_read_common(rd, consumer_id, &rarg, total_num, total_size, strategy, arg);
-}
+    jthread_mutex_lock(&rd->mutex);
+    ++rd->rw_count;
 
-int jringdata_readv(jringdata_t *rd, int consumer_id, void **idx, uint32_t num,
-                    void **data, uint32_t *len, uint32_t* total_num, uint32_t* total_size,
-                    uint32_t strategy, int arg)
-{
-    if (!rd || !idx || !num)
-        return -1;
+    if (rd->disable_rw) {
+        goto err;
+    }
 
-    struct jringdata_read_arg rarg;
-    rarg.is_discrete = 1;
-    rarg.num = num;
-    rarg.v.d.idx = idx;
-    rarg.v.d.data = data;
-    rarg.v.d.len = len;
+    if (rd->max_producers > 1 &&
+        (producer_id < 0 || (uint32_t)producer_id >= rd->max_producers
+            || !JRD_PROD_ACT(rd)[producer_id])) {
+        goto err;
+    }
 
-    return jringdata_read_common(rd, consumer_id, &rarg, total_num, total_size, strategy, arg);
-}
+    /* 同一时刻只能有一个预留，已有预留（包括本生产者自己的）时和空间不足一样直接失败 */
+    if (rd->wr_reserved) {
+        goto err;
+    }
 
-/*----------------------------------------------------------------------------
-  生产者管理
-----------------------------------------------------------------------------*/
+    if (rd->min_read_stale)
+        update_min_read_index(rd);
 
-/**
- * @brief   添加一个生产者
- */
-int jringdata_add_producer(jringdata_t *rd)
-{
-    if (!rd)
-        return -1;
-    if (rd->max_producers == 1)
-        return 0;
+    if (rd->idx_ctx.data_len >= rd->idx_ctx.total_len
+        || rd->data_ctx.total_len - rd->data_ctx.data_len < data_len) {
+        goto err;
+    }
+
+    idx_pos = rd->idx_ctx.write_index & (rd->idx_ctx.total_len - 1);
+    data_pos = rd->data_ctx.write_index & (rd->data_ctx.total_len - 1);
+    tail = rd->data_ctx.total_len - data_pos;
+
+    *idx = JRD_IDX_BUF(rd) + idx_pos * rd->idx_ctx.unit_size;
+    span1->data = JRD_DATA_BUF(rd) + data_pos;
+    if (data_len <= tail || rd->mirror) {
+        span1->len = data_len;
+        span2->data = JRD_DATA_BUF(rd);
+        span2->len = 0;
+    } else {
+        span1->len = tail;
+        span2->data = JRD_DATA_BUF(rd);
+        span2->len = data_len - tail;
+    }
+
+    /* 提交前保持 rw_count 计数，其它生产者看到 wr_reserved 后失败或按策略等待，jringdata_stop 会等待提交 */
+    rd->wr_reserved = 1;
+    rd->wr_data = data_len;
+    rd->wr_producer = rd->max_producers > 1 ? producer_id : 0;
+    jthread_mutex_unlock(&rd->mutex);
+    return 0;
+
+err:
+    --rd->rw_count;
+    jthread_mutex_unlock(&rd->mutex);
+    return -1;
+}
+
+int jringdata_write_commit(jringdata_t *rd, int producer_id, uint32_t num)
+{
+    if (!rd || num > 1)
+        return -1;
+
+    uint32_t dlen = 0;
+    jringdata_stats_t *st;
+
+    if (rd->max_producers == 1)
+        producer_id = 0;
+
+    jthread_mutex_lock(&rd->mutex);
+    if (!rd->wr_reserved || rd->wr_producer != producer_id) {
+        jthread_mutex_unlock(&rd->mutex);
+        return -1;
+    }
+
+    if (num) {
+        uint32_t idx_pos = rd->idx_ctx.write_index & (rd->idx_ctx.total_len - 1);
+        dlen = rd->get_size(JRD_IDX_BUF(rd) + idx_pos * rd->idx_ctx.unit_size);
+        if (dlen > rd->wr_data) {
+            jthread_mutex_unlock(&rd->mutex);
+            return -1;
+        }
+
+        if (rd->dpos_offset)
+            JRD_DPOS_ARR(rd)[idx_pos] = rd->data_ctx.write_index;
+        if (rd->ts_offset)
+            JRD_TS_ARR(rd)[idx_pos] = jtime_mononsec_get();
+        rd->idx_ctx.write_index += 1;
+        rd->idx_ctx.data_len += 1;
+        rd->write_seq += 1;
+        rd->data_ctx.write_index += dlen;
+        rd->data_ctx.data_len += dlen;
+        if ((st = jringdata_stats_slot(rd, 0, producer_id)) != NULL) {
+            st->write_num += 1;
+            st->write_bytes += dlen;
+            ++st->occupancy[32 - jbit32_clz(rd->idx_ctx.data_len)];
+        }
+        if (rd->idx_ctx.data_len >= rd->wake_num)
+            jringdata_event_wake(&rd->not_empty, 0);
+    }
+
+    rd->wr_reserved = 0;
+    rd->wr_data = 0;
+    /* 唤醒因预留而阻塞等待的其它生产者 */
+    jringdata_event_wake(&rd->not_full, 0);
+    --rd->rw_count;
+    jringdata_evfd_sync(rd);
+    jthread_mutex_unlock(&rd->mutex);
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+  对外接口：生产者批量暂存
+----------------------------------------------------------------------------*/
+
+int jringdata_stage_init(jringdata_stage_t *sg, jringdata_t *rd, int producer_id, uint32_t max_num,
+                         uint32_t max_bytes, uint64_t max_delay_ns, uint32_t strategy, int arg)
+{
+    if (!sg || !rd || !max_num || !max_bytes)
+        return -1;
+
+    uint32_t idx_bytes = max_num * rd->idx_ctx.unit_size;
+    if (idx_bytes / max_num != rd->idx_ctx.unit_size || idx_bytes + max_bytes < idx_bytes)
+        return -1;
+
+    /* 索引和裸数据暂存区一次分配 */
+    sg->idx = (uint8_t*)jheap_malloc(idx_bytes + max_bytes);
+    if (!sg->idx)
+        return -1;
+    sg->data = sg->idx + idx_bytes;
+    sg->rd = rd;
+    sg->producer_id = producer_id;
+    sg->strategy = strategy;
+    sg->arg = arg;
+    sg->max_num = max_num;
+    sg->max_bytes = max_bytes;
+    sg->max_delay_ns = max_delay_ns;
+    sg->num = 0;
+    sg->bytes = 0;
+    sg->first_ns = 0;
+    return 0;
+}
+
+void jringdata_stage_uninit(jringdata_stage_t *sg)
+{
+    if (!sg)
+        return;
+    if (sg->idx)
+        jheap_free(sg->idx);
+    sg->idx = NULL;
+    sg->data = NULL;
+    sg->num = 0;
+    sg->bytes = 0;
+}
+
+int jringdata_stage(jringdata_stage_t *sg, const void *idx, const void *data)
+{
+    if (!sg || !sg->idx || !idx)
+        return -1;
+
+    jringdata_t *rd = sg->rd;
+    uint32_t idx_size = rd->idx_ctx.unit_size;
+    uint32_t dlen = rd->get_size(idx);
+
+    if (dlen > sg->max_bytes || (dlen && !data))
+        return -1;
+
+    /* 暂存区放不下时先发布 */
+    if (sg->num == sg->max_num || sg->bytes + dlen > sg->max_bytes) {
+        jringdata_flush(sg, 1);
+        if (sg->num == sg->max_num || sg->bytes + dlen > sg->max_bytes)
+            return -1;
+    }
+
+    memcpy(sg->idx + sg->num * idx_size, idx, idx_size);
+    if (dlen)
+        memcpy(sg->data + sg->bytes, data, dlen);
+    if (!sg->num && sg->max_delay_ns)
+        sg->first_ns = jtime_mononsec_get();
+    ++sg->num;
+    sg->bytes += dlen;
+
+    /* 发布失败时记录仍保留在暂存区，下次暂存或发布时重试 */
+    jringdata_flush(sg, 0);
+    return 0;
+}
+
+int jringdata_flush(jringdata_stage_t *sg, int force)
+{
+    if (!sg || !sg->idx)
+        return -1;
+    if (!sg->num)
+        return 0;
+
+    if (!force && sg->num < sg->max_num && sg->bytes < sg->max_bytes &&
+        (!sg->max_delay_ns || jtime_mononsec_get() - sg->first_ns < sg->max_delay_ns))
+        return 0;
+
+    jringdata_t *rd = sg->rd;
+    int ret = jringdata_write(rd, sg->producer_id, sg->idx, sg->num, sg->data, sg->strategy, sg->arg, NULL);
+    if (ret <= 0)
+        return -1;
+
+    if ((uint32_t)ret < sg->num) {
+        /* 只发布了前面一部分，剩余的记录移到开头，保持原有顺序 */
+        uint32_t idx_size = rd->idx_ctx.unit_size;
+        uint32_t done_bytes = calc_data_len_for_input_idx(rd, sg->idx, (uint32_t)ret);
+        memmove(sg->idx, sg->idx + (uint32_t)ret * idx_size, (sg->num - (uint32_t)ret) * idx_size);
+        memmove(sg->data, sg->data + done_bytes, sg->bytes - done_bytes);
+        sg->num -= (uint32_t)ret;
+        sg->bytes -= done_bytes;
+    } else {
+        sg->num = 0;
+        sg->bytes = 0;
+    }
+    return ret;
+}
+
+/*----------------------------------------------------------------------------
+  对外接口：Read / Readv
+----------------------------------------------------------------------------*/
+
+int jringdata_read(jringdata_t *rd, int consumer_id, void *idx, uint32_t num,
+                   void *data, uint32_t len, uint32_t* total_num, uint32_t* total_size,
+                   uint32_t strategy, int arg)
+{
+    if (!rd || !idx || !num)
+        return -1;
+
+    struct jringdata_read_arg rarg;
+    rarg.is_discrete = 0;
+    rarg.num = num;
+    rarg.v.c.idx = idx;
+    rarg.v.c.data = data;
+    rarg.v.c.len = len;
+
+    return jringdata_read_common(rd, consumer_id, &rarg, total_num, total_size, strategy, arg);
+}
+
+int jringdata_readv(jringdata_t *rd, int consumer_id, void **idx, uint32_t num,
+                    void **data, uint32_t *len, uint32_t* total_num, uint32_t* total_size,
+                    uint32_t strategy, int arg)
+{
+    if (!rd || !idx || !num)
+        return -1;
+
+    struct jringdata_read_arg rarg;
+    rarg.is_discrete = 1;
+    rarg.num = num;
+    rarg.v.d.idx = idx;
+    rarg.v.d.data = data;
+    rarg.v.d.len = len;
+
+    return jringdata_read_common(rd, consumer_id, &rarg, total_num, total_size, strategy, arg);
+}
+
+/*----------------------------------------------------------------------------
+  对外接口：零拷贝迭代读取
+----------------------------------------------------------------------------*/
+
+int jringdata_iter_begin(jringdata_t *rd, int consumer_id, jringdata_iter_t *it)
+{
+    if (!rd || !it)
+        return -1;
+
+    uint32_t c_idx, c_data, avail_idx;
+    int shared_mode;
+
+    jthread_mutex_lock(&rd->mutex);
+    ++rd->rw_count;
+
+    if (rd->max_consumers == 1) {
+        consumer_id = 0;
+    } else if (consumer_id < 0 || (uint32_t)consumer_id >= rd->max_consumers) {
+        goto err;
+    }
+
+    shared_mode = (rd->max_consumers == 1 || rd->read_mode == JRINGDATA_READ_SHARED);
+
+    while (1) {
+        if (rd->disable_rw)
+            goto err;
+        if (rd->max_consumers > 1 && !JRD_CONS_ACT(rd)[consumer_id])
+            goto err;
+        /* 共享读位置同一时刻只能有一个迭代器 */
+        if (!shared_mode || !rd->rd_reserved)
+            break;
+        if (rd->rd_consumer == consumer_id)
+            goto err;
+        jthread_mutex_unlock(&rd->mutex);
+        jthread_yield();
+        jthread_mutex_lock(&rd->mutex);
+    }
+
+    if (rd->max_age_ns && !(shared_mode && rd->min_read_lock)) {
+        uint32_t expired = expire_old_data(rd, shared_mode ? -1 : consumer_id);
+        JRD_STAT_ADD(jringdata_stats_slot(rd, 1, consumer_id), drop_expired, expired);
+    }
+
+    if (shared_mode) {
+        c_idx = rd->idx_ctx.min_read_index;
+        c_data = rd->data_ctx.min_read_index;
+        avail_idx = rd->idx_ctx.data_len;
+    } else {
+        c_idx = JRD_RIDX_ARR(rd)[consumer_id];
+        c_data = JRD_RDATA_ARR(rd)[consumer_id];
+        avail_idx = rd->idx_ctx.write_index - c_idx;
+    }
+    if (!avail_idx)
+        goto err;
+
+    it->rd = rd;
+    it->consumer_id = consumer_id;
+    it->idx_start = c_idx;
+    it->data_start = c_data;
+    it->idx_pos = c_idx;
+    it->data_pos = c_data;
+    it->idx_end = c_idx + avail_idx;
+    it->filter = NULL;
+    it->filter_arg = NULL;
+    if (!shared_mode && rd->filters && rd->filters[consumer_id].cb) {
+        it->filter = rd->filters[consumer_id].cb;
+        it->filter_arg = rd->filters[consumer_id].arg;
+    }
+
+    /* 结束前保持 rw_count 和 min_read_lock 计数，jringdata_stop 会等待结束，记录不会被丢弃 */
+    if (shared_mode) {
+        rd->rd_reserved = 1;
+        rd->rd_consumer = consumer_id;
+    }
+    ++rd->min_read_lock;
+    jthread_mutex_unlock(&rd->mutex);
+    return (int)avail_idx;
+
+err:
+    --rd->rw_count;
+    jthread_mutex_unlock(&rd->mutex);
+    return -1;
+}
+
+int jringdata_iter_next(jringdata_iter_t *it, void **idx, jringdata_span_t *span1, jringdata_span_t *span2)
+{
+    if (!it || !it->rd || !idx || !span1 || !span2 || it->idx_pos == it->idx_end)
+        return -1;
+
+    jringdata_t *rd = it->rd;
+    uint32_t idx_pos, data_pos, tail, dlen;
+
+    /* [idx_start, idx_end) 内的记录已发布且不会被丢弃，无需持锁 */
+    while (1) {
+        idx_pos = it->idx_pos & (rd->idx_ctx.total_len - 1);
+        *idx = JRD_IDX_BUF(rd) + idx_pos * rd->idx_ctx.unit_size;
+        dlen = rd->get_size(*idx);
+        if (!it->filter || it->filter(*idx, it->filter_arg))
+            break;
+        /* 跳过不匹配的记录，只越过其裸数据 */
+        ++it->idx_pos;
+        it->data_pos += dlen;
+        if (it->idx_pos == it->idx_end)
+            return -1;
+    }
+    data_pos = it->data_pos & (rd->data_ctx.total_len - 1);
+    tail = rd->data_ctx.total_len - data_pos;
+    span1->data = JRD_DATA_BUF(rd) + data_pos;
+    if (dlen <= tail || rd->mirror) {
+        span1->len = dlen;
+        span2->data = JRD_DATA_BUF(rd);
+        span2->len = 0;
+    } else {
+        span1->len = tail;
+        span2->data = JRD_DATA_BUF(rd);
+        span2->len = dlen - tail;
+    }
+
+    ++it->idx_pos;
+    it->data_pos += dlen;
+    return 0;
+}
+
+int jringdata_iter_end(jringdata_iter_t *it)
+{
+    if (!it || !it->rd)
+        return -1;
+
+    jringdata_t *rd = it->rd;
+    int consumer_id = it->consumer_id;
+    uint32_t read_num = it->idx_pos - it->idx_start;
+    uint32_t read_data = it->data_pos - it->data_start;
+    jringdata_stats_t *st = jringdata_stats_slot(rd, 1, consumer_id);
+    int ret = 0;
+
+    jthread_mutex_lock(&rd->mutex);
+    if (rd->max_consumers == 1 || rd->read_mode == JRINGDATA_READ_SHARED) {
+        if (!rd->rd_reserved || rd->rd_consumer != consumer_id) {
+            jthread_mutex_unlock(&rd->mutex);
+            return -1;
+        }
+        rd->idx_ctx.min_read_index += read_num;
+        rd->idx_ctx.data_len -= read_num;
+        rd->data_ctx.min_read_index += read_data;
+        rd->data_ctx.data_len -= read_data;
+        rd->rd_reserved = 0;
+    } else {
+        uint32_t *ridx = JRD_RIDX_ARR(rd);
+        uint32_t *rdata = JRD_RDATA_ARR(rd);
+        /* 迭代期间消费者被移除或读位置被改变时不推进 */
+        if (!JRD_CONS_ACT(rd)[consumer_id] || ridx[consumer_id] != it->idx_start) {
+            ret = -1;
+        } else {
+            ridx[consumer_id] += read_num;
+            rdata[consumer_id] += read_data;
+            if (!rd->min_read_stale && (it->idx_start == rd->idx_ctx.min_read_index || rd->hold_num))
+                rd->min_read_stale = 1;
+        }
+    }
+
+    if (!ret && st) {
+        st->read_num += read_num;
+        st->read_bytes += read_data;
+    }
+    --rd->min_read_lock;
+    --rd->rw_count;
+    jringdata_event_wake(&rd->not_full, 0);
+    jringdata_evfd_sync(rd);
+    jthread_mutex_unlock(&rd->mutex);
+    it->rd = NULL;
+    return ret;
+}
+
+/*----------------------------------------------------------------------------
+  对外接口：直接写出到文件描述符
+----------------------------------------------------------------------------*/
+
+#define JRD_FD_IOV_NUM      256     // jringdata_read_to_fd 一次最多构造的 iovec 个数
+
+int jringdata_read_to_fd(jringdata_t *rd, int consumer_id, int fd, uint32_t max_records, uint32_t flags)
+{
+    if (!rd || fd < 0)
+        return -1;
+
+    jfs_iovec_t iov[JRD_FD_IOV_NUM];
+    uint16_t rec_iov[JRD_FD_IOV_NUM + 1];   // 每条记录的第一个 iovec 下标，最后一项为 iovec 总个数
+    jringdata_iter_t it;
+    jringdata_span_t span1, span2;
+    void *idx;
+    uint32_t num = 0, done = 0, i;
+    size_t pos = 0, end;
+    ssize_t n = 0;
+    int cnt = 0, ret;
+
+    ret = jringdata_iter_begin(rd, consumer_id, &it);
+    if (ret < 0)
+        return -1;
+    if (!max_records || max_records > (uint32_t)ret)
+        max_records = (uint32_t)ret;
+
+    /* 每条记录最多 3 个 iovec：索引（JRINGDATA_FD_IDX）和跨越尾部的两段裸数据 */
+    while (num < max_records && cnt + 3 <= JRD_FD_IOV_NUM) {
+        if (jringdata_iter_next(&it, &idx, &span1, &span2) < 0)
+            break;
+        rec_iov[num++] = (uint16_t)cnt;
+        if (flags & JRINGDATA_FD_IDX) {
+            iov[cnt].iov_base = idx;
+            iov[cnt++].iov_len = rd->idx_ctx.unit_size;
+        }
+        if (span1.len) {
+            iov[cnt].iov_base = span1.data;
+            iov[cnt++].iov_len = span1.len;
+        }
+        if (span2.len) {
+            iov[cnt].iov_base = span2.data;
+            iov[cnt++].iov_len = span2.len;
+        }
+    }
+    rec_iov[num] = (uint16_t)cnt;
+
+    if (cnt) {
+        do {
+            n = jfs_writev(fd, iov, cnt);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) {
+            ret = errno;
+            it.idx_pos = it.idx_start;
+            it.data_pos = it.data_start;
+            jringdata_iter_end(&it);
+            errno = ret;
+            return -1;
+        }
+    }
+
+    /* 找出内核完整接受的记录 */
+    for (i = 0; i < num; ++i) {
+        end = pos;
+        for (ret = rec_iov[i]; ret < rec_iov[i + 1]; ++ret)
+            end += iov[ret].iov_len;
+        if (end > (size_t)n)
+            break;
+        pos = end;
+        done = i + 1;
+    }
+    if (done < num && ((size_t)n > pos || (flags & JRINGDATA_FD_ALL))) {
+        /* 补写只写出一部分的记录（JRINGDATA_FD_ALL时为全部剩余记录），接收端不会看到半条记录 */
+        uint32_t target = (flags & JRINGDATA_FD_ALL) ? num : done + 1;
+
+        if (jfs_writev_full(fd, iov + rec_iov[done], rec_iov[target] - rec_iov[done], (size_t)n - pos,
+                JRINGDATA_FD_WAIT_MS) == 0)
+            done = target;
+        else if ((size_t)n > pos)
+            ++done; /* 已写出一部分的记录不能重发，也算作消费 */
+    }
+
+    /* 迭代器回退到最后一条消费的记录之后，只释放消费的记录 */
+    if (done < num) {
+        it.idx_pos = it.idx_start;
+        it.data_pos = it.data_start;
+        for (i = 0; i < done; ++i)
+            jringdata_iter_next(&it, &idx, &span1, &span2);
+    }
+    if (jringdata_iter_end(&it) < 0)
+        return -1;
+    return (int)done;
+}
+
+/*----------------------------------------------------------------------------
+  生产者管理
+----------------------------------------------------------------------------*/
+
+/**
+ * @brief   添加一个生产者
+ */
+int jringdata_add_producer(jringdata_t *rd)
+{
+    if (!rd)
+        return -1;
+    if (rd->max_producers == 1)
+        return 0;
 
     jthread_mutex_lock(&rd->mutex);
     uint8_t *prod = JRD_PROD_ACT(rd);
@@ -1291,7 +2285,8 @@ int jringdata_del_producer(jringdata_t *rd, int producer_id)
     --rd->cur_producers;
 
 end:
-    jthread_cond_broadcast(&rd->not_full);
+    jringdata_event_wake(&rd->not_full, 0);
+    jringdata_evfd_sync(rd);
     jthread_mutex_unlock(&rd->mutex);
     return 0;
 }
@@ -1304,13 +2299,30 @@ end:
  * @brief   添加一个消费者，返回消费者 ID
  */
 int jringdata_add_consumer(jringdata_t *rd, int use_ridx)
+{
+    return jringdata_add_consumer_filter(rd, use_ridx, NULL, NULL);
+}
+
+/**
+ * @brief   添加一个带记录过滤的消费者，返回消费者 ID
+ */
+int jringdata_add_consumer_filter(jringdata_t *rd, int use_ridx, jringdata_filter_cb filter, void *arg)
 {
     if (!rd)
         return -1;
+    if (filter && (rd->max_consumers == 1 || rd->read_mode != JRINGDATA_READ_EXCLUSIVE))
+        return -1;
     if (rd->max_consumers == 1)
         return 0;
 
     jthread_mutex_lock(&rd->mutex);
+    if (filter && !rd->filters) {
+        rd->filters = (struct jringdata_filter*)jheap_calloc(rd->max_consumers, sizeof(struct jringdata_filter));
+        if (!rd->filters) {
+            jthread_mutex_unlock(&rd->mutex);
+            return -1;
+        }
+    }
     uint8_t *act = JRD_CONS_ACT(rd);
     uint32_t i = rd->cur_consumers;
     if (rd->cur_consumers < rd->max_consumers) {
@@ -1328,6 +2340,10 @@ int jringdata_add_consumer(jringdata_t *rd, int use_ridx)
 end:
     act[i] = 1;
     ++rd->cur_consumers;
+    if (rd->filters) {
+        rd->filters[i].cb = filter;
+        rd->filters[i].arg = arg;
+    }
     if (rd->read_mode == JRINGDATA_READ_EXCLUSIVE) {
         uint32_t *ridx = JRD_RIDX_ARR(rd);
         uint32_t *rdata = JRD_RDATA_ARR(rd);
@@ -1339,6 +2355,7 @@ end:
             rdata[i] = rd->data_ctx.write_index;
         }
     }
+    jringdata_evfd_sync(rd);
     jthread_mutex_unlock(&rd->mutex);
     return (int)i;
 }
@@ -1357,7 +2374,8 @@ int jringdata_del_consumer(jringdata_t *rd, int consumer_id)
             rd->idx_ctx.data_len = 0;
             rd->data_ctx.min_read_index = rd->data_ctx.write_index;
             rd->data_ctx.data_len = 0;
-            jthread_cond_broadcast(&rd->not_full);
+            jringdata_event_wake(&rd->not_full, 0);
+            jringdata_evfd_sync(rd);
             jthread_mutex_unlock(&rd->mutex);
             return 0;
         }
@@ -1382,8 +2400,9 @@ int jringdata_del_consumer(jringdata_t *rd, int consumer_id)
 
 end:
     update_min_read_index(rd);
-    jthread_cond_broadcast(&rd->not_full);
-    jthread_cond_broadcast(&rd->not_empty);
+    jringdata_event_wake(&rd->not_full, 0);
+    jringdata_event_wake(&rd->not_empty, 0);
+    jringdata_evfd_sync(rd);
     jthread_mutex_unlock(&rd->mutex);
     return 0;
 }
@@ -1405,6 +2424,7 @@ int jringdata_drop_data(jringdata_t *rd, int consumer_id, uint32_t dropped)
 
     uint32_t idx_avail, drop_idx, drop_data;
     uint8_t *act = NULL;
+    jringdata_stats_t *st = jringdata_stats_slot(rd, 1, consumer_id < 0 ? 0 : consumer_id);
 
     if (rd->max_consumers == 1) {
         if (consumer_id == 0 || consumer_id == -1) {
@@ -1427,6 +2447,7 @@ int jringdata_drop_data(jringdata_t *rd, int consumer_id, uint32_t dropped)
                     uint32_t drop_data_len = calc_data_len_for_idx_range(rd, ridx[i], drop_idx);
                     ridx[i] += drop_idx;
                     rdata[i] += drop_data_len;
+                    JRD_STAT_ADD(jringdata_stats_slot(rd, 1, (int)i), drop_user, drop_idx);
                     ++j;
                 }
             }
@@ -1450,6 +2471,7 @@ int jringdata_drop_data(jringdata_t *rd, int consumer_id, uint32_t dropped)
         drop_data = calc_data_len_for_idx_range(rd, ridx[consumer_id], drop_idx);
         ridx[consumer_id] += drop_idx;
         rdata[consumer_id] += drop_data;
+        JRD_STAT_ADD(st, drop_user, drop_idx);
         update_min_read_index(rd);
         goto end1;
     } else {
@@ -1465,10 +2487,224 @@ end2:
     rd->idx_ctx.data_len -= drop_idx;
     rd->data_ctx.min_read_index += drop_data;
     rd->data_ctx.data_len -= drop_data;
+    JRD_STAT_ADD(st, drop_user, drop_idx);
 
 end1:
-    jthread_cond_broadcast(&rd->not_full);
+    jringdata_event_wake(&rd->not_full, 0);
+    jringdata_evfd_sync(rd);
+    jthread_mutex_unlock(&rd->mutex);
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+  序号与定位
+----------------------------------------------------------------------------*/
+
+/**
+ * @brief   获取缓冲区中保留的最早记录序号和下一条写入记录的序号
+ */
+int jringdata_seq_range(jringdata_t *rd, uint64_t *oldest, uint64_t *next)
+{
+    if (!rd)
+        return -1;
+
+    jthread_mutex_lock(&rd->mutex);
+    if (rd->min_read_stale)
+        update_min_read_index(rd);
+    if (oldest)
+        *oldest = rd->write_seq - rd->idx_ctx.data_len;
+    if (next)
+        *next = rd->write_seq;
+    jthread_mutex_unlock(&rd->mutex);
+    return 0;
+}
+
+/**
+ * @brief   获取消费者下一条未读记录的序号
+ */
+int jringdata_tell(jringdata_t *rd, int consumer_id, uint64_t *seq)
+{
+    if (!rd || !seq)
+        return -1;
+
+    uint32_t c_idx;
+
+    jthread_mutex_lock(&rd->mutex);
+    if (rd->max_consumers == 1) {
+        consumer_id = 0;
+    } else if (consumer_id < 0 || (uint32_t)consumer_id >= rd->max_consumers
+            || !JRD_CONS_ACT(rd)[consumer_id]) {
+        jthread_mutex_unlock(&rd->mutex);
+        return -1;
+    }
+
+    if (rd->read_mode == JRINGDATA_READ_EXCLUSIVE)
+        c_idx = JRD_RIDX_ARR(rd)[consumer_id];
+    else
+        c_idx = rd->idx_ctx.min_read_index;
+    *seq = rd->write_seq - (rd->idx_ctx.write_index - c_idx);
     jthread_mutex_unlock(&rd->mutex);
     return 0;
 }
 
+/**
+ * @brief   把消费者的读位置移动到指定序号的记录
+ */
+int jringdata_seek(jringdata_t *rd, int consumer_id, uint64_t seq)
+{
+    if (!rd || !rd->dpos_offset)
+        return -1;
+
+    uint32_t t_idx, t_data;
+
+    jthread_mutex_lock(&rd->mutex);
+    /* 共享读位置正在被锁外读取或迭代时不能移动 */
+    while (rd->read_mode == JRINGDATA_READ_SHARED && (rd->min_read_lock || rd->rd_reserved)) {
+        jthread_mutex_unlock(&rd->mutex);
+        jthread_yield();
+        jthread_mutex_lock(&rd->mutex);
+    }
+
+    if (rd->max_consumers == 1) {
+        consumer_id = 0;
+    } else if (consumer_id < 0 || (uint32_t)consumer_id >= rd->max_consumers
+            || !JRD_CONS_ACT(rd)[consumer_id]) {
+        goto err;
+    }
+
+    if (rd->min_read_stale)
+        update_min_read_index(rd);
+
+    /* 只能定位到 [最早保留的记录, 下一条写入的记录]，更早的记录已被覆盖或释放 */
+    if (seq > rd->write_seq || rd->write_seq - seq > rd->idx_ctx.data_len)
+        goto err;
+
+    /* 索引个数是2的幂，序号和索引绝对位置一一对应，数据位置由槽位记录直接得到 */
+    t_idx = rd->idx_ctx.write_index - (uint32_t)(rd->write_seq - seq);
+    if (t_idx == rd->idx_ctx.write_index)
+        t_data = rd->data_ctx.write_index;
+    else
+        t_data = JRD_DPOS_ARR(rd)[t_idx & (rd->idx_ctx.total_len - 1)];
+
+    if (rd->read_mode == JRINGDATA_READ_EXCLUSIVE) {
+        uint32_t *ridx = JRD_RIDX_ARR(rd);
+        uint32_t *rdata = JRD_RDATA_ARR(rd);
+        if ((ridx[consumer_id] == rd->idx_ctx.min_read_index || rd->hold_num) && t_idx != ridx[consumer_id])
+            rd->min_read_stale = 1;
+        ridx[consumer_id] = t_idx;
+        rdata[consumer_id] = t_data;
+    } else {
+        /* 共享读模式下序号不早于读位置，只能向前跳过 */
+        rd->idx_ctx.min_read_index = t_idx;
+        rd->idx_ctx.data_len = rd->idx_ctx.write_index - t_idx;
+        rd->data_ctx.min_read_index = t_data;
+        rd->data_ctx.data_len = rd->data_ctx.write_index - t_data;
+    }
+
+    jringdata_event_wake(&rd->not_full, 0);
+    jringdata_evfd_sync(rd);
+    jthread_mutex_unlock(&rd->mutex);
+    return 0;
+
+err:
+    jthread_mutex_unlock(&rd->mutex);
+    return -1;
+}
+
+/**
+ * @brief   获取消费者下一条未读记录的写入时间
+ */
+int jringdata_front_time(jringdata_t *rd, int consumer_id, uint64_t *ns)
+{
+    if (!rd || !ns || !rd->ts_offset)
+        return -1;
+
+    uint32_t c_idx;
+
+    jthread_mutex_lock(&rd->mutex);
+    if (rd->max_consumers == 1) {
+        consumer_id = 0;
+    } else if (consumer_id < 0 || (uint32_t)consumer_id >= rd->max_consumers
+            || !JRD_CONS_ACT(rd)[consumer_id]) {
+        jthread_mutex_unlock(&rd->mutex);
+        return -1;
+    }
+
+    if (rd->read_mode == JRINGDATA_READ_EXCLUSIVE)
+        c_idx = JRD_RIDX_ARR(rd)[consumer_id];
+    else
+        c_idx = rd->idx_ctx.min_read_index;
+    if (c_idx == rd->idx_ctx.write_index) {
+        jthread_mutex_unlock(&rd->mutex);
+        return -1;
+    }
+    *ns = JRD_TS_ARR(rd)[c_idx & (rd->idx_ctx.total_len - 1)];
+    jthread_mutex_unlock(&rd->mutex);
+    return 0;
+}
+
+/**
+ * @brief   获取迭代器最近一次返回的记录的写入时间
+ */
+uint64_t jringdata_iter_time(const jringdata_iter_t *it)
+{
+    if (!it || !it->rd || !it->rd->ts_offset || it->idx_pos == it->idx_start)
+        return 0;
+    return JRD_TS_ARR(it->rd)[(it->idx_pos - 1) & (it->rd->idx_ctx.total_len - 1)];
+}
+
+/*----------------------------------------------------------------------------
+  就绪描述符
+----------------------------------------------------------------------------*/
+
+/**
+ * @brief   获取消费者的数据就绪描述符
+ */
+int jringdata_get_event_fd(jringdata_t *rd, int consumer_id)
+{
+    if (!rd)
+        return -1;
+    if (rd->max_consumers == 1)
+        consumer_id = 0;
+    else if (consumer_id < 0 || (uint32_t)consumer_id >= rd->max_consumers)
+        return -1;
+
+    return jringdata_evfd_get(rd, rd->read_mode == JRINGDATA_READ_EXCLUSIVE ? 1 + (uint32_t)consumer_id : 1);
+}
+
+/**
+ * @brief   获取生产者的空间就绪描述符
+ */
+int jringdata_get_space_fd(jringdata_t *rd)
+{
+    if (!rd)
+        return -1;
+
+    return jringdata_evfd_get(rd, 0);
+}
+
+/*----------------------------------------------------------------------------
+  统计信息
+----------------------------------------------------------------------------*/
+
+/**
+ * @brief   获取统计信息
+ */
+int jringdata_stats_get(jringdata_t *rd, jringdata_stats_t *stats)
+{
+    if (!rd || !stats || !rd->stats)
+        return -1;
+
+    uint64_t *dst = (uint64_t *)stats;
+    uint32_t num = sizeof(jringdata_stats_t) / sizeof(uint64_t);
+
+    memset(stats, 0, sizeof(jringdata_stats_t));
+    jthread_mutex_lock(&rd->mutex);
+    for (uint32_t i = 0; i < rd->max_producers + rd->max_consumers; ++i) {
+        const uint64_t *src = (const uint64_t *)&rd->stats[i];
+        for (uint32_t j = 0; j < num; ++j)
+            dst[j] += src[j];
+    }
+    jthread_mutex_unlock(&rd->mutex);
+    return 0;
+}
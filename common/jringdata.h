@@ -41,10 +41,112 @@ enum jringdata_read_mode {
     JRINGDATA_READ_EXCLUSIVE    // 独立读指针：所有消费者都读过某数据后空间才释放
 };
 
+/**
+ * @brief   缓冲区特性标志（jringdata_cfg_t.flags，可按位或）
+ * @note    JRINGDATA_MIRROR：裸数据缓冲区使用镜像映射（同一块内存连续映射两次），任意不超过容量的
+ *          数据在虚拟地址上都连续，读写不再分段拷贝；容量小于映射粒度（posix为页大小，windows为64KB）时自动增大
+ *          JRINGDATA_STATS：记录统计信息，每个生产者和消费者各有一组计数，持有互斥锁时累加，jringdata_stats_get 时才汇总
+ *          JRINGDATA_SEQ：每个索引槽位额外记录一个uint32_t的数据位置，jringdata_seek 可以O(1)定位到任意保留的记录；
+ *          记录序号总是从0开始递增，未开启时 jringdata_seq_range 和 jringdata_tell 也可用
+ *          JRINGDATA_TIME：每个索引槽位额外记录一个uint64_t的写入时间（jtime_mononsec_get），消费者可以通过
+ *          jringdata_front_time 或 jringdata_iter_time 获取，计算排队延迟；cfg.max_age_ns不为0时自动开启
+ */
+enum jringdata_flag {
+    JRINGDATA_MIRROR = 1,       // 裸数据缓冲区镜像映射
+    JRINGDATA_STATS  = 1 << 1,  // 记录统计信息
+    JRINGDATA_SEQ    = 1 << 2,  // 支持按序号定位（jringdata_seek）
+    JRINGDATA_TIME   = 1 << 3   // 记录每条记录的写入时间
+};
+
+/**
+ * @brief   jringdata_read_to_fd 的标志（可按位或）
+ */
+enum jringdata_fd_flag {
+    JRINGDATA_FD_ALL = 1,       // 写出迭代到的全部记录才返回，否则只调用一次writev（补写不完整的记录除外）
+    JRINGDATA_FD_IDX = 1 << 1   // 每条记录的裸数据前先写出索引（idx_size字节），否则只写出裸数据
+};
+
+#define JRINGDATA_FD_WAIT_MS 1000 // jringdata_read_to_fd 补写时非阻塞描述符最多等待可写的毫秒数
+
+#define JRINGDATA_HIST_NUM  33  // 占用直方图的桶数
+
+/**
+ * @brief   统计信息（JRINGDATA_STATS）
+ * @note    occupancy 是每次写入后缓冲区中索引个数的 log2 直方图：[0] 为 0 个，[k] 为 [2^(k-1), 2^k) 个
+ */
+typedef struct jringdata_stats {
+    uint64_t write_num;         // 写入的索引个数
+    uint64_t write_bytes;       // 写入的裸数据字节数
+    uint64_t write_short;       // 请求写入但没有写入的索引个数（空间不足、停止读写等）
+    uint64_t read_num;          // 读取的索引个数
+    uint64_t read_bytes;        // 读取的裸数据字节数
+    uint64_t drop_full;         // 写入时 JRINGDATA_DROP 丢弃的旧索引个数
+    uint64_t drop_user;         // jringdata_drop_data 丢弃的索引个数
+    uint64_t block_waits;       // JRINGDATA_BLOCK 等待的次数
+    uint64_t block_nsec;        // JRINGDATA_BLOCK 等待的总时间（纳秒）
+    uint64_t retries;           // JRINGDATA_RETRY 重试的次数
+    uint64_t drop_expired;      // 超过 max_age_ns 过期丢弃的索引个数（读取时跳过的算消费者，丢弃时的算生产者）
+    uint64_t occupancy[JRINGDATA_HIST_NUM]; // 写入后索引个数的 log2 直方图
+} jringdata_stats_t;
+
+/**
+ * @brief   零拷贝写入或迭代读取时裸数据缓冲区中的一段连续内存
+ * @note    预留的区域跨越缓冲区尾部时分为两段（JRINGDATA_MIRROR时不分段），否则第二段的len为0
+ */
+typedef struct jringdata_span {
+    void *data;                 // 连续内存起始地址
+    uint32_t len;               // 连续内存的字节数
+} jringdata_span_t;
+
+/**
+ * @brief   消费者的记录过滤回调，只根据索引判断，不访问裸数据
+ * @param   idx         [IN]    索引在缓冲区中的地址（idx_size字节）
+ * @param   arg         [IN]    注册时传入的用户参数
+ * @return  返回非0表示接收该记录，返回0表示跳过
+ * @note    持锁调用（迭代器中不持锁），同一条记录可能被调用多次，必须快速且无副作用
+ */
+typedef int (*jringdata_filter_cb)(const void *idx, void *arg);
+
+/**
+ * @brief   零拷贝读取的记录迭代器，由调用者分配，成员由 jringdata_iter_begin 填写
+ */
+typedef struct jringdata_iter {
+    jringdata_t *rd;            // 管理器指针，jringdata_iter_end 后置为NULL
+    int consumer_id;            // 消费者 ID
+    uint32_t idx_start;         // 开始迭代时的索引读位置
+    uint32_t data_start;        // 开始迭代时的数据读位置
+    uint32_t idx_pos;           // 下一条记录的索引位置
+    uint32_t data_pos;          // 下一条记录的数据位置
+    uint32_t idx_end;           // 开始迭代时的索引写位置（不含）
+    jringdata_filter_cb filter; // 消费者的过滤回调，为NULL时不过滤
+    void *filter_arg;           // 过滤回调的用户参数
+} jringdata_iter_t;
+
+/**
+ * @brief   生产者私有的批量暂存区，由调用者分配，成员由 jringdata_stage_init 填写
+ * @note    暂存的记录对消费者不可见，jringdata_flush 时作为一批连续的索引和裸数据一次持锁写入
+ */
+typedef struct jringdata_stage {
+    jringdata_t *rd;            // 管理器指针
+    int producer_id;            // 生产者 ID
+    uint32_t strategy;          // 发布时的写满策略
+    int arg;                    // 写满策略的参数（超时时间或尝试次数）
+    uint32_t max_num;           // 暂存的最大记录数，达到时发布
+    uint32_t max_bytes;         // 暂存的最大裸数据字节数，放不下下一条记录时发布
+    uint64_t max_delay_ns;      // 第一条暂存记录的最长等待时间（纳秒），为0时不按时间发布
+    uint32_t num;               // 当前暂存的记录数
+    uint32_t bytes;             // 当前暂存的裸数据字节数
+    uint64_t first_ns;          // 第一条暂存记录的暂存时间
+    uint8_t *idx;               // 索引暂存区（max_num * idx_size字节）
+    uint8_t *data;              // 裸数据暂存区（max_bytes字节）
+} jringdata_stage_t;
+
 /**
  * @brief   缓冲区初始化参数
  * @note    1. hold_num用于更新min_read_index保留一定size，以便可以新消费者可以消费历史数据
  *          2. 多生产者需要显式 jringdata_add_producer，多消费者需要显式 jringdata_add_consumer，单的无需
+ *          3. spin_num/yield_num是JRINGDATA_BLOCK的等待策略：先自旋spin_num次，再让出CPU yield_num次，
+ *             条件仍不满足时才在futex上睡眠；都为0时立即睡眠
  */
 typedef struct jringdata_cfg {
     uint32_t idx_num;           // 索引缓冲区的索引数量，内部会向上对齐到2的幂
@@ -56,6 +158,10 @@ typedef struct jringdata_cfg {
     uint32_t wake_num;          // 生产者写入后缓冲中的数据大小大于等于此项设置时才唤醒消费者
     enum jringdata_read_mode read_mode; // 多消费者时的读模式（max_consumers==1 时忽略，内部强制为 SHARED）
     uint32_t (*get_size)(const void *idx); // 通过idx获取裸数据大小，不填时直接将idx的前4字节当作uint32_t获取值
+    uint32_t spin_num;          // 阻塞等待时睡眠前的自旋次数（为 0 时不自旋）
+    uint32_t yield_num;         // 阻塞等待时自旋后睡眠前让出CPU的次数（为 0 时不让出）
+    uint32_t flags;             // 特性标志，见 enum jringdata_flag
+    uint64_t max_age_ns;        // 记录的最长存活时间（纳秒），为 0 时不过期；读取和 JRINGDATA_DROP 写入时整批过期更早的记录
 } jringdata_cfg_t;
 
 /**
@@ -63,7 +169,7 @@ typedef struct jringdata_cfg {
  * @param   cfg          [IN]   创建缓冲区的配置参数
  * @return  成功返回管理器指针；失败返回 NULL
  * @note    1. 结构体、缓冲区、消费者数组、生产者数组分配在连续的一块内存中
- *          2. 条件变量总使用单调时钟
+ *          2. 超时等待总使用单调时钟
  */
 jringdata_t* jringdata_init(const jringdata_cfg_t *cfg);
 
@@ -158,6 +264,80 @@ int jringdata_write(jringdata_t *rd, int producer_id, const void *idx, uint32_t
 int jringdata_writev(jringdata_t *rd, int producer_id, const void **idx, uint32_t num,
     const void **data, uint32_t strategy, int arg, uint32_t *pdropped);
 
+/**
+ * @brief   预留一条记录的写空间（零拷贝写入）
+ * @param   rd          [INOUT] 管理器指针
+ * @param   producer_id [IN]    写数据的生产者 ID
+ * @param   data_len    [IN]    预留的裸数据字节数（记录的最大长度，可以为0）
+ * @param   idx         [OUT]   索引槽位地址（idx_size字节）
+ * @param   span1       [OUT]   第一段裸数据内存
+ * @param   span2       [OUT]   第二段裸数据内存（不跨越尾部时len为0）
+ * @return  成功返回 0；失败返回 -1（ID 无效、停止读写、空间不足或已有预留）
+ * @note    1. 调用者直接在索引槽位和裸数据内存中编码记录，再调用 jringdata_write_commit 提交，
+ *             两者之间的数据对消费者不可见
+ *          2. 同一时刻只能有一个预留，已有预留（包括本生产者自己的）时再预留直接失败；
+ *             其它生产者的写入和空间不足一样处理，只有 JRINGDATA_BLOCK/JRINGDATA_RETRY 策略时等待提交，
+ *             所以预留期间不要执行耗时操作；预留者自己的写入直接失败；jringdata_stop 会等待提交
+ *          3. 此接口不阻塞也不丢弃旧数据，需要时可先调用 jringdata_drop_data
+ */
+int jringdata_write_reserve(jringdata_t *rd, int producer_id, uint32_t data_len,
+    void **idx, jringdata_span_t *span1, jringdata_span_t *span2);
+
+/**
+ * @brief   提交预留的记录
+ * @param   rd          [INOUT] 管理器指针
+ * @param   producer_id [IN]    预留空间的生产者 ID
+ * @param   num         [IN]    为 1 时提交记录，为 0 时放弃预留
+ * @return  成功返回 0；没有预留、num大于1或索引中的数据长度超过预留字节数返回 -1（仍保留预留）
+ * @note    记录的实际长度通过索引槽位的长度获取回调得到，只占用预留裸数据的前面部分
+ */
+int jringdata_write_commit(jringdata_t *rd, int producer_id, uint32_t num);
+
+/**
+ * @brief   初始化生产者私有的批量暂存区
+ * @param   sg          [OUT]   暂存区
+ * @param   rd          [IN]    管理器指针
+ * @param   producer_id [IN]    写数据的生产者 ID
+ * @param   max_num     [IN]    暂存的最大记录数
+ * @param   max_bytes   [IN]    暂存的最大裸数据字节数
+ * @param   max_delay_ns[IN]    第一条暂存记录的最长等待时间（纳秒），为0时只按数量和字节数发布
+ * @param   strategy    [IN]    发布时的写满策略，同 jringdata_write
+ * @param   arg         [IN]    策略的参数，含义依赖策略（超时时间或尝试次数）
+ * @return  成功返回 0；参数无效或内存不足返回 -1
+ * @note    1. 多生产者时每个生产者线程使用自己的暂存区，小记录的写入不再每条都竞争锁
+ *          2. max_bytes 应远小于裸数据缓冲区容量，JRINGDATA_COMPLETE 时一批记录需要一次放入
+ */
+int jringdata_stage_init(jringdata_stage_t *sg, jringdata_t *rd, int producer_id, uint32_t max_num,
+    uint32_t max_bytes, uint64_t max_delay_ns, uint32_t strategy, int arg);
+
+/**
+ * @brief   释放暂存区
+ * @param   sg          [INOUT] 暂存区
+ * @return  无返回值
+ * @note    未发布的记录被丢弃，需要时先调用 jringdata_flush
+ */
+void jringdata_stage_uninit(jringdata_stage_t *sg);
+
+/**
+ * @brief   暂存一条记录，达到数量、字节数或时间阈值时发布
+ * @param   sg          [INOUT] 暂存区
+ * @param   idx         [IN]    索引（idx_size字节）
+ * @param   data        [IN]    裸数据，长度通过索引的长度获取回调得到
+ * @return  成功返回 0；记录大于 max_bytes 或暂存区满且发布失败返回 -1
+ * @note    只在本线程内拷贝，不持锁；时间阈值只在暂存时检查，空闲时需要定期调用 jringdata_flush
+ */
+int jringdata_stage(jringdata_stage_t *sg, const void *idx, const void *data);
+
+/**
+ * @brief   发布暂存的记录
+ * @param   sg          [INOUT] 暂存区
+ * @param   force       [IN]    为1时总是发布，为0时只在达到数量、字节数或时间阈值时发布
+ * @return  成功返回发布的记录数（没有发布时为0）；写入失败返回 -1（记录仍保留在暂存区）
+ * @note    所有记录通过一次 jringdata_write 写入；不是 JRINGDATA_COMPLETE 时可能只发布前面一部分，
+ *          剩余的记录移到暂存区开头
+ */
+int jringdata_flush(jringdata_stage_t *sg, int force);
+
 /**
  * @brief   从缓冲区读取数据
  * @param   rd          [INOUT] 管理器指针
@@ -194,6 +374,57 @@ int jringdata_read(jringdata_t *rd, int consumer_id, void *idx, uint32_t num,
 int jringdata_readv(jringdata_t *rd, int consumer_id, void **idx, uint32_t num,
     void **data, uint32_t *len, uint32_t* total_num, uint32_t* total_size, uint32_t strategy, int arg);
 
+/**
+ * @brief   开始原地迭代消费者的未读记录（零拷贝读取）
+ * @param   rd          [INOUT] 管理器指针
+ * @param   consumer_id [IN]    消费者 ID（由 add_consumer 返回；单消费者时固定传 0）
+ * @param   it          [OUT]   迭代器
+ * @return  成功返回可迭代的记录数（有过滤回调时是包含被跳过记录的上限）；失败返回 -1（ID 无效、停止读写或没有数据）
+ * @note    1. 只迭代开始时已写入的记录，之后写入的记录留给下次迭代
+ *          2. 迭代期间记录不会被丢弃，写入的丢弃策略会等待迭代结束；jringdata_stop 也会等待结束，
+ *             所以迭代期间不要执行耗时操作，结束前同一消费者也不能调用读接口或再次开始迭代
+ *          3. JRINGDATA_READ_SHARED 模式同一时刻只能有一个迭代器，其它消费者的读取会等待结束；
+ *             JRINGDATA_READ_EXCLUSIVE 模式各消费者独立迭代，互不影响
+ */
+int jringdata_iter_begin(jringdata_t *rd, int consumer_id, jringdata_iter_t *it);
+
+/**
+ * @brief   获取迭代器的下一条记录
+ * @param   it          [INOUT] 迭代器
+ * @param   idx         [OUT]   索引在缓冲区中的地址（idx_size字节）
+ * @param   span1       [OUT]   第一段裸数据内存
+ * @param   span2       [OUT]   第二段裸数据内存（不跨越尾部时len为0）
+ * @return  成功返回 0；没有更多记录返回 -1
+ * @note    1. 不持锁，返回的内存在 jringdata_iter_end 前有效，只能读不能写
+ *          2. 消费者有过滤回调时自动跳过不匹配的记录，jringdata_iter_end 时一起释放
+ */
+int jringdata_iter_next(jringdata_iter_t *it, void **idx, jringdata_span_t *span1, jringdata_span_t *span2);
+
+/**
+ * @brief   结束迭代并一次释放所有已迭代的记录
+ * @param   it          [INOUT] 迭代器
+ * @return  成功返回 0；迭代器无效或独占模式下读位置已被改变返回 -1
+ * @note    只释放 jringdata_iter_next 已返回的记录，未取出的记录下次仍可读取
+ */
+int jringdata_iter_end(jringdata_iter_t *it);
+
+/**
+ * @brief   把未读记录直接写出到文件描述符（零拷贝转发）
+ * @param   rd          [INOUT] 管理器指针
+ * @param   consumer_id [IN]    消费者 ID（由 add_consumer 返回；单消费者时固定传 0）
+ * @param   fd          [IN]    文件、管道或套接字描述符
+ * @param   max_records [IN]    最多写出的记录数，为 0 时不限制（一次最多构造256个iovec）
+ * @param   flags       [IN]    jringdata_fd_flag 标志
+ * @return  成功返回消费的记录数；没有数据、写出失败（errno为写出的错误码）或其它失败返回 -1
+ * @note    1. 内部通过迭代器直接以缓冲区中的索引和裸数据构造 iovec，一次 writev 写出，只消费内核
+ *             完整接受的记录，内核只接受了某条记录的一部分时会补写该记录的剩余部分
+ *          2. 和 jringdata_iter_begin 有相同的限制，阻塞的描述符会使其它消费者和丢弃等待
+ *          3. 消费者有过滤回调时只写出匹配的记录，全部不匹配时越过这些记录并返回 0
+ *          4. 非阻塞描述符补写时最多等待可写 JRINGDATA_FD_WAIT_MS 毫秒，超时后已写出一部分的记录也算作消费
+ *             （接收端只收到半条记录），JRINGDATA_FD_ALL 时未写出的完整记录留待下次
+ */
+int jringdata_read_to_fd(jringdata_t *rd, int consumer_id, int fd, uint32_t max_records, uint32_t flags);
+
 /**
  * @brief   添加一个生产者（多生产者有效）
  * @param   rd          [INOUT] 管理器指针
@@ -220,6 +451,20 @@ int jringdata_del_producer(jringdata_t *rd, int producer_id);
  */
 int jringdata_add_consumer(jringdata_t *rd, int use_ridx);
 
+/**
+ * @brief   添加一个带记录过滤的消费者（JRINGDATA_READ_EXCLUSIVE 多消费者有效）
+ * @param   rd          [INOUT] 管理器指针
+ * @param   use_ridx    [IN]    初始index是使用min_read_index(1)还是write_index(0)
+ * @param   filter      [IN]    过滤回调，为NULL时等同于 jringdata_add_consumer
+ * @param   arg         [IN]    过滤回调的用户参数
+ * @return  成功返回分配的消费者 ID；无可分配槽位、非独立读模式或内存不足返回 -1
+ * @note    1. 读取、迭代和 jringdata_read_to_fd 只在索引环上调用过滤回调，不匹配的记录直接跳过，
+ *             不访问也不拷贝其裸数据；读取返回的记录数和字节数只包含匹配的记录
+ *          2. 按掩码过滤索引中的主题等字段时在回调中比较即可
+ *          3. jringdata_size 等容量接口仍统计包含不匹配记录的总量
+ */
+int jringdata_add_consumer_filter(jringdata_t *rd, int use_ridx, jringdata_filter_cb filter, void *arg);
+
 /**
  * @brief   移除一个消费者（多消费者有效）
  * @param   rd          [INOUT] 管理器指针
@@ -240,6 +485,86 @@ int jringdata_del_consumer(jringdata_t *rd, int consumer_id);
  */
 int jringdata_drop_data(jringdata_t *rd, int consumer_id, uint32_t dropped);
 
+/**
+ * @brief   获取记录序号范围
+ * @param   rd          [INOUT] 管理器指针
+ * @param   oldest      [OUT]   缓冲区中保留的最早记录的序号（可以为NULL）
+ * @param   next        [OUT]   下一条写入记录的序号，即已写入的记录总数（可以为NULL）
+ * @return  成功返回 0；失败返回 -1
+ * @note    每条写入的记录按顺序分配一个64位序号，从0开始，不会回绕；oldest等于next时缓冲区为空
+ */
+int jringdata_seq_range(jringdata_t *rd, uint64_t *oldest, uint64_t *next);
+
+/**
+ * @brief   获取消费者下一条未读记录的序号
+ * @param   rd          [INOUT] 管理器指针
+ * @param   consumer_id [IN]    消费者 ID（单消费者时固定传 0）
+ * @param   seq         [OUT]   下一次读取的第一条记录的序号
+ * @return  成功返回 0；ID 无效返回 -1
+ * @note    共享读模式下所有消费者的读位置相同
+ */
+int jringdata_tell(jringdata_t *rd, int consumer_id, uint64_t *seq);
+
+/**
+ * @brief   把消费者的读位置移动到指定序号的记录（需要 JRINGDATA_SEQ）
+ * @param   rd          [INOUT] 管理器指针
+ * @param   consumer_id [IN]    消费者 ID（单消费者时固定传 0）
+ * @param   seq         [IN]    下一次读取的第一条记录的序号
+ * @return  成功返回 0；未开启 JRINGDATA_SEQ、ID 无效、记录已被覆盖或释放、序号大于下一条写入的序号返回 -1
+ * @note    1. 由序号直接计算索引位置和数据位置，不需要读取和丢弃中间的记录
+ *          2. JRINGDATA_READ_EXCLUSIVE 模式可以向前或向后定位到任意保留的记录（配合hold_num，
+ *             断线重连的消费者可以从 "某序号之后" 继续读取）；共享读模式下已读的记录已释放，只能向后跳过
+ *          3. 同一消费者迭代期间不要定位，否则 jringdata_iter_end 返回失败
+ */
+int jringdata_seek(jringdata_t *rd, int consumer_id, uint64_t seq);
+
+/**
+ * @brief   获取消费者下一条未读记录的写入时间（需要 JRINGDATA_TIME 或 max_age_ns）
+ * @param   rd          [INOUT] 管理器指针
+ * @param   consumer_id [IN]    消费者 ID（单消费者时固定传 0）
+ * @param   ns          [OUT]   写入时的 jtime_mononsec_get() 值
+ * @return  成功返回 0；未开启、ID 无效或没有未读记录返回 -1
+ * @note    jtime_mononsec_get() - ns 即该记录的排队时间
+ */
+int jringdata_front_time(jringdata_t *rd, int consumer_id, uint64_t *ns);
+
+/**
+ * @brief   获取迭代器最近一次 jringdata_iter_next 返回的记录的写入时间
+ * @param   it          [IN]    迭代器
+ * @return  成功返回写入时的 jtime_mononsec_get() 值；未开启或还没有返回记录时返回 0
+ * @note    无
+ */
+uint64_t jringdata_iter_time(const jringdata_iter_t *it);
+
+/**
+ * @brief   获取消费者的数据就绪描述符，可以和套接字、定时器一起用 poll/epoll 等待
+ * @param   rd          [IN]    管理器指针
+ * @param   consumer_id [IN]    消费者 ID（单消费者时固定传 0）
+ * @return  成功返回描述符；失败返回 -1
+ * @note    1. 首次调用时创建描述符，jringdata_uninit时关闭，调用者不要读写或关闭描述符
+ *          2. 消费者未读索引个数大于等于 wake_num(为0时按1处理)时描述符可读，读取后不足时自动变为不可读，
+ *             等待者收到可读事件后使用非阻塞方式(JRINGDATA_BLOCK之外的策略)读取
+ *          3. 共享读模式下所有消费者返回同一个描述符；停止读写后描述符一直可读
+ *          4. 只支持linux
+ */
+int jringdata_get_event_fd(jringdata_t *rd, int consumer_id);
+
+/**
+ * @brief   获取生产者的空间就绪描述符，可以和套接字、定时器一起用 poll/epoll 等待
+ * @param   rd          [IN]    管理器指针
+ * @return  成功返回描述符；失败返回 -1
+ * @note    空闲索引个数大于等于 wake_num(为0时按1处理)且裸数据缓冲区未满时描述符可读，其它同 jringdata_get_event_fd
+ */
+int jringdata_get_space_fd(jringdata_t *rd);
+
+/**
+ * @brief   获取统计信息（JRINGDATA_STATS）
+ * @param   rd          [IN]    管理器指针
+ * @param   stats       [OUT]   所有生产者和消费者的计数之和
+ * @return  成功返回 0；未开启统计返回 -1
+ */
+int jringdata_stats_get(jringdata_t *rd, jringdata_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -764,6 +764,56 @@ ssize_t jsocket_send(jsocket_fd_t sfd, const void *buf, ssize_t blen)
     return jsocket_send_(sfd, buf, blen, 1);
 }
 
+ssize_t jsocket_sendv_(jsocket_fd_t sfd, const jfs_iovec_t *iov, int cnt, int print_flag)
+{
+    ssize_t size = 0, blen = 0;
+    int i = 0;
+#ifdef _WIN32
+    WSABUF bufs[JSOCKET_IOV_MAX];
+    DWORD sent = 0;
+
+    if (cnt > JSOCKET_IOV_MAX)
+        cnt = JSOCKET_IOV_MAX;
+    for (i = 0; i < cnt; ++i) {
+        bufs[i].buf = (CHAR *)iov[i].iov_base;
+        bufs[i].len = (ULONG)iov[i].iov_len;
+        blen += (ssize_t)iov[i].iov_len;
+    }
+    size = WSASend(sfd, bufs, (DWORD)cnt, &sent, 0, NULL, NULL) == 0 ? (ssize_t)sent : -1;
+#else
+    struct msghdr msg;
+    int flag = 0; // Linux支持MSG_NOSIGNAL，作用是对端已经关闭再写，不产生SIGPIPE信号
+
+    if (cnt > JSOCKET_IOV_MAX)
+        cnt = JSOCKET_IOV_MAX;
+    for (i = 0; i < cnt; ++i)
+        blen += (ssize_t)iov[i].iov_len;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = (struct iovec *)iov;
+    msg.msg_iovlen = cnt;
+    size = sendmsg(sfd, &msg, flag);
+#endif
+    if (size != blen) {
+#ifdef _WIN32
+        int wsaerr = WSAGetLastError();
+        if (size < 0 && (wsaerr == WSAEWOULDBLOCK || wsaerr == WSAEINTR || wsaerr == WSAETIMEDOUT))
+            return 0;
+#else
+        if (size < 0 && (errno == EAGAIN || errno == EINTR || errno == ETIMEDOUT))
+            return 0;
+#endif
+        if (print_flag)
+            JSOCKET_ERRNO("%ld!=%ld, sendv(%d) failed!", (long)blen, (long)size, sfd);
+    }
+
+    return size;
+}
+
+ssize_t jsocket_sendv(jsocket_fd_t sfd, const jfs_iovec_t *iov, int cnt)
+{
+    return jsocket_sendv_(sfd, iov, cnt, 1);
+}
+
 ssize_t jsocket_recv(jsocket_fd_t sfd, void *buf, size_t blen)
 {
     ssize_t size = 0;
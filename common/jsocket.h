@@ -20,6 +20,7 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #endif
+#include "jfs.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,6 +31,7 @@ extern "C" {
 #define JSOCKET_IPV4_LEN                16
 #define JSOCKET_IPV6_LEN                46
 #define JSOCKET_IP_LEN                  46
+#define JSOCKET_IOV_MAX                 64      // jsocket_sendv一次最多发送的内存段个数
 #define AF_INETAUTO                     0
 
 /**
@@ -361,6 +363,16 @@ ssize_t jsocket_recvfrom(jsocket_fd_t sfd, void *buf, size_t blen, jsocket_saddr
  */
 ssize_t jsocket_send(jsocket_fd_t sfd, const void *buf, ssize_t blen);
 
+/**
+ * @brief   分散发送数据
+ * @param   sfd [IN] socket描述符
+ * @param   iov [IN] 要发送的内存段数组
+ * @param   cnt [IN] 内存段个数，超过JSOCKET_IOV_MAX时只发送前JSOCKET_IOV_MAX段
+ * @return  成功返回发送的数据长度; 失败返回-1
+ * @note    一次系统调用发送多段内存(sendmsg/WSASend)，非阻塞socket发送缓冲满时返回0或部分长度
+ */
+ssize_t jsocket_sendv(jsocket_fd_t sfd, const jfs_iovec_t *iov, int cnt);
+
 /**
  * @brief   接收数据
  * @param   sfd [IN] socket描述符
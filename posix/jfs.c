@@ -6,10 +6,14 @@
 *******************************************/
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
 #include <dirent.h>
+#include <sys/mman.h>
 #include "jlog.h"
 #include "jfs.h"
 #include "jheap.h"
+#include "jtime.h"
 
 #define JFS_PATH_MAX        4096
 
@@ -45,7 +49,7 @@ int jfs_countdir(const char *dname, jfs_filter_cb filter)
             char path[JFS_PATH_MAX];
 
             memcpy(path, dname, dlen);
-            if (path[dlen] != '/')
+            if (!dlen || path[dlen - 1] != '/')
                 path[dlen++] = '/';
 
             while ((d = readdir(dir))) {
@@ -134,7 +138,7 @@ int jfs_listdir_(const char *dname, jfs_dirent_t **dirs, int *num, jfs_filter_cb
         char path[JFS_PATH_MAX];
 
         memcpy(path, dname, dlen);
-        if (path[dlen] != '/')
+        if (!dlen || path[dlen - 1] != '/')
             path[dlen++] = '/';
 
         if (!filter)
@@ -335,7 +339,7 @@ int jfs_rmdir(const char *dname)
         char path[JFS_PATH_MAX];
 
         memcpy(path, dname, dlen);
-        if (path[dlen] != '/')
+        if (!dlen || path[dlen - 1] != '/')
             path[dlen++] = '/';
         path[dlen] = '\0';
         ret = jfs_rmdir_exec(path, dlen);
@@ -343,3 +347,190 @@ int jfs_rmdir(const char *dname)
 
     return ret;
 }
+
+static void *jfs_fd_map(int fd, const char *name, size_t *size, int create)
+{
+    void *addr = NULL;
+
+    if (create) {
+        if (ftruncate(fd, (off_t)*size) < 0) {
+            JFS_ERRNO("ftruncate(%s) failed!", name);
+            return NULL;
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+            JFS_ERRNO("fstat(%s) failed!", name);
+            return NULL;
+        }
+        *size = (size_t)st.st_size;
+    }
+
+    addr = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        JFS_ERRNO("mmap(%s) failed!", name);
+        return NULL;
+    }
+    return addr;
+}
+
+void *jfs_shm_map(const char *name, size_t *size, int create)
+{
+    void *addr = NULL;
+    int fd = -1;
+
+    fd = shm_open(name, create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, 0666);
+    if (fd < 0) {
+        JFS_ERRNO("shm_open(%s) failed!", name);
+        return NULL;
+    }
+
+    addr = jfs_fd_map(fd, name, size, create);
+    close(fd);
+    if (!addr && create)
+        shm_unlink(name);
+    return addr;
+}
+
+int jfs_shm_unmap(void *addr, size_t size)
+{
+    return munmap(addr, size);
+}
+
+int jfs_shm_unlink(const char *name)
+{
+    return shm_unlink(name);
+}
+
+void *jfs_file_map(const char *fname, size_t *size, int create)
+{
+    void *addr = NULL;
+    int fd = -1;
+
+    fd = open(fname, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+    if (fd < 0) {
+        JFS_ERRNO("open(%s) failed!", fname);
+        return NULL;
+    }
+
+    addr = jfs_fd_map(fd, fname, size, create);
+    close(fd);
+    return addr;
+}
+
+int jfs_file_sync(void *addr, size_t size)
+{
+    return msync(addr, size, MS_SYNC);
+}
+
+int jfs_fallocate(jfs_fd_t fd, size_t size)
+{
+    /* 先分配磁盘块，之后写入映射内存时不会因为磁盘满触发SIGBUS */
+    if (fallocate(fd, 0, 0, (off_t)size) == 0)
+        return 0;
+    return ftruncate(fd, (off_t)size);
+}
+
+void *jfs_fdmap(jfs_fd_t fd, size_t size)
+{
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return addr == MAP_FAILED ? NULL : addr;
+}
+
+int jfs_file_flush(void *addr, size_t size)
+{
+    return msync(addr, size, MS_ASYNC);
+}
+
+size_t jfs_mirror_granularity(void)
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+void *jfs_mirror_map(size_t size)
+{
+    char *addr = NULL;
+    int fd = -1;
+
+    if (size == 0 || size % jfs_mirror_granularity())
+        return NULL;
+
+    fd = memfd_create("jfs_mirror", MFD_CLOEXEC);
+    if (fd < 0) {
+        JFS_ERRNO("memfd_create failed!");
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)size) < 0) {
+        JFS_ERRNO("ftruncate failed!");
+        goto err;
+    }
+
+    /* 先保留两倍大小的连续地址空间，再把同一个文件固定映射到前后两半 */
+    addr = (char *)mmap(NULL, size << 1, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        JFS_ERRNO("mmap reserve failed!");
+        goto err;
+    }
+    if (mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+            || mmap(addr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        JFS_ERRNO("mmap mirror failed!");
+        munmap(addr, size << 1);
+        goto err;
+    }
+
+    close(fd);
+    return addr;
+err:
+    close(fd);
+    return NULL;
+}
+
+int jfs_mirror_unmap(void *addr, size_t size)
+{
+    return munmap(addr, size << 1);
+}
+
+int jfs_writev_full(jfs_fd_t fd, jfs_iovec_t *iov, int cnt, size_t skip, int timeout_ms)
+{
+    struct pollfd pfd;
+    uint64_t end = timeout_ms > 0 ? jtime_monomsec_get() + (uint64_t)timeout_ms : 0;
+    uint64_t now = 0;
+    int wait = timeout_ms;
+    ssize_t n;
+
+    while (1) {
+        /* 跳过已经写出的内存段 */
+        while (cnt > 0 && skip >= iov->iov_len) {
+            skip -= iov->iov_len;
+            ++iov;
+            --cnt;
+        }
+        if (cnt <= 0)
+            return 0;
+        iov->iov_base = (char *)iov->iov_base + skip;
+        iov->iov_len -= skip;
+
+        n = writev(fd, iov, cnt > JFS_IOV_MAX ? JFS_IOV_MAX : cnt);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                /* 按剩余时间等待可写，超时返回失败 */
+                if (timeout_ms > 0) {
+                    now = jtime_monomsec_get();
+                    wait = now < end ? (int)(end - now) : 0;
+                }
+                if (!wait) {
+                    errno = ETIMEDOUT;
+                    return -1;
+                }
+                pfd.fd = fd;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+                poll(&pfd, 1, wait);
+            } else if (errno != EINTR) {
+                return -1;
+            }
+            n = 0;
+        }
+        skip = (size_t)n;
+    }
+}
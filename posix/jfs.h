@@ -6,11 +6,13 @@
 *******************************************/
 #pragma once
 #include <stdio.h>
+#include <limits.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,6 +41,11 @@ static inline void jfs_sp_adapted(char *buf)
  */
 #define JFS_WROUT(buf, count)           write(STDOUT_FILENO, buf, count);
 
+/**
+ * @brief   分散写入到标准输出
+ */
+#define JFS_WROUTV(iov, cnt)            writev(STDOUT_FILENO, iov, cnt)
+
 /**
  * @brief   写入到标准错误
  */
@@ -63,7 +70,7 @@ typedef int jfs_fd_t;
 /**
  * @brief   打开文件
  * @param   fname [IN] 要打开的文件名
- * @param   mode [IN] 打开的模式，只有"r" "w" "a" "r+" "w+" "a+"六种类型
+ * @param   mode [IN] 打开的模式，只有"r" "w" "a" "r+" "w+" "a+"六种类型，"w" "a"后面可加'x'(例如"w+x")表示文件已存在时失败
  * @return  成功返回文件描述符; 失败返回JFS_INVALID_FD
  * @note    无
  */
@@ -88,6 +95,8 @@ static inline jfs_fd_t jfs_open(const char *fname, const char *mode)
         oflag = O_RDONLY;
         break;
     }
+    if (omode && mode[1] && (mode[1] == 'x' || mode[2] == 'x'))
+        oflag |= O_EXCL;
 
     return omode ? open(fname, oflag, omode) : open(fname, oflag);
 }
@@ -102,6 +111,21 @@ static inline jfs_fd_t jfs_open(const char *fname, const char *mode)
  */
 #define jfs_write(fd, buffer, count)    write(fd, buffer, count)
 
+/**
+ * @brief   分散写的内存段（成员为 iov_base 和 iov_len）及一次最多的内存段个数
+ */
+typedef struct iovec jfs_iovec_t;
+#ifdef IOV_MAX
+#define JFS_IOV_MAX                     IOV_MAX
+#else
+#define JFS_IOV_MAX                     1024
+#endif
+
+/**
+ * @brief   分散写文件，一次系统调用写出多段内存
+ */
+#define jfs_writev(fd, iov, cnt)        writev(fd, iov, cnt)
+
 /**
  * @brief   修改文件偏移
  */
@@ -115,7 +139,7 @@ static inline jfs_fd_t jfs_open(const char *fname, const char *mode)
 /**
  * @brief   截断文件
  */
-#define jfs_ftruncate(fd, length)       fftruncate(fd, length)
+#define jfs_ftruncate(fd, length)       ftruncate(fd, length)
 
 /**
  * @brief   删除文件
@@ -287,6 +311,117 @@ int jfs_mkdir(const char *dname);
  */
 int jfs_rmdir(const char *dname);
 
+/**
+ * @brief   创建或打开命名共享内存并映射到本进程
+ * @param   name [IN] 共享内存名称，posix要求以'/'开头且不含其它'/'
+ * @param   size [INOUT] 创建时为共享内存大小；打开时返回共享内存大小
+ * @param   create [IN] 1: 创建(已存在时失败); 0: 打开已存在的共享内存
+ * @return  成功返回映射地址; 失败返回NULL
+ * @note    映射可读写且进程间共享，使用jfs_shm_unmap解除映射
+ */
+void *jfs_shm_map(const char *name, size_t *size, int create);
+
+/**
+ * @brief   解除共享内存映射
+ * @param   addr [IN] jfs_shm_map返回的映射地址
+ * @param   size [IN] 映射大小
+ * @return  成功返回0; 失败返回-1
+ * @note    无
+ */
+int jfs_shm_unmap(void *addr, size_t size);
+
+/**
+ * @brief   删除命名共享内存
+ * @param   name [IN] 共享内存名称
+ * @return  成功返回0; 失败返回-1
+ * @note    已映射的进程仍可继续使用，所有映射解除后才真正释放；windows在最后一个映射解除时自动释放
+ */
+int jfs_shm_unlink(const char *name);
+
+/**
+ * @brief   创建或打开普通文件并整体映射到本进程
+ * @param   fname [IN] 文件名
+ * @param   size [INOUT] 创建时为文件大小；打开时返回文件大小
+ * @param   create [IN] 1: 创建(已存在时清空后重新设置大小); 0: 打开已存在的文件
+ * @return  成功返回映射地址; 失败返回NULL
+ * @note    1. 映射可读写且进程间共享(MAP_SHARED)，写入映射内存即写入文件的页缓存，进程崩溃后数据仍在文件中
+ *          2. 使用jfs_shm_unmap解除映射，需要在系统崩溃前落盘时调用jfs_file_sync
+ */
+void *jfs_file_map(const char *fname, size_t *size, int create);
+
+/**
+ * @brief   将文件映射的修改同步写入磁盘
+ * @param   addr [IN] jfs_file_map返回的映射地址
+ * @param   size [IN] 映射大小
+ * @return  成功返回0; 失败返回-1
+ * @note    会阻塞到写盘完成，不要在热路径调用
+ */
+int jfs_file_sync(void *addr, size_t size);
+
+/**
+ * @brief   为已打开的文件预分配空间
+ * @param   fd [IN] 文件描述符
+ * @param   size [IN] 预分配后的文件大小
+ * @return  成功返回0; 失败返回-1
+ * @note    文件大小会扩展到size，文件系统不支持预分配时只设置文件大小
+ */
+int jfs_fallocate(jfs_fd_t fd, size_t size);
+
+/**
+ * @brief   将已打开文件的开头部分映射到本进程
+ * @param   fd [IN] 文件描述符，需要以读写模式打开
+ * @param   size [IN] 映射大小，不能超过文件大小
+ * @return  成功返回映射地址; 失败返回NULL
+ * @note    1. 映射可读写且进程间共享，关闭文件描述符后映射仍然有效，使用jfs_shm_unmap解除映射
+ *          2. 失败时不打印日志，可以在日志输出线程中使用
+ */
+void *jfs_fdmap(jfs_fd_t fd, size_t size);
+
+/**
+ * @brief   发起文件映射的修改写回磁盘
+ * @param   addr [IN] 映射地址，posix要求页对齐
+ * @param   size [IN] 要写回的大小
+ * @return  成功返回0; 失败返回-1
+ * @note    不等待写盘完成，可以周期调用；需要确保落盘时调用jfs_file_sync
+ */
+int jfs_file_flush(void *addr, size_t size);
+
+/**
+ * @brief   获取镜像映射的大小粒度
+ * @return  返回字节数，posix为页大小，windows为内存分配粒度
+ * @note    jfs_mirror_map的size必须是它的整数倍
+ */
+size_t jfs_mirror_granularity(void);
+
+/**
+ * @brief   创建镜像映射：同一块size大小的物理内存连续映射两次
+ * @param   size [IN] 内存大小，必须是jfs_mirror_granularity()的整数倍
+ * @return  成功返回映射地址addr，[addr, addr+size)和[addr+size, addr+2*size)访问同一块内存; 失败返回NULL
+ * @note    环形缓冲区使用镜像映射后，任意不超过size的区域在虚拟地址上都是连续的，回绕时无需分段拷贝
+ */
+void *jfs_mirror_map(size_t size);
+
+/**
+ * @brief   解除镜像映射
+ * @param   addr [IN] jfs_mirror_map返回的映射地址
+ * @param   size [IN] jfs_mirror_map时的内存大小
+ * @return  成功返回0; 失败返回-1
+ * @note    无
+ */
+int jfs_mirror_unmap(void *addr, size_t size);
+
+/**
+ * @brief   分散写文件直到全部写完
+ * @param   fd [IN] 文件描述符
+ * @param   iov [INOUT] 内存段数组，函数内部会修改成员
+ * @param   cnt [IN] 内存段个数
+ * @param   skip [IN] 开头已经写出的字节数
+ * @param   timeout_ms [IN] 非阻塞描述符暂时不可写时总共最多等待的毫秒数，为0时不等待，小于0时一直等待
+ * @return  成功返回0; 失败返回-1，等待超时时errno为ETIMEDOUT
+ * @note    被信号中断时重试，非阻塞描述符暂时不可写时poll等待；阻塞描述符在内核中等待，不受timeout_ms限制
+ */
+int jfs_writev_full(jfs_fd_t fd, jfs_iovec_t *iov, int cnt, size_t skip, int timeout_ms);
+
 #ifdef __cplusplus
 }
 #endif
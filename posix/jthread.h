@@ -8,7 +8,15 @@
 #include <stddef.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <errno.h>
 #include "jtime.h"
+#ifdef __linux__
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/futex.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,6 +33,24 @@ extern "C" {
 #define jthread_mutex_lock(mutex)       pthread_mutex_lock(mutex)
 #define jthread_mutex_unlock(mutex)     pthread_mutex_unlock(mutex)
 
+/**
+ * @brief   进程间共享的健壮互斥锁
+ * @note    1. 互斥锁必须位于多个进程都映射的共享内存中，使用jthread_mutex_destroy销毁
+ *          2. 持锁进程异常退出后，其它进程jthread_mutex_lock返回EOWNERDEAD(已获得锁)，
+ *             需要调用jthread_mutex_consistent标记锁已恢复一致，否则解锁后锁将不可用
+ */
+static inline int jthread_mutex_init_pshared(jthread_mutex_t *mutex)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    int ret = pthread_mutex_init(mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return ret;
+}
+#define jthread_mutex_consistent(mutex) pthread_mutex_consistent(mutex)
+
 /**
  * @brief   超时互斥锁
  * @note    1. mutex都为jthread_tmutex_t的指针
@@ -140,6 +166,102 @@ static inline int jthread_sem_mtimewait(jthread_sem_t *sem, uint32_t msec)
     return jthread_sem_timedwait(sem, &jnt);
 }
 
+/**
+ * @brief   地址等待/唤醒(futex)
+ * @note    1. addr都为uint32_t的指针，用于实现“先自旋再睡眠”的轻量等待
+ *          2. jthread_futex_wait在*addr等于val时睡眠，直到被唤醒、超时(msec为-1时永不超时)或虚假唤醒；
+ *             *addr不等于val时立即返回；超时返回ETIMEDOUT，其它情况返回0，调用者需要重新检查条件
+ *          3. jthread_futex_wake唤醒在addr上等待的线程，all为0时最多唤醒一个，否则唤醒所有
+ *          4. pshared为1时addr位于进程间共享内存中，等待和唤醒可以跨进程
+ *          5. 非linux系统没有futex，退化为短暂睡眠后返回
+ */
+static inline int jthread_futex_wait(uint32_t *addr, uint32_t val, int msec, int pshared)
+{
+#ifdef __linux__
+    struct timespec ts, *pts = NULL;
+    if (msec >= 0) {
+        ts.tv_sec = msec / 1000;
+        ts.tv_nsec = (long)(msec % 1000) * 1000000;
+        pts = &ts;
+    }
+    if (syscall(SYS_futex, addr, pshared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, val, pts, NULL, 0) < 0 && errno == ETIMEDOUT)
+        return ETIMEDOUT;
+    return 0;
+#else
+    (void)pshared;
+    if (*(volatile uint32_t *)addr != val)
+        return 0;
+    if (msec == 0)
+        return ETIMEDOUT;
+    jtime_usleep(100);
+    return 0;
+#endif
+}
+static inline int jthread_futex_wake(uint32_t *addr, int all, int pshared)
+{
+#ifdef __linux__
+    return (int)syscall(SYS_futex, addr, pshared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0);
+#else
+    (void)addr; (void)all; (void)pshared;
+    return 0;
+#endif
+}
+
+/**
+ * @brief   事件描述符(eventfd)
+ * @note    1. 事件描述符可以和套接字、定时器一起放在 poll/epoll 中等待，置位后可读，清除后不可读
+ *          2. jthread_evfd_create创建非阻塞的事件描述符，失败返回-1
+ *          3. jthread_evfd_set置位，jthread_evfd_clear清除，成功返回0；失败返回-1
+ *          4. 非linux系统不支持，jthread_evfd_create固定返回-1
+ */
+static inline int jthread_evfd_create(void)
+{
+#ifdef __linux__
+    return eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    return -1;
+#endif
+}
+static inline int jthread_evfd_set(int fd)
+{
+#ifdef __linux__
+    uint64_t val = 1;
+    return write(fd, &val, sizeof(val)) < 0 ? -1 : 0;
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+static inline int jthread_evfd_clear(int fd)
+{
+#ifdef __linux__
+    uint64_t val = 0;
+    return (read(fd, &val, sizeof(val)) < 0 && errno != EAGAIN) ? -1 : 0;
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+static inline void jthread_evfd_close(int fd)
+{
+#ifdef __linux__
+    close(fd);
+#else
+    (void)fd;
+#endif
+}
+
+/**
+ * @brief   线程局部数据的键
+ * @note    1. jthread_key_create 的 destructor 在线程退出时以本线程设置的值(非NULL时)调用，可以为NULL
+ *          2. 成功返回0; 失败返回非0
+ */
+#define jthread_key_t                   pthread_key_t
+#define jthread_key_create(key, destructor) pthread_key_create(key, destructor)
+#define jthread_key_delete(key)         pthread_key_delete(key)
+#define jthread_key_set(key, value)     pthread_setspecific(key, value)
+#define jthread_key_get(key)            pthread_getspecific(key)
+
 /**
  * @brief   线程属性
  */
@@ -0,0 +1,318 @@
+#!/bin/sh
+############################################
+# SPDX-License-Identifier: MIT             #
+# Copyright (C) 2026-.... Jing Leng        #
+# Contact: Jing Leng <lengjingzju@163.com> #
+# https://github.com/lengjingzju/jcore     #
+############################################
+
+name=$1             # 生成的头文件或源文件名称、管理结构类型名、函数名前缀
+T=$2                # 元素类型名
+capacity=$3         # 编译期固定容量（元素个数，必须是2的幂），不设置时运行时指定容量
+header=$4           # 定义元素类型的头文件
+NAME=$(echo "${name}" | tr 'a-z' 'A-Z') # 大写的名称
+
+if [ -z "${name}" ] || [ -z "${T}" ] || [ "${name}" = "-h" ]; then
+    echo "Usage: $0 <name> <T> <capacity> <header>"
+    echo "       name:      生成的头文件或源文件名称、管理结构类型名、函数名前缀"
+    echo "       T:         元素类型名"
+    echo "       capacity:  可选，编译期固定容量（元素个数，必须是2的幂），缓冲区内嵌在管理结构中，"
+    echo "                  环内位置用常量掩码计算；为空时由 ${name}_init 指定容量并动态分配缓冲区"
+    echo "       header:    可选，定义元素类型的头文件，生成的头文件会包含它；T为基本类型时不需要"
+    exit 1
+fi
+
+if [ -n "${capacity}" ]; then
+    case "${capacity}" in
+        *[!0-9]*) capacity=0;;
+    esac
+    if [ "${capacity}" -lt 2 ] || [ $((capacity & (capacity - 1))) -ne 0 ]; then
+        echo "ERROR: capacity($3) must be a power of 2 and >= 2"
+        exit 1
+    fi
+    cap_def="#define ${NAME}_CAPACITY    ${capacity}u  // 编译期固定容量（元素个数）"
+    head_member="    /* 容量为 ${NAME}_CAPACITY，缓冲区内嵌在结构末尾 */"
+    tail_member="    ${T} buf[${NAME}_CAPACITY];     // 数据缓冲区"
+    mask_expr="(${NAME}_CAPACITY - 1)"
+    cap_expr="${NAME}_CAPACITY"
+    init_note="固定容量，capacity被忽略，管理结构可以是静态变量"
+else
+    cap_def="/* 运行时容量，由 ${name}_init 指定 */"
+    head_member="    ${T} *buf;                          // 数据缓冲区
+    uint32_t capacity;                  // 缓冲区元素个数（2的幂）"
+    tail_member="    /* 缓冲区动态分配 */"
+    mask_expr="(rb->capacity - 1)"
+    cap_expr="rb->capacity"
+    init_note="capacity向上对齐到2的幂"
+fi
+
+type_inc=""
+if [ -n "${header}" ]; then
+    type_inc="#include \"${header}\""
+fi
+
+echo "${name}.h and ${name}.c have been generated."
+
+##############
+# 生成头文件 #
+##############
+
+cat <<EOF> ${name}.h
+/*******************************************
+* SPDX-License-Identifier: MIT             *
+* Copyright (C) 2026-.... Jing Leng        *
+* Contact: Jing Leng <lengjingzju@163.com> *
+* https://github.com/lengjingzju/jcore     *
+*******************************************/
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "joptimize.h"
+${type_inc}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+${cap_def}
+#define ${NAME}_CACHELINE   64u     // 缓存行大小（字节），用于隔离生产者和消费者的热数据
+
+/**
+ * @brief   单生产者单消费者类型化环形缓冲区管理结构
+ * @note    1. 元素按 ${T} 类型整体赋值，编译器按元素大小内联拷贝，不调用 memcpy
+ *          2. 写位置只由生产者修改，读位置只由消费者修改，通过 acquire/release 发布，无锁；
+ *             双方各自缓存对端的位置，空间或数据不足时才读取对端的缓存行
+ *          3. 只能一个生产者线程和一个消费者线程并发使用，多生产者或多消费者使用 jringbuf
+ */
+struct ${name} {
+${head_member}
+    uint8_t pad0[${NAME}_CACHELINE];
+    uint32_t write_index;               // 绝对写位置（元素个数），单调递增，利用自然溢出
+    uint32_t cached_read_index;         // 生产者缓存的读位置
+    uint8_t pad1[${NAME}_CACHELINE - 2 * sizeof(uint32_t)];
+    uint32_t read_index;                // 绝对读位置（元素个数）
+    uint32_t cached_write_index;        // 消费者缓存的写位置
+    uint8_t pad2[${NAME}_CACHELINE - 2 * sizeof(uint32_t)];
+${tail_member}
+};
+
+/**
+ * @brief   初始化环形缓冲区管理结构
+ * @param   rb [IN] 环形缓冲区管理结构
+ * @param   capacity [IN] 缓冲区元素个数
+ * @return  成功返回0; 失败返回-1
+ * @note    ${init_note}
+ */
+int ${name}_init(struct ${name} *rb, uint32_t capacity);
+
+/**
+ * @brief   反初始化环形缓冲区管理结构
+ * @param   rb [IN] 环形缓冲区管理结构
+ * @return  无返回值
+ * @note    无
+ */
+void ${name}_uninit(struct ${name} *rb);
+
+/**
+ * @brief   获取缓冲区中的元素个数
+ * @param   rb [IN] 环形缓冲区管理结构
+ * @return  返回元素个数
+ * @note    和读写并发时只是一个近似值
+ */
+static inline uint32_t ${name}_size(struct ${name} *rb)
+{
+    return jatomic32_load_acquire(&rb->write_index) - jatomic32_load_acquire(&rb->read_index);
+}
+
+/**
+ * @brief   写入一个元素（生产者）
+ * @param   rb [IN] 环形缓冲区管理结构
+ * @param   element [IN] 要写入的元素
+ * @return  成功返回0; 缓冲区满返回-1
+ * @note    无
+ */
+static inline int ${name}_push(struct ${name} *rb, ${T} const *element)
+{
+    uint32_t w = rb->write_index;
+
+    if (JATTR_UNLIKELY(w - rb->cached_read_index >= ${cap_expr})) {
+        rb->cached_read_index = jatomic32_load_acquire(&rb->read_index);
+        if (w - rb->cached_read_index >= ${cap_expr})
+            return -1;
+    }
+    rb->buf[w & ${mask_expr}] = *element;
+    jatomic32_store_release(&rb->write_index, w + 1);
+    return 0;
+}
+
+/**
+ * @brief   读取一个元素（消费者）
+ * @param   rb [IN] 环形缓冲区管理结构
+ * @param   element [OUT] 读出的元素，可以为空（只丢弃）
+ * @return  成功返回0; 缓冲区空返回-1
+ * @note    无
+ */
+static inline int ${name}_pop(struct ${name} *rb, ${T} *element)
+{
+    uint32_t r = rb->read_index;
+
+    if (JATTR_UNLIKELY(r == rb->cached_write_index)) {
+        rb->cached_write_index = jatomic32_load_acquire(&rb->write_index);
+        if (r == rb->cached_write_index)
+            return -1;
+    }
+    if (element)
+        *element = rb->buf[r & ${mask_expr}];
+    jatomic32_store_release(&rb->read_index, r + 1);
+    return 0;
+}
+
+/**
+ * @brief   访问最早写入的元素（消费者）
+ * @param   rb [IN] 环形缓冲区管理结构
+ * @return  成功返回元素指针; 缓冲区空返回NULL
+ * @note    指针在 ${name}_pop 该元素之前有效
+ */
+static inline ${T} *${name}_front(struct ${name} *rb)
+{
+    uint32_t r = rb->read_index;
+
+    if (r == rb->cached_write_index) {
+        rb->cached_write_index = jatomic32_load_acquire(&rb->write_index);
+        if (r == rb->cached_write_index)
+            return NULL;
+    }
+    return rb->buf + (r & ${mask_expr});
+}
+
+/**
+ * @brief   写入多个元素（生产者）
+ * @param   rb [IN] 环形缓冲区管理结构
+ * @param   elements [IN] 要写入的元素数组
+ * @param   num [IN] 要写入的元素数量
+ * @return  返回实际写入的元素数量，空间不足时部分写入
+ * @note    所有元素写完后只发布一次写位置
+ */
+static inline uint32_t ${name}_pushs(struct ${name} *rb, ${T} const *elements, uint32_t num)
+{
+    uint32_t w = rb->write_index;
+    uint32_t space = ${cap_expr} - (w - rb->cached_read_index);
+    uint32_t i;
+
+    if (space < num) {
+        rb->cached_read_index = jatomic32_load_acquire(&rb->read_index);
+        space = ${cap_expr} - (w - rb->cached_read_index);
+        if (space < num)
+            num = space;
+    }
+    for (i = 0; i < num; ++i)
+        rb->buf[(w + i) & ${mask_expr}] = elements[i];
+    if (num)
+        jatomic32_store_release(&rb->write_index, w + num);
+    return num;
+}
+
+/**
+ * @brief   读取多个元素（消费者）
+ * @param   rb [IN] 环形缓冲区管理结构
+ * @param   elements [OUT] 读出的元素数组，可以为空（只丢弃）
+ * @param   num [IN] 要读取的元素数量
+ * @return  返回实际读取的元素数量，数据不足时部分读取
+ * @note    所有元素读完后只发布一次读位置
+ */
+static inline uint32_t ${name}_pops(struct ${name} *rb, ${T} *elements, uint32_t num)
+{
+    uint32_t r = rb->read_index;
+    uint32_t avail = rb->cached_write_index - r;
+    uint32_t i;
+
+    if (avail < num) {
+        rb->cached_write_index = jatomic32_load_acquire(&rb->write_index);
+        avail = rb->cached_write_index - r;
+        if (avail < num)
+            num = avail;
+    }
+    if (elements) {
+        for (i = 0; i < num; ++i)
+            elements[i] = rb->buf[(r + i) & ${mask_expr}];
+    }
+    if (num)
+        jatomic32_store_release(&rb->read_index, r + num);
+    return num;
+}
+
+#ifdef __cplusplus
+}
+#endif
+EOF
+
+##############
+# 生成源文件 #
+##############
+
+if [ -n "${capacity}" ]; then
+init_body="    (void)capacity;
+    rb->write_index = 0;
+    rb->cached_read_index = 0;
+    rb->read_index = 0;
+    rb->cached_write_index = 0;
+    return 0;"
+uninit_body="    rb->write_index = 0;
+    rb->cached_read_index = 0;
+    rb->read_index = 0;
+    rb->cached_write_index = 0;"
+else
+init_body="    uint32_t n = 2;
+
+    if (!capacity || capacity > 0x80000000u)
+        return -1;
+    while (n < capacity)
+        n <<= 1;
+
+    rb->buf = (${T} *)jmalloc(n * sizeof(${T}));
+    if (!rb->buf) {
+        rb->capacity = 0;
+        return -1;
+    }
+    rb->capacity = n;
+    rb->write_index = 0;
+    rb->cached_read_index = 0;
+    rb->read_index = 0;
+    rb->cached_write_index = 0;
+    return 0;"
+uninit_body="    if (rb->buf) {
+        jfree(rb->buf);
+        rb->buf = NULL;
+    }
+    rb->capacity = 0;
+    rb->write_index = 0;
+    rb->cached_read_index = 0;
+    rb->read_index = 0;
+    rb->cached_write_index = 0;"
+fi
+
+cat <<EOF> ${name}.c
+/*******************************************
+* SPDX-License-Identifier: MIT             *
+* Copyright (C) 2026-.... Jing Leng        *
+* Contact: Jing Leng <lengjingzju@163.com> *
+* https://github.com/lengjingzju/jcore     *
+*******************************************/
+#include <stdlib.h>
+#include <stdint.h>
+#include "jheap.h"
+#include "${name}.h"
+
+#define jmalloc     jheap_malloc
+#define jfree       jheap_free
+
+int ${name}_init(struct ${name} *rb, uint32_t capacity)
+{
+${init_body}
+}
+
+void ${name}_uninit(struct ${name} *rb)
+{
+${uninit_body}
+}
+EOF
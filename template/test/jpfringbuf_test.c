@@ -0,0 +1,117 @@
+/*******************************************
+* SPDX-License-Identifier: MIT             *
+* Copyright (C) 2026-.... Jing Leng        *
+* Contact: Jing Leng <lengjingzju@163.com> *
+* https://github.com/lengjingzju/jcore     *
+*******************************************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "jthread.h"
+#include "jpfringbuf.h"
+
+#define RING_TOTAL          1000000
+
+/* 固定容量的缓冲区内嵌在管理结构中，可以是静态变量 */
+static struct jpfringbuf s_ring;
+
+static jthread_ret_t ring_producer(void *arg)
+{
+    struct jpfringbuf *rb = (struct jpfringbuf *)arg;
+    uint64_t batch[8];
+    uint64_t i = 1, j;
+
+    while (i <= RING_TOTAL) {
+        if (i & 1) {
+            if (jpfringbuf_push(rb, &i) == 0) {
+                ++i;
+                continue;
+            }
+        } else {
+            for (j = 0; j < 8; ++j)
+                batch[j] = i + j;
+            j = jpfringbuf_pushs(rb, batch, (RING_TOTAL - i + 1) < 8 ? (uint32_t)(RING_TOTAL - i + 1) : 8);
+            if (j) {
+                i += j;
+                continue;
+            }
+        }
+        jthread_yield();
+    }
+    return (jthread_ret_t)0;
+}
+
+int main(void)
+{
+    struct jpfringbuf *rb = &s_ring;
+    jthread_t tid;
+    uint64_t items[16], v;
+    uint64_t expect = 1;
+    uint32_t i, n;
+
+    /* 固定容量忽略capacity参数 */
+    if (jpfringbuf_init(rb, 3) < 0 || sizeof(rb->buf) / sizeof(rb->buf[0]) != JPFRINGBUF_CAPACITY) {
+        printf("jpfringbuf_init failed!\n");
+        return -1;
+    }
+
+    /* 单线程：写满、读空、部分批量读写 */
+    for (i = 0; i < JPFRINGBUF_CAPACITY; ++i) {
+        v = i;
+        if (jpfringbuf_push(rb, &v) < 0) {
+            printf("push %u failed!\n", i);
+            return -1;
+        }
+    }
+    if (jpfringbuf_push(rb, &v) == 0 || jpfringbuf_size(rb) != JPFRINGBUF_CAPACITY) {
+        printf("push to full ring should fail!\n");
+        return -1;
+    }
+    if (jpfringbuf_pops(rb, items, 16) != 16 || items[15] != 15 || *jpfringbuf_front(rb) != 16) {
+        printf("pops failed!\n");
+        return -1;
+    }
+    if (jpfringbuf_pushs(rb, items, 16) != 16 || jpfringbuf_pushs(rb, items, 16) != 0) {
+        printf("pushs failed!\n");
+        return -1;
+    }
+    if (jpfringbuf_pops(rb, NULL, 1000) != JPFRINGBUF_CAPACITY || jpfringbuf_pop(rb, &v) == 0
+        || jpfringbuf_front(rb) != NULL) {
+        printf("pop from empty ring should fail!\n");
+        return -1;
+    }
+
+    /* 绝对位置越过32位上限时，常量掩码仍然定位正确 */
+    rb->write_index = rb->cached_read_index = rb->read_index = rb->cached_write_index = UINT32_MAX - 20;
+    for (i = 0; i < 40; ++i) {
+        v = i;
+        if (jpfringbuf_push(rb, &v) < 0 || jpfringbuf_pop(rb, items) < 0 || items[0] != i) {
+            printf("index wrap failed at %u!\n", i);
+            return -1;
+        }
+    }
+    jpfringbuf_uninit(rb);
+    jpfringbuf_init(rb, 0);
+
+    /* 两个线程：生产者交替单个和批量写入，消费者检查顺序 */
+    jthread_create(&tid, NULL, ring_producer, rb);
+    while (expect <= RING_TOTAL) {
+        n = jpfringbuf_pops(rb, items, 16);
+        if (!n) {
+            jthread_yield();
+            continue;
+        }
+        for (i = 0; i < n; ++i) {
+            if (items[i] != expect) {
+                printf("order wrong: expect %llu, got %llu\n", (unsigned long long)expect, (unsigned long long)items[i]);
+                return -1;
+            }
+            ++expect;
+        }
+    }
+    jthread_join(tid);
+
+    jpfringbuf_uninit(rb);
+    printf("jpfringbuf test passed.\n");
+    return 0;
+}
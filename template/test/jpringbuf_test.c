@@ -0,0 +1,106 @@
+/*******************************************
+* SPDX-License-Identifier: MIT             *
+* Copyright (C) 2026-.... Jing Leng        *
+* Contact: Jing Leng <lengjingzju@163.com> *
+* https://github.com/lengjingzju/jcore     *
+*******************************************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "jthread.h"
+#include "jpringbuf.h"
+
+#define RING_CAPACITY       64
+#define RING_TOTAL          1000000
+
+static struct jpringbuf s_ring;
+
+static jthread_ret_t ring_producer(void *arg)
+{
+    struct jpringbuf *rb = (struct jpringbuf *)arg;
+    void *batch[8];
+    uintptr_t i = 1, j;
+
+    while (i <= RING_TOTAL) {
+        if (i & 1) {
+            void *p = (void *)i;
+            if (jpringbuf_push(rb, &p) == 0) {
+                ++i;
+                continue;
+            }
+        } else {
+            for (j = 0; j < 8; ++j)
+                batch[j] = (void *)(i + j);
+            j = jpringbuf_pushs(rb, (void *const *)batch, (RING_TOTAL - i + 1) < 8 ? (uint32_t)(RING_TOTAL - i + 1) : 8);
+            if (j) {
+                i += j;
+                continue;
+            }
+        }
+        jthread_yield();
+    }
+    return (jthread_ret_t)0;
+}
+
+int main(void)
+{
+    struct jpringbuf *rb = &s_ring;
+    jthread_t tid;
+    void *items[16];
+    uintptr_t expect = 1;
+    uint32_t i, n;
+
+    if (jpringbuf_init(rb, RING_CAPACITY - 1) < 0 || rb->capacity != RING_CAPACITY) {
+        printf("jpringbuf_init failed!\n");
+        return -1;
+    }
+
+    /* 单线程：写满、读空、部分批量读写 */
+    for (i = 0; i < RING_CAPACITY; ++i) {
+        void *p = (void *)(uintptr_t)i;
+        if (jpringbuf_push(rb, &p) < 0) {
+            printf("push %u failed!\n", i);
+            return -1;
+        }
+    }
+    if (jpringbuf_push(rb, items) == 0 || jpringbuf_size(rb) != RING_CAPACITY) {
+        printf("push to full ring should fail!\n");
+        return -1;
+    }
+    if (jpringbuf_pops(rb, items, 16) != 16 || (uintptr_t)items[15] != 15
+        || (uintptr_t)*jpringbuf_front(rb) != 16) {
+        printf("pops failed!\n");
+        return -1;
+    }
+    if (jpringbuf_pushs(rb, (void *const *)items, 16) != 16 || jpringbuf_pushs(rb, (void *const *)items, 16) != 0) {
+        printf("pushs failed!\n");
+        return -1;
+    }
+    if (jpringbuf_pops(rb, NULL, 1000) != RING_CAPACITY || jpringbuf_pop(rb, items) == 0
+        || jpringbuf_front(rb) != NULL) {
+        printf("pop from empty ring should fail!\n");
+        return -1;
+    }
+
+    /* 两个线程：生产者交替单个和批量写入，消费者检查顺序 */
+    jthread_create(&tid, NULL, ring_producer, rb);
+    while (expect <= RING_TOTAL) {
+        n = jpringbuf_pops(rb, items, 16);
+        if (!n) {
+            jthread_yield();
+            continue;
+        }
+        for (i = 0; i < n; ++i) {
+            if ((uintptr_t)items[i] != expect) {
+                printf("order wrong: expect %lu, got %lu\n", (unsigned long)expect, (unsigned long)(uintptr_t)items[i]);
+                return -1;
+            }
+            ++expect;
+        }
+    }
+    jthread_join(tid);
+
+    jpringbuf_uninit(rb);
+    printf("jpringbuf test passed.\n");
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*******************************************
+* SPDX-License-Identifier: MIT             *
+* Copyright (C) 2024-.... Jing Leng        *
+* Contact: Jing Leng <lengjingzju@163.com> *
+* https://github.com/lengjingzju/jcore     *
+*******************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "jfs.h"
+#include "jlog.h"
+
+#define TEST_DIR        "jlog_bprint_logs"
+#define TEST_TXT        TEST_DIR "/decoded.txt"
+#define TEST_RES        1024            // 单条日志的最大长度，超过时截断
+#define TEST_MAX        64              // 最多的用例数
+
+static char (*g_exp)[TEST_RES * 2];
+static int g_num;
+
+/* 同一个格式串和参数分别调用snprintf和jlog_bprint，输出的日志体应和snprintf的结果相同 */
+#define CASE(fmt, ...) do {                                                     \
+    snprintf(g_exp[g_num++], sizeof(g_exp[0]), fmt, ##__VA_ARGS__);            \
+    jbinfo(fmt, ##__VA_ARGS__);                                                 \
+} while (0)
+
+static void test_cases(void)
+{
+    int i = -12345, n = 300, w = 8, prec = 3;
+    unsigned int u = 4000000000u;
+    short sh = -1234;
+    unsigned short ush = 65000;
+    signed char sc = -100;
+    unsigned char uc = 200;
+    long l = -1234567890L;
+    unsigned long ul = 3456789012UL;
+    long long ll = -1234567890123456789LL;
+    unsigned long long ull = 18000000000000000000ULL;
+    intmax_t im = -9876543210LL;
+    uintmax_t um = 9876543210ULL;
+    ssize_t zs = -4096;
+    size_t z = 65536;
+    ptrdiff_t t = -77;
+    double d = 3.14159265358979, e = -0.000123456, big = 1.5e300;
+    char c = 'Z';
+    const char *s = "hello";
+    char raw[4] = {'a', 'b', 'c', 'd'}; /* 没有'\0'结尾，只能用精度输出 */
+    static char lstr[TEST_RES * 2];
+
+    memset(lstr, 'x', sizeof(lstr) - 1);
+
+    /* 整数转换和标志 */
+    CASE("%d|%i|%5d|%-8d|%08d|%+d|% d", i, i, n, n, n, n, n);
+    CASE("%u|%o|%x|%X|%#x|%#o|%#X", u, u, u, u, u, u, u);
+    CASE("%hhd|%hhu|%hhx|%hd|%hu|%hx", sc, uc, n, sh, ush, i);
+    CASE("%ld|%lu|%lx|%lld|%llu|%llX", l, ul, ul, ll, ull, ull);
+    CASE("%jd|%ju|%zd|%zu|%td|%tx", im, um, zs, z, t, t);
+    CASE("%c|%5c|%-3c|", c, c, c);
+    CASE("%p|%20p", (void *)&i, (void *)s);
+
+    /* 浮点转换 */
+    CASE("%e|%E|%f|%F|%g|%G", d, e, d, e, d, big);
+    CASE("%a|%A|%.0f|%10.3f|%-12.4e|%+g|%#g", d, e, d, d, e, d, d);
+    CASE("%lf|%le|%lg", d, d, d);
+
+    /* 字符串和精度 */
+    CASE("%s|%10s|%-10s|%.3s|%10.2s|%.0s|", s, s, s, s, s, s);
+    CASE("%.4s|%.2s|%-6.3s|", raw, raw, raw);
+
+    /* '*'指定的宽度和精度，负的宽度表示左对齐，负的精度表示没有精度 */
+    CASE("%*d|%-*d|%*d|", w, i, w, i, -w, i);
+    CASE("%.*f|%.*f|%*.*f|", prec, d, -1, d, 12, prec, d);
+    CASE("%*.*s|%-*.*s|%.*s|", 10, prec, s, 10, prec, s, 4, raw);
+
+    /* 没有参数和'%%' */
+    CASE("no arguments");
+    CASE("100%% done %d%%", n);
+
+    /* 截断 */
+    CASE("%s", lstr);
+    CASE("head %1500d tail", n);
+    CASE("%s|%d|%s", lstr + TEST_RES, i, s);
+}
+
+static int test_check(const char *buf, size_t size)
+{
+    const char *p = buf, *end = buf + size, *q = NULL, *body = NULL;
+    int num = 0, fails = 0, blen = 0, elen = 0, max = 0;
+
+    while (p < end && num < g_num) {
+        q = (const char *)memchr(p, '\n', end - p);
+        if (!q)
+            q = end;
+        body = strstr(p, "] ");
+        if (!body || body > q) {
+            printf("[FAIL] line %d has no head\n", num);
+            return -1;
+        }
+        if (body - p < 5 || memcmp(body - 5, "I N N", 5) != 0) {
+            /* 写线程产生的日志，例如截断的统计 */
+            p = q + 1;
+            continue;
+        }
+        body += 2;
+        blen = (int)(q - body);
+        elen = (int)strlen(g_exp[num]);
+
+        /* 日志头加日志体最长 TEST_RES - 1，超出的部分被截断 */
+        max = TEST_RES - 1 - (int)(body - p);
+        if (elen > max ? (blen != max || memcmp(body, g_exp[num], max) != 0)
+            : (blen != elen || memcmp(body, g_exp[num], elen) != 0)) {
+            printf("[FAIL] case %d\n  expect: %.*s\n  actual: %.*s\n", num, elen > max ? max : elen, g_exp[num], blen, body);
+            ++fails;
+        } else {
+            printf("[PASS] case %d%s\n", num, elen > max ? " (truncated)" : "");
+        }
+        ++num;
+        p = q + 1;
+    }
+
+    if (num != g_num) {
+        printf("[FAIL] only %d of %d logs are output\n", num, g_num);
+        return -1;
+    }
+    return fails ? -1 : 0;
+}
+
+/* binary为0时写文本文件直接检查，否则写二进制文件，用 jlog_decode 还原后检查 */
+static int test_run(int binary)
+{
+    jlog_cfg_t cfg;
+    jfs_dirent_t *dirs = NULL;
+    char path[256];
+    char *buf = NULL;
+    size_t size = 0;
+    int num = 0, ret = -1;
+
+    jfs_rmdir(TEST_DIR);
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = JLOG_TO_FILE;
+    cfg.res_size = TEST_RES;
+    cfg.file.file_path = TEST_DIR;
+    cfg.file.file_binary = binary ? 1 : -1;
+    if (jlog_init(&cfg) < 0) {
+        printf("[FAIL] jlog_init\n");
+        return -1;
+    }
+
+    g_num = 0;
+    test_cases();
+    jlog_uninit();
+
+    if (jfs_listdir(TEST_DIR, &dirs, &num, NULL) < 0 || num != 1) {
+        printf("[FAIL] expect one log file in %s\n", TEST_DIR);
+        goto end;
+    }
+    snprintf(path, sizeof(path), "%s/%s", TEST_DIR, dirs[0].name);
+    if (binary) {
+        if (strcmp(path + strlen(path) - 6, "_j.bin") != 0 || jlog_decode(path, TEST_TXT) < 0) {
+            printf("[FAIL] decode %s\n", path);
+            goto end;
+        }
+        snprintf(path, sizeof(path), "%s", TEST_TXT);
+    }
+    if (jfs_readall(path, &buf, &size) < 0) {
+        printf("[FAIL] read %s\n", path);
+        goto end;
+    }
+
+    ret = test_check(buf, size);
+    printf("%s: %d cases in %s file\n", ret == 0 ? "All tests passed" : "Some tests failed",
+        g_num, binary ? "binary" : "text");
+
+end:
+    jfs_readfree(&buf, &size);
+    jfs_freedir(&dirs, &num);
+    jfs_rmdir(TEST_DIR);
+    return ret;
+}
+
+int main(void)
+{
+    int ret = -1;
+
+    g_exp = (char (*)[TEST_RES * 2])malloc(TEST_MAX * sizeof(*g_exp));
+    if (!g_exp)
+        return -1;
+
+    ret = test_run(0);
+    if (test_run(1) < 0)
+        ret = -1;
+
+    free(g_exp);
+    return ret;
+}
@@ -0,0 +1,19 @@
+/*******************************************
+* SPDX-License-Identifier: MIT             *
+* Copyright (C) 2024-.... Jing Leng        *
+* Contact: Jing Leng <lengjingzju@163.com> *
+* https://github.com/lengjingzju/jcore     *
+*******************************************/
+#include <stdio.h>
+#include "jlog.h"
+
+/* 把 file_binary 写入的二进制日志文件还原为文本日志，没有指定输出文件时输出到标准输出 */
+int main(int argc, char *argv[])
+{
+    if (argc != 2 && argc != 3) {
+        printf("Usage: %s <binary log file (*_j.bin)> [text log file]\n", argv[0]);
+        return -1;
+    }
+
+    return jlog_decode(argv[1], argc == 3 ? argv[2] : NULL) < 0 ? -1 : 0;
+}
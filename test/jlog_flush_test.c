@@ -0,0 +1,219 @@
+/*******************************************
+* SPDX-License-Identifier: MIT             *
+* Copyright (C) 2024-.... Jing Leng        *
+* Contact: Jing Leng <lengjingzju@163.com> *
+* https://github.com/lengjingzju/jcore     *
+*******************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jfs.h"
+#include "jtime.h"
+#include "jthread.h"
+#include "jlog.h"
+
+#define TEST_DIR        "jlog_flush_logs"
+#define TEST_LONG_MS    10000           // 足够长的输出间隔，测试期间不会按时间输出
+#define TEST_WAIT_MS    2000            // 等待日志输出的最长时间
+
+static int test_init(int flush_ms, int wake_size, int tbuf_size, int file_level)
+{
+    jlog_cfg_t cfg;
+
+    jfs_rmdir(TEST_DIR);
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = JLOG_TO_FILE;
+    cfg.level = JLOG_LEVEL_INFO;
+    cfg.file_level = file_level;
+    cfg.flush_ms = flush_ms;
+    cfg.wake_size = wake_size;
+    cfg.tbuf_size = tbuf_size;
+    cfg.file.file_path = TEST_DIR;
+    cfg.file.file_size = 4 << 20;
+    cfg.file.file_count = -1;
+    if (jlog_init(&cfg) < 0) {
+        printf("[FAIL] jlog_init\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* 读取并拼接所有日志文件(按文件名即时间顺序)，返回总长度，buf为NULL时只统计长度 */
+static size_t test_read(char **buf)
+{
+    jfs_dirent_t *dirs = NULL;
+    char path[256];
+    char *data = NULL, *all = NULL, *tmp = NULL;
+    size_t size = 0, total = 0;
+    int num = 0, i = 0;
+
+    if (buf)
+        *buf = NULL;
+    if (jfs_listdir(TEST_DIR, &dirs, &num, NULL) < 0)
+        return 0;
+    jfs_sortdir(dirs, num, JFS_SORT_BY_NAME);
+    for (i = 0; i < num; ++i) {
+        snprintf(path, sizeof(path), "%s/%s", TEST_DIR, dirs[i].name);
+        if (jfs_readall(path, &data, &size) < 0)
+            continue;
+        if (buf && size) {
+            tmp = (char *)realloc(all, total + size + 1);
+            if (tmp) {
+                all = tmp;
+                memcpy(all + total, data, size);
+                all[total + size] = '\0';
+            }
+        }
+        total += size;
+        jfs_readfree(&data, &size);
+    }
+    jfs_freedir(&dirs, &num);
+    if (buf)
+        *buf = all;
+    return total;
+}
+
+/* 等待日志文件中有数据，返回等待的毫秒数，超时返回-1 */
+static int test_wait_output(void)
+{
+    uint64_t start = jtime_monomsec_get(), now = 0;
+
+    for (;;) {
+        now = jtime_monomsec_get();
+        if (test_read(NULL))
+            return (int)(now - start);
+        if (now - start >= TEST_WAIT_MS)
+            return -1;
+        jthread_msleep(5);
+    }
+}
+
+static int test_result(const char *name, int ret)
+{
+    printf("[%s] %s\n", ret == 0 ? "PASS" : "FAIL", name);
+    jfs_rmdir(TEST_DIR);
+    return ret;
+}
+
+/* 积压没有达到唤醒阈值时，写线程只按flush_ms输出；反初始化时输出剩余日志 */
+static int test_idle(void)
+{
+    int ret = 0, i = 0;
+
+    if (test_init(TEST_LONG_MS, 1 << 20, 0, 0) < 0)
+        return -1;
+    for (i = 0; i < 10; ++i)
+        jinfo("idle %d", i);
+    jthread_msleep(300);
+    if (test_read(NULL)) {
+        printf("[FAIL] logs below wake_size are output before flush_ms\n");
+        ret = -1;
+    }
+    jlog_uninit();
+    if (ret == 0 && !test_read(NULL)) {
+        printf("[FAIL] logs are lost at uninit\n");
+        ret = -1;
+    }
+    return test_result("no output below wake_size before flush_ms", ret);
+}
+
+/* flush_ms较短时，少量日志在flush_ms左右输出，而不是默认的1秒 */
+static int test_flush_ms(void)
+{
+    int ret = 0, ms = 0;
+
+    if (test_init(50, 1 << 20, 0, 0) < 0)
+        return -1;
+    jinfo("flush_ms");
+    ms = test_wait_output();
+    if (ms < 0 || ms >= 500) {
+        printf("[FAIL] flush_ms=50 but logs are output after %d ms\n", ms);
+        ret = -1;
+    }
+    jlog_uninit();
+    return test_result("output every flush_ms", ret);
+}
+
+/* 线程缓冲或共享缓冲的积压越过唤醒阈值时立即唤醒写线程，不等flush_ms */
+static int test_wake(int tbuf_size)
+{
+    char name[64];
+    int ret = 0, ms = 0, i = 0;
+
+    if (test_init(TEST_LONG_MS, 4096, tbuf_size, 0) < 0)
+        return -1;
+    for (i = 0; i < 200; ++i)
+        jinfo("wake %d 0123456789abcdef0123456789abcdef", i);
+    ms = test_wait_output();
+    if (ms < 0 || ms >= 500) {
+        printf("[FAIL] logs above wake_size are output after %d ms\n", ms);
+        ret = -1;
+    }
+    jlog_uninit();
+    snprintf(name, sizeof(name), "wake at wake_size (%s)", tbuf_size < 0 ? "shared buffer" : "thread buffer");
+    return test_result(name, ret);
+}
+
+/*
+ * 文件等级比日志等级低时隔行过滤，每行都是一个输出内存段，一次输出的段数超过上限，
+ * 要分多次writev输出，输出的必须正好是所有ERROR日志且顺序不变
+ */
+static int test_batch(int tbuf_size)
+{
+    char name[64];
+    char *buf = NULL, *p = NULL, *q = NULL, *body = NULL;
+    int ret = 0, i = 0, seq = 0, next = 0, num = 20000;
+
+    if (test_init(TEST_LONG_MS, 1 << 20, tbuf_size, JLOG_LEVEL_ERROR) < 0)
+        return -1;
+    for (i = 0; i < num; ++i) {
+        if (i & 1)
+            jinfo("batch %d", i);
+        else
+            jerror("batch %d", i);
+    }
+    jlog_uninit();
+
+    test_read(&buf);
+    for (p = buf; p && *p; p = q + 1) {
+        q = strchr(p, '\n');
+        if (!q)
+            q = p + strlen(p) - 1;
+        body = strstr(p, "batch ");
+        if (!body || body > q || sscanf(body + 6, "%d", &seq) != 1 || seq != next) {
+            printf("[FAIL] expect log %d, actual %.*s\n", next, (int)(q - p), p);
+            ret = -1;
+            break;
+        }
+        next += 2;
+    }
+    if (ret == 0 && next != num) {
+        printf("[FAIL] %d of %d logs are output\n", next / 2, num / 2);
+        ret = -1;
+    }
+    free(buf);
+
+    snprintf(name, sizeof(name), "writev batches with level filter (%s)", tbuf_size < 0 ? "shared buffer" : "thread buffer");
+    return test_result(name, ret);
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    if (test_idle() < 0)
+        ret = -1;
+    if (test_flush_ms() < 0)
+        ret = -1;
+    if (test_wake(0) < 0)
+        ret = -1;
+    if (test_wake(-1) < 0)
+        ret = -1;
+    if (test_batch(0) < 0)
+        ret = -1;
+    if (test_batch(-1) < 0)
+        ret = -1;
+
+    printf("%s\n", ret == 0 ? "All tests passed" : "Some tests failed");
+    return ret;
+}
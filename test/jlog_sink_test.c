@@ -0,0 +1,393 @@
+/*******************************************
+* SPDX-License-Identifier: MIT             *
+* Copyright (C) 2024-.... Jing Leng        *
+* Contact: Jing Leng <lengjingzju@163.com> *
+* https://github.com/lengjingzju/jcore     *
+*******************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "joptimize.h"
+#include "jfs.h"
+#include "jtime.h"
+#include "jthread.h"
+#include "jsocket.h"
+#include "jlog.h"
+
+#define TEST_DIR        "jlog_sink_logs"
+#define TEST_THREADS    8               // 最多的写日志线程数
+#define TEST_WAIT_MS    5000            // 等待日志输出的最长时间
+
+typedef struct {
+    jsocket_fd_t sfd;                   // 监听描述符
+    uint32_t stall;                     // 置位时接受连接后不读取
+    char *buf;                          // 收到的数据
+    size_t len;                         // 收到的数据长度
+} test_peer_t;
+
+typedef struct {
+    int id;                             // 线程编号，日志体为 "T<id> N<seq>"
+    int num;                            // 写入的日志条数
+} test_arg_t;
+
+static int g_next[TEST_THREADS];
+
+/* 读取并拼接所有日志文件(按文件名即时间顺序)，返回总长度，files返回文件个数 */
+static size_t test_read(char **buf, int *files)
+{
+    jfs_dirent_t *dirs = NULL;
+    char path[256];
+    char *data = NULL, *all = NULL, *tmp = NULL;
+    size_t size = 0, total = 0;
+    int num = 0, i = 0;
+
+    *buf = NULL;
+    if (files)
+        *files = 0;
+    if (jfs_listdir(TEST_DIR, &dirs, &num, NULL) < 0)
+        return 0;
+    jfs_sortdir(dirs, num, JFS_SORT_BY_NAME);
+    for (i = 0; i < num; ++i) {
+        snprintf(path, sizeof(path), "%s/%s", TEST_DIR, dirs[i].name);
+        if (jfs_readall(path, &data, &size) < 0)
+            continue;
+        if (size) {
+            tmp = (char *)realloc(all, total + size + 1);
+            if (tmp) {
+                all = tmp;
+                memcpy(all + total, data, size);
+                total += size;
+                all[total] = '\0';
+            }
+        }
+        jfs_readfree(&data, &size);
+    }
+    if (files)
+        *files = num;
+    jfs_freedir(&dirs, &num);
+    *buf = all;
+    return total;
+}
+
+/* 统计包含key的行数 */
+static int test_count(const char *buf, const char *key)
+{
+    const char *p = buf;
+    int num = 0;
+
+    while (p && (p = strstr(p, key))) {
+        ++num;
+        p += strlen(key);
+    }
+    return num;
+}
+
+/*
+ * 检查日志，每行的日志体为 "<tag><seq>"，只检查tag开头的行，
+ * 序号必须从0开始每次增加step，返回检查到的行数，乱序返回-1
+ */
+static int test_check_seq(const char *buf, const char *tag, int step)
+{
+    const char *p = buf, *q = NULL, *body = NULL;
+    int seq = 0, next = 0, num = 0;
+    size_t tlen = strlen(tag);
+
+    while (p && *p) {
+        q = strchr(p, '\n');
+        if (!q)
+            q = p + strlen(p);
+        body = strstr(p, "] ");
+        if (body && body < q && strncmp(body + 2, tag, tlen) == 0) {
+            if (sscanf(body + 2 + tlen, "%d", &seq) != 1 || seq != next) {
+                printf("[FAIL] %s expect seq %d, actual %.*s\n", tag, next, (int)(q - p), p);
+                return -1;
+            }
+            next += step;
+            ++num;
+        }
+        p = *q ? q + 1 : q;
+    }
+    return num;
+}
+
+/* 检查每个线程的日志序号必须从0开始连续递增，返回-1表示乱序、重复或丢失 */
+static int test_check_threads(const char *buf, const test_arg_t *targs, int cnt)
+{
+    const char *p = buf, *q = NULL, *body = NULL;
+    int id = 0, seq = 0, i = 0;
+
+    memset(g_next, 0, sizeof(g_next));
+    while (p && *p) {
+        q = strchr(p, '\n');
+        if (!q)
+            q = p + strlen(p);
+        body = strstr(p, "] ");
+        if (body && body < q && sscanf(body + 2, "T%d N%d", &id, &seq) == 2) {
+            if (id < 0 || id >= TEST_THREADS || seq != g_next[id]) {
+                printf("[FAIL] thread %d expect seq %d, actual %d\n", id, id >= 0 && id < TEST_THREADS ? g_next[id] : -1, seq);
+                return -1;
+            }
+            ++g_next[id];
+        }
+        p = *q ? q + 1 : q;
+    }
+    for (i = 0; i < cnt; ++i) {
+        if (g_next[targs[i].id] != targs[i].num) {
+            printf("[FAIL] thread %d wrote %d logs, %d are output\n", targs[i].id, targs[i].num, g_next[targs[i].id]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int test_result(const char *name, int ret)
+{
+    printf("[%s] %s\n", ret == 0 ? "PASS" : "FAIL", name);
+    jfs_rmdir(TEST_DIR);
+    return ret;
+}
+
+/* 接受一个连接，一直接收到对端关闭，stall置位时先不读取 */
+static jthread_ret_t test_peer_run(void *arg)
+{
+    test_peer_t *peer = (test_peer_t *)arg;
+    jsocket_jaddr_t taddr;
+    jsocket_fd_t afd;
+    char buf[8192];
+    char *tmp = NULL;
+    ssize_t len = 0;
+
+    afd = jsocket_tcp_accept(peer->sfd, &taddr);
+    if (!jsocket_fd_valid(afd))
+        return (jthread_ret_t)0;
+    while (jatomic32_load(&peer->stall))
+        jthread_msleep(5);
+    while ((len = jsocket_recv(afd, buf, sizeof(buf))) > 0) {
+        tmp = (char *)realloc(peer->buf, peer->len + len + 1);
+        if (!tmp)
+            break;
+        peer->buf = tmp;
+        memcpy(peer->buf + peer->len, buf, len);
+        peer->len += len;
+        peer->buf[peer->len] = '\0';
+    }
+    jsocket_close(afd);
+    return (jthread_ret_t)0;
+}
+
+/* 在本机随机端口上启动接收日志的对端，返回端口 */
+static int test_peer_start(test_peer_t *peer, jthread_t *tid, int stall)
+{
+    jsocket_jaddr_t jaddr;
+
+    memset(peer, 0, sizeof(*peer));
+    memset(&jaddr, 0, sizeof(jaddr));
+    jaddr.domain = AF_INET;
+    strcpy(jaddr.addr, "127.0.0.1");
+    peer->sfd = jsocket_tcp_server(&jaddr, 1);
+    if (!jsocket_fd_valid(peer->sfd) || jsocket_sockaddr_get(peer->sfd, &jaddr) < 0) {
+        printf("[FAIL] start tcp server\n");
+        return -1;
+    }
+    if (stall)
+        jsocket_recv_bufsize_set(peer->sfd, 4096);
+    peer->stall = (uint32_t)stall;
+    jthread_create(tid, NULL, test_peer_run, peer);
+    return jaddr.port;
+}
+
+static void test_peer_stop(test_peer_t *peer, jthread_t tid)
+{
+    jatomic32_store(&peer->stall, 0);
+    jthread_join(tid);
+    jsocket_close(peer->sfd);
+    free(peer->buf);
+}
+
+static int test_init(int sinks, int port, int file_level, int net_level, int file_size, int mmap)
+{
+    jlog_cfg_t cfg;
+
+    jfs_rmdir(TEST_DIR);
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = JLOG_TO_FILE;
+    cfg.sinks = sinks;
+    cfg.level = JLOG_LEVEL_INFO;
+    cfg.file_level = file_level;
+    cfg.net_level = net_level;
+    cfg.flush_ms = 20;
+    cfg.file.file_path = TEST_DIR;
+    cfg.file.file_size = file_size;
+    cfg.file.file_count = -1;
+    cfg.file.file_mmap = mmap;
+    cfg.net.ip_addr = "127.0.0.1";
+    cfg.net.ip_port = port;
+    if (jlog_init(&cfg) < 0) {
+        printf("[FAIL] jlog_init\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* 文件和网络同时输出，各自按自己的等级过滤，互不影响 */
+static int test_levels(void)
+{
+    test_peer_t peer;
+    jthread_t tid;
+    char *buf = NULL;
+    int port = 0, num = 2000, i = 0, ret = 0, n = 0;
+
+    if ((port = test_peer_start(&peer, &tid, 0)) < 0)
+        return -1;
+    if (test_init(JLOG_SINK_FILE | JLOG_SINK_NET, port, 0, JLOG_LEVEL_ERROR, 4 << 20, -1) < 0) {
+        test_peer_stop(&peer, tid);
+        return -1;
+    }
+    /* 等待写线程连上对端，没连上时网络输出的日志会被丢弃 */
+    jthread_msleep(100);
+    for (i = 0; i < num; ++i) {
+        if (i & 1)
+            jinfo("L%d", i);
+        else
+            jerror("L%d", i);
+    }
+    jlog_uninit();
+    jthread_join(tid);
+
+    /* 文件输出全部日志，网络只输出ERROR日志 */
+    test_read(&buf, NULL);
+    if ((n = test_check_seq(buf, "L", 1)) != num) {
+        printf("[FAIL] file: %d of %d logs are output\n", n, num);
+        ret = -1;
+    }
+    free(buf);
+    if (ret == 0 && (n = test_check_seq(peer.buf, "L", 2)) != num / 2) {
+        printf("[FAIL] net: %d of %d error logs are output\n", n, num / 2);
+        ret = -1;
+    }
+    if (ret == 0 && test_count(peer.buf, " I ")) {
+        printf("[FAIL] net: info logs are not filtered\n");
+        ret = -1;
+    }
+
+    jsocket_close(peer.sfd);
+    free(peer.buf);
+    return test_result("per-sink levels of file and network", ret);
+}
+
+/* 网络对端不读取时网络线程落后，文件输出不受影响 */
+static int test_net_thread(void)
+{
+    test_peer_t peer;
+    jthread_t tid;
+    char *buf = NULL;
+    uint64_t start = 0;
+    int port = 0, num = 20000, i = 0, ret = 0, n = 0;
+
+    if ((port = test_peer_start(&peer, &tid, 1)) < 0)
+        return -1;
+    if (test_init(JLOG_SINK_FILE | JLOG_SINK_NET, port, 0, 0, 4 << 20, -1) < 0) {
+        test_peer_stop(&peer, tid);
+        return -1;
+    }
+    jthread_msleep(100);
+    for (i = 0; i < num; ++i)
+        jinfo("S%d 0123456789abcdef0123456789abcdef0123456789abcdef", i);
+
+    /* 对端还没有读取，文件中应该很快有全部日志 */
+    start = jtime_monomsec_get();
+    for (;;) {
+        test_read(&buf, NULL);
+        n = buf ? test_count(buf, "] S") : 0;
+        free(buf);
+        buf = NULL;
+        if (n >= num || jtime_monomsec_get() - start >= TEST_WAIT_MS)
+            break;
+        jthread_msleep(20);
+    }
+    if (n != num) {
+        printf("[FAIL] file: %d of %d logs are output while the network peer stalls\n", n, num);
+        ret = -1;
+    }
+
+    /* 对端开始读取，网络输出可能丢弃了落后的日志，但收到的日志顺序不变 */
+    jatomic32_store(&peer.stall, 0);
+    jlog_uninit();
+    jthread_join(tid);
+    test_read(&buf, NULL);
+    if (ret == 0 && test_check_seq(buf, "S", 1) != num)
+        ret = -1;
+    free(buf);
+    if (ret == 0 && peer.buf && test_count(peer.buf, "] S") > num)
+        ret = -1;
+
+    jsocket_close(peer.sfd);
+    free(peer.buf);
+    return test_result("network sink in its own thread", ret);
+}
+
+static jthread_ret_t test_writer(void *arg)
+{
+    test_arg_t *targ = (test_arg_t *)arg;
+    int i = 0;
+
+    for (i = 0; i < targ->num; ++i)
+        jinfo("T%d N%d 0123456789abcdef0123456789abcdef", targ->id, i);
+    return (jthread_ret_t)0;
+}
+
+/* 映射写入的小文件频繁滚动，同一毫秒内创建的文件也不会互相覆盖，日志不丢失 */
+static int test_mmap_rotate(int mmap)
+{
+    jthread_t tids[TEST_THREADS];
+    test_arg_t targs[TEST_THREADS];
+    char name[64];
+    char *buf = NULL;
+    size_t total = 0;
+    int ret = 0, files = 0, i = 0;
+
+    if (test_init(JLOG_SINK_FILE, 0, 0, 0, 16 << 10, mmap) < 0)
+        return -1;
+    for (i = 0; i < TEST_THREADS; ++i) {
+        targs[i].id = i;
+        targs[i].num = 5000;
+        jthread_create(&tids[i], NULL, test_writer, &targs[i]);
+    }
+    for (i = 0; i < TEST_THREADS; ++i)
+        jthread_join(tids[i]);
+    jlog_uninit();
+
+    total = test_read(&buf, &files);
+    if (files < 100) {
+        printf("[FAIL] only %d files are created\n", files);
+        ret = -1;
+    }
+    if (ret == 0 && strlen(buf) != total) {
+        printf("[FAIL] mapped files are not truncated to their content\n");
+        ret = -1;
+    }
+    if (ret == 0)
+        ret = test_check_threads(buf, targs, TEST_THREADS);
+    free(buf);
+
+    snprintf(name, sizeof(name), "rotate %s files", mmap > 0 ? "mapped" : "direct");
+    return test_result(name, ret);
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    jsocket_wsa_init();
+    if (test_levels() < 0)
+        ret = -1;
+    if (test_net_thread() < 0)
+        ret = -1;
+    if (test_mmap_rotate(1) < 0)
+        ret = -1;
+    if (test_mmap_rotate(-1) < 0)
+        ret = -1;
+
+    printf("%s\n", ret == 0 ? "All tests passed" : "Some tests failed");
+    return ret;
+}
@@ -0,0 +1,250 @@
+/*******************************************
+* SPDX-License-Identifier: MIT             *
+* Copyright (C) 2024-.... Jing Leng        *
+* Contact: Jing Leng <lengjingzju@163.com> *
+* https://github.com/lengjingzju/jcore     *
+*******************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "joptimize.h"
+#include "jfs.h"
+#include "jlog.h"
+#include "jthread.h"
+
+#define TEST_DIR        "jlog_tbuf_logs"
+#define TEST_RES        1024            // 单条日志的最大长度，超过时截断
+#define TEST_THREADS    64              // 最多的线程数
+
+typedef struct {
+    int id;                             // 线程编号，日志体为 "T<id> N<seq>"
+    int num;                            // 写入的日志条数，为0时一直写到 g_stop 置位
+    int written;                        // 实际写入的日志条数
+    const char *pad;                    // 日志体后面追加的字符串
+} test_arg_t;
+
+static int g_next[TEST_THREADS];
+static uint32_t g_stop;
+static uint32_t g_done;
+static uint32_t g_hold;
+
+static jthread_ret_t test_writer(void *arg)
+{
+    test_arg_t *targ = (test_arg_t *)arg;
+    int i = 0;
+
+    for (i = 0; targ->num ? i < targ->num : !jatomic32_load(&g_stop); ++i)
+        jinfo("T%d N%d %s", targ->id, i, targ->pad);
+    targ->written = i;
+
+    /* g_hold 置位时线程写完后不退出，等待主线程反初始化 */
+    jatomic32_fetch_add(&g_done, 1);
+    while (jatomic32_load(&g_hold))
+        jthread_yield();
+    jinfo("T%d after uninit", targ->id);
+    return (jthread_ret_t)0;
+}
+
+static int test_init(int tbuf_size)
+{
+    jlog_cfg_t cfg;
+
+    jfs_rmdir(TEST_DIR);
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = JLOG_TO_FILE;
+    cfg.res_size = TEST_RES;
+    cfg.tbuf_size = tbuf_size;
+    cfg.file.file_path = TEST_DIR;
+    cfg.file.file_size = 256 << 10;
+    cfg.file.file_count = -1;
+    if (jlog_init(&cfg) < 0) {
+        printf("[FAIL] jlog_init\n");
+        return -1;
+    }
+    memset(g_next, 0, sizeof(g_next));
+    return 0;
+}
+
+/* 检查一段日志，每个线程的日志序号必须从0开始连续递增，不能丢失、重复或乱序 */
+static int test_check_buf(const char *buf, size_t size)
+{
+    const char *p = buf, *end = buf + size, *q = NULL, *body = NULL;
+    int id = 0, seq = 0;
+
+    while (p < end) {
+        q = (const char *)memchr(p, '\n', end - p);
+        if (!q)
+            q = end;
+        body = strstr(p, "] ");
+        if (body && body < q && sscanf(body + 2, "T%d N%d", &id, &seq) == 2) {
+            if (id < 0 || id >= TEST_THREADS || seq != g_next[id]) {
+                printf("[FAIL] thread %d expect seq %d, actual %d\n", id, id >= 0 && id < TEST_THREADS ? g_next[id] : -1, seq);
+                return -1;
+            }
+            ++g_next[id];
+        }
+        p = q + 1;
+    }
+    return 0;
+}
+
+/* 按文件名(时间)顺序检查所有日志文件，targs不为NULL时每个线程的日志条数必须和写入的相同 */
+static int test_check(const char *name, test_arg_t *targs, int cnt)
+{
+    jfs_dirent_t *dirs = NULL;
+    char path[256];
+    char *buf = NULL;
+    size_t size = 0;
+    int num = 0, i = 0, ret = 0;
+
+    if (jfs_listdir(TEST_DIR, &dirs, &num, NULL) < 0 || num < 1) {
+        printf("[FAIL] %s: no log file in %s\n", name, TEST_DIR);
+        return -1;
+    }
+    jfs_sortdir(dirs, num, JFS_SORT_BY_NAME);
+    for (i = 0; i < num && ret == 0; ++i) {
+        snprintf(path, sizeof(path), "%s/%s", TEST_DIR, dirs[i].name);
+        if (jfs_readall(path, &buf, &size) < 0) {
+            printf("[FAIL] %s: read %s\n", name, path);
+            ret = -1;
+            break;
+        }
+        ret = test_check_buf(buf, size);
+        jfs_readfree(&buf, &size);
+    }
+    jfs_freedir(&dirs, &num);
+
+    for (i = 0; i < cnt && ret == 0; ++i) {
+        if (g_next[targs[i].id] != targs[i].written) {
+            printf("[FAIL] %s: thread %d wrote %d logs, %d are output\n", name, targs[i].id, targs[i].written, g_next[targs[i].id]);
+            ret = -1;
+        }
+    }
+
+    printf("[%s] %s\n", ret == 0 ? "PASS" : "FAIL", name);
+    jfs_rmdir(TEST_DIR);
+    return ret;
+}
+
+static void test_start(jthread_t *tids, test_arg_t *targs, int cnt, int base, int num, const char *pad)
+{
+    int i = 0;
+
+    for (i = 0; i < cnt; ++i) {
+        targs[i].id = base + i;
+        targs[i].num = num;
+        targs[i].written = 0;
+        targs[i].pad = pad;
+        jthread_create(&tids[i], NULL, test_writer, &targs[i]);
+    }
+}
+
+static void test_join(jthread_t *tids, int cnt)
+{
+    int i = 0;
+
+    for (i = 0; i < cnt; ++i)
+        jthread_join(tids[i]);
+}
+
+/* 多个线程并发写各自的线程缓冲，写线程按时间顺序合并，每个线程的日志保持顺序且不丢失 */
+static int test_merge(void)
+{
+    jthread_t tids[8];
+    test_arg_t targs[8];
+
+    if (test_init(0) < 0)
+        return -1;
+    test_start(tids, targs, 8, 0, 20000, "");
+    test_join(tids, 8);
+    jlog_uninit();
+    return test_check("merge thread buffers", targs, 8);
+}
+
+/* 线程缓冲取最小值(4条最长日志)，超长日志截断到res，缓冲满时等待写线程而不丢日志 */
+static int test_small(void)
+{
+    static char pad[TEST_RES * 2];
+    jthread_t tids[4];
+    test_arg_t targs[4];
+
+    memset(pad, 'x', sizeof(pad) - 1);
+    if (test_init(1) < 0)
+        return -1;
+    test_start(tids, targs, 4, 0, 3000, pad);
+    test_join(tids, 4);
+    jlog_uninit();
+    return test_check("minimum thread buffer with truncated logs", targs, 4);
+}
+
+/* 大量短生命周期的线程，退出时线程缓冲被关闭，写线程读完后释放，日志不丢失 */
+static int test_exit(void)
+{
+    jthread_t tids[8];
+    test_arg_t targs[TEST_THREADS];
+    int i = 0;
+
+    if (test_init(0) < 0)
+        return -1;
+    for (i = 0; i < TEST_THREADS; i += 8) {
+        test_start(tids, targs + i, 8, i, 500, "");
+        test_join(tids, 8);
+    }
+    jlog_uninit();
+    return test_check("exited threads", targs, TEST_THREADS);
+}
+
+/* 线程写完后不退出，反初始化要输出线程缓冲中所有已提交的日志，之后线程再写日志被忽略 */
+static int test_uninit(void)
+{
+    jthread_t tids[8];
+    test_arg_t targs[8];
+
+    if (test_init(0) < 0)
+        return -1;
+    jatomic32_store(&g_done, 0);
+    jatomic32_store(&g_hold, 1);
+    test_start(tids, targs, 8, 0, 5000, "");
+    while (jatomic32_load(&g_done) != 8)
+        jthread_yield();
+    jlog_uninit();
+    jatomic32_store(&g_hold, 0);
+    test_join(tids, 8);
+    return test_check("drain live threads at uninit", targs, 8);
+}
+
+/* 线程一直在写时反初始化，每个线程输出的日志必须是从0开始的连续前缀 */
+static int test_race(void)
+{
+    jthread_t tids[8];
+    test_arg_t targs[8];
+
+    if (test_init(0) < 0)
+        return -1;
+    jatomic32_store(&g_stop, 0);
+    test_start(tids, targs, 8, 0, 0, "");
+    jthread_msleep(50);
+    jlog_uninit();
+    jatomic32_store(&g_stop, 1);
+    test_join(tids, 8);
+    return test_check("uninit while threads are writing", NULL, 0);
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    if (test_merge() < 0)
+        ret = -1;
+    if (test_small() < 0)
+        ret = -1;
+    if (test_exit() < 0)
+        ret = -1;
+    if (test_uninit() < 0)
+        ret = -1;
+    if (test_race() < 0)
+        ret = -1;
+
+    printf("%s\n", ret == 0 ? "All tests passed" : "Some tests failed");
+    return ret;
+}
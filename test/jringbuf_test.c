@@ -10,6 +10,15 @@
 #include <assert.h>
 #include "jringbuf.h"
 #include "jthread.h"
+#include "joptimize.h"
+#ifdef __linux__
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
 
 /*----------------------------------------------------------------------------
   测试配置
@@ -532,6 +541,1262 @@ static void test_uninit_safety(void)
     printf("Test 12 PASSED\n\n");
 }
 
+/*----------------------------------------------------------------------------
+  测试 13：单生产者单消费者无锁模式并发读写
+----------------------------------------------------------------------------*/
+#define SPSC_TOTAL  200000
+
+typedef struct {
+    jringbuf_t *rb;
+    uint32_t strategy;
+} spsc_arg_t;
+
+static jthread_ret_t spsc_producer(void *arg) {
+    spsc_arg_t *sarg = (spsc_arg_t*)arg;
+    uint32_t data[16];
+    uint32_t seq = 0;
+
+    while (seq < SPSC_TOTAL) {
+        uint32_t n = 1 + seq % 16;
+        if (n > SPSC_TOTAL - seq)
+            n = SPSC_TOTAL - seq;
+        for (uint32_t i = 0; i < n; ++i)
+            data[i] = seq + i;
+        int ret = jringbuf_write(sarg->rb, 0, data, n, sarg->strategy | JRINGBUF_COMPLETE, -1, NULL);
+        test_assert(ret == (int)n, "spsc write failed");
+        seq += n;
+    }
+    return NULL;
+}
+
+static void spsc_run(uint32_t strategy)
+{
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = TEST_CAPACITY;
+    cfg.unit_size = sizeof(uint32_t);
+    cfg.max_producers = 1;
+    cfg.max_consumers = 1;
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+
+    spsc_arg_t sarg = {rb, strategy};
+    jthread_t prod;
+    jthread_create(&prod, NULL, spsc_producer, &sarg);
+
+    uint32_t buf[32];
+    uint32_t expect = 0, got = 0;
+    while (expect < SPSC_TOTAL) {
+        int ret = jringbuf_read(rb, 0, buf, 32, NULL, JRINGBUF_BLOCK, 100);
+        if (ret < 0)
+            break;
+        for (int i = 0; i < ret; ++i) {
+            if (strategy & JRINGBUF_DROP) {
+                /* 允许丢数据，但顺序不能乱 */
+                test_assert(buf[i] >= expect, "spsc order mismatch");
+            } else {
+                test_assert(buf[i] == expect, "spsc data mismatch");
+            }
+            expect = buf[i] + 1;
+            ++got;
+        }
+    }
+    jthread_join(prod);
+
+    if (!(strategy & JRINGBUF_DROP)) {
+        test_assert(got == SPSC_TOTAL, "spsc lost data");
+    }
+    test_assert(expect == SPSC_TOTAL, "spsc last data mismatch");
+    test_assert(jringbuf_size(rb, 0) == 0, "should be empty");
+
+    jringbuf_uninit(rb);
+}
+
+static void test_spsc_lockfree(void)
+{
+    printf("Test 13: SPSC lock-free concurrent read/write\n");
+
+    spsc_run(JRINGBUF_BLOCK);
+    spsc_run(JRINGBUF_DROP);
+
+    printf("Test 13 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 14：零拷贝预留/提交写入
+----------------------------------------------------------------------------*/
+static void reserve_run(jringbuf_t *rb, int pid)
+{
+    jringbuf_span_t s1, s2;
+    uint8_t rbuf[TEST_CAPACITY];
+
+    /* 先移动读写位置，使预留跨越缓冲区尾部 */
+    memset(rbuf, 0, sizeof(rbuf));
+    test_assert(jringbuf_write(rb, pid, rbuf, TEST_CAPACITY - 4, 0, 0, NULL) == TEST_CAPACITY - 4, "write failed");
+    test_assert(jringbuf_read(rb, 0, rbuf, TEST_CAPACITY - 4, NULL, 0, 0) == TEST_CAPACITY - 4, "read failed");
+
+    int ret = jringbuf_write_reserve(rb, pid, 10, &s1, &s2);
+    test_assert(ret == 10, "reserve failed");
+    test_assert(s1.len == 4 && s2.len == 6, "span split wrong");
+    for (uint32_t i = 0; i < s1.len; ++i)
+        ((uint8_t*)s1.data)[i] = (uint8_t)i;
+    for (uint32_t i = 0; i < s2.len; ++i)
+        ((uint8_t*)s2.data)[i] = (uint8_t)(s1.len + i);
+
+    /* 提交前数据不可见 */
+    test_assert(jringbuf_size(rb, -1) == 0, "reserved data should be invisible");
+    test_assert(jringbuf_write_commit(rb, pid, 11) == -1, "commit more than reserved should fail");
+    test_assert(jringbuf_write_commit(rb, pid, 8) == 0, "commit failed");
+    test_assert(jringbuf_write_commit(rb, pid, 0) == -1, "double commit should fail");
+    test_assert(jringbuf_size(rb, -1) == 8, "size after commit");
+
+    ret = jringbuf_read(rb, 0, rbuf, TEST_CAPACITY, NULL, 0, 0);
+    test_assert(ret == 8, "read committed data failed");
+    for (int i = 0; i < ret; ++i)
+        test_assert(rbuf[i] == (uint8_t)i, "committed data mismatch");
+
+    /* 放弃预留 */
+    test_assert(jringbuf_write_reserve(rb, pid, TEST_CAPACITY * 2, &s1, &s2) == TEST_CAPACITY, "reserve all failed");
+    test_assert(jringbuf_write_commit(rb, pid, 0) == 0, "abort failed");
+    test_assert(jringbuf_size(rb, -1) == 0, "abort should publish nothing");
+}
+
+static void test_write_reserve(void)
+{
+    printf("Test 14: Zero-copy write reserve/commit\n");
+
+    /* 无锁模式 */
+    jringbuf_t *rb = jringbuf_init1(TEST_CAPACITY, 1, 1, 0, 0, JRINGBUF_READ_SHARED);
+    test_assert(rb != NULL, "init failed");
+    reserve_run(rb, 0);
+
+    /* 预留未提交时再次预留或写入都失败，且不影响原预留 */
+    jringbuf_span_t s1, s2;
+    uint8_t wbuf[4] = {1, 2, 3, 4};
+    test_assert(jringbuf_write_reserve(rb, 0, 4, &s1, &s2) == 4, "reserve failed");
+    test_assert(jringbuf_write_reserve(rb, 0, 4, &s1, &s2) == -1, "second reserve should fail");
+    test_assert(jringbuf_write(rb, 0, wbuf, 4, 0, 0, NULL) == -1, "write during reserve should fail");
+    memcpy(s1.data, wbuf, s1.len);
+    if (s2.len)
+        memcpy(s2.data, wbuf + s1.len, s2.len);
+    test_assert(jringbuf_write_commit(rb, 0, 4) == 0, "commit failed");
+    test_assert(jringbuf_size(rb, -1) == 4, "size after commit");
+    jringbuf_uninit(rb);
+
+    /* 加锁模式 */
+    rb = jringbuf_init1(TEST_CAPACITY, 2, 1, 0, 0, JRINGBUF_READ_SHARED);
+    test_assert(rb != NULL, "init failed");
+    int pid1 = jringbuf_add_producer(rb);
+    int pid2 = jringbuf_add_producer(rb);
+    reserve_run(rb, pid1);
+
+    test_assert(jringbuf_write_reserve(rb, pid1, 4, &s1, &s2) == 4, "reserve failed");
+    test_assert(jringbuf_write_commit(rb, pid2, 4) == -1, "commit by other producer should fail");
+    /* 有预留时其它预留和写入按策略失败或等待，不会无限自旋 */
+    test_assert(jringbuf_write_reserve(rb, pid1, 4, &s1, &s2) == -1, "second reserve should fail");
+    test_assert(jringbuf_write_reserve(rb, pid2, 4, &s1, &s2) == -1, "reserve by other producer should fail");
+    test_assert(jringbuf_write(rb, pid1, wbuf, 4, JRINGBUF_BLOCK, -1, NULL) == -1, "write by reserving producer should fail");
+    test_assert(jringbuf_write(rb, pid2, wbuf, 4, 0, 0, NULL) == -1, "write during reserve should fail");
+    test_assert(jringbuf_write(rb, pid2, wbuf, 4, JRINGBUF_DROP, 0, NULL) == -1, "drop write during reserve should fail");
+    test_assert(jringbuf_write(rb, pid2, wbuf, 4, JRINGBUF_RETRY, 3, NULL) == -1, "retry write during reserve should fail");
+    test_assert(jringbuf_write(rb, pid2, wbuf, 4, JRINGBUF_BLOCK, 20, NULL) == -1, "block write during reserve should time out");
+    test_assert(jringbuf_write_commit(rb, pid1, 4) == 0, "commit failed");
+    test_assert(jringbuf_write(rb, pid2, wbuf, 4, 0, 0, NULL) == 4, "write after commit failed");
+    jringbuf_uninit(rb);
+
+    printf("Test 14 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 15：零拷贝窥视/释放读取
+----------------------------------------------------------------------------*/
+static void peek_run(jringbuf_t *rb, int cid)
+{
+    jringbuf_span_t s1, s2;
+    uint8_t wbuf[TEST_CAPACITY];
+
+    /* 先移动读写位置，使窥视跨越缓冲区尾部 */
+    memset(wbuf, 0, sizeof(wbuf));
+    test_assert(jringbuf_write(rb, 0, wbuf, TEST_CAPACITY - 4, 0, 0, NULL) == TEST_CAPACITY - 4, "write failed");
+    test_assert(jringbuf_drop_data(rb, cid, 0) == 0, "drop failed");
+    test_assert(jringbuf_read_peek(rb, cid, 4, &s1, &s2) == -1, "peek empty should fail");
+
+    for (int i = 0; i < 10; ++i)
+        wbuf[i] = (uint8_t)i;
+    test_assert(jringbuf_write(rb, 0, wbuf, 10, 0, 0, NULL) == 10, "write failed");
+
+    int ret = jringbuf_read_peek(rb, cid, 20, &s1, &s2);
+    test_assert(ret == 10, "peek failed");
+    test_assert(s1.len == 4 && s2.len == 6, "span split wrong");
+    for (uint32_t i = 0; i < s1.len; ++i)
+        test_assert(((uint8_t*)s1.data)[i] == (uint8_t)i, "peek data mismatch");
+    for (uint32_t i = 0; i < s2.len; ++i)
+        test_assert(((uint8_t*)s2.data)[i] == (uint8_t)(s1.len + i), "peek data mismatch");
+
+    test_assert(jringbuf_read_release(rb, cid, 11) == -1, "release more than peeked should fail");
+    test_assert(jringbuf_read_release(rb, cid, 3) == 0, "release failed");
+    test_assert(jringbuf_read_release(rb, cid, 0) == -1, "double release should fail");
+    test_assert(jringbuf_size(rb, cid) == 7, "size after release");
+
+    /* 释放 0 个不消费数据 */
+    test_assert(jringbuf_read_peek(rb, cid, 20, &s1, &s2) == 7, "peek again failed");
+    test_assert(((uint8_t*)s1.data)[0] == 3, "peek again data mismatch");
+    test_assert(jringbuf_read_release(rb, cid, 0) == 0, "release 0 failed");
+    test_assert(jringbuf_size(rb, cid) == 7, "release 0 should consume nothing");
+}
+
+static void test_read_peek(void)
+{
+    printf("Test 15: Zero-copy read peek/release\n");
+
+    /* 无锁模式 */
+    jringbuf_t *rb = jringbuf_init1(TEST_CAPACITY, 1, 1, 0, 0, JRINGBUF_READ_SHARED);
+    test_assert(rb != NULL, "init failed");
+    peek_run(rb, 0);
+
+    /* 窥视未释放时再次窥视或读取都失败，且不影响原窥视 */
+    jringbuf_span_t s1, s2;
+    uint8_t rbuf[TEST_CAPACITY];
+    test_assert(jringbuf_read_peek(rb, 0, 3, &s1, &s2) == 3, "peek failed");
+    test_assert(jringbuf_read_peek(rb, 0, 3, &s1, &s2) == -1, "second peek should fail");
+    test_assert(jringbuf_read(rb, 0, rbuf, 2, NULL, 0, 0) == -1, "read during peek should fail");
+    test_assert(jringbuf_read_release(rb, 0, 3) == 0, "release failed");
+    test_assert(jringbuf_size(rb, 0) == 4, "size after release");
+    jringbuf_uninit(rb);
+
+    /* 共享读模式 */
+    rb = jringbuf_init1(TEST_CAPACITY, 1, 2, 0, 0, JRINGBUF_READ_SHARED);
+    test_assert(rb != NULL, "init failed");
+    int cid1 = jringbuf_add_consumer(rb, 1);
+    int cid2 = jringbuf_add_consumer(rb, 1);
+    peek_run(rb, cid1);
+    /* 窥视期间其它消费者的窥视失败，读取和没有数据一样按策略失败 */
+    test_assert(jringbuf_read_peek(rb, cid1, 3, &s1, &s2) == 3, "peek failed");
+    test_assert(jringbuf_read_peek(rb, cid2, 3, &s1, &s2) == -1, "peek by other consumer should fail");
+    test_assert(jringbuf_read(rb, cid2, rbuf, 2, NULL, 0, 0) == -1, "read during peek should fail");
+    test_assert(jringbuf_read(rb, cid2, rbuf, 2, NULL, JRINGBUF_RETRY, 3) == -1, "retry read during peek should fail");
+    test_assert(jringbuf_read(rb, cid2, rbuf, 2, NULL, JRINGBUF_BLOCK, 20) == -1, "block read during peek should time out");
+    test_assert(jringbuf_read_release(rb, cid1, 3) == 0, "release failed");
+    test_assert(jringbuf_read(rb, cid2, rbuf, 2, NULL, 0, 0) == 2, "read after release failed");
+    jringbuf_uninit(rb);
+
+    /* 独占读模式：释放的数据参与最小读位置的计算 */
+    rb = jringbuf_init1(TEST_CAPACITY, 1, 2, 0, 0, JRINGBUF_READ_EXCLUSIVE);
+    test_assert(rb != NULL, "init failed");
+    cid1 = jringbuf_add_consumer(rb, 1);
+    peek_run(rb, cid1);
+    cid2 = jringbuf_add_consumer(rb, 1); /* 从最小读位置开始，可读全部 10 个 */
+    test_assert(jringbuf_size(rb, -1) == 10, "global size before release");
+
+    test_assert(jringbuf_read_peek(rb, cid2, 5, &s1, &s2) == 5, "peek cid2 failed");
+    test_assert(((uint8_t*)s1.data)[0] == 0, "peek cid2 data mismatch");
+    /* 其它独占消费者不受影响 */
+    test_assert(jringbuf_read(rb, cid1, rbuf, 2, NULL, 0, 0) == 2, "read cid1 failed");
+    test_assert(jringbuf_read_release(rb, cid2, 5) == 0, "release cid2 failed");
+    test_assert(jringbuf_size(rb, -1) == 5, "global size after release");
+    jringbuf_uninit(rb);
+
+    printf("Test 15 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 16：无锁多生产者多消费者模式，和加锁模式对比扩展性
+----------------------------------------------------------------------------*/
+#define BENCH_OPS           40000
+#define BENCH_MAX_THREADS   32
+
+typedef struct {
+    jringbuf_t *rb;
+    int id;
+    uint32_t num;               // 生产者写入元素个数
+    uint32_t total;             // 所有生产者写入元素总个数
+    uint32_t *consumed;         // 所有消费者已读元素总个数
+    uint64_t sum;               // 消费者读到的数据之和
+} bench_arg_t;
+
+static jthread_ret_t bench_producer(void *arg) {
+    bench_arg_t *barg = (bench_arg_t*)arg;
+    for (uint32_t i = 0; i < barg->num; ++i) {
+        uint64_t v = (uint64_t)barg->id * BENCH_OPS + i + 1;
+        int ret = jringbuf_write(barg->rb, barg->id, &v, 1, 0, 0, NULL);
+        while (ret != 1) {
+            jthread_yield();
+            ret = jringbuf_write(barg->rb, barg->id, &v, 1, 0, 0, NULL);
+        }
+    }
+    return NULL;
+}
+
+static jthread_ret_t bench_consumer(void *arg) {
+    bench_arg_t *barg = (bench_arg_t*)arg;
+    uint64_t v;
+    while (jatomic32_load(barg->consumed) < barg->total) {
+        if (jringbuf_read(barg->rb, barg->id, &v, 1, NULL, 0, 0) == 1) {
+            barg->sum += v;
+            jatomic32_fetch_add(barg->consumed, 1);
+        } else {
+            jthread_yield();
+        }
+    }
+    return NULL;
+}
+
+static double bench_run(uint32_t threads, uint32_t flags)
+{
+    static bench_arg_t pargs[BENCH_MAX_THREADS], cargs[BENCH_MAX_THREADS];
+    jthread_t prods[BENCH_MAX_THREADS], conss[BENCH_MAX_THREADS];
+    uint32_t consumed = 0;
+    uint32_t num = BENCH_OPS / threads;
+    uint32_t total = num * threads;
+    uint64_t expect = 0, sum = 0;
+
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = 1024;
+    cfg.unit_size = sizeof(uint64_t);
+    cfg.max_producers = threads;
+    cfg.max_consumers = threads;
+    cfg.read_mode = JRINGBUF_READ_SHARED;
+    cfg.flags = flags;
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+
+    uint64_t start = jtime_mononsec_get();
+    for (uint32_t i = 0; i < threads; ++i) {
+        cargs[i].rb = rb;
+        cargs[i].id = jringbuf_add_consumer(rb, 1);
+        cargs[i].total = total;
+        cargs[i].consumed = &consumed;
+        cargs[i].sum = 0;
+        jthread_create(&conss[i], NULL, bench_consumer, &cargs[i]);
+    }
+    for (uint32_t i = 0; i < threads; ++i) {
+        pargs[i].rb = rb;
+        pargs[i].id = jringbuf_add_producer(rb);
+        pargs[i].num = num;
+        for (uint32_t j = 0; j < num; ++j)
+            expect += (uint64_t)pargs[i].id * BENCH_OPS + j + 1;
+        jthread_create(&prods[i], NULL, bench_producer, &pargs[i]);
+    }
+    for (uint32_t i = 0; i < threads; ++i) {
+        jthread_join(prods[i]);
+    }
+    for (uint32_t i = 0; i < threads; ++i) {
+        jthread_join(conss[i]);
+        sum += cargs[i].sum;
+    }
+    uint64_t elapsed = jtime_mononsec_get() - start;
+
+    test_assert(consumed == total, "bench lost data");
+    test_assert(sum == expect, "bench data mismatch");
+    test_assert(jringbuf_size(rb, -1) == 0, "bench should be empty");
+    jringbuf_uninit(rb);
+
+    return (double)total * 1000000000.0 / (double)(elapsed ? elapsed : 1);
+}
+
+static void test_lockfree_mpmc(void)
+{
+    printf("Test 16: Lock-free MPMC mode and scaling benchmark\n");
+
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = TEST_CAPACITY;
+    cfg.unit_size = 1;
+    cfg.max_producers = 2;
+    cfg.max_consumers = 2;
+    cfg.read_mode = JRINGBUF_READ_EXCLUSIVE;
+    cfg.flags = JRINGBUF_LOCKFREE;
+    test_assert(jringbuf_init(&cfg) == NULL, "lockfree exclusive mode should fail");
+
+    cfg.read_mode = JRINGBUF_READ_SHARED;
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+    int pid = jringbuf_add_producer(rb);
+    int cid = jringbuf_add_consumer(rb, 1);
+
+    uint8_t wbuf[TEST_CAPACITY], rbuf[TEST_CAPACITY];
+    jringbuf_span_t s1, s2;
+    for (int i = 0; i < TEST_CAPACITY; ++i)
+        wbuf[i] = (uint8_t)i;
+    test_assert(jringbuf_write_reserve(rb, pid, 4, &s1, &s2) == -1, "lockfree reserve should fail");
+    test_assert(jringbuf_write(rb, pid, wbuf, 40, 0, 0, NULL) == 40, "write failed");
+    test_assert(jringbuf_write(rb, pid, wbuf + 40, 40, JRINGBUF_COMPLETE, 0, NULL) == -1, "complete write should fail");
+    test_assert(jringbuf_write(rb, pid, wbuf + 40, 40, 0, 0, NULL) == 24, "partial write failed");
+    test_assert(jringbuf_size(rb, -1) == TEST_CAPACITY, "size mismatch");
+    test_assert(jringbuf_read(rb, cid, rbuf, 30, NULL, 0, 0) == 30, "read failed");
+    test_assert(memcmp(rbuf, wbuf, 30) == 0, "data mismatch");
+    test_assert(jringbuf_write(rb, pid, wbuf, 30, 0, 0, NULL) == 30, "wrap write failed");
+    test_assert(jringbuf_read(rb, cid, rbuf, TEST_CAPACITY, NULL, 0, 0) == TEST_CAPACITY, "wrap read failed");
+    test_assert(memcmp(rbuf, wbuf + 30, 34) == 0 && memcmp(rbuf + 34, wbuf, 30) == 0, "wrap data mismatch");
+    test_assert(jringbuf_write(rb, pid, wbuf, 10, 0, 0, NULL) == 10, "write failed");
+    test_assert(jringbuf_drop_data(rb, cid, 4) == 0 && jringbuf_size(rb, -1) == 6, "drop failed");
+    test_assert(jringbuf_read(rb, cid, rbuf, 10, NULL, 0, 0) == 6 && rbuf[0] == 4, "read after drop failed");
+    jringbuf_uninit(rb);
+
+    /* 容量为1时序号无法区分满和空，增大到2 */
+    cfg.capacity = 1;
+    rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL && jringbuf_capacity(rb) == 2, "lockfree capacity should be at least 2");
+    pid = jringbuf_add_producer(rb);
+    cid = jringbuf_add_consumer(rb, 1);
+    for (int i = 0; i < 4; ++i) {
+        test_assert(jringbuf_write(rb, pid, wbuf + i, 1, 0, 0, NULL) == 1, "write failed");
+        test_assert(jringbuf_read(rb, cid, rbuf, 2, NULL, 0, 0) == 1 && rbuf[0] == wbuf[i], "read failed");
+        test_assert(jringbuf_read(rb, cid, rbuf, 2, NULL, 0, 0) == -1, "empty read should fail");
+    }
+    test_assert(jringbuf_write(rb, pid, wbuf, 3, 0, 0, NULL) == 2, "full write failed");
+    test_assert(jringbuf_write(rb, pid, wbuf, 1, 0, 0, NULL) == -1, "write to full buffer should fail");
+    jringbuf_uninit(rb);
+
+    /* 单生产者单消费者时两者都是SPSC无锁模式 */
+    printf("  threads(P+C)   mutex ops/s   lockfree ops/s\n");
+    for (uint32_t threads = 1; threads <= BENCH_MAX_THREADS; threads <<= 1) {
+        double m = bench_run(threads, 0);
+        double l = bench_run(threads, JRINGBUF_LOCKFREE);
+        printf("  %2u+%-2u          %10.0f    %10.0f\n", threads, threads, m, l);
+    }
+
+    printf("Test 16 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 17：大量独占消费者时最慢读位置的跟踪
+----------------------------------------------------------------------------*/
+#define MANY_CONSUMERS  100
+
+static void test_many_exclusive_consumers(void)
+{
+    printf("Test 17: Slowest reader tracking with many exclusive consumers\n");
+
+    jringbuf_t *rb = jringbuf_init1(1024, 1, MANY_CONSUMERS, 0, 0, JRINGBUF_READ_EXCLUSIVE);
+    test_assert(rb != NULL, "init failed");
+
+    int cids[MANY_CONSUMERS];
+    for (int i = 0; i < MANY_CONSUMERS; ++i) {
+        cids[i] = jringbuf_add_consumer(rb, 1);
+        test_assert(cids[i] >= 0, "add consumer failed");
+    }
+
+    uint8_t buf[64] = {0};
+    uint32_t rnd = 12345;
+    for (int round = 0; round < 2000; ++round) {
+        rnd = rnd * 1103515245 + 12345;
+        int ret = jringbuf_write(rb, 0, buf, 1 + (rnd >> 16) % 32, 0, 0, NULL);
+        test_assert(ret >= 0 || jringbuf_size(rb, -1) == jringbuf_capacity(rb), "write failed");
+
+        rnd = rnd * 1103515245 + 12345;
+        int k = (rnd >> 16) % MANY_CONSUMERS;
+        rnd = rnd * 1103515245 + 12345;
+        jringbuf_read(rb, cids[k], buf, 1 + (rnd >> 16) % 64, NULL, 0, 0);
+
+        /* 偶尔移除并重新加入一个消费者 */
+        if (round % 97 == 0) {
+            test_assert(jringbuf_del_consumer(rb, cids[k]) == 0, "del consumer failed");
+            cids[k] = jringbuf_add_consumer(rb, round & 1);
+            test_assert(cids[k] >= 0, "re-add consumer failed");
+        }
+
+        /* 全局有效个数等于最慢消费者的未读个数 */
+        uint32_t slowest = 0;
+        for (int i = 0; i < MANY_CONSUMERS; ++i) {
+            uint32_t sz = jringbuf_size(rb, cids[i]);
+            if (sz > slowest)
+                slowest = sz;
+        }
+        test_assert(jringbuf_size(rb, -1) == slowest, "slowest reader mismatch");
+    }
+
+    jringbuf_uninit(rb);
+    printf("Test 17 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 18：阻塞等待策略（先自旋、再让出CPU、最后睡眠）的乒乓交接
+----------------------------------------------------------------------------*/
+#define PINGPONG_NUM    2000
+
+typedef struct {
+    jringbuf_t *ping;
+    jringbuf_t *pong;
+    int pid;                    // 回应线程在 pong 上的生产者 ID
+} pingpong_arg_t;
+
+static jthread_ret_t pingpong_echo(void *arg) {
+    pingpong_arg_t *parg = (pingpong_arg_t*)arg;
+    uint32_t v;
+    for (uint32_t i = 0; i < PINGPONG_NUM; ++i) {
+        test_assert(jringbuf_read(parg->ping, 0, &v, 1, NULL, JRINGBUF_BLOCK, -1) == 1, "echo read failed");
+        test_assert(jringbuf_write(parg->pong, parg->pid, &v, 1, JRINGBUF_BLOCK, -1, NULL) == 1, "echo write failed");
+    }
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void pingpong_run(uint32_t max_producers, uint32_t spin_num, uint32_t yield_num)
+{
+    static uint32_t lat[PINGPONG_NUM];  // 往返时间（纳秒）
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = TEST_CAPACITY;
+    cfg.unit_size = sizeof(uint32_t);
+    cfg.max_producers = max_producers;
+    cfg.max_consumers = 1;
+    cfg.spin_num = spin_num;
+    cfg.yield_num = yield_num;
+
+    pingpong_arg_t parg;
+    parg.ping = jringbuf_init(&cfg);
+    parg.pong = jringbuf_init(&cfg);
+    test_assert(parg.ping && parg.pong, "init failed");
+    int pid = max_producers > 1 ? jringbuf_add_producer(parg.ping) : 0;
+    parg.pid = max_producers > 1 ? jringbuf_add_producer(parg.pong) : 0;
+
+    jthread_t echo;
+    jthread_create(&echo, NULL, pingpong_echo, &parg);
+    for (uint32_t i = 0; i < PINGPONG_NUM; ++i) {
+        uint32_t v = i;
+        uint64_t t = jtime_mononsec_get();
+        test_assert(jringbuf_write(parg.ping, pid, &v, 1, JRINGBUF_BLOCK, -1, NULL) == 1, "ping failed");
+        test_assert(jringbuf_read(parg.pong, 0, &v, 1, NULL, JRINGBUF_BLOCK, -1) == 1, "pong failed");
+        lat[i] = (uint32_t)(jtime_mononsec_get() - t);
+        test_assert(v == i, "pingpong data mismatch");
+    }
+    jthread_join(echo);
+
+    /* 超时等待仍然有效 */
+    uint32_t v;
+    uint64_t start = now_ms();
+    test_assert(jringbuf_read(parg.pong, 0, &v, 1, NULL, JRINGBUF_BLOCK, 20) == -1, "read empty should time out");
+    test_assert(now_ms() - start >= 20, "should have waited about 20ms");
+
+    qsort(lat, PINGPONG_NUM, sizeof(lat[0]), cmp_u32);
+    printf("    %-6s spin=%-6u yield=%-3u round trip p50 %8.2f us, p99 %8.2f us\n",
+        max_producers > 1 ? "mutex" : "spsc", spin_num, yield_num,
+        lat[PINGPONG_NUM / 2] / 1000.0, lat[PINGPONG_NUM * 99 / 100] / 1000.0);
+
+    jringbuf_uninit(parg.ping);
+    jringbuf_uninit(parg.pong);
+}
+
+static void test_spin_wait(void)
+{
+    printf("Test 18: Spin-then-sleep BLOCK wait policy\n");
+
+    pingpong_run(1, 0, 0);
+    pingpong_run(1, 2000, 4);
+    pingpong_run(2, 0, 0);
+    pingpong_run(2, 2000, 4);
+
+    printf("Test 18 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 19：进程间共享内存环形缓冲区
+----------------------------------------------------------------------------*/
+#ifdef __linux__
+#define SHM_TOTAL   20000
+
+/* 子进程：消费者读取校验（SPSC），或作为第二个生产者写入（加锁模式） */
+static int shm_child(const char *name, int as_producer)
+{
+    jringbuf_t *rb = jringbuf_attach_shm(name);
+    if (!rb)
+        return 1;
+
+    int ret = 0;
+    if (as_producer) {
+        int pid = jringbuf_add_producer(rb);
+        for (uint32_t i = 0; i < SHM_TOTAL && !ret; ++i) {
+            if (jringbuf_write(rb, pid, &i, 1, JRINGBUF_BLOCK, -1, NULL) != 1)
+                ret = 2;
+        }
+        jringbuf_del_producer(rb, pid);
+    } else {
+        uint32_t buf[16], expect = 0;
+        while (expect < SHM_TOTAL && !ret) {
+            int n = jringbuf_read(rb, 0, buf, 16, NULL, JRINGBUF_BLOCK, 2000);
+            if (n <= 0)
+                ret = 3;
+            for (int i = 0; i < n; ++i) {
+                if (buf[i] != expect++)
+                    ret = 4;
+            }
+        }
+    }
+    jringbuf_detach_shm(rb);
+    return ret;
+}
+
+static void shm_run(uint32_t max_producers, uint32_t spin_num)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/jringbuf_test_%d", (int)getpid());
+
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = TEST_CAPACITY;
+    cfg.unit_size = sizeof(uint32_t);
+    cfg.max_producers = max_producers;
+    cfg.max_consumers = 1;
+    cfg.spin_num = spin_num;
+    jringbuf_t *rb = jringbuf_init_shm(name, &cfg);
+    test_assert(rb != NULL, "init shm failed");
+    test_assert(jringbuf_init_shm(name, &cfg) == NULL, "duplicate shm name should fail");
+
+    pid_t child = fork();
+    test_assert(child >= 0, "fork failed");
+    if (child == 0)
+        _exit(shm_child(name, max_producers > 1));
+
+    if (max_producers > 1) {
+        /* 子进程写入，本进程读取 */
+        uint32_t v, expect = 0;
+        while (expect < SHM_TOTAL) {
+            test_assert(jringbuf_read(rb, 0, &v, 1, NULL, JRINGBUF_BLOCK, 2000) == 1, "shm read failed");
+            test_assert(v == expect, "shm data mismatch");
+            ++expect;
+        }
+    } else {
+        /* 本进程写入，子进程读取 */
+        for (uint32_t i = 0; i < SHM_TOTAL; ++i)
+            test_assert(jringbuf_write(rb, 0, &i, 1, JRINGBUF_BLOCK, 2000, NULL) == 1, "shm write failed");
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    test_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0, "shm child failed");
+    test_assert(jringbuf_size(rb, -1) == 0, "shm should be empty");
+
+    jringbuf_uninit(rb);
+    test_assert(jringbuf_attach_shm(name) == NULL, "shm should be removed");
+}
+#endif
+
+static void test_shm(void)
+{
+    printf("Test 19: Cross-process shared-memory ring\n");
+
+#ifdef __linux__
+    shm_run(1, 0);
+    shm_run(1, 100);
+    shm_run(2, 0);
+#endif
+
+    printf("Test 19 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 20：镜像映射的数据缓冲区
+----------------------------------------------------------------------------*/
+static void mirror_run(uint32_t max_producers)
+{
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = TEST_CAPACITY;
+    cfg.unit_size = sizeof(uint32_t);
+    cfg.max_producers = max_producers;
+    cfg.max_consumers = 1;
+    cfg.flags = JRINGBUF_MIRROR;
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+    int pid = max_producers > 1 ? jringbuf_add_producer(rb) : 0;
+
+    /* 容量增大到映射粒度 */
+    uint32_t cap = jringbuf_capacity(rb);
+    test_assert(cap >= TEST_CAPACITY && cap * sizeof(uint32_t) % 4096 == 0, "mirror capacity wrong");
+
+    /* 随机长度读写多圈，和期望序列比较 */
+    uint32_t wbuf[256], rbuf[256];
+    uint32_t wseq = 0, rseq = 0, rnd = 1;
+    while (rseq < cap * 5) {
+        rnd = rnd * 1103515245 + 12345;
+        uint32_t n = 1 + (rnd >> 16) % 256;
+        for (uint32_t i = 0; i < n; ++i)
+            wbuf[i] = wseq + i;
+        int ret = jringbuf_write(rb, pid, wbuf, n, 0, 0, NULL);
+        test_assert(ret >= 0, "mirror write failed");
+        wseq += ret;
+
+        rnd = rnd * 1103515245 + 12345;
+        ret = jringbuf_read(rb, 0, rbuf, 1 + (rnd >> 16) % 256, NULL, 0, 0);
+        for (int i = 0; i < ret; ++i)
+            test_assert(rbuf[i] == rseq++, "mirror data mismatch");
+    }
+
+    /* 跨越尾部的预留和窥视只返回一段 */
+    jringbuf_span_t s1, s2;
+    while (jringbuf_size(rb, -1))
+        test_assert(jringbuf_read(rb, 0, rbuf, 256, NULL, 0, 0) > 0, "drain failed");
+    while (wseq % cap != cap - 2) {   // 写位置移动到尾部前两个元素
+        test_assert(jringbuf_write(rb, pid, &wseq, 1, 0, 0, NULL) == 1, "move write failed");
+        test_assert(jringbuf_read(rb, 0, rbuf, 1, NULL, 0, 0) == 1, "move read failed");
+        ++wseq;
+    }
+    int ret = jringbuf_write_reserve(rb, pid, 10, &s1, &s2);
+    test_assert(ret == 10 && s1.len == 10 && s2.len == 0, "mirror reserve should be one span");
+    for (uint32_t i = 0; i < 10; ++i)
+        ((uint32_t*)s1.data)[i] = 1000 + i;
+    test_assert(jringbuf_write_commit(rb, pid, 10) == 0, "commit failed");
+    ret = jringbuf_read_peek(rb, 0, 10, &s1, &s2);
+    test_assert(ret == 10 && s1.len == 10 && s2.len == 0, "mirror peek should be one span");
+    for (uint32_t i = 0; i < 10; ++i)
+        test_assert(((uint32_t*)s1.data)[i] == 1000 + i, "mirror peek data mismatch");
+    test_assert(jringbuf_read_release(rb, 0, 10) == 0, "release failed");
+
+    jringbuf_uninit(rb);
+}
+
+static void test_mirror(void)
+{
+    printf("Test 20: Mirrored buffer without wrap-around splits\n");
+
+    mirror_run(1);
+    mirror_run(2);
+
+    /* 元素大小无法对齐到映射粒度时创建失败 */
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = TEST_CAPACITY;
+    cfg.unit_size = 3;
+    cfg.max_producers = 1;
+    cfg.max_consumers = 1;
+    cfg.flags = JRINGBUF_MIRROR;
+    test_assert(jringbuf_init(&cfg) == NULL, "unaligned mirror should fail");
+
+    printf("Test 20 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 21：就绪描述符（poll 等待环形缓冲区）
+----------------------------------------------------------------------------*/
+#ifdef __linux__
+#define EVFD_TOTAL  20000
+
+/* 描述符在 msec 毫秒内是否可读 */
+static int fd_ready(int fd, int msec)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+    return poll(&pfd, 1, msec) == 1 && (pfd.revents & POLLIN);
+}
+
+static jthread_ret_t evfd_producer(void *arg) {
+    jringbuf_t *rb = (jringbuf_t*)arg;
+    int fd = jringbuf_get_space_fd(rb);
+    uint32_t i = 0;
+    while (i < EVFD_TOTAL) {
+        /* 写满后在空间就绪描述符上等待 */
+        if (jringbuf_write(rb, 0, &i, 1, 0, 0, NULL) == 1)
+            ++i;
+        else if (!fd_ready(fd, 2000))
+            break;
+    }
+    return (jthread_ret_t)0;
+}
+
+static void evfd_level_run(uint32_t max_producers)
+{
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = 16;
+    cfg.unit_size = sizeof(uint32_t);
+    cfg.max_producers = max_producers;
+    cfg.max_consumers = 1;
+    cfg.wake_num = 4;
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+    int pid = max_producers > 1 ? jringbuf_add_producer(rb) : 0;
+
+    int efd = jringbuf_get_event_fd(rb, 0);
+    int sfd = jringbuf_get_space_fd(rb);
+    test_assert(efd >= 0 && sfd >= 0 && efd != sfd, "get fd failed");
+    test_assert(jringbuf_get_event_fd(rb, 0) == efd, "fd should be cached");
+    test_assert(!fd_ready(efd, 0) && fd_ready(sfd, 0), "initial state wrong");
+
+    uint32_t buf[16] = {0};
+    jringbuf_write(rb, pid, buf, 3, 0, 0, NULL);
+    test_assert(!fd_ready(efd, 0), "below wake_num should not be ready");
+    jringbuf_write(rb, pid, buf, 1, 0, 0, NULL);
+    test_assert(fd_ready(efd, 0), "wake_num reached should be ready");
+    test_assert(fd_ready(efd, 0), "level should persist until read");
+    jringbuf_read(rb, 0, buf, 2, NULL, 0, 0);
+    test_assert(!fd_ready(efd, 0), "below wake_num after read");
+
+    jringbuf_write(rb, pid, buf, 14, 0, 0, NULL);
+    test_assert(fd_ready(efd, 0) && !fd_ready(sfd, 0), "full state wrong");
+    jringbuf_drop_data(rb, 0, 4);
+    test_assert(fd_ready(sfd, 0), "space after drop should be ready");
+
+    jringbuf_drop_data(rb, 0, 0);
+    test_assert(!fd_ready(efd, 0), "empty should not be ready");
+    jringbuf_stop(rb);
+    test_assert(fd_ready(efd, 0), "stopped should be ready");
+    test_assert(jringbuf_read(rb, 0, buf, 1, NULL, 0, 0) < 0, "read after stop should fail");
+    jringbuf_start(rb);
+    test_assert(!fd_ready(efd, 0), "restarted empty should not be ready");
+
+    jringbuf_uninit(rb);
+}
+#endif
+
+static void test_event_fd(void)
+{
+    printf("Test 21: Event fd readiness for poll/epoll\n");
+
+#ifdef __linux__
+    evfd_level_run(1);
+    evfd_level_run(2);
+
+    /* 独占读：每个消费者一个描述符，只反映自己的未读数据 */
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = TEST_CAPACITY;
+    cfg.unit_size = sizeof(uint32_t);
+    cfg.max_producers = 2;
+    cfg.max_consumers = 2;
+    cfg.wake_num = 1;
+    cfg.read_mode = JRINGBUF_READ_EXCLUSIVE;
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+    int pid = jringbuf_add_producer(rb);
+    int c0 = jringbuf_add_consumer(rb, 0);
+    int c1 = jringbuf_add_consumer(rb, 0);
+    int fd0 = jringbuf_get_event_fd(rb, c0);
+    int fd1 = jringbuf_get_event_fd(rb, c1);
+    test_assert(fd0 >= 0 && fd1 >= 0 && fd0 != fd1, "exclusive fds should differ");
+    test_assert(jringbuf_get_event_fd(rb, 2) < 0, "invalid consumer should fail");
+
+    uint32_t buf[8] = {0};
+    jringbuf_write(rb, pid, buf, 8, 0, 0, NULL);
+    test_assert(fd_ready(fd0, 0) && fd_ready(fd1, 0), "both consumers should be ready");
+    jringbuf_read(rb, c0, buf, 8, NULL, 0, 0);
+    test_assert(!fd_ready(fd0, 0) && fd_ready(fd1, 0), "only consumer 1 should be ready");
+    jringbuf_del_consumer(rb, c1);
+    test_assert(!fd_ready(fd1, 0), "deleted consumer should not be ready");
+    jringbuf_uninit(rb);
+
+    /* 另一个线程写入，本线程只在 poll 返回可读后非阻塞读取 */
+    cfg.max_producers = 1;
+    cfg.max_consumers = 1;
+    cfg.capacity = 16;
+    cfg.wake_num = 4;
+    rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+    int efd = jringbuf_get_event_fd(rb, 0);
+    jthread_t tid;
+    test_assert(jthread_create(&tid, NULL, evfd_producer, rb) == 0, "create thread failed");
+
+    uint32_t expect = 0;
+    while (expect < EVFD_TOTAL) {
+        int n = jringbuf_read(rb, 0, buf, 8, NULL, 0, 0);
+        if (n <= 0) {
+            /* 最后不足 wake_num 个元素时描述符不会置位，用超时兜底 */
+            fd_ready(efd, 10);
+            continue;
+        }
+        for (int i = 0; i < n; ++i)
+            test_assert(buf[i] == expect++, "evfd data mismatch");
+    }
+    jthread_join(tid);
+    jringbuf_uninit(rb);
+#endif
+
+    printf("Test 21 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 22：分片环形缓冲区（每个生产者一个分片，合并消费者）
+----------------------------------------------------------------------------*/
+#define SHARD_NUM       4
+#define SHARD_TOTAL     20000
+
+typedef struct {
+    uint32_t producer;
+    uint32_t seq;
+} shard_rec_t;
+
+typedef struct {
+    jringbuf_shard_t *sh;
+    int pid;
+} shard_arg_t;
+
+static jthread_ret_t shard_producer(void *arg) {
+    shard_arg_t *a = (shard_arg_t*)arg;
+    shard_rec_t rec = { (uint32_t)a->pid, 0 };
+    for (rec.seq = 0; rec.seq < SHARD_TOTAL; ++rec.seq) {
+        if (jringbuf_shard_write(a->sh, a->pid, &rec, 1, JRINGBUF_BLOCK, -1, NULL) != 1)
+            break;
+    }
+    return (jthread_ret_t)0;
+}
+
+static uint64_t shard_key(const void *elem) {
+    return ((const shard_rec_t*)elem)->seq;
+}
+
+static void test_shard(void)
+{
+    printf("Test 22: Sharded ring with merging consumer\n");
+
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = TEST_CAPACITY;
+    cfg.unit_size = sizeof(shard_rec_t);
+    cfg.max_producers = SHARD_NUM;
+    cfg.wake_num = 1;
+
+    /* 多线程写入，消费者轮询读取，每个生产者的数据保持顺序 */
+    jringbuf_shard_t *sh = jringbuf_shard_init(&cfg, NULL);
+    test_assert(sh != NULL, "shard init failed");
+    shard_arg_t args[SHARD_NUM];
+    jthread_t tids[SHARD_NUM];
+    for (int i = 0; i < SHARD_NUM; ++i) {
+        args[i].sh = sh;
+        args[i].pid = jringbuf_shard_add_producer(sh);
+        test_assert(args[i].pid == i, "add shard producer failed");
+    }
+    test_assert(jringbuf_shard_add_producer(sh) < 0, "no free shard should fail");
+    for (int i = 0; i < SHARD_NUM; ++i)
+        jthread_create(&tids[i], NULL, shard_producer, &args[i]);
+
+    uint32_t expect[SHARD_NUM] = {0};
+    uint32_t total = 0;
+    shard_rec_t recs[16];
+    while (total < SHARD_NUM * SHARD_TOTAL) {
+        int n = jringbuf_shard_read(sh, recs, 16, NULL, JRINGBUF_BLOCK, 2000);
+        test_assert(n > 0, "shard read failed");
+        for (int i = 0; i < n; ++i) {
+            test_assert(recs[i].producer < SHARD_NUM, "shard producer wrong");
+            test_assert(recs[i].seq == expect[recs[i].producer]++, "shard order wrong");
+        }
+        total += n;
+    }
+    for (int i = 0; i < SHARD_NUM; ++i)
+        jthread_join(tids[i]);
+    test_assert(jringbuf_shard_size(sh) == 0, "shard should be empty");
+    test_assert(jringbuf_shard_read(sh, recs, 1, NULL, JRINGBUF_BLOCK, 10) < 0, "empty read should time out");
+    jringbuf_shard_uninit(sh);
+
+    /* 按排序键合并：各分片交错的序号按全局顺序读出 */
+    cfg.max_producers = 3;
+    sh = jringbuf_shard_init(&cfg, shard_key);
+    test_assert(sh != NULL, "shard init failed");
+    for (int i = 0; i < 3; ++i)
+        jringbuf_shard_add_producer(sh);
+    for (uint32_t seq = 0; seq < 48; ++seq) {
+        shard_rec_t rec = { (seq * 7) % 3, seq };
+        test_assert(jringbuf_shard_write(sh, (int)rec.producer, &rec, 1, 0, 0, NULL) == 1, "shard write failed");
+    }
+    uint32_t size = 0;
+    test_assert(jringbuf_shard_read(sh, recs, 5, &size, JRINGBUF_COMPLETE, 0) == 5 && size == 48, "merge read failed");
+    uint32_t next = 0;
+    for (int i = 0; i < 5; ++i)
+        test_assert(recs[i].seq == next++, "merge order wrong");
+    while (next < 48) {
+        int n = jringbuf_shard_read(sh, recs, 16, NULL, 0, 0);
+        test_assert(n > 0, "merge read failed");
+        for (int i = 0; i < n; ++i)
+            test_assert(recs[i].seq == next++, "merge order wrong");
+    }
+    test_assert(jringbuf_shard_del_producer(sh, 1) == 0, "del shard producer failed");
+    test_assert(jringbuf_shard_write(sh, 1, recs, 1, 0, 0, NULL) < 0, "deleted producer should fail");
+    jringbuf_shard_uninit(sh);
+
+    printf("Test 22 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 23：文件环形缓冲区（进程崩溃后回放）
+----------------------------------------------------------------------------*/
+#ifdef __linux__
+#define FILE_TOTAL  1000
+#define FILE_SKIP   4
+
+static void file_run(uint32_t max_producers)
+{
+    char fname[64];
+    snprintf(fname, sizeof(fname), "/tmp/jringbuf_test_%d.rec", (int)getpid());
+
+    pid_t child = fork();
+    test_assert(child >= 0, "fork failed");
+    if (child == 0) {
+        /* 子进程持续写入，缓冲区满时丢弃旧数据，最后被杀死而不调用 jringbuf_uninit */
+        jringbuf_cfg_t cfg = {0};
+        cfg.capacity = TEST_CAPACITY;
+        cfg.unit_size = sizeof(uint32_t);
+        cfg.max_producers = max_producers;
+        cfg.max_consumers = 1;
+        jringbuf_t *rb = jringbuf_init_file(fname, &cfg);
+        if (!rb)
+            _exit(1);
+        int pid = max_producers > 1 ? jringbuf_add_producer(rb) : 0;
+        for (uint32_t i = 0; i < FILE_TOTAL; ++i) {
+            if (jringbuf_write(rb, pid, &i, 1, JRINGBUF_DROP, 0, NULL) != 1)
+                _exit(2);
+        }
+        /* 读走 FILE_SKIP 个元素后留下未释放的窥视和未提交的预留 */
+        uint32_t skip[FILE_SKIP];
+        jringbuf_span_t s1, s2;
+        if (jringbuf_read(rb, 0, skip, FILE_SKIP, NULL, JRINGBUF_COMPLETE, 0) != FILE_SKIP
+                || jringbuf_read_peek(rb, 0, 2, &s1, &s2) != 2
+                || jringbuf_write_reserve(rb, pid, 2, &s1, &s2) != 2)
+            _exit(2);
+        kill(getpid(), SIGKILL);
+        _exit(3);
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    test_assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL, "file child failed");
+
+    /* 重新打开文件，清除遗留的窥视和预留，从 min_read_index 回放最后 capacity 个元素中未读的部分 */
+    jringbuf_t *rb = jringbuf_recover_file(fname);
+    test_assert(rb != NULL, "recover file failed");
+    uint32_t cap = jringbuf_capacity(rb);
+    test_assert(jringbuf_size(rb, 0) == cap - FILE_SKIP, "file should hold unread elements");
+    uint32_t v, expect = FILE_TOTAL - cap + FILE_SKIP;
+    while (jringbuf_read(rb, 0, &v, 1, NULL, 0, 0) == 1) {
+        test_assert(v == expect, "file replay mismatch");
+        ++expect;
+    }
+    test_assert(expect == FILE_TOTAL, "file replay incomplete");
+    v = FILE_TOTAL;
+    test_assert(jringbuf_write(rb, 0, &v, 1, 0, 0, NULL) == 1, "write after recover failed");
+    test_assert(jringbuf_read(rb, 0, &v, 1, NULL, 0, 0) == 1 && v == FILE_TOTAL, "read after recover failed");
+    test_assert(jringbuf_sync_file(rb) == 0, "sync file failed");
+    jringbuf_detach_file(rb);
+
+    unlink(fname);
+    test_assert(jringbuf_attach_file(fname) == NULL, "missing file should fail");
+}
+#endif
+
+static void test_file(void)
+{
+    printf("Test 23: File-backed flight recorder survives a crash\n");
+
+#ifdef __linux__
+    file_run(1);
+    file_run(2);
+
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = TEST_CAPACITY;
+    cfg.unit_size = sizeof(uint32_t);
+    cfg.max_producers = 2;
+    cfg.max_consumers = 2;
+    cfg.flags = JRINGBUF_LOCKFREE;
+    test_assert(jringbuf_init_file("/tmp/jringbuf_test_lockfree.rec", &cfg) == NULL, "lockfree file should fail");
+#endif
+
+    printf("Test 23 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 24：统计信息（计数和占用直方图）
+----------------------------------------------------------------------------*/
+static void stats_run(uint32_t max_producers)
+{
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = 8;
+    cfg.unit_size = sizeof(uint32_t);
+    cfg.max_producers = max_producers;
+    cfg.max_consumers = 1;
+    cfg.flags = JRINGBUF_STATS;
+
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+    int pid = max_producers > 1 ? jringbuf_add_producer(rb) : 0;
+    test_assert(pid >= 0, "add producer failed");
+
+    uint32_t data[8] = {0};
+    test_assert(jringbuf_write(rb, pid, data, 6, 0, 0, NULL) == 6, "write failed");
+    test_assert(jringbuf_write(rb, pid, data, 4, 0, 0, NULL) == 2, "partial write failed");
+    test_assert(jringbuf_write(rb, pid, data, 3, JRINGBUF_DROP | JRINGBUF_COMPLETE, 0, NULL) == 3, "drop write failed");
+    test_assert(jringbuf_write(rb, pid, data, 1, JRINGBUF_RETRY, 2, NULL) < 0, "retry write should fail");
+    test_assert(jringbuf_write(rb, pid, data, 1, JRINGBUF_BLOCK, 10, NULL) < 0, "block write should time out");
+    test_assert(jringbuf_read(rb, 0, data, 5, NULL, 0, 0) == 5, "read failed");
+    test_assert(jringbuf_drop_data(rb, 0, 2) == 0, "drop data failed");
+
+    jringbuf_stats_t st;
+    test_assert(jringbuf_stats_get(rb, &st) == 0, "stats get failed");
+    test_assert(st.write_num == 11 && st.write_bytes == 44, "write counters wrong");
+    test_assert(st.write_short == 4, "write_short wrong");
+    test_assert(st.read_num == 5 && st.read_bytes == 20, "read counters wrong");
+    test_assert(st.drop_full == 3 && st.drop_user == 2, "drop counters wrong");
+    test_assert(st.retries == 2, "retries wrong");
+    test_assert(st.block_waits >= 1 && st.block_nsec >= 5000000ULL, "block counters wrong");
+    /* 第一次写入后 6 个元素落在 [4,8) 桶，之后都是满的 8 个落在 [8,16) 桶 */
+    test_assert(st.occupancy[3] == 1 && st.occupancy[4] == 4, "occupancy wrong");
+
+    /* 零拷贝提交和释放的元素同样计数，提交后剩余 1+3 个元素落在 [4,8) 桶 */
+    jringbuf_span_t s1, s2;
+    test_assert(jringbuf_write_reserve(rb, pid, 4, &s1, &s2) == 4, "reserve failed");
+    test_assert(jringbuf_write_commit(rb, pid, 3) == 0, "commit failed");
+    test_assert(jringbuf_read_peek(rb, 0, 8, &s1, &s2) == 4, "peek failed");
+    test_assert(jringbuf_read_release(rb, 0, 2) == 0, "release failed");
+    test_assert(jringbuf_read_peek(rb, 0, 8, &s1, &s2) == 2, "peek again failed");
+    test_assert(jringbuf_read_release(rb, 0, 0) == 0, "release 0 failed");
+    test_assert(jringbuf_stats_get(rb, &st) == 0, "stats get failed");
+    test_assert(st.write_num == 14 && st.write_bytes == 56, "zero-copy write counters wrong");
+    test_assert(st.read_num == 7 && st.read_bytes == 28, "zero-copy read counters wrong");
+    test_assert(st.occupancy[3] == 2 && st.occupancy[4] == 4, "zero-copy occupancy wrong");
+    jringbuf_uninit(rb);
+}
+
+static void test_stats(void)
+{
+    printf("Test 24: Stats counters and occupancy histogram\n");
+
+    stats_run(1);
+    stats_run(2);
+
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = 8;
+    cfg.unit_size = sizeof(uint32_t);
+    cfg.max_producers = 1;
+    cfg.max_consumers = 1;
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    jringbuf_stats_t st;
+    test_assert(rb != NULL, "init failed");
+    test_assert(jringbuf_stats_get(rb, &st) < 0, "stats disabled should fail");
+    jringbuf_uninit(rb);
+
+    printf("Test 24 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 25：直接写出到文件描述符
+----------------------------------------------------------------------------*/
+#ifdef __linux__
+#define FD_UNIT             3       // 元素大小不整除管道容量，内核会只接受某个元素的一部分
+#define FD_NUM              2000
+
+typedef struct {
+    int fd;
+    uint32_t total;     // 期望读取的字节数
+    uint32_t bad;       // 内容错误的字节数
+} fd_drain_arg_t;
+
+/* 第 i 个元素的内容为 {i, i >> 8, 0x5a} */
+static void fd_fill(uint8_t *buf, uint32_t num)
+{
+    for (uint32_t i = 0; i < num; ++i) {
+        buf[i * FD_UNIT] = (uint8_t)i;
+        buf[i * FD_UNIT + 1] = (uint8_t)(i >> 8);
+        buf[i * FD_UNIT + 2] = 0x5a;
+    }
+}
+
+static jthread_ret_t fd_drain(void *arg) {
+    fd_drain_arg_t *a = (fd_drain_arg_t *)arg;
+    uint8_t buf[1024], expect[FD_UNIT * FD_NUM];
+    uint32_t got = 0;
+    ssize_t n;
+
+    fd_fill(expect, FD_NUM);
+    while (got < a->total && (n = read(a->fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; ++i, ++got)
+            a->bad += (buf[i] != expect[got]);
+    }
+    a->total = got;
+    return (jthread_ret_t)0;
+}
+
+static void fd_run(uint32_t flags)
+{
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = 2048;
+    cfg.unit_size = FD_UNIT;
+    cfg.max_producers = 1;
+    cfg.max_consumers = 1;
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+
+    static uint8_t data[FD_UNIT * FD_NUM];
+    int pfd[2];
+    test_assert(pipe(pfd) == 0, "pipe failed");
+    fcntl(pfd[1], F_SETPIPE_SZ, 4096);
+    if (!flags)
+        fcntl(pfd[1], F_SETFL, fcntl(pfd[1], F_GETFL) | O_NONBLOCK);
+    test_assert(jringbuf_read_to_fd(rb, 0, pfd[1], 0, flags) < 0, "empty ring should fail");
+
+    /* 先前移读写位置，使后面写入的数据跨越缓冲区尾部 */
+    test_assert(jringbuf_write(rb, 0, data, FD_NUM, 0, 0, NULL) == FD_NUM, "write failed");
+    test_assert(jringbuf_read(rb, 0, data, FD_NUM, NULL, 0, 0) == FD_NUM, "read failed");
+    fd_fill(data, FD_NUM);
+    test_assert(jringbuf_write(rb, 0, data, FD_NUM, 0, 0, NULL) == FD_NUM, "write failed");
+
+    fd_drain_arg_t darg = {pfd[0], FD_UNIT * FD_NUM, 0};
+    jthread_t tid;
+    jthread_create(&tid, NULL, fd_drain, &darg);
+
+    uint32_t sent = 0;
+    int ret;
+    if (flags & JRINGBUF_FD_ALL) {
+        test_assert(jringbuf_read_to_fd(rb, 0, pfd[1], 0, flags) == FD_NUM, "write all failed");
+        sent = FD_NUM;
+    } else {
+        /* 非阻塞管道每次只接受一部分，只消费内核接受的元素 */
+        while (sent < FD_NUM) {
+            ret = jringbuf_read_to_fd(rb, 0, pfd[1], 0, flags);
+            if (ret < 0) {
+                test_assert(errno == EAGAIN, "read to fd failed");
+                jthread_yield();
+                continue;
+            }
+            test_assert(ret > 0 && ret < FD_NUM, "partial write expected");
+            sent += ret;
+        }
+    }
+    test_assert(sent == FD_NUM && jringbuf_read(rb, 0, data, 1, NULL, 0, 0) < 0, "ring should be drained");
+
+    jthread_join(tid);
+    test_assert(darg.total == FD_UNIT * FD_NUM && darg.bad == 0, "fd content wrong");
+    close(pfd[0]);
+    close(pfd[1]);
+    jringbuf_uninit(rb);
+}
+
+/* 非阻塞管道没有读者时补写有时间上限，已写出一部分的元素算作消费 */
+static void fd_stall(void)
+{
+    jringbuf_cfg_t cfg = {0};
+    cfg.capacity = 2048;
+    cfg.unit_size = FD_UNIT;
+    cfg.max_producers = 1;
+    cfg.max_consumers = 1;
+    jringbuf_t *rb = jringbuf_init(&cfg);
+    test_assert(rb != NULL, "init failed");
+
+    static uint8_t data[FD_UNIT * FD_NUM];
+    int pfd[2];
+    test_assert(pipe(pfd) == 0, "pipe failed");
+    int psize = fcntl(pfd[1], F_SETPIPE_SZ, 4096);
+    test_assert(psize > 0, "set pipe size failed");
+    fcntl(pfd[1], F_SETFL, fcntl(pfd[1], F_GETFL) | O_NONBLOCK);
+    fd_fill(data, FD_NUM);
+    test_assert(jringbuf_write(rb, 0, data, FD_NUM, 0, 0, NULL) == FD_NUM, "write failed");
+
+    uint64_t start = jtime_monomsec_get();
+    int ret = jringbuf_read_to_fd(rb, 0, pfd[1], 0, JRINGBUF_FD_ALL);
+    uint64_t ms = jtime_monomsec_get() - start;
+    test_assert(ret == psize / FD_UNIT + 1, "stalled write should consume the partial element");
+    test_assert(ms + 50 >= JRINGBUF_FD_WAIT_MS && ms < JRINGBUF_FD_WAIT_MS * 3, "stalled write should wait for the bound");
+    test_assert(jringbuf_read(rb, 0, data, FD_NUM, NULL, 0, 0) == FD_NUM - ret, "unsent elements should remain");
+
+    close(pfd[0]);
+    close(pfd[1]);
+    jringbuf_uninit(rb);
+}
+#endif
+
+static void test_read_to_fd(void)
+{
+    printf("Test 25: Drain directly to a file descriptor with writev\n");
+
+#ifdef __linux__
+    fd_run(0);
+    fd_run(JRINGBUF_FD_ALL);
+    fd_stall();
+#endif
+
+    printf("Test 25 PASSED\n\n");
+}
+
 /*----------------------------------------------------------------------------
   主函数
 ----------------------------------------------------------------------------*/
@@ -551,6 +1816,19 @@ int main(void)
     test_dynamic_del();
     test_drop_data();
     test_uninit_safety();
+    test_spsc_lockfree();
+    test_write_reserve();
+    test_read_peek();
+    test_lockfree_mpmc();
+    test_many_exclusive_consumers();
+    test_spin_wait();
+    test_shm();
+    test_mirror();
+    test_event_fd();
+    test_shard();
+    test_file();
+    test_stats();
+    test_read_to_fd();
 
     printf("All tests PASSED.\n");
     return 0;
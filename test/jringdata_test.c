@@ -10,6 +10,12 @@
 #include <assert.h>
 #include "jringdata.h"
 #include "jthread.h"
+#ifdef __linux__
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#endif
 
 /*----------------------------------------------------------------------------
   测试配置
@@ -822,6 +828,1010 @@ static void test_custom_get_size(void)
     printf("Test 14 PASSED\n\n");
 }
 
+/*----------------------------------------------------------------------------
+  测试 15：阻塞等待策略（先自旋、再让出CPU、最后睡眠）
+----------------------------------------------------------------------------*/
+#define SPIN_RECORDS    2000
+
+static jthread_ret_t spin_producer(void *arg) {
+    jringdata_t *rd = (jringdata_t*)arg;
+    uint8_t data[64];
+    for (uint32_t i = 0; i < SPIN_RECORDS; ++i) {
+        uint32_t len = 1 + i % 64;
+        memset(data, (int)(i & 0xFF), len);
+        int ret = jringdata_write(rd, 0, &len, 1, data, JRINGDATA_BLOCK | JRINGDATA_COMPLETE, -1, NULL);
+        test_assert(ret == 1, "spin producer write failed");
+    }
+    return NULL;
+}
+
+static void test_spin_wait(void)
+{
+    printf("Test 15: Spin-then-sleep BLOCK wait policy\n");
+
+    jringdata_cfg_t cfg = {
+        .idx_num = 8,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 128,
+        .max_producers = 1,
+        .max_consumers = 1,
+        .read_mode = JRINGDATA_READ_SHARED,
+        .spin_num = 1000,
+        .yield_num = 2
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+
+    jthread_t prod;
+    jthread_create(&prod, NULL, spin_producer, rd);
+    for (uint32_t i = 0; i < SPIN_RECORDS; ++i) {
+        uint32_t len;
+        uint8_t rdata[64];
+        int ret = jringdata_read(rd, 0, &len, 1, rdata, sizeof(rdata), NULL, NULL, JRINGDATA_BLOCK, -1);
+        test_assert(ret == 1, "spin consumer read failed");
+        test_assert(len == 1 + i % 64, "record length mismatch");
+        test_assert(rdata[0] == (uint8_t)i && rdata[len - 1] == (uint8_t)i, "record data mismatch");
+    }
+    jthread_join(prod);
+
+    /* 超时等待仍然有效 */
+    uint32_t len;
+    uint8_t rdata[64];
+    uint64_t start = now_ms();
+    int ret = jringdata_read(rd, 0, &len, 1, rdata, sizeof(rdata), NULL, NULL, JRINGDATA_BLOCK, 20);
+    test_assert(ret == -1, "read empty should time out");
+    test_assert(now_ms() - start >= 20, "should have waited about 20ms");
+
+    jringdata_uninit(rd);
+    printf("Test 15 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 16：镜像映射的裸数据缓冲区
+----------------------------------------------------------------------------*/
+static void test_mirror(void)
+{
+    printf("Test 16: Mirrored data buffer without wrap-around splits\n");
+
+    jringdata_cfg_t cfg = {
+        .idx_num = TEST_IDX_NUM,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = TEST_DATA_CAP,
+        .max_producers = 1,
+        .max_consumers = 1,
+        .read_mode = JRINGDATA_READ_SHARED,
+        .flags = JRINGDATA_MIRROR
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+
+    /* 变长记录多次跨越尾部，连续和分散读写都校验内容 */
+    uint8_t wdata[300], rdata[300];
+    uint32_t rnd = 7, wcnt = 0, rcnt = 0, bytes = 0;
+    while (bytes < 4096 * 6) {
+        rnd = rnd * 1103515245 + 12345;
+        uint32_t len = 1 + (rnd >> 16) % 300;
+        memset(wdata, (int)(wcnt & 0xFF), len);
+        if (wcnt & 1) {
+            const void *pidx[1] = {&len};
+            const void *pdata[1] = {wdata};
+            test_assert(jringdata_writev(rd, 0, pidx, 1, pdata, 0, 0, NULL) == 1, "writev failed");
+        } else {
+            test_assert(jringdata_write(rd, 0, &len, 1, wdata, 0, 0, NULL) == 1, "write failed");
+        }
+        ++wcnt;
+        bytes += len;
+
+        uint32_t rlen;
+        if (rcnt & 1) {
+            void *pidx[1] = {&rlen};
+            void *pdata[1] = {rdata};
+            uint32_t plen[1] = {sizeof(rdata)};
+            test_assert(jringdata_readv(rd, 0, pidx, 1, pdata, plen, NULL, NULL, 0, 0) == 1, "readv failed");
+        } else {
+            test_assert(jringdata_read(rd, 0, &rlen, 1, rdata, sizeof(rdata), NULL, NULL, 0, 0) == 1, "read failed");
+        }
+        test_assert(rlen == len, "record length mismatch");
+        test_assert(rdata[0] == (uint8_t)rcnt && rdata[rlen - 1] == (uint8_t)rcnt, "record data mismatch");
+        ++rcnt;
+    }
+
+    jringdata_uninit(rd);
+    printf("Test 16 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 17：就绪描述符（poll 等待环形缓冲区）
+----------------------------------------------------------------------------*/
+#ifdef __linux__
+/* 描述符是否可读 */
+static int fd_ready(int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+#endif
+
+static void test_event_fd(void)
+{
+    printf("Test 17: Event fd readiness for poll/epoll\n");
+
+#ifdef __linux__
+    jringdata_cfg_t cfg = {
+        .idx_num = 8,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 64,
+        .max_producers = 1,
+        .max_consumers = 1,
+        .wake_num = 2,
+        .read_mode = JRINGDATA_READ_SHARED
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+
+    int efd = jringdata_get_event_fd(rd, 0);
+    int sfd = jringdata_get_space_fd(rd);
+    test_assert(efd >= 0 && sfd >= 0 && efd != sfd, "get fd failed");
+    test_assert(!fd_ready(efd) && fd_ready(sfd), "initial state wrong");
+
+    uint8_t data[64] = {0};
+    uint32_t len = 8, rlen;
+    jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL);
+    test_assert(!fd_ready(efd), "below wake_num should not be ready");
+    jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL);
+    test_assert(fd_ready(efd), "wake_num reached should be ready");
+    jringdata_read(rd, 0, &rlen, 1, data, sizeof(data), NULL, NULL, 0, 0);
+    test_assert(!fd_ready(efd), "below wake_num after read");
+
+    /* 裸数据缓冲区写满时空间描述符不可读 */
+    len = 56;
+    test_assert(jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL) == 1, "fill write failed");
+    test_assert(fd_ready(efd) && !fd_ready(sfd), "full state wrong");
+    jringdata_drop_data(rd, 0, 1);
+    test_assert(fd_ready(sfd), "space after drop should be ready");
+
+    jringdata_stop(rd);
+    test_assert(fd_ready(efd), "stopped should be ready");
+    jringdata_uninit(rd);
+
+    /* 独占读：每个消费者一个描述符 */
+    cfg.max_consumers = 2;
+    cfg.wake_num = 1;
+    cfg.read_mode = JRINGDATA_READ_EXCLUSIVE;
+    rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    int c0 = jringdata_add_consumer(rd, 0);
+    int c1 = jringdata_add_consumer(rd, 0);
+    int fd0 = jringdata_get_event_fd(rd, c0);
+    int fd1 = jringdata_get_event_fd(rd, c1);
+    test_assert(fd0 >= 0 && fd1 >= 0 && fd0 != fd1, "exclusive fds should differ");
+    len = 4;
+    jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL);
+    test_assert(fd_ready(fd0) && fd_ready(fd1), "both consumers should be ready");
+    jringdata_read(rd, c1, &rlen, 1, data, sizeof(data), NULL, NULL, 0, 0);
+    test_assert(fd_ready(fd0) && !fd_ready(fd1), "only consumer 0 should be ready");
+    jringdata_uninit(rd);
+#endif
+
+    printf("Test 17 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 18：统计信息（计数和占用直方图）
+----------------------------------------------------------------------------*/
+static void test_stats(void)
+{
+    printf("Test 18: Stats counters and occupancy histogram\n");
+
+    jringdata_cfg_t cfg = {
+        .idx_num = 8,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 64,
+        .max_producers = 1,
+        .max_consumers = 1,
+        .read_mode = JRINGDATA_READ_SHARED,
+        .flags = JRINGDATA_STATS
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+
+    uint8_t data[64] = {0};
+    uint32_t lens[8] = {4, 4, 4, 4, 4, 4, 4, 4};
+    test_assert(jringdata_write(rd, 0, lens, 6, data, 0, 0, NULL) == 6, "write failed");
+    test_assert(jringdata_write(rd, 0, lens, 4, data, 0, 0, NULL) == 2, "partial write failed");
+    test_assert(jringdata_write(rd, 0, lens, 3, data, JRINGDATA_DROP | JRINGDATA_COMPLETE, 0, NULL) == 3, "drop write failed");
+    test_assert(jringdata_write(rd, 0, lens, 1, data, JRINGDATA_RETRY, 2, NULL) < 0, "retry write should fail");
+    test_assert(jringdata_write(rd, 0, lens, 1, data, JRINGDATA_BLOCK, 10, NULL) < 0, "block write should time out");
+    test_assert(jringdata_read(rd, 0, lens, 5, data, sizeof(data), NULL, NULL, 0, 0) == 5, "read failed");
+    test_assert(jringdata_drop_data(rd, 0, 2) == 0, "drop data failed");
+
+    jringdata_stats_t st;
+    test_assert(jringdata_stats_get(rd, &st) == 0, "stats get failed");
+    test_assert(st.write_num == 11 && st.write_bytes == 44, "write counters wrong");
+    test_assert(st.write_short == 4, "write_short wrong");
+    test_assert(st.read_num == 5 && st.read_bytes == 20, "read counters wrong");
+    test_assert(st.drop_full == 3 && st.drop_user == 2, "drop counters wrong");
+    test_assert(st.retries == 2, "retries wrong");
+    test_assert(st.block_waits >= 1 && st.block_nsec >= 5000000ULL, "block counters wrong");
+    test_assert(st.occupancy[3] == 1 && st.occupancy[4] == 4, "occupancy wrong");
+    jringdata_uninit(rd);
+
+    cfg.flags = 0;
+    rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    test_assert(jringdata_stats_get(rd, &st) < 0, "stats disabled should fail");
+    jringdata_uninit(rd);
+
+    printf("Test 18 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 19：零拷贝预留写入变长记录
+----------------------------------------------------------------------------*/
+/* 预留一条记录，在索引槽位和裸数据内存中直接编码 len 字节的 val */
+static int reserve_record(jringdata_t *rd, uint32_t len, uint8_t val, uint32_t *nspan)
+{
+    jringdata_span_t span1, span2;
+    void *idx;
+
+    if (jringdata_write_reserve(rd, 0, len, &idx, &span1, &span2) < 0)
+        return -1;
+    test_assert(span1.len + span2.len == len, "span len wrong");
+    memset(span1.data, val, span1.len);
+    if (span2.len)
+        memset(span2.data, val, span2.len);
+    memcpy(idx, &len, sizeof(len));
+    *nspan = span2.len ? 2 : 1;
+    return jringdata_write_commit(rd, 0, 1);
+}
+
+static void reserve_run(uint32_t flags)
+{
+    jringdata_cfg_t cfg = {
+        .idx_num = 8,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 64,
+        .max_producers = 1,
+        .max_consumers = 1,
+        .read_mode = JRINGDATA_READ_SHARED,
+        .flags = flags
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    uint32_t cap = 0, nspan = 0, rlen;
+    jringdata_capacity(rd, &cap);
+
+    uint8_t data[8192];
+    jringdata_span_t span1, span2;
+    void *idx;
+    uint32_t len = 8;
+
+    /* 放弃预留不写入，数据长度超过预留时提交失败 */
+    test_assert(jringdata_write_reserve(rd, 0, 16, &idx, &span1, &span2) == 0, "reserve failed");
+    len = 17;
+    memcpy(idx, &len, sizeof(len));
+    test_assert(jringdata_write_commit(rd, 0, 1) < 0, "oversize commit should fail");
+    test_assert(jringdata_write_commit(rd, 0, 0) == 0, "cancel failed");
+    test_assert(jringdata_write_commit(rd, 0, 0) < 0, "commit without reserve should fail");
+    test_assert(jringdata_read(rd, 0, &rlen, 1, data, sizeof(data), NULL, NULL, 0, 0) < 0, "cancel should not publish");
+
+    /* 循环写入读出 3/4 容量的记录，直到跨越尾部 */
+    uint32_t rec = cap / 4 * 3, wrapped = 0;
+    for (uint8_t i = 1; i <= 8; ++i) {
+        test_assert(reserve_record(rd, rec, i, &nspan) == 0, "reserve record failed");
+        wrapped |= (nspan == 2);
+        test_assert(reserve_record(rd, rec, i, &nspan) < 0, "reserve without space should fail");
+        test_assert(jringdata_read(rd, 0, &rlen, 1, data, sizeof(data), NULL, NULL, 0, 0) == 1, "read failed");
+        test_assert(rlen == rec && data[0] == i && data[rec - 1] == i, "record content wrong");
+    }
+    test_assert(wrapped == !(flags & JRINGDATA_MIRROR), "span split wrong");
+
+    /* 预留期间停止读写会等待提交，之后预留失败 */
+    test_assert(reserve_record(rd, 0, 0, &nspan) == 0, "empty record failed");
+    jringdata_stop(rd);
+    test_assert(jringdata_write_reserve(rd, 0, 1, &idx, &span1, &span2) < 0, "reserve after stop should fail");
+    jringdata_uninit(rd);
+}
+
+static jthread_ret_t producer_reserve_block(void *arg) {
+    thread_arg_t *targ = (thread_arg_t*)arg;
+    uint32_t idx = 4;
+    uint8_t data[4] = {5, 6, 7, 8};
+    /* 等待预留者提交后写入 */
+    int ret = jringdata_write(targ->rd, targ->id, &idx, 1, data, JRINGDATA_BLOCK, -1, NULL);
+    test_assert(ret == 1, "blocked write after commit failed");
+    return NULL;
+}
+
+/* 有预留时其它写入和预留按策略失败或等待，不会无限自旋 */
+static void reserve_contend(void)
+{
+    jringdata_cfg_t cfg = {
+        .idx_num = 8,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 64,
+        .max_producers = 2,
+        .max_consumers = 1,
+        .read_mode = JRINGDATA_READ_SHARED
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    int pid1 = jringdata_add_producer(rd);
+    int pid2 = jringdata_add_producer(rd);
+    test_assert(pid1 >= 0 && pid2 >= 0, "add producer failed");
+
+    jringdata_span_t span1, span2;
+    void *idx;
+    uint32_t len = 4, rlen[2];
+    uint8_t data[4] = {1, 2, 3, 4}, rdata[8];
+
+    test_assert(jringdata_write_reserve(rd, pid1, len, &idx, &span1, &span2) == 0, "reserve failed");
+    test_assert(jringdata_write_reserve(rd, pid1, len, &idx, &span1, &span2) < 0, "second reserve by same producer should fail");
+    test_assert(jringdata_write_reserve(rd, pid2, len, &idx, &span1, &span2) < 0, "reserve by other producer should fail");
+    test_assert(jringdata_write(rd, pid1, &len, 1, data, JRINGDATA_BLOCK, -1, NULL) < 0, "write by reserving producer should fail");
+    test_assert(jringdata_write(rd, pid2, &len, 1, data, 0, 0, NULL) < 0, "write during reserve should fail");
+    test_assert(jringdata_write(rd, pid2, &len, 1, data, JRINGDATA_DROP, 0, NULL) < 0, "drop write during reserve should fail");
+    test_assert(jringdata_write(rd, pid2, &len, 1, data, JRINGDATA_RETRY, 3, NULL) < 0, "retry write during reserve should fail");
+    uint64_t start = now_ms();
+    test_assert(jringdata_write(rd, pid2, &len, 1, data, JRINGDATA_BLOCK, 30, NULL) < 0, "block write during reserve should time out");
+    test_assert(now_ms() - start >= 25, "block write should wait for the timeout");
+
+    /* 阻塞写入在预留提交后完成，提交的记录在前 */
+    jthread_t prod;
+    thread_arg_t parg = {rd, pid2, 0};
+    jthread_create(&prod, NULL, producer_reserve_block, &parg);
+    jthread_msleep(20);
+    memcpy(span1.data, data, span1.len);
+    if (span2.len)
+        memcpy(span2.data, data + span1.len, span2.len);
+    memcpy(idx, &len, sizeof(len));
+    test_assert(jringdata_write_commit(rd, pid1, 1) == 0, "commit failed");
+    jthread_join(prod);
+
+    test_assert(jringdata_read(rd, 0, rlen, 2, rdata, sizeof(rdata), NULL, NULL, 0, 0) == 2, "read failed");
+    test_assert(rdata[0] == 1 && rdata[4] == 5, "record order wrong");
+    jringdata_uninit(rd);
+}
+
+static void test_write_reserve(void)
+{
+    printf("Test 19: Zero-copy reserve/commit of variable-length records\n");
+
+    reserve_run(0);
+    reserve_run(JRINGDATA_MIRROR);
+    reserve_contend();
+
+    printf("Test 19 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 20：零拷贝迭代读取
+----------------------------------------------------------------------------*/
+/* 迭代取出一条记录，拼接两段裸数据后检查长度和内容 */
+static void iter_check(jringdata_iter_t *it, uint32_t len, uint8_t val)
+{
+    jringdata_span_t span1, span2;
+    uint8_t data[64];
+    void *idx;
+
+    test_assert(jringdata_iter_next(it, &idx, &span1, &span2) == 0, "iter next failed");
+    test_assert(*(uint32_t *)idx == len && span1.len + span2.len == len, "iter len wrong");
+    memcpy(data, span1.data, span1.len);
+    if (span2.len)
+        memcpy(data + span1.len, span2.data, span2.len);
+    for (uint32_t i = 0; i < len; ++i)
+        test_assert(data[i] == val, "iter content wrong");
+}
+
+static void iter_run(enum jringdata_read_mode mode)
+{
+    jringdata_cfg_t cfg = {
+        .idx_num = 8,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 128,
+        .max_producers = 1,
+        .max_consumers = 2,
+        .read_mode = mode,
+        .flags = 0
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    int c0 = jringdata_add_consumer(rd, 1);
+    int c1 = jringdata_add_consumer(rd, 1);
+    test_assert(c0 >= 0 && c1 >= 0, "add consumer failed");
+
+    jringdata_iter_t it0, it1;
+    jringdata_span_t span1, span2;
+    void *idx;
+    uint8_t data[24];
+    uint32_t len = sizeof(data), rlen;
+    test_assert(jringdata_iter_begin(rd, c0, &it0) < 0, "iter on empty ring should fail");
+
+    /* 多轮写入 3 条 24 字节记录，使记录跨越数据缓冲区尾部 */
+    for (uint8_t round = 1; round <= 4; ++round) {
+        for (uint8_t i = 0; i < 3; ++i) {
+            memset(data, round * 3 + i, len);
+            test_assert(jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL) == 1, "write failed");
+        }
+
+        test_assert(jringdata_iter_begin(rd, c0, &it0) == 3, "iter begin failed");
+        if (mode == JRINGDATA_READ_SHARED) {
+            test_assert(jringdata_iter_begin(rd, c0, &it1) < 0, "second shared iter should fail");
+            test_assert(jringdata_read(rd, c0, &rlen, 1, data, len, NULL, NULL, 0, 0) < 0,
+                "read while iterating should fail");
+            /* 只取出 2 条，剩下的 1 条留给另一个消费者 */
+            iter_check(&it0, len, round * 3);
+            iter_check(&it0, len, round * 3 + 1);
+            test_assert(jringdata_iter_end(&it0) == 0, "iter end failed");
+            test_assert(jringdata_iter_end(&it0) < 0, "double end should fail");
+            test_assert(jringdata_iter_begin(rd, c1, &it1) == 1, "shared remain wrong");
+            iter_check(&it1, len, round * 3 + 2);
+        } else {
+            /* 两个消费者各自迭代全部记录，独立释放 */
+            for (uint8_t i = 0; i < 3; ++i)
+                iter_check(&it0, len, round * 3 + i);
+            test_assert(jringdata_iter_next(&it0, &idx, &span1, &span2) < 0, "iter should end");
+            test_assert(jringdata_iter_end(&it0) == 0, "iter end failed");
+            test_assert(jringdata_iter_begin(rd, c0, &it0) < 0, "c0 should be drained");
+            test_assert(jringdata_iter_begin(rd, c1, &it1) == 3, "c1 should keep records");
+            for (uint8_t i = 0; i < 3; ++i)
+                iter_check(&it1, len, round * 3 + i);
+        }
+        test_assert(jringdata_iter_end(&it1) == 0, "iter end failed");
+    }
+
+    /* 停止读写后不能开始迭代 */
+    test_assert(jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL) == 1, "write failed");
+    test_assert(jringdata_iter_begin(rd, c1, &it1) == 1, "iter begin failed");
+    test_assert(jringdata_iter_end(&it1) == 0, "iter end failed");
+    jringdata_stop(rd);
+    test_assert(jringdata_iter_begin(rd, c1, &it1) < 0, "iter after stop should fail");
+    jringdata_uninit(rd);
+}
+
+static void test_iter(void)
+{
+    printf("Test 20: Zero-copy record iterator\n");
+
+    iter_run(JRINGDATA_READ_SHARED);
+    iter_run(JRINGDATA_READ_EXCLUSIVE);
+
+    printf("Test 20 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 21：直接写出到文件描述符
+----------------------------------------------------------------------------*/
+#ifdef __linux__
+#define FD_REC_NUM          150
+#define FD_REC_LEN(i)       (1 + (i) % 50)
+#define FD_STREAM_LEN       (FD_REC_NUM * 4 + 3 * 1275)  // 索引 + 裸数据的总字节数
+
+typedef struct {
+    int fd;
+    uint32_t total;     // 读取的字节数
+    uint8_t buf[FD_STREAM_LEN];
+} fd_drain_arg_t;
+
+static jthread_ret_t fd_drain(void *arg) {
+    fd_drain_arg_t *a = (fd_drain_arg_t *)arg;
+    ssize_t n;
+
+    while (a->total < FD_STREAM_LEN && (n = read(a->fd, a->buf + a->total, FD_STREAM_LEN - a->total)) > 0)
+        a->total += (uint32_t)n;
+    return (jthread_ret_t)0;
+}
+
+static void fd_run(uint32_t flags)
+{
+    jringdata_cfg_t cfg = {
+        .idx_num = 256,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 4096,
+        .max_producers = 1,
+        .max_consumers = 1,
+        .read_mode = JRINGDATA_READ_SHARED,
+        .flags = 0
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+
+    uint8_t data[1000];
+    uint32_t len = sizeof(data), sent = 0, i;
+    int pfd[2], ret;
+    test_assert(pipe(pfd) == 0, "pipe failed");
+    fcntl(pfd[1], F_SETPIPE_SZ, 4096);
+    if (!(flags & JRINGDATA_FD_ALL))
+        fcntl(pfd[1], F_SETFL, fcntl(pfd[1], F_GETFL) | O_NONBLOCK);
+    test_assert(jringdata_read_to_fd(rd, 0, pfd[1], 0, flags) < 0, "empty ring should fail");
+
+    /* 先前移读写位置，使后面写入的记录跨越缓冲区尾部 */
+    test_assert(jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL) == 1, "write failed");
+    test_assert(jringdata_read(rd, 0, &len, 1, data, len, NULL, NULL, 0, 0) == 1, "read failed");
+    for (i = 0; i < FD_REC_NUM; ++i) {
+        len = FD_REC_LEN(i);
+        memset(data, (int)i, len);
+        test_assert(jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL) == 1, "write failed");
+    }
+
+    fd_drain_arg_t *darg = (fd_drain_arg_t *)calloc(1, sizeof(*darg));
+    test_assert(darg != NULL, "calloc failed");
+    darg->fd = pfd[0];
+    jthread_t tid;
+    jthread_create(&tid, NULL, fd_drain, darg);
+
+    /* 非阻塞管道每次只接受一部分，只消费内核完整接受的记录；一次最多构造256个iovec */
+    while (sent < FD_REC_NUM) {
+        ret = jringdata_read_to_fd(rd, 0, pfd[1], 0, flags);
+        if (ret < 0) {
+            test_assert(!(flags & JRINGDATA_FD_ALL) && errno == EAGAIN, "read to fd failed");
+            jthread_yield();
+            continue;
+        }
+        test_assert(ret > 0 && ret < FD_REC_NUM, "read to fd num wrong");
+        test_assert(!(flags & JRINGDATA_FD_ALL) || sent || ret > 100, "write all should fill iovec");
+        sent += (uint32_t)ret;
+    }
+    test_assert(sent == FD_REC_NUM, "sent num wrong");
+    test_assert(jringdata_read(rd, 0, &len, 1, data, sizeof(data), NULL, NULL, 0, 0) < 0, "ring should be drained");
+
+    /* 按 “索引 + 裸数据” 解析写出的字节流 */
+    jthread_join(tid);
+    test_assert(darg->total == FD_STREAM_LEN, "stream len wrong");
+    uint8_t *p = darg->buf;
+    for (i = 0; i < FD_REC_NUM; ++i) {
+        memcpy(&len, p, sizeof(len));
+        test_assert(len == FD_REC_LEN(i), "stream idx wrong");
+        for (uint32_t j = 0; j < len; ++j)
+            test_assert(p[sizeof(len) + j] == (uint8_t)i, "stream data wrong");
+        p += sizeof(len) + len;
+    }
+
+    free(darg);
+    close(pfd[0]);
+    close(pfd[1]);
+    jringdata_uninit(rd);
+}
+#endif
+
+static void test_read_to_fd(void)
+{
+    printf("Test 21: Drain records directly to a file descriptor with writev\n");
+
+#ifdef __linux__
+    fd_run(JRINGDATA_FD_IDX);
+    fd_run(JRINGDATA_FD_IDX | JRINGDATA_FD_ALL);
+#endif
+
+    printf("Test 21 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 22：按序号定位
+----------------------------------------------------------------------------*/
+#define SEEK_REC_NUM        100
+#define SEEK_REC_LEN(i)     (1 + (i) % 7)
+
+/* 读取一条记录，检查它是序号为 seq 的记录 */
+static void seek_check(jringdata_t *rd, int cid, uint64_t seq)
+{
+    uint8_t data[8];
+    uint32_t len;
+
+    test_assert(jringdata_read(rd, cid, &len, 1, data, sizeof(data), NULL, NULL, 0, 0) == 1, "read failed");
+    test_assert(len == SEEK_REC_LEN(seq) && data[0] == (uint8_t)seq && data[len - 1] == (uint8_t)seq,
+        "record seq wrong");
+}
+
+static void seek_run(enum jringdata_read_mode mode)
+{
+    jringdata_cfg_t cfg = {
+        .idx_num = 16,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 256,
+        .max_producers = 1,
+        .max_consumers = mode == JRINGDATA_READ_EXCLUSIVE ? 2 : 1,
+        .hold_num = 8,
+        .read_mode = mode,
+        .flags = JRINGDATA_SEQ
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    int c0 = mode == JRINGDATA_READ_EXCLUSIVE ? jringdata_add_consumer(rd, 0) : 0;
+    test_assert(c0 >= 0, "add consumer failed");
+
+    /* 交替使用连续写、分散写和预留写入，索引和数据都多次回绕 */
+    uint8_t data[8];
+    uint32_t len, i;
+    uint64_t oldest, next, seq;
+    for (i = 0; i < SEEK_REC_NUM; ++i) {
+        len = SEEK_REC_LEN(i);
+        memset(data, (int)i, sizeof(data));
+        if (i % 3 == 0) {
+            test_assert(jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL) == 1, "write failed");
+        } else if (i % 3 == 1) {
+            const void *pidx = &len, *pdata = data;
+            test_assert(jringdata_writev(rd, 0, &pidx, 1, &pdata, 0, 0, NULL) == 1, "writev failed");
+        } else {
+            jringdata_span_t span1, span2;
+            void *idx;
+            test_assert(jringdata_write_reserve(rd, 0, len, &idx, &span1, &span2) == 0, "reserve failed");
+            memcpy(idx, &len, sizeof(len));
+            memset(span1.data, (int)i, span1.len);
+            if (span2.len)
+                memset(span2.data, (int)i, span2.len);
+            test_assert(jringdata_write_commit(rd, 0, 1) == 0, "commit failed");
+        }
+        seek_check(rd, c0, i);
+    }
+
+    test_assert(jringdata_seq_range(rd, &oldest, &next) == 0 && next == SEEK_REC_NUM, "seq range failed");
+    test_assert(jringdata_tell(rd, c0, &seq) == 0 && seq == SEEK_REC_NUM, "tell failed");
+    test_assert(jringdata_seek(rd, c0, SEEK_REC_NUM + 1) < 0, "seek future should fail");
+    test_assert(jringdata_seek(rd, c0, oldest - 1) < 0, "seek overwritten should fail");
+
+    if (mode == JRINGDATA_READ_EXCLUSIVE) {
+        /* 保留 hold_num 条历史记录，后加入的消费者直接定位到历史记录 */
+        test_assert(oldest == SEEK_REC_NUM - 8, "oldest wrong");
+        int c1 = jringdata_add_consumer(rd, 0);
+        test_assert(c1 >= 0, "add consumer failed");
+        test_assert(jringdata_seek(rd, c1, SEEK_REC_NUM - 5) == 0, "seek history failed");
+        seek_check(rd, c1, SEEK_REC_NUM - 5);
+        test_assert(jringdata_seek(rd, c1, oldest) == 0, "seek oldest failed");
+        seek_check(rd, c1, oldest);
+        test_assert(jringdata_tell(rd, c1, &seq) == 0 && seq == oldest + 1, "tell after seek wrong");
+        test_assert(jringdata_seek(rd, c0, SEEK_REC_NUM - 1) == 0, "seek back failed");
+        seek_check(rd, c0, SEEK_REC_NUM - 1);
+    } else {
+        /* 共享读模式下已读的记录已释放，只能向后跳过 */
+        test_assert(oldest == SEEK_REC_NUM, "oldest wrong");
+        for (i = 0; i < 5; ++i) {
+            len = SEEK_REC_LEN(SEEK_REC_NUM + i);
+            memset(data, (int)(SEEK_REC_NUM + i), sizeof(data));
+            test_assert(jringdata_write(rd, 0, &len, 1, data, 0, 0, NULL) == 1, "write failed");
+        }
+        test_assert(jringdata_seek(rd, c0, SEEK_REC_NUM + 3) == 0, "seek forward failed");
+        seek_check(rd, c0, SEEK_REC_NUM + 3);
+        test_assert(jringdata_seek(rd, c0, SEEK_REC_NUM + 3) < 0, "seek released should fail");
+    }
+    test_assert(jringdata_seq_range(rd, NULL, &next) == 0, "seq range failed");
+    test_assert(jringdata_seek(rd, c0, next) == 0, "seek to end failed");
+    test_assert(jringdata_read(rd, c0, &len, 1, data, sizeof(data), NULL, NULL, 0, 0) < 0, "read at end should fail");
+    jringdata_uninit(rd);
+}
+
+static void test_seek(void)
+{
+    printf("Test 22: Sequence numbers and seek\n");
+
+    seek_run(JRINGDATA_READ_EXCLUSIVE);
+    seek_run(JRINGDATA_READ_SHARED);
+
+    jringdata_cfg_t cfg = {
+        .idx_num = 8,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 64,
+        .max_producers = 1,
+        .max_consumers = 1,
+        .read_mode = JRINGDATA_READ_SHARED,
+        .flags = 0
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    test_assert(jringdata_seek(rd, 0, 0) < 0, "seek without JRINGDATA_SEQ should fail");
+    jringdata_uninit(rd);
+
+    printf("Test 22 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 23：写入时间和过期
+----------------------------------------------------------------------------*/
+#define TTL_AGE_MS          50
+
+/* 写入 num 条 4 字节记录，内容为序号 first ~ first+num-1 */
+static void ttl_write(jringdata_t *rd, uint32_t first, uint32_t num, uint32_t strategy)
+{
+    uint32_t len = sizeof(uint32_t);
+    for (uint32_t i = first; i < first + num; ++i)
+        test_assert(jringdata_write(rd, 0, &len, 1, &i, strategy, 0, NULL) == 1, "write failed");
+}
+
+static void ttl_run(enum jringdata_read_mode mode)
+{
+    jringdata_cfg_t cfg = {
+        .idx_num = 16,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 256,
+        .max_producers = 1,
+        .max_consumers = mode == JRINGDATA_READ_EXCLUSIVE ? 2 : 1,
+        .read_mode = mode,
+        .flags = JRINGDATA_STATS,
+        .max_age_ns = TTL_AGE_MS * 1000000ULL
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    int c0 = mode == JRINGDATA_READ_EXCLUSIVE ? jringdata_add_consumer(rd, 0) : 0;
+    int c1 = mode == JRINGDATA_READ_EXCLUSIVE ? jringdata_add_consumer(rd, 0) : -1;
+    test_assert(c0 >= 0, "add consumer failed");
+
+    uint32_t idx[16], data[16];
+    uint64_t ns, t0 = jtime_mononsec_get();
+    jringdata_stats_t st;
+
+    /* 读取时整批跳过过期的记录，写入时间可读 */
+    ttl_write(rd, 0, 5, 0);
+    jthread_msleep(TTL_AGE_MS + 10);
+    ttl_write(rd, 5, 3, 0);
+    test_assert(jringdata_front_time(rd, c0, &ns) == 0 && ns >= t0 && ns + cfg.max_age_ns < jtime_mononsec_get(),
+        "front time wrong");
+    test_assert(jringdata_read(rd, c0, idx, 16, data, sizeof(data), NULL, NULL, 0, 0) == 3 && data[0] == 5,
+        "expired records should be skipped");
+    if (c1 >= 0) {
+        test_assert(jringdata_read(rd, c1, idx, 16, data, sizeof(data), NULL, NULL, 0, 0) == 3 && data[2] == 7,
+            "expired records should be skipped");
+    }
+
+    /* 缓冲区满时 JRINGDATA_DROP 整批过期，不丢弃未过期的记录 */
+    ttl_write(rd, 8, 16, 0);
+    jthread_msleep(TTL_AGE_MS + 10);
+    ttl_write(rd, 24, 1, JRINGDATA_DROP);
+
+    /* 迭代器可读写入时间 */
+    jringdata_iter_t it;
+    jringdata_span_t span1, span2;
+    void *pidx;
+    test_assert(jringdata_iter_begin(rd, c0, &it) == 1, "iter begin failed");
+    test_assert(jringdata_iter_time(&it) == 0, "iter time before next should be 0");
+    test_assert(jringdata_iter_next(&it, &pidx, &span1, &span2) == 0 && *(uint32_t *)span1.data == 24, "iter next failed");
+    ns = jringdata_iter_time(&it);
+    test_assert(ns > t0 && ns <= jtime_mononsec_get(), "iter time wrong");
+    test_assert(jringdata_iter_end(&it) == 0, "iter end failed");
+    test_assert(jringdata_front_time(rd, c0, &ns) < 0, "front time on empty should fail");
+
+    test_assert(jringdata_stats_get(rd, &st) == 0, "stats get failed");
+    test_assert(st.drop_expired == (c1 >= 0 ? 5 + 5 + 16 : 5 + 16) && st.drop_full == 0, "expire counters wrong");
+    jringdata_uninit(rd);
+}
+
+static void test_max_age(void)
+{
+    printf("Test 23: Record timestamps and max_age_ns expiry\n");
+
+    ttl_run(JRINGDATA_READ_SHARED);
+    ttl_run(JRINGDATA_READ_EXCLUSIVE);
+
+    printf("Test 23 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 24：消费者按索引过滤记录
+----------------------------------------------------------------------------*/
+typedef struct {
+    uint32_t len;
+    uint32_t topic;
+} topic_idx_t;
+
+static uint32_t topic_get_size(const void *idx)
+{
+    return ((const topic_idx_t *)idx)->len;
+}
+
+static int topic_filter(const void *idx, void *arg)
+{
+    return ((const topic_idx_t *)idx)->topic == (uint32_t)(uintptr_t)arg;
+}
+
+/* 写入 num 条 4 字节记录，内容为序号 first ~ first+num-1，主题为序号 % 4 */
+static void topic_write(jringdata_t *rd, uint32_t first, uint32_t num)
+{
+    for (uint32_t i = first; i < first + num; ++i) {
+        topic_idx_t ti = { sizeof(uint32_t), i % 4 };
+        test_assert(jringdata_write(rd, 0, &ti, 1, &i, 0, 0, NULL) == 1, "write failed");
+    }
+}
+
+static void test_filter(void)
+{
+    printf("Test 24: Consumer-side index filter\n");
+
+    jringdata_cfg_t cfg = {
+        .idx_num = 64,
+        .idx_size = sizeof(topic_idx_t),
+        .capacity = 256,
+        .max_producers = 1,
+        .max_consumers = 4,
+        .read_mode = JRINGDATA_READ_EXCLUSIVE,
+        .get_size = topic_get_size,
+        .flags = 0
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    int c0 = jringdata_add_consumer_filter(rd, 0, topic_filter, (void *)(uintptr_t)0);
+    int c1 = jringdata_add_consumer_filter(rd, 0, topic_filter, (void *)(uintptr_t)1);
+    int c2 = jringdata_add_consumer_filter(rd, 0, topic_filter, (void *)(uintptr_t)2);
+    int call = jringdata_add_consumer(rd, 0);
+    test_assert(c0 >= 0 && c1 >= 0 && c2 >= 0 && call >= 0, "add consumer failed");
+
+    topic_idx_t idx[64];
+    uint32_t data[64], len[4], i;
+    void *pidx[4], *pdata[4];
+    uint32_t total_num = 0;
+
+    topic_write(rd, 0, 40);
+
+    /* 连续读取只返回匹配的记录 */
+    test_assert(jringdata_read(rd, c0, idx, 64, data, sizeof(data), &total_num, NULL, 0, 0) == 10 && total_num == 40,
+        "filtered read count wrong");
+    for (i = 0; i < 10; ++i)
+        test_assert(idx[i].topic == 0 && data[i] == i * 4, "filtered read content wrong");
+    test_assert(jringdata_size(rd, c0, NULL) == 0, "filtered consumer should pass the skipped tail");
+
+    /* 分散读取分批返回匹配的记录，数据缓冲区放不下匹配的记录时失败 */
+    for (i = 0; i < 4; ++i) {
+        pidx[i] = &idx[i];
+        pdata[i] = &data[i];
+        len[i] = sizeof(uint32_t);
+    }
+    test_assert(jringdata_readv(rd, c1, pidx, 4, pdata, len, NULL, NULL, 0, 0) == 4 && data[0] == 1 && data[3] == 13,
+        "filtered readv wrong");
+    len[0] = 2;
+    test_assert(jringdata_readv(rd, c1, pidx, 4, pdata, len, NULL, NULL, 0, 0) < 0, "small buffer should fail");
+    len[0] = sizeof(uint32_t);
+    test_assert(jringdata_readv(rd, c1, pidx, 4, pdata, len, NULL, NULL, JRINGDATA_COMPLETE, 0) == 4 && data[0] == 17,
+        "filtered readv wrong");
+
+    /* 迭代器跳过不匹配的记录 */
+    jringdata_iter_t it;
+    jringdata_span_t span1, span2;
+    void *p;
+    test_assert(jringdata_iter_begin(rd, c2, &it) == 40, "iter begin failed");
+    for (i = 0; jringdata_iter_next(&it, &p, &span1, &span2) == 0; ++i)
+        test_assert(((topic_idx_t *)p)->topic == 2 && *(uint32_t *)span1.data == i * 4 + 2, "filtered iter wrong");
+    test_assert(i == 10 && jringdata_iter_end(&it) == 0, "filtered iter count wrong");
+
+    /* 不过滤的消费者读取全部记录 */
+    test_assert(jringdata_read(rd, call, idx, 64, data, sizeof(data), NULL, NULL, 0, 0) == 40, "unfiltered read wrong");
+
+    /* 全部不匹配时越过这些记录，等待之后的记录 */
+    topic_write(rd, 41, 3);
+    test_assert(jringdata_read(rd, c0, idx, 64, data, sizeof(data), NULL, NULL, 0, 0) < 0, "no match should fail");
+    test_assert(jringdata_size(rd, c0, NULL) == 0, "unmatched records should be passed");
+    test_assert(jringdata_read(rd, c0, idx, 64, data, sizeof(data), NULL, NULL, JRINGDATA_RETRY, 3) < 0,
+        "no match should fail");
+    topic_write(rd, 44, 1);
+    test_assert(jringdata_read(rd, c0, idx, 64, data, sizeof(data), NULL, NULL, 0, 0) == 1 && data[0] == 44,
+        "filtered read after skip wrong");
+    test_assert(jringdata_size(rd, c1, NULL) == 44 - 30, "filtered consumer size wrong");
+    jringdata_uninit(rd);
+
+    /* 共享读模式不能过滤 */
+    cfg.read_mode = JRINGDATA_READ_SHARED;
+    rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+    test_assert(jringdata_add_consumer_filter(rd, 0, topic_filter, NULL) < 0, "filter in shared mode should fail");
+    jringdata_uninit(rd);
+
+    printf("Test 24 PASSED\n\n");
+}
+
+/*----------------------------------------------------------------------------
+  测试 25：生产者批量暂存
+----------------------------------------------------------------------------*/
+#define STAGE_NUM           2000    // 每个生产者暂存的记录数
+
+static jthread_ret_t stage_producer(void *arg)
+{
+    thread_arg_t *targ = (thread_arg_t*)arg;
+    jringdata_stage_t sg;
+    uint32_t len = sizeof(uint32_t);
+
+    test_assert(jringdata_stage_init(&sg, targ->rd, targ->id, 16, 64, 1000000, JRINGDATA_BLOCK, -1) == 0,
+        "stage init failed");
+    for (uint32_t i = 0; i < STAGE_NUM; ++i) {
+        uint32_t v = ((uint32_t)targ->id << 16) | i;
+        test_assert(jringdata_stage(&sg, &len, &v) == 0, "stage failed");
+    }
+    test_assert(jringdata_flush(&sg, 1) >= 0 && sg.num == 0, "final flush failed");
+    jringdata_stage_uninit(&sg);
+    return NULL;
+}
+
+static void test_stage(void)
+{
+    printf("Test 25: Producer batch staging\n");
+
+    jringdata_cfg_t cfg = {
+        .idx_num = 8,
+        .idx_size = TEST_IDX_SIZE,
+        .capacity = 256,
+        .max_producers = TEST_MAX_PRODUCERS,
+        .max_consumers = 1,
+        .read_mode = JRINGDATA_READ_SHARED,
+        .flags = JRINGDATA_STATS
+    };
+    jringdata_t *rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+
+    jringdata_stage_t sg;
+    jringdata_stats_t st;
+    uint32_t len = sizeof(uint32_t), big = 65, idx[16], data[16], i, v;
+    int pid = jringdata_add_producer(rd);
+    test_assert(pid >= 0, "add producer failed");
+
+    /* 达到数量阈值时一次发布 */
+    test_assert(jringdata_stage_init(&sg, rd, pid, 4, 64, 0, 0, 0) == 0, "stage init failed");
+    for (i = 0; i < 3; ++i)
+        test_assert(jringdata_stage(&sg, &len, &i) == 0, "stage failed");
+    test_assert(jringdata_size(rd, 0, NULL) == 0 && jringdata_flush(&sg, 0) == 0, "staged records should be private");
+    test_assert(jringdata_stage(&sg, &len, &i) == 0 && sg.num == 0 && jringdata_size(rd, 0, NULL) == 4,
+        "count threshold should publish");
+    test_assert(jringdata_stats_get(rd, &st) == 0 && st.write_num == 4 && st.write_bytes == 16, "stats wrong");
+    test_assert(jringdata_stage(&sg, &big, data) < 0, "record larger than max_bytes should fail");
+
+    /* 缓冲区满时发布失败，记录保留在暂存区 */
+    for (i = 4; i < 12; ++i)
+        test_assert(jringdata_stage(&sg, &len, &i) == 0, "stage failed");
+    test_assert(jringdata_size(rd, 0, NULL) == 8 && sg.num == 4, "partial publish wrong");
+    test_assert(jringdata_stage(&sg, &len, &i) < 0, "stage into full area should fail");
+    test_assert(jringdata_read(rd, 0, idx, 16, data, sizeof(data), NULL, NULL, 0, 0) == 8, "read failed");
+    for (i = 0; i < 8; ++i)
+        test_assert(data[i] == i, "stage order wrong");
+    test_assert(jringdata_flush(&sg, 1) == 4 && jringdata_flush(&sg, 1) == 0, "flush failed");
+    jringdata_stage_uninit(&sg);
+
+    /* 不是完全写入时只发布放得下的部分，剩余的记录保持顺序 */
+    test_assert(jringdata_stage_init(&sg, rd, pid, 16, 64, 0, 0, 0) == 0, "stage init failed");
+    for (i = 12; i < 24; ++i)
+        test_assert(jringdata_stage(&sg, &len, &i) == 0, "stage failed");
+    test_assert(jringdata_flush(&sg, 1) == 4 && sg.num == 8, "partial flush wrong");
+    test_assert(jringdata_read(rd, 0, idx, 16, data, sizeof(data), NULL, NULL, 0, 0) == 8, "read failed");
+    test_assert(jringdata_flush(&sg, 1) == 8, "flush rest failed");
+    test_assert(jringdata_read(rd, 0, idx, 16, data, sizeof(data), NULL, NULL, 0, 0) == 8, "read failed");
+    for (i = 0; i < 8; ++i)
+        test_assert(data[i] == 16 + i, "partial flush order wrong");
+    jringdata_stage_uninit(&sg);
+
+    /* 达到时间阈值时发布 */
+    test_assert(jringdata_stage_init(&sg, rd, pid, 16, 64, 5000000, 0, 0) == 0, "stage init failed");
+    test_assert(jringdata_stage(&sg, &len, &i) == 0 && jringdata_flush(&sg, 0) == 0, "flush before delay should wait");
+    jthread_msleep(10);
+    test_assert(jringdata_flush(&sg, 0) == 1 && jringdata_size(rd, 0, NULL) == 1, "delay threshold should publish");
+    jringdata_stage_uninit(&sg);
+    jringdata_uninit(rd);
+
+    /* 多个生产者各自暂存，消费者检查每个生产者的顺序 */
+    cfg.idx_num = TEST_IDX_NUM;
+    rd = jringdata_init(&cfg);
+    test_assert(rd != NULL, "init failed");
+
+    jthread_t threads[TEST_MAX_PRODUCERS];
+    thread_arg_t args[TEST_MAX_PRODUCERS];
+    uint32_t expect[TEST_MAX_PRODUCERS] = {0}, total = 0;
+    for (i = 0; i < TEST_MAX_PRODUCERS; ++i) {
+        args[i].rd = rd;
+        args[i].id = jringdata_add_producer(rd);
+        test_assert(args[i].id >= 0 && args[i].id < TEST_MAX_PRODUCERS, "add producer failed");
+        jthread_create(&threads[i], NULL, stage_producer, &args[i]);
+    }
+    while (total < TEST_MAX_PRODUCERS * STAGE_NUM) {
+        int n = jringdata_read(rd, 0, idx, 16, data, sizeof(data), NULL, NULL, JRINGDATA_BLOCK, 1000);
+        test_assert(n > 0, "read staged records failed");
+        for (int k = 0; k < n; ++k) {
+            v = data[k] >> 16;
+            test_assert(v < TEST_MAX_PRODUCERS && (data[k] & 0xffff) == expect[v], "staged order wrong");
+            ++expect[v];
+        }
+        total += (uint32_t)n;
+    }
+    for (i = 0; i < TEST_MAX_PRODUCERS; ++i)
+        jthread_join(threads[i]);
+    test_assert(jringdata_stats_get(rd, &st) == 0 && st.write_num == TEST_MAX_PRODUCERS * STAGE_NUM, "stats wrong");
+    jringdata_uninit(rd);
+
+    printf("Test 25 PASSED\n\n");
+}
+
 /*----------------------------------------------------------------------------
   主函数
 ----------------------------------------------------------------------------*/
@@ -843,6 +1853,17 @@ int main(void)
     test_uninit_safety();
     test_writev_readv();
     test_custom_get_size();
+    test_spin_wait();
+    test_mirror();
+    test_event_fd();
+    test_stats();
+    test_write_reserve();
+    test_iter();
+    test_read_to_fd();
+    test_seek();
+    test_max_age();
+    test_filter();
+    test_stage();
 
     printf("All tests PASSED.\n");
     return 0;
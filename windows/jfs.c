@@ -220,3 +220,194 @@ int jfs_rmdir(const char *dname)
     return jfs_rmdir_exec(dname);
 }
 
+
+void *jfs_shm_map(const char *name, size_t *size, int create)
+{
+    HANDLE handle = NULL;
+    void *addr = NULL;
+
+    if (create) {
+        handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+            (DWORD)((unsigned long long)*size >> 32), (DWORD)*size, name);
+        if (handle && GetLastError() == ERROR_ALREADY_EXISTS) {
+            CloseHandle(handle);
+            return NULL;
+        }
+    } else {
+        handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    }
+    if (!handle)
+        return NULL;
+
+    addr = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, create ? *size : 0);
+    CloseHandle(handle); /* 映射视图存在时共享内存对象不会释放 */
+    if (!addr)
+        return NULL;
+
+    if (!create) {
+        MEMORY_BASIC_INFORMATION mbi;
+        VirtualQuery(addr, &mbi, sizeof(mbi));
+        *size = mbi.RegionSize;
+    }
+    return addr;
+}
+
+int jfs_shm_unmap(void *addr, size_t size)
+{
+    (void)size;
+    return UnmapViewOfFile(addr) ? 0 : -1;
+}
+
+int jfs_shm_unlink(const char *name)
+{
+    (void)name;
+    return 0;
+}
+
+void *jfs_file_map(const char *fname, size_t *size, int create)
+{
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE handle = NULL;
+    void *addr = NULL;
+    LARGE_INTEGER fsize;
+
+    file = CreateFileA(fname, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    if (!create) {
+        if (!GetFileSizeEx(file, &fsize) || fsize.QuadPart <= 0) {
+            CloseHandle(file);
+            return NULL;
+        }
+        *size = (size_t)fsize.QuadPart;
+    }
+
+    /* 创建映射时文件会扩展到映射大小 */
+    handle = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+        (DWORD)((unsigned long long)*size >> 32), (DWORD)*size, NULL);
+    CloseHandle(file);
+    if (!handle)
+        return NULL;
+
+    addr = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, *size);
+    CloseHandle(handle); /* 映射视图存在时文件映射对象不会释放 */
+    return addr;
+}
+
+int jfs_file_sync(void *addr, size_t size)
+{
+    return FlushViewOfFile(addr, size) ? 0 : -1;
+}
+
+int jfs_fallocate(jfs_fd_t fd, size_t size)
+{
+    return _chsize_s(fd, (long long)size) == 0 ? 0 : -1;
+}
+
+void *jfs_fdmap(jfs_fd_t fd, size_t size)
+{
+    HANDLE file = (HANDLE)_get_osfhandle(fd);
+    HANDLE handle = NULL;
+    void *addr = NULL;
+
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    handle = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+        (DWORD)((unsigned long long)size >> 32), (DWORD)size, NULL);
+    if (!handle)
+        return NULL;
+
+    addr = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    CloseHandle(handle); /* 映射视图存在时文件映射对象不会释放 */
+    return addr;
+}
+
+int jfs_file_flush(void *addr, size_t size)
+{
+    /* FlushViewOfFile只把脏页交给系统写回，不等待写盘完成 */
+    return FlushViewOfFile(addr, size) ? 0 : -1;
+}
+
+size_t jfs_mirror_granularity(void)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (size_t)si.dwAllocationGranularity;
+}
+
+void *jfs_mirror_map(size_t size)
+{
+    HANDLE handle = NULL;
+    int i = 0;
+
+    if (size == 0 || size % jfs_mirror_granularity())
+        return NULL;
+
+    handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        (DWORD)((unsigned long long)size >> 32), (DWORD)size, NULL);
+    if (!handle)
+        return NULL;
+
+    /* 先找到两倍大小的空闲地址空间，释放后立即映射前后两半，被其它线程抢占时重试 */
+    for (i = 0; i < 16; ++i) {
+        unsigned char *addr = (unsigned char *)VirtualAlloc(NULL, size << 1, MEM_RESERVE, PAGE_NOACCESS);
+        void *view1 = NULL, *view2 = NULL;
+        if (!addr)
+            break;
+        VirtualFree(addr, 0, MEM_RELEASE);
+
+        view1 = MapViewOfFileEx(handle, FILE_MAP_ALL_ACCESS, 0, 0, size, addr);
+        if (view1)
+            view2 = MapViewOfFileEx(handle, FILE_MAP_ALL_ACCESS, 0, 0, size, addr + size);
+        if (view1 && view2) {
+            CloseHandle(handle); /* 映射视图存在时内存对象不会释放 */
+            return addr;
+        }
+        if (view1)
+            UnmapViewOfFile(view1);
+    }
+
+    CloseHandle(handle);
+    return NULL;
+}
+
+int jfs_mirror_unmap(void *addr, size_t size)
+{
+    int ret = 0;
+    if (!UnmapViewOfFile(addr))
+        ret = -1;
+    if (!UnmapViewOfFile((unsigned char *)addr + size))
+        ret = -1;
+    return ret;
+}
+
+int jfs_writev_full(jfs_fd_t fd, jfs_iovec_t *iov, int cnt, size_t skip, int timeout_ms)
+{
+    ssize_t n;
+
+    (void)timeout_ms;
+
+    while (1) {
+        /* 跳过已经写出的内存段 */
+        while (cnt > 0 && skip >= iov->iov_len) {
+            skip -= iov->iov_len;
+            ++iov;
+            --cnt;
+        }
+        if (cnt <= 0)
+            return 0;
+        iov->iov_base = (char *)iov->iov_base + skip;
+        iov->iov_len -= skip;
+
+        n = jfs_writev(fd, iov, cnt);
+        if (n < 0) {
+            if (errno != EINTR)
+                return -1;
+            n = 0;
+        }
+        skip = (size_t)n;
+    }
+}
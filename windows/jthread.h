@@ -11,8 +11,11 @@
 #include <winbase.h>
 #include <synchapi.h>
 #include <processthreadsapi.h>
+#include <errno.h>
 #include "jtime.h"
 
+#pragma comment(lib, "Synchronization.lib")
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -43,6 +46,21 @@ static inline int jthread_mutex_unlock(jthread_mutex_t* mutex)
     return 0;
 }
 
+/**
+ * @brief   进程间共享的健壮互斥锁
+ * @note    windows的CRITICAL_SECTION不能跨进程共享，jthread_mutex_init_pshared总是返回-1
+ */
+static inline int jthread_mutex_init_pshared(jthread_mutex_t *mutex)
+{
+    (void)mutex;
+    return -1;
+}
+static inline int jthread_mutex_consistent(jthread_mutex_t *mutex)
+{
+    (void)mutex;
+    return 0;
+}
+
 /**
  * @brief   超时互斥锁
  * @note    1. mutex都为jthread_tmutex_t的指针
@@ -224,6 +242,75 @@ static inline int jthread_sem_mtimewait(jthread_sem_t *sem, uint32_t msec)
     return WaitForSingleObject(*sem, (DWORD)msec) == WAIT_OBJECT_0 ? 0 : -1;
 }
 
+/**
+ * @brief   地址等待/唤醒(futex)
+ * @note    1. addr都为uint32_t的指针，用于实现“先自旋再睡眠”的轻量等待
+ *          2. jthread_futex_wait在*addr等于val时睡眠，直到被唤醒、超时(msec为-1时永不超时)或虚假唤醒；
+ *             *addr不等于val时立即返回；超时返回ETIMEDOUT，其它情况返回0，调用者需要重新检查条件
+ *          3. jthread_futex_wake唤醒在addr上等待的线程，all为0时最多唤醒一个，否则唤醒所有
+ *          4. windows使用WaitOnAddress实现(Windows 8及以上)，只支持同一进程内，忽略pshared
+ */
+static inline int jthread_futex_wait(uint32_t *addr, uint32_t val, int msec, int pshared)
+{
+    (void)pshared;
+    if (WaitOnAddress((volatile VOID *)addr, &val, sizeof(val), msec < 0 ? INFINITE : (DWORD)msec))
+        return 0;
+    return GetLastError() == ERROR_TIMEOUT ? ETIMEDOUT : 0;
+}
+static inline int jthread_futex_wake(uint32_t *addr, int all, int pshared)
+{
+    (void)pshared;
+    if (all)
+        WakeByAddressAll((PVOID)addr);
+    else
+        WakeByAddressSingle((PVOID)addr);
+    return 0;
+}
+
+/**
+ * @brief   事件描述符(eventfd)
+ * @note    windows没有可以和套接字一起等待的事件描述符，jthread_evfd_create固定返回-1
+ */
+static inline int jthread_evfd_create(void)
+{
+    return -1;
+}
+static inline int jthread_evfd_set(int fd)
+{
+    (void)fd;
+    return -1;
+}
+static inline int jthread_evfd_clear(int fd)
+{
+    (void)fd;
+    return -1;
+}
+static inline void jthread_evfd_close(int fd)
+{
+    (void)fd;
+}
+
+/**
+ * @brief   线程局部数据的键
+ * @note    1. jthread_key_create 的 destructor 在线程退出时以本线程设置的值(非NULL时)调用，可以为NULL
+ *          2. 成功返回0; 失败返回非0
+ */
+#define jthread_key_t                   DWORD
+static inline int jthread_key_create(jthread_key_t *key, void (*destructor)(void *))
+{
+    *key = FlsAlloc((PFLS_CALLBACK_FUNCTION)destructor);
+    return *key == FLS_OUT_OF_INDEXES ? -1 : 0;
+}
+static inline int jthread_key_delete(jthread_key_t key)
+{
+    return FlsFree(key) ? 0 : -1;
+}
+static inline int jthread_key_set(jthread_key_t key, void *value)
+{
+    return FlsSetValue(key, value) ? 0 : -1;
+}
+#define jthread_key_get(key)            FlsGetValue(key)
+
 /**
  * @brief   线程属性
  */